@@ -16,12 +16,15 @@ import time
 PAYLOADS = (512, 4096, 32768)
 TARGET_BYTES = 8 * 1024 * 1024
 MIN_DA_MESSAGES = 12288
+DRAIN_BACKLOG_FACTOR = 8
+DRAIN_SEGMENT_BYTES = 8 * 1024 * 1024
 
 
 def parse_args():
     parser = argparse.ArgumentParser()
     parser.add_argument("--scenario",
-                        choices=("all", "throughput", "rotation", "restart-replay", "sync-throughput"),
+                        choices=("all", "throughput", "rotation", "restart-replay", "sync-throughput",
+                                 "drain"),
                         default="all")
     parser.add_argument("--build-dir", required=True)
     parser.add_argument("--label", required=True)
@@ -55,7 +58,8 @@ def workloads(scenario, modes, payloads, target_bytes, batch_size):
     for item in scenarios:
         for mode in modes:
             for payload in payloads:
-                message_count = max(4 * batch_size, target_bytes // payload)
+                backlog_bytes = target_bytes * DRAIN_BACKLOG_FACTOR if item == "drain" else target_bytes
+                message_count = max(4 * batch_size, backlog_bytes // payload)
                 if mode == "da":
                     message_count = max(message_count, MIN_DA_MESSAGES)
                 result.append({
@@ -64,12 +68,20 @@ def workloads(scenario, modes, payloads, target_bytes, batch_size):
                     "payload_bytes": payload,
                     "messages": message_count,
                     "batch_size": batch_size,
-                    "segment_bytes": 262144 if item == "rotation" else 1048576,
+                    "segment_bytes": segment_bytes(item),
                     "sync_files": item == "sync-throughput",
                 })
     return result
 
 
+def segment_bytes(scenario):
+    if scenario == "rotation":
+        return 262144
+    if scenario == "drain":
+        return DRAIN_SEGMENT_BYTES
+    return 1048576
+
+
 def verify_build(build_dir):
     required = ("tools/rsyslogd", "tests/tcpflood", "tests/minitcpsrv", "tests/diag.sh")
     missing = [name for name in required if not (build_dir / name).exists()]
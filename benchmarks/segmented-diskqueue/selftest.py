@@ -29,6 +29,13 @@ def main():
     rotation = next(item for item in matrix if item["scenario"] == "rotation" and
                     item["mode"] == "segmented" and item["payload_bytes"] == 32768)
     check(rotation["segment_bytes"] == 262144, "rotation workload must use the stress segment size")
+    check(not any(item["scenario"] == "drain" for item in matrix),
+          "the large drain backlog must stay an explicitly selected scenario")
+    drain = runner.workloads("drain", ("segmented",), (4096,), runner.TARGET_BYTES, 1024)
+    check(len(drain) == 1 and drain[0]["messages"] == 16384,
+          "drain workload must prefill eight times the throughput backlog")
+    check(drain[0]["segment_bytes"] == runner.DRAIN_SEGMENT_BYTES,
+          "drain workload must read back large sealed segments")
 
     # strace output has an optional error-count column. Both shapes must map to
     # structured counts without retaining machine-specific text.
@@ -54,6 +61,10 @@ def main():
     ]
     check(compare.paired_metric_ratios(metric_pairs, "spill_ns") == [(7, 2.0)],
           "filtered metric ratio lost its original trial ID")
+    # Builds that predate the read.calls counter record no value; such pairs
+    # are skipped instead of failing the comparison.
+    check(compare.paired_metric_ratios(metric_pairs, "read_calls") == [],
+          "missing read_calls produced a ratio")
 
     matching = (
         {"metadata": {"session": "session-a", "revision": "base", "source_fingerprint": "base-fp",
@@ -154,23 +154,49 @@ touch "$RECEIVER_LISTEN_RELEASE_FILE" "$RECEIVER_RELEASE_FILE"
 wait_file_exists "$RECEIVER_READY_FILE"
 wait_file_lines --abort-on-oversize "$RECEIVER_FILE" "$BENCH_MESSAGES" 300
 t_drained=$(now_ns)
+if [ "$BENCH_SCENARIO" = drain ]; then
+	# Let impstats publish one interval that covers the complete drain so
+	# read_calls reflects every dequeue read.
+	./msleep 1100
+fi
+t_shutdown=$(now_ns)
 shutdown_when_empty
 wait_shutdown
 rm -f "$RECEIVER_KEEP_FILE"
 wait "$RECEIVER_PID" || error_exit 1 "minitcpsrv did not exit cleanly"
 t_end=$(now_ns)
 
+# Builds without the read.calls or sync.groupCommits counters report zero,
+# which compare.py skips.
+if [ "$BENCH_MODE" = segmented ]; then
+	stats_queue='main Q'
+else
+	stats_queue='main Q\[DA\]'
+fi
+read_calls=$(sed -n 's/.*'"$stats_queue"': origin=core.queue .* read\.calls=\([0-9][0-9]*\).*/\1/p' \
+	"$STATS_FILE" | tail -1)
+[ -n "$read_calls" ] || read_calls=0
+group_commits=$(sed -n 's/.*'"$stats_queue"': origin=core.queue .* sync\.groupCommits=\([0-9][0-9]*\).*/\1/p' \
+	"$STATS_FILE" | tail -1)
+[ -n "$group_commits" ] || group_commits=0
+drain_ns=$((t_drained - t_drain_start))
+drain_bytes_per_second=0
+if [ "$drain_ns" -gt 0 ]; then
+	drain_bytes_per_second=$((BENCH_PAYLOAD_BYTES * BENCH_MESSAGES * 1000000000 / drain_ns))
+fi
+
 cut -d: -f2 "$RECEIVER_FILE" >"$RSYSLOG_OUT_LOG"
 export NUMMESSAGES="$BENCH_MESSAGES"
 seq_check 0 $((BENCH_MESSAGES - 1))
 mkdir -p "$(dirname "$BENCH_METRIC_FILE")"
-printf '{"scenario":"%s","mode":"%s","payload_bytes":%d,"batch_size":%d,"segment_bytes":%d,"messages":%d,"bytes":%d,"input_submitted_at_spill":%d,"enqueued_at_spill":%d,"child_enqueued_at_spill":%d,"backlog_at_spill":%d,"startup_ns":%d,"spill_ns":%d,"restart_ns":%d,"drain_ns":%d,"shutdown_ns":%d,"end_to_end_ns":%d,"segments_observed":%d}\n' \
+printf '{"scenario":"%s","mode":"%s","payload_bytes":%d,"batch_size":%d,"segment_bytes":%d,"messages":%d,"bytes":%d,"input_submitted_at_spill":%d,"enqueued_at_spill":%d,"child_enqueued_at_spill":%d,"backlog_at_spill":%d,"startup_ns":%d,"spill_ns":%d,"restart_ns":%d,"drain_ns":%d,"drain_bytes_per_second":%d,"read_calls":%d,"group_commits":%d,"shutdown_ns":%d,"end_to_end_ns":%d,"segments_observed":%d}\n' \
 	"$BENCH_SCENARIO" "$BENCH_MODE" "$BENCH_PAYLOAD_BYTES" "$BENCH_BATCH_SIZE" "$BENCH_SEGMENT_BYTES" \
 	"$BENCH_MESSAGES" "$((BENCH_PAYLOAD_BYTES * BENCH_MESSAGES))" "$input_submitted" "$enqueued" \
 	"$child_enqueued" "$backlog" \
 	"$((t_started - t0))" \
 	"$((t_spilled - t_started))" \
-	"$restart_ns" "$((t_drained - t_drain_start))" "$((t_end - t_drained))" "$((t_end - t0))" \
+	"$restart_ns" "$drain_ns" "$drain_bytes_per_second" "$read_calls" "$group_commits" \
+	"$((t_end - t_shutdown))" "$((t_end - t0))" \
 	"$segments_at_spill" \
 	>"$BENCH_METRIC_FILE"
 exit_test
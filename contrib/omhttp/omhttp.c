@@ -335,7 +335,6 @@ static rsRetVal ATTR_NONNULL() resetCompressCtx(wrkrInstanceData_t *pWrkrData, s
 
 static rsRetVal ATTR_NONNULL() growCompressCtx(wrkrInstanceData_t *pWrkrData, size_t newLen);
 
-static rsRetVal ATTR_NONNULL() appendCompressCtx(wrkrInstanceData_t *pWrkrData, uchar *srcBuf, size_t srcLen);
 
 BEGINcreateInstance
     CODESTARTcreateInstance;
@@ -1296,7 +1295,6 @@ finalize_it:
 static rsRetVal compressHttpPayload(wrkrInstanceData_t *pWrkrData, uchar *message, size_t len) {
     int zRet;
     unsigned outavail;
-    uchar zipBuf[32 * 1024];
 
     DEFiRet;
 
@@ -1320,37 +1318,28 @@ static rsRetVal compressHttpPayload(wrkrInstanceData_t *pWrkrData, uchar *messag
         deflateReset(&pWrkrData->zstrm);
     }
 
-    CHKiRet(resetCompressCtx(pWrkrData, len));
+    /* deflate writes straight into the context buffer, which is what gets
+     * posted. deflateBound() is sufficient for a single Z_FINISH call, the
+     * loop only guards against zlib versions which need more.
+     */
+    CHKiRet(resetCompressCtx(pWrkrData, deflateBound(&pWrkrData->zstrm, (uLong)len)));
 
-    /* now doing the compression */
     pWrkrData->zstrm.next_in = (Bytef *)message;
     pWrkrData->zstrm.avail_in = (uInt)len;
-    /* run deflate() on buffer until everything has been compressed */
     do {
-        DBGPRINTF("omhttp: compressHttpPayload in deflate() loop, avail_in %d, total_in %ld\n",
-                  pWrkrData->zstrm.avail_in, pWrkrData->zstrm.total_in);
-        pWrkrData->zstrm.avail_out = sizeof(zipBuf);
-        pWrkrData->zstrm.next_out = zipBuf;
-
-        zRet = deflate(&pWrkrData->zstrm, Z_NO_FLUSH);
+        if (pWrkrData->compressCtx.curLen == pWrkrData->compressCtx.len) {
+            CHKiRet(growCompressCtx(pWrkrData, pWrkrData->compressCtx.len * 2));
+        }
+        const size_t bufFree = pWrkrData->compressCtx.len - pWrkrData->compressCtx.curLen;
+        outavail = (bufFree > UINT_MAX) ? UINT_MAX : (unsigned)bufFree;
+        pWrkrData->zstrm.next_out = pWrkrData->compressCtx.buf + pWrkrData->compressCtx.curLen;
+        pWrkrData->zstrm.avail_out = outavail;
+        zRet = deflate(&pWrkrData->zstrm, Z_FINISH);
         DBGPRINTF("omhttp: compressHttpPayload after deflate, ret %d, avail_out %d\n", zRet,
                   pWrkrData->zstrm.avail_out);
-        if (zRet != Z_OK) ABORT_FINALIZE(RS_RET_ZLIB_ERR);
-        outavail = sizeof(zipBuf) - pWrkrData->zstrm.avail_out;
-        if (outavail != 0) CHKiRet(appendCompressCtx(pWrkrData, zipBuf, outavail));
-
-    } while (pWrkrData->zstrm.avail_out == 0);
-
-    /* run deflate again with Z_FINISH with no new input */
-    pWrkrData->zstrm.avail_in = 0;
-    do {
-        pWrkrData->zstrm.avail_out = sizeof(zipBuf);
-        pWrkrData->zstrm.next_out = zipBuf;
-        deflate(&pWrkrData->zstrm, Z_FINISH); /* returns Z_STREAM_END == 1 */
-        outavail = sizeof(zipBuf) - pWrkrData->zstrm.avail_out;
-        if (outavail != 0) CHKiRet(appendCompressCtx(pWrkrData, zipBuf, outavail));
-
-    } while (pWrkrData->zstrm.avail_out == 0);
+        if (zRet != Z_OK && zRet != Z_STREAM_END && zRet != Z_BUF_ERROR) ABORT_FINALIZE(RS_RET_ZLIB_ERR);
+        pWrkrData->compressCtx.curLen += outavail - pWrkrData->zstrm.avail_out;
+    } while (zRet != Z_STREAM_END);
 
 finalize_it:
     if (pWrkrData->bzInitDone) deflateEnd(&pWrkrData->zstrm);
@@ -1397,18 +1386,6 @@ finalize_it:
     RETiRet;
 }
 
-static rsRetVal ATTR_NONNULL() appendCompressCtx(wrkrInstanceData_t *pWrkrData, uchar *srcBuf, size_t srcLen) {
-    size_t newLen;
-    DEFiRet;
-    newLen = pWrkrData->compressCtx.curLen + srcLen;
-    if (newLen > pWrkrData->compressCtx.len) CHKiRet(growCompressCtx(pWrkrData, newLen));
-
-    memcpy(pWrkrData->compressCtx.buf + pWrkrData->compressCtx.curLen, srcBuf, srcLen);
-    pWrkrData->compressCtx.curLen = newLen;
-finalize_it:
-    if (iRet != RS_RET_OK) freeCompressCtx(pWrkrData);
-    RETiRet;
-}
 
 /* Some duplicate code to curlSetup, but we need to add the gzip content-encoding
  * header at runtime, and if the compression fails, we do not want to send it.
@@ -1773,36 +1750,36 @@ finalize_it:
 }
 
 /* Build a batch by joining each element with a newline character.
+ * The total size is known up front, so the rendered messages are copied
+ * exactly once, into the buffer that is posted.
  */
 static rsRetVal serializeBatchNewline(wrkrInstanceData_t *pWrkrData, char **batchBuf) {
     DEFiRet;
     size_t numMessages = pWrkrData->batch.nmemb;
     size_t sizeTotal = pWrkrData->batch.sizeBytes + numMessages;  // message + newline + null term
-    int r = 0;
+    char *buf = NULL;
+    size_t offs = 0;
 
     DBGPRINTF("omhttp: serializeBatchNewline numMessages=%zd sizeTotal=%zd\n", numMessages, sizeTotal);
 
-    es_str_t *batchString = es_newStr(1024);
-
-    if (batchString == NULL) ABORT_FINALIZE(RS_RET_ERR);
-
+    CHKmalloc(buf = malloc(sizeTotal + 1));
     for (size_t i = 0; i < numMessages; i++) {
-        size_t nToCopy = ustrlen(pWrkrData->batch.data[i]);
-        if (r == 0) r = es_addBuf(&batchString, (char *)pWrkrData->batch.data[i], nToCopy);
+        const size_t nToCopy = ustrlen(pWrkrData->batch.data[i]);
+        if (nToCopy > sizeTotal - offs) {
+            LogError(0, RS_RET_ERR, "omhttp: serializeBatchNewline batch size accounting mismatch");
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        memcpy(buf + offs, pWrkrData->batch.data[i], nToCopy);
+        offs += nToCopy;
         if (i == numMessages - 1) break;
-        if (r == 0) r = es_addChar(&batchString, '\n');
-    }
-
-    if (r == 0) *batchBuf = (char *)es_str2cstr(batchString, NULL);
-
-    if (r != 0 || *batchBuf == NULL) {
-        LogError(0, RS_RET_ERR, "omhttp: serializeBatchNewline failed to build batch string");
-        ABORT_FINALIZE(RS_RET_ERR);
+        buf[offs++] = '\n';
     }
+    buf[offs] = '\0';
+    *batchBuf = buf;
+    buf = NULL;
 
 finalize_it:
-    if (batchString != NULL) es_deleteStr(batchString);
-
+    free(buf);
     RETiRet;
 }
 
@@ -67,9 +67,13 @@ MODULE_CNFNAME("imkafka")
 /* =============================================================================
  * Concurrency & Locking
  * =============================================================================
- * - Each instance processes messages sequentially in its worker thread
- *   (imkafkawrkr). Messages are consumed via librdkafka's consumer API
- *   which handles thread-safety internally.
+ * - Each instance owns consumer.threads librdkafka consumer handles, each
+ *   serviced by its own worker thread (imkafkawrkr). All handles of an
+ *   instance join the same consumer group, so the broker distributes the
+ *   topic partitions across them. A kafkaConsumer_t is only ever touched by
+ *   its worker thread (and by shutdown after that thread was joined).
+ * - Instance configuration is read-only while workers run; per-instance
+ *   counters are updated via the atomic STATSCOUNTER helpers.
  * - JSON splitting (splitJsonRecords) operates on a per-message basis with
  *   no shared mutable state. Each split record is submitted independently
  *   to the rsyslog core, which handles its own queuing and threading.
@@ -151,14 +155,15 @@ typedef struct instanceConf_s {
     int bReportErrs;
     int nConfParams;
     struct kafka_params *confParams;
-    int bIsConnected;
-    rd_kafka_conf_t *conf;
-    rd_kafka_t *rk;
+    rd_kafka_conf_t *conf; /* template for all consumer handles, only valid during setup */
     rd_kafka_topic_conf_t *topic_conf;
     int partition;
-    int bIsSubscribed;
     int nMsgParsingFlags;
     int bSplitJsonRecords; /* if enabled, split {"records":[...]} into individual messages */
+    int batchSize; /* max number of kafka messages fetched per poll burst */
+    int nConsumers; /* number of consumer handles (and worker threads) */
+    int bStoreOffsetAfterSubmit; /* store offsets only once rsyslog accepted the messages */
+    struct kafkaConsumer_s *consumers;
     struct instanceConf_s *next;
     /* per-instance stats object + counters */
     statsobj_t *stats;
@@ -170,10 +175,25 @@ typedef struct instanceConf_s {
     STATSCOUNTER_DEF(ctrMaxLag, mutCtrMaxLag);
 } instanceConf_t;
 
+/* A single librdkafka consumer handle together with the buffers used by the
+ * worker thread servicing it. See the locking notes at the top of the file.
+ */
+typedef struct kafkaConsumer_s {
+    instanceConf_t *inst; /* instance this consumer belongs to */
+    rd_kafka_t *rk;
+    int bIsConnected;
+    int bIsSubscribed;
+    rd_kafka_message_t **rkmessages; /* poll burst, inst->batchSize entries */
+    rd_kafka_topic_partition_list_t *rewind; /* pending seeks after a failed burst, NULL if none */
+} kafkaConsumer_t;
+
 /* Hard fan-out ceiling for split.json.records to avoid queue amplification
  * from a single broker message. */
 #define IMKAFKA_MAX_JSON_SPLIT_RECORDS 10000
 
+/* default number of kafka messages fetched per poll burst */
+#define IMKAFKA_DFLT_BATCHSIZE 128
+
 typedef struct modConfData_s {
     rsconf_t *pConf; /* our overall config object */
     uchar **topics; /* Array of topic names (module default) */
@@ -195,7 +215,7 @@ DEF_ATOMIC_HELPER_MUT(mutStopImkafkaWorkers);
  */
 struct kafkaWrkrInfo_s {
     pthread_t tid; /* the worker's thread ID */
-    instanceConf_t *inst; /* Pointer to imkafka instance */
+    kafkaConsumer_t *consumer; /* consumer serviced by this worker */
 };
 static struct kafkaWrkrInfo_s *kafkaWrkrInfo;
 
@@ -214,7 +234,8 @@ static struct cnfparamblk modpblk = {CNFPARAMBLK_VERSION, sizeof(modpdescr) / si
 static struct cnfparamdescr inppdescr[] = {
     {"topic", eCmdHdlrArray, CNFPARAM_REQUIRED}, {"broker", eCmdHdlrArray, 0},   {"confparam", eCmdHdlrArray, 0},
     {"consumergroup", eCmdHdlrString, 0},        {"ruleset", eCmdHdlrString, 0}, {"parsehostname", eCmdHdlrBinary, 0},
-    {"split.json.records", eCmdHdlrBinary, 0},
+    {"split.json.records", eCmdHdlrBinary, 0},   {"batchsize", eCmdHdlrPositiveInt, 0},
+    {"consumer.threads", eCmdHdlrPositiveInt, 0}, {"offset.storeaftersubmit", eCmdHdlrBinary, 0},
 };
 static struct cnfparamblk inppblk = {CNFPARAMBLK_VERSION, sizeof(inppdescr) / sizeof(struct cnfparamdescr), inppdescr};
 
@@ -343,9 +364,18 @@ static void errorCallback(rd_kafka_t __attribute__((unused)) * rk,
     LogError(0, RS_RET_KAFKA_ERROR, "imkafka: kafka error message: %d,'%s','%s'", err, rd_kafka_err2str(err), reason);
 }
 
-/* enqueue the kafka message. The provided string is
- * not freed - this must be done by the caller.
+/* add a message to the pending multi-submit batch, handing the batch
+ * to the rsyslog core once it is full.
  */
+static rsRetVal addToBatch(multi_submit_t *const pMultiSub, smsg_t *const pMsg) {
+    DEFiRet;
+    pMultiSub->ppMsgs[pMultiSub->nElem++] = pMsg;
+    if (pMultiSub->nElem == pMultiSub->maxElem) {
+        CHKiRet(multiSubmitMsg2(pMultiSub));
+    }
+finalize_it:
+    RETiRet;
+}
 
 /**
  * Helper: extract timestamp from JSON record's "time" field if present
@@ -385,9 +415,10 @@ static time_t extractJsonTimestamp(struct fjson_object *record) {
 
 /**
  * Submit a single JSON record as a message to rsyslog
- * This is used both for normal messages and split records
+ * This is used for split records; the message is added to pMultiSub.
  */
 static rsRetVal submitJsonRecord(instanceConf_t *const __restrict__ inst,
+                                 multi_submit_t *const pMultiSub,
                                  const char *payload,
                                  size_t len,
                                  const char *key,
@@ -430,7 +461,7 @@ static rsRetVal submitJsonRecord(instanceConf_t *const __restrict__ inst,
         MsgSetTAG(pMsg, (const uchar *)key, (int)key_len);
     }
     MsgSetMSGoffs(pMsg, 0); /* we do not have a header... */
-    CHKiRet(submitMsg2(pMsg));
+    CHKiRet(addToBatch(pMultiSub, pMsg));
 
     /* submitted successfully */
     STATSCOUNTER_INC(ctrSubmitted, mutCtrSubmitted);
@@ -444,6 +475,7 @@ finalize_it:
  * Returns RS_RET_OK if splitting succeeded, error otherwise
  */
 static rsRetVal splitJsonRecords(instanceConf_t *const __restrict__ inst,
+                                 multi_submit_t *const pMultiSub,
                                  rd_kafka_message_t *const __restrict__ rkmessage) {
     DEFiRet;
     struct fjson_object *root = NULL;
@@ -531,7 +563,7 @@ static rsRetVal splitJsonRecords(instanceConf_t *const __restrict__ inst,
         }
 
         /* Submit individual record */
-        local_ret = submitJsonRecord(inst, record_str, strlen(record_str), (const char *)rkmessage->key,
+        local_ret = submitJsonRecord(inst, pMultiSub, record_str, strlen(record_str), (const char *)rkmessage->key,
                                      rkmessage->key_len, timestamp);
         if (local_ret == RS_RET_OK) {
             submitted_count++;
@@ -554,7 +586,12 @@ finalize_it:
     RETiRet;
 }
 
-static rsRetVal enqMsg(instanceConf_t *const __restrict__ inst, rd_kafka_message_t *const __restrict__ rkmessage) {
+/* enqueue the kafka message into the pending multi-submit batch. The
+ * kafka message is not freed - this must be done by the caller.
+ */
+static rsRetVal enqMsg(instanceConf_t *const __restrict__ inst,
+                       multi_submit_t *const pMultiSub,
+                       rd_kafka_message_t *const __restrict__ rkmessage) {
     DEFiRet;
     smsg_t *pMsg;
 
@@ -568,7 +605,7 @@ static rsRetVal enqMsg(instanceConf_t *const __restrict__ inst, rd_kafka_message
 
     /* If JSON record splitting is enabled, try to split the message */
     if (inst->bSplitJsonRecords) {
-        rsRetVal split_ret = splitJsonRecords(inst, rkmessage);
+        rsRetVal split_ret = splitJsonRecords(inst, pMultiSub, rkmessage);
         if (split_ret == RS_RET_OK) {
             /* Successfully split and submitted all records */
             FINALIZE;
@@ -592,7 +629,7 @@ static rsRetVal enqMsg(instanceConf_t *const __restrict__ inst, rd_kafka_message
         MsgSetTAG(pMsg, (const uchar *)rkmessage->key, (int)rkmessage->key_len);
     }
     MsgSetMSGoffs(pMsg, 0); /* we do not have a header... */
-    CHKiRet(submitMsg2(pMsg));
+    CHKiRet(addToBatch(pMultiSub, pMsg));
 
     /* submitted successfully */
     STATSCOUNTER_INC(ctrSubmitted, mutCtrSubmitted);
@@ -601,87 +638,237 @@ finalize_it:
     RETiRet;
 }
 
-/**
- * Handle Kafka Consumer Loop until all msgs are processed
+/* check a single kafka message of a poll burst. Returns 1 if it carries
+ * a payload which must be submitted, 0 if it was a status or error event.
  */
-static void msgConsume(instanceConf_t *inst) {
-    rd_kafka_message_t *rkmessage = NULL;
-
-    do { /* Consume messages */
-        rkmessage = rd_kafka_consumer_poll(inst->rk, 1000); /* Block for 1000 ms max */
-        if (rkmessage == NULL) {
-            DBGPRINTF("imkafka: msgConsume EMPTY Loop on group %s/%s\n", inst->consumergroup, inst->brokers);
-            /* poll returned nothing */
-            STATSCOUNTER_INC(ctrPollEmpty, mutCtrPollEmpty);
-            INST_STATSCOUNTER_INC(inst, inst->ctrPollEmpty, inst->mutCtrPollEmpty);
-            goto done;
+static int checkConsumedMsg(kafkaConsumer_t *const consumer, rd_kafka_message_t *const rkmessage) {
+    instanceConf_t *const inst = consumer->inst;
+
+    if (rkmessage->err) {
+        if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF) {
+            /* not an error, just a regular status! */
+            DBGPRINTF("imkafka: Consumer reached end of topic \"%s\" [%" PRId32 "] message queue offset %" PRId64
+                      "\n",
+                      rd_kafka_topic_name(rkmessage->rkt), rkmessage->partition, rkmessage->offset);
+            STATSCOUNTER_INC(ctrEOF, mutCtrEOF);
+            INST_STATSCOUNTER_INC(inst, inst->ctrEOF, inst->mutCtrEOF);
+            return 0;
         }
-
-        if (rkmessage->err) {
-            if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF) {
-                /* not an error, just a regular status! */
-                DBGPRINTF("imkafka: Consumer reached end of topic \"%s\" [%" PRId32 "] message queue offset %" PRId64
-                          "\n",
-                          rd_kafka_topic_name(rkmessage->rkt), rkmessage->partition, rkmessage->offset);
-                STATSCOUNTER_INC(ctrEOF, mutCtrEOF);
-                INST_STATSCOUNTER_INC(inst, inst->ctrEOF, inst->mutCtrEOF);
-                goto done;
-            }
-            if (rkmessage->rkt) {
-                LogError(0, RS_RET_KAFKA_ERROR,
-                         "imkafka: Consumer error for topic \"%s\" [%" PRId32 "] message queue offset %" PRId64
-                         ": %s\n",
-                         rd_kafka_topic_name(rkmessage->rkt), rkmessage->partition, rkmessage->offset,
-                         rd_kafka_message_errstr(rkmessage));
-            } else {
-                LogError(0, RS_RET_KAFKA_ERROR, "imkafka: Consumer error for topic \"%s\": \"%s\"\n",
-                         rd_kafka_err2str(rkmessage->err), rd_kafka_message_errstr(rkmessage));
-            }
-            STATSCOUNTER_INC(ctrKafkaFail, mutCtrKafkaFail);
-            INST_STATSCOUNTER_INC(inst, inst->ctrKafkaFail, inst->mutCtrKafkaFail);
-            goto done;
+        if (rkmessage->rkt) {
+            LogError(0, RS_RET_KAFKA_ERROR,
+                     "imkafka: Consumer error for topic \"%s\" [%" PRId32 "] message queue offset %" PRId64 ": %s\n",
+                     rd_kafka_topic_name(rkmessage->rkt), rkmessage->partition, rkmessage->offset,
+                     rd_kafka_message_errstr(rkmessage));
+        } else {
+            LogError(0, RS_RET_KAFKA_ERROR, "imkafka: Consumer error for topic \"%s\": \"%s\"\n",
+                     rd_kafka_err2str(rkmessage->err), rd_kafka_message_errstr(rkmessage));
         }
+        STATSCOUNTER_INC(ctrKafkaFail, mutCtrKafkaFail);
+        INST_STATSCOUNTER_INC(inst, inst->ctrKafkaFail, inst->mutCtrKafkaFail);
+        return 0;
+    }
 
-        DBGPRINTF("imkafka: msgConsume Loop on %s/%s/%s: [%" PRId32 "], offset %" PRId64 ", %zd bytes):\n",
-                  rd_kafka_topic_name(rkmessage->rkt), inst->consumergroup, inst->brokers, rkmessage->partition,
-                  rkmessage->offset, rkmessage->len);
+    DBGPRINTF("imkafka: msgConsume Loop on %s/%s/%s: [%" PRId32 "], offset %" PRId64 ", %zd bytes):\n",
+              rd_kafka_topic_name(rkmessage->rkt), inst->consumergroup, inst->brokers, rkmessage->partition,
+              rkmessage->offset, rkmessage->len);
+
+    /* message received */
+    STATSCOUNTER_INC(ctrReceived, mutCtrReceived);
+    INST_STATSCOUNTER_INC(inst, inst->ctrReceived, inst->mutCtrReceived);
+
+    /* compute consumer lag and track max via watermarks (high - current - 1) */
+    if (rkmessage->rkt) {
+        int64_t lo = 0, hi = 0;
+        const char *tname = rd_kafka_topic_name(rkmessage->rkt);
+        if (rd_kafka_get_watermark_offsets(consumer->rk, tname, rkmessage->partition, &lo, &hi) ==
+            RD_KAFKA_RESP_ERR_NO_ERROR) {
+            int64_t lag = hi - rkmessage->offset - 1;
+            if (lag < 0) lag = 0;
+            STATSCOUNTER_SETMAX_NOMUT(ctrMaxLag, (uint64_t)lag);
+            INST_STATSCOUNTER_SETMAX(inst, inst->ctrMaxLag, lag);
+        }
+    }
+    return 1;
+}
 
-        /* message received */
-        STATSCOUNTER_INC(ctrReceived, mutCtrReceived);
-        INST_STATSCOUNTER_INC(inst, inst->ctrReceived, inst->mutCtrReceived);
+/* store the offsets of all payload messages of a burst, so that the next
+ * (auto) commit covers them. Only called once the rsyslog core accepted
+ * the whole burst.
+ */
+static void storeBurstOffsets(kafkaConsumer_t *const consumer, const int nMsgs) {
+    for (int i = 0; i < nMsgs; ++i) {
+        rd_kafka_message_t *const rkmessage = consumer->rkmessages[i];
+        if (rkmessage->err || rkmessage->rkt == NULL) {
+            continue;
+        }
+        const rd_kafka_resp_err_t err = rd_kafka_offset_store(rkmessage->rkt, rkmessage->partition, rkmessage->offset);
+        if (err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+            /* e.g. partition was revoked meanwhile - the new owner re-reads it */
+            DBGPRINTF("imkafka: could not store offset %" PRId64 " for \"%s\" [%" PRId32 "]: %s\n",
+                      rkmessage->offset, rd_kafka_topic_name(rkmessage->rkt), rkmessage->partition,
+                      rd_kafka_err2str(err));
+        }
+    }
+}
 
-        /* compute consumer lag and track max via watermarks (high - current - 1) */
-        if (rkmessage->rkt) {
-            int64_t lo = 0, hi = 0;
-            const char *tname = rd_kafka_topic_name(rkmessage->rkt);
-            if (rd_kafka_get_watermark_offsets(inst->rk, tname, rkmessage->partition, &lo, &hi) ==
-                RD_KAFKA_RESP_ERR_NO_ERROR) {
-                int64_t lag = hi - rkmessage->offset - 1;
-                if (lag < 0) lag = 0;
-                STATSCOUNTER_SETMAX_NOMUT(ctrMaxLag, (uint64_t)lag);
-                INST_STATSCOUNTER_SETMAX(inst, inst->ctrMaxLag, lag);
+/* seek the partitions of a failed burst back to their first offset in that
+ * burst. Returns 1 if no seek is pending anymore. Partitions which can not be
+ * sought because they are no longer assigned to us are dropped, their new
+ * owner re-reads them from the last committed offset.
+ */
+static int seekRewind(kafkaConsumer_t *const consumer) {
+    rd_kafka_topic_partition_list_t *const rewind = consumer->rewind;
+    int bPending = 0;
+
+    if (rewind == NULL) return 1;
+#if RD_KAFKA_VERSION >= 0x010600ff
+    rd_kafka_error_t *const error = rd_kafka_seek_partitions(consumer->rk, rewind, 1000);
+    if (error != NULL) {
+        DBGPRINTF("imkafka: seek after failed burst failed: %s\n", rd_kafka_error_string(error));
+        rd_kafka_error_destroy(error);
+        return 0;
+    }
+#else
+    for (int i = 0; i < rewind->cnt; ++i) {
+        rd_kafka_topic_t *const rkt = rd_kafka_topic_new(consumer->rk, rewind->elems[i].topic, NULL);
+        if (rkt == NULL) {
+            rewind->elems[i].err = rd_kafka_last_error();
+            continue;
+        }
+        rewind->elems[i].err = rd_kafka_seek(rkt, rewind->elems[i].partition, rewind->elems[i].offset, 1000);
+        rd_kafka_topic_destroy(rkt);
+    }
+#endif
+    for (int i = 0; i < rewind->cnt; ++i) {
+        rd_kafka_topic_partition_t *const elem = &rewind->elems[i];
+        if (elem->err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+            DBGPRINTF("imkafka: rewound \"%s\" [%" PRId32 "] to offset %" PRId64 " after failed burst\n",
+                      elem->topic, elem->partition, elem->offset);
+            elem->offset = RD_KAFKA_OFFSET_INVALID;
+        } else if (elem->err == RD_KAFKA_RESP_ERR__TIMED_OUT) {
+            bPending = 1;
+        } else {
+            LogError(0, RS_RET_KAFKA_ERROR,
+                     "imkafka: could not rewind topic \"%s\" [%" PRId32 "] to offset %" PRId64
+                     " after a failed submission: %s",
+                     elem->topic, elem->partition, elem->offset, rd_kafka_err2str(elem->err));
+            elem->offset = RD_KAFKA_OFFSET_INVALID;
+        }
+    }
+    if (bPending) {
+        /* only retry the partitions which timed out */
+        for (int i = 0; i < rewind->cnt; ++i) {
+            if (rewind->elems[i].offset == RD_KAFKA_OFFSET_INVALID) {
+                rd_kafka_topic_partition_list_del_by_idx(rewind, i--);
             }
         }
+        return 0;
+    }
+    rd_kafka_topic_partition_list_destroy(rewind);
+    consumer->rewind = NULL;
+    return 1;
+}
+
+/* a burst was not (completely) accepted by the rsyslog core. Its offsets are
+ * not stored, but librdkafka would hand out the following messages anyway and
+ * their offsets would cover the lost ones. So we seek every partition of the
+ * burst back to its first message in it. Messages of the burst that were
+ * accepted are delivered once more, which is in line with at-least-once.
+ */
+static void rewindBurst(kafkaConsumer_t *const consumer, const int nMsgs) {
+    rd_kafka_topic_partition_t *elem;
+
+    if (consumer->rewind == NULL && (consumer->rewind = rd_kafka_topic_partition_list_new(4)) == NULL) {
+        return;
+    }
+    for (int i = 0; i < nMsgs; ++i) {
+        rd_kafka_message_t *const rkmessage = consumer->rkmessages[i];
+        if (rkmessage->err || rkmessage->rkt == NULL) {
+            continue;
+        }
+        const char *const topic = rd_kafka_topic_name(rkmessage->rkt);
+        elem = rd_kafka_topic_partition_list_find(consumer->rewind, topic, rkmessage->partition);
+        if (elem == NULL) {
+            elem = rd_kafka_topic_partition_list_add(consumer->rewind, topic, rkmessage->partition);
+            elem->offset = rkmessage->offset;
+        } else if (rkmessage->offset < elem->offset) {
+            elem->offset = rkmessage->offset;
+        }
+    }
+    seekRewind(consumer);
+}
+
+/**
+ * Fetch one burst of kafka messages and hand them to the rsyslog core.
+ *
+ * The first poll blocks for up to one second; once a message arrived, the
+ * consumer queue is drained without waiting until batchsize messages are
+ * collected. That keeps latency low at light load while amortizing the
+ * enqueue cost via multiSubmitMsg2() under heavy load. If
+ * offset.storeAfterSubmit is enabled, offsets are stored only after the
+ * complete burst was accepted by the rsyslog core. A burst that was not
+ * accepted is re-consumed (see rewindBurst()) before anything else.
+ */
+static void msgConsume(kafkaConsumer_t *const consumer) {
+    instanceConf_t *const inst = consumer->inst;
+    smsg_t *pMsgs[CONF_NUM_MULTISUB];
+    multi_submit_t multiSub;
+    int nMsgs = 0;
+    int bSubmitFailed = 0;
+
+    multiSub.ppMsgs = pMsgs;
+    multiSub.maxElem = CONF_NUM_MULTISUB;
+    multiSub.nElem = 0;
+
+    if (!seekRewind(consumer)) {
+        /* do not consume (and store) anything past messages we failed to submit */
+        return;
+    }
 
+    rd_kafka_message_t *rkmessage = rd_kafka_consumer_poll(consumer->rk, 1000); /* Block for 1000 ms max */
+    if (rkmessage == NULL) {
+        DBGPRINTF("imkafka: msgConsume EMPTY Loop on group %s/%s\n", inst->consumergroup, inst->brokers);
+        /* poll returned nothing */
+        STATSCOUNTER_INC(ctrPollEmpty, mutCtrPollEmpty);
+        INST_STATSCOUNTER_INC(inst, inst->ctrPollEmpty, inst->mutCtrPollEmpty);
+        return;
+    }
+    consumer->rkmessages[nMsgs++] = rkmessage;
+    while (nMsgs < inst->batchSize && (rkmessage = rd_kafka_consumer_poll(consumer->rk, 0)) != NULL) {
+        consumer->rkmessages[nMsgs++] = rkmessage;
+    }
+    DBGPRINTF("imkafka: msgConsume fetched burst of %d messages\n", nMsgs);
+
+    for (int i = 0; i < nMsgs; ++i) {
+        rkmessage = consumer->rkmessages[i];
+        if (!checkConsumedMsg(consumer, rkmessage)) {
+            continue;
+        }
         /* Hand off into rsyslog core */
-        {
-            rsRetVal __er = enqMsg(inst, rkmessage);
-            if (__er != RS_RET_OK) {
-                STATSCOUNTER_INC(ctrKafkaFail, mutCtrKafkaFail);
-                INST_STATSCOUNTER_INC(inst, inst->ctrKafkaFail, inst->mutCtrKafkaFail);
-            }
+        if (enqMsg(inst, &multiSub, rkmessage) != RS_RET_OK) {
+            bSubmitFailed = 1;
+            STATSCOUNTER_INC(ctrKafkaFail, mutCtrKafkaFail);
+            INST_STATSCOUNTER_INC(inst, inst->ctrKafkaFail, inst->mutCtrKafkaFail);
+        }
+    }
+    if (multiSubmitFlush(&multiSub) != RS_RET_OK) {
+        bSubmitFailed = 1;
+        STATSCOUNTER_INC(ctrKafkaFail, mutCtrKafkaFail);
+        INST_STATSCOUNTER_INC(inst, inst->ctrKafkaFail, inst->mutCtrKafkaFail);
+    }
+
+    if (inst->bStoreOffsetAfterSubmit) {
+        if (bSubmitFailed) {
+            rewindBurst(consumer, nMsgs);
+        } else {
+            storeBurstOffsets(consumer, nMsgs);
         }
+    }
 
-        /* Destroy message and continue */
-        rd_kafka_message_destroy(rkmessage);
-        rkmessage = NULL;
-    } while (1); /* loop broken inside */
-done:
-    /* Destroy message in case rkmessage->err was set */
-    if (rkmessage != NULL) {
-        rd_kafka_message_destroy(rkmessage);
+    for (int i = 0; i < nMsgs; ++i) {
+        rd_kafka_message_destroy(consumer->rkmessages[i]);
+        consumer->rkmessages[i] = NULL;
     }
-    return;
 }
 
 /* create input instance, set default parameters, and
@@ -703,11 +890,12 @@ static rsRetVal createInstance(instanceConf_t **pinst) {
     inst->bReportErrs = 1; /* Fixed for now */
     inst->nMsgParsingFlags = NEEDS_PARSING;
     inst->bSplitJsonRecords = 0; /* disabled by default */
-    inst->bIsConnected = 0;
-    inst->bIsSubscribed = 0;
+    inst->batchSize = IMKAFKA_DFLT_BATCHSIZE;
+    inst->nConsumers = 1;
+    inst->bStoreOffsetAfterSubmit = 0;
+    inst->consumers = NULL;
     /* Kafka objects */
     inst->conf = NULL;
-    inst->rk = NULL;
     inst->topic_conf = NULL;
     inst->partition = RD_KAFKA_PARTITION_UA;
     /* stats */
@@ -724,6 +912,63 @@ finalize_it:
     RETiRet;
 }
 
+static void destroyConsumer(kafkaConsumer_t *const consumer) {
+    if (consumer->rk != NULL) {
+        rd_kafka_destroy(consumer->rk);
+        consumer->rk = NULL;
+    }
+    free(consumer->rkmessages);
+    consumer->rkmessages = NULL;
+    if (consumer->rewind != NULL) {
+        rd_kafka_topic_partition_list_destroy(consumer->rewind);
+        consumer->rewind = NULL;
+    }
+    consumer->bIsConnected = 0;
+    consumer->bIsSubscribed = 0;
+}
+
+/* create one consumer handle from the instance's configuration template */
+static rsRetVal ATTR_NONNULL() createConsumer(instanceConf_t *const inst, kafkaConsumer_t *const consumer) {
+    DEFiRet;
+    char kafkaErrMsg[1024];
+    rd_kafka_conf_t *conf = NULL;
+
+    consumer->inst = inst;
+    CHKmalloc(consumer->rkmessages = calloc(inst->batchSize, sizeof(rd_kafka_message_t *)));
+    CHKmalloc(conf = rd_kafka_conf_dup(inst->conf));
+
+    consumer->rk = rd_kafka_new(RD_KAFKA_CONSUMER, conf, kafkaErrMsg, sizeof(kafkaErrMsg));
+    if (consumer->rk == NULL) {
+        if (inst->bReportErrs) {
+            LogError(0, RS_RET_KAFKA_ERROR, "imkafka: error creating kafka handle: %s\n", kafkaErrMsg);
+        }
+        ABORT_FINALIZE(RS_RET_KAFKA_ERROR);
+    }
+    conf = NULL; /* now owned by consumer->rk */
+
+#if RD_KAFKA_VERSION < 0x00090001
+    rd_kafka_set_logger(consumer->rk, kafkaLogger);
+#endif
+    DBGPRINTF("imkafka: setting brokers: '%s'\n", inst->brokers);
+    if (rd_kafka_brokers_add(consumer->rk, (char *)inst->brokers) == 0) {
+        if (inst->bReportErrs) {
+            LogError(0, RS_RET_KAFKA_NO_VALID_BROKERS, "imkafka: no valid brokers specified: %s", inst->brokers);
+        }
+        ABORT_FINALIZE(RS_RET_KAFKA_NO_VALID_BROKERS);
+    }
+
+    /* Kafka Consumer is opened */
+    consumer->bIsConnected = 1;
+finalize_it:
+    if (conf != NULL) {
+        rd_kafka_conf_destroy(conf);
+    }
+    if (iRet != RS_RET_OK) {
+        destroyConsumer(consumer);
+    }
+    RETiRet;
+}
+
 /* this function checks instance parameters and does some required pre-processing */
 static rsRetVal ATTR_NONNULL() checkInstance(instanceConf_t *const inst) {
     DEFiRet;
@@ -766,6 +1011,15 @@ static rsRetVal ATTR_NONNULL() checkInstance(instanceConf_t *const inst) {
         }
     }
 
+    if (inst->bStoreOffsetAfterSubmit) {
+        /* offsets are stored explicitly once the core accepted a burst */
+        if (rd_kafka_conf_set(inst->conf, "enable.auto.offset.store", "false", kafkaErrMsg, sizeof(kafkaErrMsg)) !=
+            RD_KAFKA_CONF_OK) {
+            LogError(0, RS_RET_KAFKA_ERROR, "imkafka: error disabling enable.auto.offset.store: %s", kafkaErrMsg);
+            ABORT_FINALIZE(RS_RET_KAFKA_ERROR);
+        }
+    }
+
     /* Topic configuration */
     inst->topic_conf = rd_kafka_topic_conf_new();
 
@@ -813,39 +1067,25 @@ static rsRetVal ATTR_NONNULL() checkInstance(instanceConf_t *const inst) {
     rd_kafka_conf_set_error_cb(inst->conf, errorCallback);
     rd_kafka_conf_set_stats_cb(inst->conf, statsCallback);
 
-    /* Create Kafka Consumer */
-    inst->rk = rd_kafka_new(RD_KAFKA_CONSUMER, inst->conf, kafkaErrMsg, sizeof(kafkaErrMsg));
-    if (inst->rk == NULL) {
-        if (inst->bReportErrs) {
-            LogError(0, RS_RET_KAFKA_ERROR, "imkafka: error creating kafka handle: %s\n", kafkaErrMsg);
-        }
-        ABORT_FINALIZE(RS_RET_KAFKA_ERROR);
-    }
-
-#if RD_KAFKA_VERSION < 0x00090001
-    rd_kafka_set_logger(inst->rk, kafkaLogger);
-#endif
-    DBGPRINTF("imkafka: setting brokers: '%s'\n", inst->brokers);
-    if (rd_kafka_brokers_add(inst->rk, (char *)inst->brokers) == 0) {
-        if (inst->bReportErrs) {
-            LogError(0, RS_RET_KAFKA_NO_VALID_BROKERS, "imkafka: no valid brokers specified: %s", inst->brokers);
-        }
-        ABORT_FINALIZE(RS_RET_KAFKA_NO_VALID_BROKERS);
+    /* Create Kafka Consumers; all of them share the configuration and
+     * consumer group, so the broker assigns each a share of the partitions.
+     */
+    CHKmalloc(inst->consumers = calloc(inst->nConsumers, sizeof(kafkaConsumer_t)));
+    for (int i = 0; i < inst->nConsumers; ++i) {
+        CHKiRet(createConsumer(inst, &inst->consumers[i]));
     }
 
-    /* Kafka Consumer is opened */
-    inst->bIsConnected = 1;
 finalize_it:
-    if (iRet != RS_RET_OK) {
-        if (inst->rk == NULL) {
-            if (inst->conf != NULL) {
-                rd_kafka_conf_destroy(inst->conf);
-                inst->conf = NULL;
-            }
-        } else { /* inst->rk != NULL ! */
-            rd_kafka_destroy(inst->rk);
-            inst->rk = NULL;
+    if (inst->conf != NULL) {
+        rd_kafka_conf_destroy(inst->conf);
+        inst->conf = NULL;
+    }
+    if (iRet != RS_RET_OK && inst->consumers != NULL) {
+        for (int i = 0; i < inst->nConsumers; ++i) {
+            destroyConsumer(&inst->consumers[i]);
         }
+        free(inst->consumers);
+        inst->consumers = NULL;
     }
     RETiRet;
 }
@@ -858,10 +1098,12 @@ static inline void std_checkRuleset_genErrMsg(__attribute__((unused)) modConfDat
     }
 }
 
-static rsRetVal ATTR_NONNULL(2) addConsumer(modConfData_t __attribute__((unused)) * modConf, instanceConf_t *inst) {
+static rsRetVal ATTR_NONNULL(2)
+    addConsumer(modConfData_t __attribute__((unused)) * modConf, kafkaConsumer_t *const consumer) {
     DEFiRet;
     rd_kafka_resp_err_t err;
     int i;
+    instanceConf_t *const inst = consumer->inst;
     assert(inst != NULL);
     assert(inst->nTopics > 0);
 
@@ -876,7 +1118,7 @@ static rsRetVal ATTR_NONNULL(2) addConsumer(modConfData_t __attribute__((unused)
     }
 
     /* Redirect rd_kafka_poll() to consumer_poll() */
-    rd_kafka_poll_set_consumer(inst->rk);
+    rd_kafka_poll_set_consumer(consumer->rk);
 
     topics = rd_kafka_topic_partition_list_new(inst->nTopics);
     for (i = 0; i < inst->nTopics; i++) {
@@ -885,9 +1127,9 @@ static rsRetVal ATTR_NONNULL(2) addConsumer(modConfData_t __attribute__((unused)
     }
     DBGPRINTF("imkafka: Created topics list with %d entries\n", topics->cnt);
 
-    if ((err = rd_kafka_subscribe(inst->rk, topics))) {
+    if ((err = rd_kafka_subscribe(consumer->rk, topics))) {
         /* Subscription failed */
-        inst->bIsSubscribed = 0;
+        consumer->bIsSubscribed = 0;
         LogError(0, RS_RET_KAFKA_ERROR, "imkafka: Failed to start consuming topics: %s\n", rd_kafka_err2str(err));
         ABORT_FINALIZE(RS_RET_KAFKA_ERROR);
     } else {
@@ -899,7 +1141,7 @@ static rsRetVal ATTR_NONNULL(2) addConsumer(modConfData_t __attribute__((unused)
                       inst->consumergroup, inst->brokers);
         }
         /* Subscription is working */
-        inst->bIsSubscribed = 1;
+        consumer->bIsSubscribed = 1;
     }
 
 finalize_it:
@@ -1023,6 +1265,12 @@ BEGINnewInpInst
             }
         } else if (!strcmp(inppblk.descr[i].name, "split.json.records")) {
             inst->bSplitJsonRecords = pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "batchsize")) {
+            inst->batchSize = (int)pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "consumer.threads")) {
+            inst->nConsumers = (int)pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "offset.storeaftersubmit")) {
+            inst->bStoreOffsetAfterSubmit = (int)pvals[i].val.d.n;
         } else {
             dbgprintf("imkafka: program error, non-handled param '%s'\n", inppblk.descr[i].name);
         }
@@ -1037,6 +1285,13 @@ BEGINnewInpInst
         LogError(0, RS_RET_MISSING_CNFPARAMS, "imkafka: no topics specified");
         ABORT_FINALIZE(RS_RET_MISSING_CNFPARAMS);
     }
+    if (inst->nConsumers > 1 && inst->consumergroup == NULL) {
+        LogError(0, RS_RET_CONFIG_ERROR,
+                 "imkafka: consumer.threads=\"%d\" requires a consumergroup to distribute "
+                 "partitions - using a single consumer",
+                 inst->nConsumers);
+        inst->nConsumers = 1;
+    }
     DBGPRINTF("imkafka: newInpIns brokers=%s, topics=%d, consumergroup=%s\n", inst->brokers, inst->nTopics,
               inst->consumergroup);
 finalize_it:
@@ -1161,6 +1416,12 @@ BEGINfreeCnf
             free((void *)inst->confParams[i].val);
         }
         free((void *)inst->confParams);
+        if (inst->consumers != NULL) {
+            for (int i = 0; i < inst->nConsumers; i++) {
+                destroyConsumer(&inst->consumers[i]);
+            }
+            free(inst->consumers);
+        }
         del = inst;
         inst = inst->next;
         free(del);
@@ -1184,7 +1445,7 @@ static void shutdownKafkaWorkers(void) {
     kafkaWrkrInfo = NULL;
 
     for (inst = runModConf->root; inst != NULL; inst = inst->next) {
-        if (inst->rk == NULL) {
+        if (inst->consumers == NULL) {
             continue;
         }
         if (inst->nTopics == 1) {
@@ -1192,11 +1453,14 @@ static void shutdownKafkaWorkers(void) {
         } else {
             DBGPRINTF("imkafka: stop consuming %d topics/%s/%s\n", inst->nTopics, inst->consumergroup, inst->brokers);
         }
-        rd_kafka_consumer_close(inst->rk); /* Close the consumer, committing final offsets, etc. */
-        rd_kafka_destroy(inst->rk); /* Destroy handle object */
-        inst->rk = NULL;
-        inst->bIsConnected = 0;
-        inst->bIsSubscribed = 0;
+        for (i = 0; i < inst->nConsumers; ++i) {
+            kafkaConsumer_t *const consumer = &inst->consumers[i];
+            if (consumer->rk == NULL) {
+                continue;
+            }
+            rd_kafka_consumer_close(consumer->rk); /* Close the consumer, committing final offsets, etc. */
+            destroyConsumer(consumer); /* Destroy handle object */
+        }
         if (inst->nTopics == 1) {
             DBGPRINTF("imkafka: stopped consuming %s/%s/%s\n", inst->topics[0], inst->consumergroup, inst->brokers);
         } else {
@@ -1224,8 +1488,8 @@ BEGINrunInput
     activeKafkaworkers = 0;
     ATOMIC_STORE_32BIT(&stopKafkaWorkers, &mutStopImkafkaWorkers, 0);
     for (inst = runModConf->root; inst != NULL; inst = inst->next) {
-        if (inst->rk != NULL) {
-            ++workerSlots;
+        if (inst->consumers != NULL) {
+            workerSlots += inst->nConsumers;
         }
     }
     if (workerSlots == 0) {
@@ -1240,22 +1504,24 @@ BEGINrunInput
         LogError(errno, RS_RET_OUT_OF_MEMORY, "imkafka: worker-info array allocation failed.");
         ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
     }
-    /* Start worker threads for each imkafka input source */
+    /* Start one worker thread for each consumer of each imkafka input source */
     i = 0;
     for (inst = runModConf->root; inst != NULL; inst = inst->next) {
-        if (inst->rk == NULL) {
+        if (inst->consumers == NULL) {
             continue;
         }
-        /* init worker info structure! */
-        kafkaWrkrInfo[i].inst = inst; /* Set reference pointer */
-        int r = pthread_create(&kafkaWrkrInfo[i].tid, &wrkrThrdAttr, imkafkawrkr, &(kafkaWrkrInfo[i]));
-        if (r != 0) {
-            activeKafkaworkers = i;
-            LogError(r, RS_RET_ERR, "imkafka: failed to start worker thread %d", i);
-            shutdownKafkaWorkers();
-            ABORT_FINALIZE(RS_RET_ERR);
+        for (int j = 0; j < inst->nConsumers; ++j) {
+            /* init worker info structure! */
+            kafkaWrkrInfo[i].consumer = &inst->consumers[j]; /* Set reference pointer */
+            int r = pthread_create(&kafkaWrkrInfo[i].tid, &wrkrThrdAttr, imkafkawrkr, &(kafkaWrkrInfo[i]));
+            if (r != 0) {
+                activeKafkaworkers = i;
+                LogError(r, RS_RET_ERR, "imkafka: failed to start worker thread %d", i);
+                shutdownKafkaWorkers();
+                ABORT_FINALIZE(RS_RET_ERR);
+            }
+            i++;
         }
-        i++;
     }
     activeKafkaworkers = i;
     while (glbl.GetGlobalInputTermState() == 0) {
@@ -1392,21 +1658,23 @@ ENDmodInit
  */
 static void *imkafkawrkr(void *myself) {
     struct kafkaWrkrInfo_s *me = (struct kafkaWrkrInfo_s *)myself;
-    DBGPRINTF("imkafka: started kafka consumer workerthread on group %s/%s with %d topics\n", me->inst->consumergroup,
-              me->inst->brokers, me->inst->nTopics);
+    kafkaConsumer_t *const consumer = me->consumer;
+    const instanceConf_t *const inst = consumer->inst;
+    DBGPRINTF("imkafka: started kafka consumer workerthread on group %s/%s with %d topics\n", inst->consumergroup,
+              inst->brokers, inst->nTopics);
     do {
         if (ATOMIC_LOAD_32BIT(&stopKafkaWorkers, &mutStopImkafkaWorkers) || glbl.GetGlobalInputTermState() == 1) {
             break; /* terminate input! */
         }
-        if (me->inst->rk == NULL) {
+        if (consumer->rk == NULL) {
             continue;
         }
         // Try to add consumer only if connected!
-        if (me->inst->bIsConnected == 1 && me->inst->bIsSubscribed == 0) {
-            addConsumer(runModConf, me->inst);
+        if (consumer->bIsConnected == 1 && consumer->bIsSubscribed == 0) {
+            addConsumer(runModConf, consumer);
         }
-        if (me->inst->bIsSubscribed == 1) {
-            msgConsume(me->inst);
+        if (consumer->bIsSubscribed == 1) {
+            msgConsume(consumer);
         }
         /* Note: the additional 10000ns wait is vitally important. It guards rsyslog
          * against totally hogging the CPU if the users selects a polling interval
@@ -1417,7 +1685,7 @@ static void *imkafkawrkr(void *myself) {
             srSleep(0, 100000);
         }
     } while (!ATOMIC_LOAD_32BIT(&stopKafkaWorkers, &mutStopImkafkaWorkers) && glbl.GetGlobalInputTermState() == 0);
-    DBGPRINTF("imkafka: stopped kafka consumer workerthread on group %s/%s with %d topics\n", me->inst->consumergroup,
-              me->inst->brokers, me->inst->nTopics);
+    DBGPRINTF("imkafka: stopped kafka consumer workerthread on group %s/%s with %d topics\n", inst->consumergroup,
+              inst->brokers, inst->nTopics);
     return NULL;
 }
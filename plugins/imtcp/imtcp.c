@@ -95,6 +95,8 @@ static permittedPeers_t *pPermPeersRoot = NULL;
  */
 #define DEFAULT_NUMWRKR 2
 #define DEFAULT_STARVATIONMAXREADS 500
+#define DEFAULT_NUMHSWRKR 0 /* no dedicated handshake workers */
+#define DEFAULT_HSMAXPENDING 0 /* unlimited */
 
 #define FRAMING_UNSET -1
 
@@ -177,6 +179,8 @@ struct instanceConf_s {
     int iKeepAliveProbes;
     int iKeepAliveTime;
     unsigned starvationMaxReads;
+    unsigned numHsWrkr; /* handshake.workerthreads */
+    unsigned hsMaxPending; /* handshake.maxpending */
     int compressionMode;
     int compressionDriver;
     uint64_t compressionMaxExpansionRatio;
@@ -227,6 +231,8 @@ struct modConfData_s {
     sbool configSetViaV2Method;
     sbool bPreserveCase; /* preserve case of fromhost; true by default */
     unsigned starvationMaxReads;
+    unsigned numHsWrkr; /* handshake.workerthreads */
+    unsigned hsMaxPending; /* handshake.maxpending */
     int compressionMode;
     int compressionDriver;
     uint64_t compressionMaxExpansionRatio;
@@ -252,6 +258,8 @@ static struct cnfparamdescr modpdescr[] = {{"flowcontrol", eCmdHdlrBinary, 0},
                                            {"maxlisteners", eCmdHdlrPositiveInt, 0},
                                            {"workerthreads", eCmdHdlrPositiveInt, 0},
                                            {"starvationprotection.maxreads", eCmdHdlrNonNegInt, 0},
+                                           {"handshake.workerthreads", eCmdHdlrNonNegInt, 0},
+                                           {"handshake.maxpending", eCmdHdlrNonNegInt, 0},
                                            {"streamdriver.mode", eCmdHdlrNonNegInt, 0},
                                            {"streamdriver.authmode", eCmdHdlrString, 0},
                                            {"streamdriver.permitexpiredcerts", eCmdHdlrString, 0},
@@ -299,6 +307,8 @@ static struct cnfparamdescr inppdescr[] = {{"port", eCmdHdlrString, CNFPARAM_REQ
                                            {"defaulttz", eCmdHdlrString, 0},
                                            {"ruleset", eCmdHdlrString, 0},
                                            {"starvationprotection.maxreads", eCmdHdlrNonNegInt, 0},
+                                           {"handshake.workerthreads", eCmdHdlrNonNegInt, 0},
+                                           {"handshake.maxpending", eCmdHdlrNonNegInt, 0},
                                            {"streamdriver.mode", eCmdHdlrNonNegInt, 0},
                                            {"streamdriver.authmode", eCmdHdlrString, 0},
                                            {"streamdriver.permitexpiredcerts", eCmdHdlrString, 0},
@@ -655,6 +665,8 @@ static rsRetVal createInstance(instanceConf_t **pinst) {
     inst->iTCPSessMax = loadModConf->iTCPSessMax;
     inst->numWrkr = loadModConf->numWrkr;
     inst->starvationMaxReads = loadModConf->starvationMaxReads;
+    inst->numHsWrkr = loadModConf->numHsWrkr;
+    inst->hsMaxPending = loadModConf->hsMaxPending;
     inst->compressionMode = loadModConf->compressionMode;
     inst->compressionDriver = loadModConf->compressionDriver;
     inst->compressionMaxExpansionRatio = loadModConf->compressionMaxExpansionRatio;
@@ -736,6 +748,8 @@ static rsRetVal addInstance(void __attribute__((unused)) * pVal, uchar *pNewVal)
     inst->iTCPSessMax = cs.iTCPSessMax;
     inst->numWrkr = DEFAULT_NUMWRKR;
     inst->starvationMaxReads = DEFAULT_STARVATIONMAXREADS;
+    inst->numHsWrkr = DEFAULT_NUMHSWRKR;
+    inst->hsMaxPending = DEFAULT_HSMAXPENDING;
     inst->compressionMode = cs.compressionMode;
     inst->compressionDriver = cs.compressionDriver;
     inst->compressionMaxExpansionRatio = cs.compressionMaxExpansionRatio;
@@ -770,6 +784,8 @@ static rsRetVal addListner(modConfData_t *modConf, instanceConf_t *inst) {
     /* params */
     CHKiRet(tcpsrv.SetNumWrkr(pOurTcpsrv, inst->numWrkr));
     CHKiRet(tcpsrv.SetStarvationMaxReads(pOurTcpsrv, inst->starvationMaxReads));
+    CHKiRet(tcpsrv.SetNumHandshakeWrkr(pOurTcpsrv, inst->numHsWrkr));
+    CHKiRet(tcpsrv.SetHandshakeMaxPending(pOurTcpsrv, inst->hsMaxPending));
     CHKiRet(tcpsrv.SetKeepAlive(pOurTcpsrv, inst->bKeepAlive));
     CHKiRet(tcpsrv.SetKeepAliveIntvl(pOurTcpsrv, inst->iKeepAliveIntvl));
     CHKiRet(tcpsrv.SetKeepAliveProbes(pOurTcpsrv, inst->iKeepAliveProbes));
@@ -954,6 +970,10 @@ BEGINnewInpInst
             CHKmalloc(inst->pszStrmDrvrName = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL));
         } else if (!strcmp(inppblk.descr[i].name, "starvationprotection.maxreads")) {
             inst->starvationMaxReads = (unsigned)pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "handshake.workerthreads")) {
+            inst->numHsWrkr = (unsigned)pvals[i].val.d.n;
+        } else if (!strcmp(inppblk.descr[i].name, "handshake.maxpending")) {
+            inst->hsMaxPending = (unsigned)pvals[i].val.d.n;
         } else if (!strcmp(inppblk.descr[i].name, "gnutlsprioritystring")) {
             CHKmalloc(inst->gnutlsPriorityString = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL));
         } else if (!strcmp(inppblk.descr[i].name, "permittedpeer")) {
@@ -1077,6 +1097,8 @@ BEGINbeginCnfLoad
     loadModConf->iTCPLstnMax = 20;
     loadModConf->numWrkr = DEFAULT_NUMWRKR;
     loadModConf->starvationMaxReads = DEFAULT_STARVATIONMAXREADS;
+    loadModConf->numHsWrkr = DEFAULT_NUMHSWRKR;
+    loadModConf->hsMaxPending = DEFAULT_HSMAXPENDING;
     loadModConf->bSuppOctetFram = 1;
     loadModConf->iStrmDrvrMode = 0;
     loadModConf->bStrmDrvrModeSet = 0;
@@ -1163,6 +1185,10 @@ BEGINsetModCnf
             loadModConf->iTCPSessMax = (int)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "starvationprotection.maxreads")) {
             loadModConf->starvationMaxReads = (unsigned)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "handshake.workerthreads")) {
+            loadModConf->numHsWrkr = (unsigned)pvals[i].val.d.n;
+        } else if (!strcmp(modpblk.descr[i].name, "handshake.maxpending")) {
+            loadModConf->hsMaxPending = (unsigned)pvals[i].val.d.n;
         } else if (!strcmp(modpblk.descr[i].name, "maxlisteners") ||
                    !strcmp(modpblk.descr[i].name, "maxlistners")) { /* keep old name for a while */
             loadModConf->iTCPLstnMax = (int)pvals[i].val.d.n;
@@ -35,6 +35,9 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <json.h>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
 
 #include "rsyslog.h"
 #include "conf.h"
@@ -73,12 +76,15 @@ typedef struct _instanceData {
     parse_mode_t mode; /**< parsing mode: cookie or find-json */
     int max_scan_bytes; /**< max bytes to scan in find-json mode */
     sbool allow_trailing; /**< allow trailing data after JSON in find-json mode */
+    sbool bLazy; /**< defer building the $! tree until it is needed */
     /* TODO: add start_regex support in future enhancement */
 } instanceData;
 
 typedef struct wrkrInstanceData {
     instanceData *pData;
     struct json_tokener *tokener;
+    uchar *fastBuf; /* unescape buffer for the fast-path builder */
+    size_t lenFastBuf;
     /* Statistics counters - manually expanded from STATSCOUNTER_DEF */
     intctr_t ctrScanAttempted;
     DEF_ATOMIC_HELPER_MUT64(mutCtrScanAttempted);
@@ -101,7 +107,8 @@ static modConfData_t *runModConf = NULL; /* modConf ptr to use for the current e
 /* action (instance) parameters */
 static struct cnfparamdescr actpdescr[] = {
     {"cookie", eCmdHdlrString, 0}, {"container", eCmdHdlrString, 0},           {"userawmsg", eCmdHdlrBinary, 0},
-    {"mode", eCmdHdlrString, 0},   {"max_scan_bytes", eCmdHdlrPositiveInt, 0}, {"allow_trailing", eCmdHdlrBinary, 0}};
+    {"mode", eCmdHdlrString, 0},   {"max_scan_bytes", eCmdHdlrPositiveInt, 0}, {"allow_trailing", eCmdHdlrBinary, 0},
+    {"lazy", eCmdHdlrBinary, 0}};
 static struct cnfparamblk actpblk = {CNFPARAMBLK_VERSION, sizeof(actpdescr) / sizeof(struct cnfparamdescr), actpdescr};
 
 
@@ -188,6 +195,7 @@ ENDfreeInstance
 BEGINfreeWrkrInstance
     CODESTARTfreeWrkrInstance;
     if (pWrkrData->tokener != NULL) json_tokener_free(pWrkrData->tokener);
+    free(pWrkrData->fastBuf);
     if (pWrkrData->statsobj != NULL) {
         statsobj.Destruct(&pWrkrData->statsobj);
     }
@@ -205,6 +213,816 @@ BEGINtryResume
 ENDtryResume
 
 
+/* Fast-path JSON object builder.
+ *
+ * json_tokener is a byte-at-a-time state machine that copies every string
+ * through a printbuf. Most log producers emit plain, strict JSON, so we
+ * first try a direct recursive-descent builder over the input. Strings are
+ * located with a vectorized scan for the quote, backslash and NUL bytes and
+ * are handed to libfastjson in one piece when they carry no escapes.
+ *
+ * The builder only accepts the strict subset for which it produces exactly
+ * what json_tokener would produce: no comments, single quotes, trailing
+ * commas, \u escapes, floating point numbers, integers that may overflow,
+ * case-insensitive literals or deep nesting. On anything else it returns
+ * JFAST_FALLBACK and the caller retries with json_tokener, so the set of
+ * accepted messages and the resulting trees are unchanged.
+ */
+#define JFAST_OK 0
+#define JFAST_FALLBACK 1
+#define JFAST_MAX_DEPTH 16 /* well below the tokener's default depth limit */
+#define JFAST_MAX_DIGITS 18 /* always fits into int64 */
+
+typedef struct jfast_s {
+    const uchar *p;
+    const uchar *end;
+    uchar **pBuf; /* unescape buffer, grown as needed */
+    size_t *pLenBuf;
+    int depth;
+    unsigned nMembers; /* top-level members, counted by the lazy validator */
+    size_t lenEscaped; /* size of top-level string values with escapes, ditto */
+} jfast_t;
+
+static int jfast_value(jfast_t *const st, struct json_object **const out);
+
+/* return pointer to the first '"', '\\' or NUL in [p, end) or end */
+static const uchar *jfast_scan_string(const uchar *p, const uchar *const end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i zero = _mm_setzero_si128();
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)p);
+        const __m128i hit =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)), _mm_cmpeq_epi8(v, zero));
+        const int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && *p != '\0') ++p;
+    return p;
+}
+
+static void jfast_skip_ws(jfast_t *const st) {
+    while (st->p < st->end && isspace(*st->p)) ++st->p;
+}
+
+static int jfast_buf_reserve(jfast_t *const st, const size_t len) {
+    uchar *newbuf;
+    size_t newlen;
+
+    if (len <= *st->pLenBuf) return JFAST_OK;
+    newlen = (len < 256) ? 256 : len * 2;
+    if ((newbuf = realloc(*st->pBuf, newlen)) == NULL) return JFAST_FALLBACK;
+    *st->pBuf = newbuf;
+    *st->pLenBuf = newlen;
+    return JFAST_OK;
+}
+
+/* Parse a string whose opening quote st->p points to. On success, *str
+ * points either into the input or into the worker's unescape buffer and
+ * is NOT NUL-terminated.
+ */
+static int jfast_string(jfast_t *const st, const char **const str, size_t *const len) {
+    const uchar *const start = ++st->p;
+    const uchar *q = jfast_scan_string(start, st->end);
+    size_t n;
+    uchar *dst;
+
+    if (q == st->end || *q == '\0') return JFAST_FALLBACK;
+    if (*q == '"') {
+        *str = (const char *)start;
+        *len = q - start;
+        st->p = q + 1;
+        return JFAST_OK;
+    }
+
+    /* unescaped size never exceeds the remaining input */
+    if (jfast_buf_reserve(st, st->end - start) != JFAST_OK) return JFAST_FALLBACK;
+    dst = *st->pBuf;
+    n = q - start;
+    memcpy(dst, start, n);
+    while (*q != '"') {
+        /* *q is a backslash here */
+        if (++q == st->end) return JFAST_FALLBACK;
+        switch (*q) {
+            case '"':
+            case '\\':
+            case '/':
+                dst[n++] = *q;
+                break;
+            case 'b':
+                dst[n++] = '\b';
+                break;
+            case 'f':
+                dst[n++] = '\f';
+                break;
+            case 'n':
+                dst[n++] = '\n';
+                break;
+            case 'r':
+                dst[n++] = '\r';
+                break;
+            case 't':
+                dst[n++] = '\t';
+                break;
+            default: /* \u escapes and anything invalid */
+                return JFAST_FALLBACK;
+        }
+        const uchar *const next = jfast_scan_string(++q, st->end);
+        if (next == st->end || *next == '\0') return JFAST_FALLBACK;
+        memcpy(dst + n, q, next - q);
+        n += next - q;
+        q = next;
+    }
+    *str = (const char *)dst;
+    *len = n;
+    st->p = q + 1;
+    return JFAST_OK;
+}
+
+static int jfast_number(jfast_t *const st, struct json_object **const out) {
+    const uchar *p = st->p;
+    int bNeg = 0;
+    int64_t val = 0;
+    int nDigits = 0;
+
+    if (*p == '-') {
+        bNeg = 1;
+        ++p;
+    }
+    while (p < st->end && isdigit(*p)) {
+        if (++nDigits > JFAST_MAX_DIGITS) return JFAST_FALLBACK;
+        val = val * 10 + (*p - '0');
+        ++p;
+    }
+    if (nDigits == 0 || p == st->end) return JFAST_FALLBACK;
+    if (*p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-') return JFAST_FALLBACK;
+    if ((*out = json_object_new_int64(bNeg ? -val : val)) == NULL) return JFAST_FALLBACK;
+    st->p = p;
+    return JFAST_OK;
+}
+
+static int jfast_literal(jfast_t *const st, const char *const lit, const size_t lenLit) {
+    if ((size_t)(st->end - st->p) <= lenLit || memcmp(st->p, lit, lenLit) != 0) return JFAST_FALLBACK;
+    st->p += lenLit;
+    return JFAST_OK;
+}
+
+static int jfast_object(jfast_t *const st, struct json_object **const out) {
+    struct json_object *obj = NULL;
+    struct json_object *val;
+    const char *key;
+    size_t lenKey;
+    char keyBuf[256];
+    char *keyCopy;
+    int r = JFAST_FALLBACK;
+
+    if (++st->depth > JFAST_MAX_DEPTH) goto done;
+    if ((obj = json_object_new_object()) == NULL) goto done;
+    ++st->p; /* skip '{' */
+    jfast_skip_ws(st);
+    if (st->p < st->end && *st->p == '}') {
+        ++st->p;
+        r = JFAST_OK;
+        goto done;
+    }
+    while (1) {
+        if (st->p == st->end || *st->p != '"') goto done;
+        if (jfast_string(st, &key, &lenKey) != JFAST_OK) goto done;
+        jfast_skip_ws(st);
+        if (st->p == st->end || *st->p != ':') goto done;
+        ++st->p;
+        jfast_skip_ws(st);
+        /* the key needs a terminator and the value may reuse the unescape buffer */
+        if (lenKey < sizeof(keyBuf)) {
+            memcpy(keyBuf, key, lenKey);
+            keyBuf[lenKey] = '\0';
+            keyCopy = keyBuf;
+        } else if ((keyCopy = strndup(key, lenKey)) == NULL) {
+            goto done;
+        }
+        r = jfast_value(st, &val);
+        if (r == JFAST_OK) json_object_object_add(obj, keyCopy, val);
+        if (keyCopy != keyBuf) free(keyCopy);
+        if (r != JFAST_OK) goto done;
+        r = JFAST_FALLBACK;
+        jfast_skip_ws(st);
+        if (st->p == st->end) goto done;
+        if (*st->p == '}') {
+            ++st->p;
+            r = JFAST_OK;
+            goto done;
+        }
+        if (*st->p != ',') goto done;
+        ++st->p;
+        jfast_skip_ws(st);
+    }
+
+done:
+    --st->depth;
+    if (r == JFAST_OK) {
+        *out = obj;
+    } else if (obj != NULL) {
+        json_object_put(obj);
+    }
+    return r;
+}
+
+static int jfast_array(jfast_t *const st, struct json_object **const out) {
+    struct json_object *arr = NULL;
+    struct json_object *val;
+    int r = JFAST_FALLBACK;
+
+    if (++st->depth > JFAST_MAX_DEPTH) goto done;
+    if ((arr = json_object_new_array()) == NULL) goto done;
+    ++st->p; /* skip '[' */
+    jfast_skip_ws(st);
+    if (st->p < st->end && *st->p == ']') {
+        ++st->p;
+        r = JFAST_OK;
+        goto done;
+    }
+    while (1) {
+        if (jfast_value(st, &val) != JFAST_OK) goto done;
+        json_object_array_add(arr, val);
+        jfast_skip_ws(st);
+        if (st->p == st->end) goto done;
+        if (*st->p == ']') {
+            ++st->p;
+            r = JFAST_OK;
+            goto done;
+        }
+        if (*st->p != ',') goto done;
+        ++st->p;
+        jfast_skip_ws(st);
+    }
+
+done:
+    --st->depth;
+    if (r == JFAST_OK) {
+        *out = arr;
+    } else if (arr != NULL) {
+        json_object_put(arr);
+    }
+    return r;
+}
+
+static int jfast_value(jfast_t *const st, struct json_object **const out) {
+    const char *str;
+    size_t len;
+
+    *out = NULL;
+    if (st->p == st->end) return JFAST_FALLBACK;
+    switch (*st->p) {
+        case '{':
+            return jfast_object(st, out);
+        case '[':
+            return jfast_array(st, out);
+        case '"':
+            if (jfast_string(st, &str, &len) != JFAST_OK) return JFAST_FALLBACK;
+            return ((*out = json_object_new_string_len(str, len)) == NULL) ? JFAST_FALLBACK : JFAST_OK;
+        case 't':
+            if (jfast_literal(st, "true", 4) != JFAST_OK) return JFAST_FALLBACK;
+            return ((*out = json_object_new_boolean(1)) == NULL) ? JFAST_FALLBACK : JFAST_OK;
+        case 'f':
+            if (jfast_literal(st, "false", 5) != JFAST_OK) return JFAST_FALLBACK;
+            return ((*out = json_object_new_boolean(0)) == NULL) ? JFAST_FALLBACK : JFAST_OK;
+        case 'n':
+            return jfast_literal(st, "null", 4); /* NULL is json null */
+        default:
+            if (*st->p == '-' || isdigit(*st->p)) return jfast_number(st, out);
+            return JFAST_FALLBACK;
+    }
+}
+
+/**
+ * Try to build the JSON object at the start of buf without json_tokener.
+ *
+ * @param pBuf      [IN/OUT] unescape buffer, grown as needed (caller frees)
+ * @param pLenBuf   [IN/OUT] size of *pBuf
+ * @param buf       Buffer to parse; leading whitespace is skipped
+ * @param len       Length of buffer
+ * @param json      [OUT] parsed object (caller must release)
+ * @param consumed  [OUT] bytes consumed, including whitespace after the
+ *                  object, matching json_tokener's char_offset
+ * @return JFAST_OK on success, JFAST_FALLBACK if json_tokener must decide
+ */
+static int jfast_parse(uchar **const pBuf,
+                       size_t *const pLenBuf,
+                       const uchar *const buf,
+                       const size_t len,
+                       struct json_object **const json,
+                       size_t *const consumed) {
+    jfast_t st;
+
+    memset(&st, 0, sizeof(st));
+    st.p = buf;
+    st.end = buf + len;
+    st.pBuf = pBuf;
+    st.pLenBuf = pLenBuf;
+    *json = NULL;
+
+    jfast_skip_ws(&st);
+    if (st.p == st.end || *st.p != '{') return JFAST_FALLBACK;
+    if (jfast_object(&st, json) != JFAST_OK) return JFAST_FALLBACK;
+    jfast_skip_ws(&st);
+    if (st.p < st.end && *st.p == '/') { /* could start a comment */
+        json_object_put(*json);
+        *json = NULL;
+        return JFAST_FALLBACK;
+    }
+    *consumed = st.p - buf;
+    return JFAST_OK;
+}
+
+
+/* Lazy mode.
+ *
+ * With lazy="on", a strict JSON object is only validated and indexed. The
+ * message receives a copy of the object text together with an index of its
+ * top-level members, see msgSetLazyJSON(). Property lookups are answered
+ * from the index, walking nested objects in the text where needed. The
+ * libfastjson tree is only built when something needs more than that,
+ * e.g. a write to $!, %$!% or a disk queue.
+ *
+ * The validator accepts the fast-path subset plus \u escapes and floating
+ * point numbers, which json_tokener accepts as well. Everything else is
+ * left to the eager path, so lazy mode never changes which messages parse.
+ */
+enum lazyValType { LAZY_STRING, LAZY_SCALAR, LAZY_NULL, LAZY_OBJECT, LAZY_OTHER };
+
+struct lazyMember {
+    uint32_t offKey; /* raw key text */
+    uint32_t lenKey;
+    uint32_t offVal; /* string content (unescaped) or value text */
+    uint32_t lenVal;
+    uint8_t type; /* enum lazyValType */
+};
+
+struct lazyJson {
+    size_t size; /* of the whole block, it is position independent */
+    uint32_t lenJson;
+    uint32_t nMembers;
+    sbool bKeyEscapes; /* some top-level key has escapes, lookups fall back */
+    struct lazyMember members[];
+    /* followed by the object text, a NUL and unescaped string values */
+};
+#define LAZY_DATA(lj) ((const uchar *)((lj)->members + (lj)->nMembers))
+#define LAZY_DATA_END(lj) (LAZY_DATA(lj) + (lj)->lenJson)
+
+static int jvalid_value(jfast_t *const st);
+
+/* validate a string at st->p; *pbEsc tells if it has escapes, *pbUni if
+ * some of them are \u escapes
+ */
+static int jvalid_string(jfast_t *const st, int *const pbEsc, int *const pbUni) {
+    const uchar *q = st->p + 1;
+
+    *pbEsc = *pbUni = 0;
+    while (1) {
+        q = jfast_scan_string(q, st->end);
+        if (q == st->end || *q == '\0') return JFAST_FALLBACK;
+        if (*q == '"') break;
+        *pbEsc = 1;
+        if (++q == st->end) return JFAST_FALLBACK;
+        switch (*q) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                ++q;
+                break;
+            case 'u':
+                /* surrogates are left to the tokener's own rules */
+                if (st->end - q < 5 || !isxdigit(q[1]) || !isxdigit(q[2]) || !isxdigit(q[3]) || !isxdigit(q[4]) ||
+                    ((q[1] == 'd' || q[1] == 'D') && strchr("89abAB", q[2]) != NULL))
+                    return JFAST_FALLBACK;
+                *pbUni = 1;
+                q += 5;
+                break;
+            default:
+                return JFAST_FALLBACK;
+        }
+    }
+    st->p = q + 1;
+    return JFAST_OK;
+}
+
+/* validate a number at st->p; *pbCanonical tells if its text is what
+ * libfastjson prints for it, i.e. a plain int64
+ */
+static int jvalid_number(jfast_t *const st, int *const pbCanonical) {
+    const uchar *p = st->p;
+    const uchar *digits;
+
+    if (*p == '-') ++p;
+    digits = p;
+    if (p == st->end || !isdigit(*p)) return JFAST_FALLBACK;
+    if (*p == '0') {
+        ++p;
+    } else {
+        while (p < st->end && isdigit(*p)) ++p;
+    }
+    *pbCanonical = (p - digits <= JFAST_MAX_DIGITS) && !(p - st->p == 2 && *st->p == '-' && *digits == '0');
+    if (p < st->end && *p == '.') {
+        *pbCanonical = 0;
+        if (++p == st->end || !isdigit(*p)) return JFAST_FALLBACK;
+        while (p < st->end && isdigit(*p)) ++p;
+    }
+    if (p < st->end && (*p == 'e' || *p == 'E')) {
+        *pbCanonical = 0;
+        if (++p < st->end && (*p == '+' || *p == '-')) ++p;
+        if (p == st->end || !isdigit(*p)) return JFAST_FALLBACK;
+        while (p < st->end && isdigit(*p)) ++p;
+    }
+    if (p == st->end) return JFAST_FALLBACK;
+    st->p = p;
+    return JFAST_OK;
+}
+
+static int jvalid_container(jfast_t *const st) {
+    const uchar close = (*st->p == '{') ? '}' : ']';
+    int bEsc, bUni;
+    int r = JFAST_FALLBACK;
+
+    if (++st->depth > JFAST_MAX_DEPTH) goto done;
+    ++st->p;
+    jfast_skip_ws(st);
+    if (st->p < st->end && *st->p == close) {
+        ++st->p;
+        r = JFAST_OK;
+        goto done;
+    }
+    while (1) {
+        if (close == '}') {
+            if (st->p == st->end || *st->p != '"') goto done;
+            if (jvalid_string(st, &bEsc, &bUni) != JFAST_OK) goto done;
+            jfast_skip_ws(st);
+            if (st->p == st->end || *st->p != ':') goto done;
+            ++st->p;
+            jfast_skip_ws(st);
+        }
+        if (st->depth == 1 && st->p < st->end && *st->p == '"') {
+            /* top-level string values may need room for unescaping */
+            const uchar *const val = st->p;
+            if (jvalid_string(st, &bEsc, &bUni) != JFAST_OK) goto done;
+            if (bEsc) st->lenEscaped += st->p - val;
+        } else if (jvalid_value(st) != JFAST_OK) {
+            goto done;
+        }
+        if (st->depth == 1) ++st->nMembers;
+        jfast_skip_ws(st);
+        if (st->p == st->end) goto done;
+        if (*st->p == close) {
+            ++st->p;
+            r = JFAST_OK;
+            goto done;
+        }
+        if (*st->p != ',') goto done;
+        ++st->p;
+        jfast_skip_ws(st);
+    }
+
+done:
+    --st->depth;
+    return r;
+}
+
+static int jvalid_value(jfast_t *const st) {
+    int bEsc, bUni, bCanonical;
+
+    if (st->p == st->end) return JFAST_FALLBACK;
+    switch (*st->p) {
+        case '{':
+        case '[':
+            return jvalid_container(st);
+        case '"':
+            return jvalid_string(st, &bEsc, &bUni);
+        case 't':
+            return jfast_literal(st, "true", 4);
+        case 'f':
+            return jfast_literal(st, "false", 5);
+        case 'n':
+            return jfast_literal(st, "null", 4);
+        default:
+            if (*st->p == '-' || isdigit(*st->p)) return jvalid_number(st, &bCanonical);
+            return JFAST_FALLBACK;
+    }
+}
+
+/* Describe the already validated value at p and return the position after
+ * it. For strings, *val and *lenVal give the raw content, for other values
+ * their text. *pbEsc is set for strings with escapes, *pbUni if those
+ * include \u escapes.
+ */
+static const uchar *lazy_value(const uchar *p,
+                               const uchar *const end,
+                               uint8_t *const type,
+                               const uchar **const val,
+                               size_t *const lenVal,
+                               int *const pbEsc,
+                               int *const pbUni) {
+    jfast_t st;
+    int bCanonical;
+
+    memset(&st, 0, sizeof(st));
+    st.p = p;
+    st.end = end;
+    *pbEsc = *pbUni = 0;
+    switch (*p) {
+        case '"':
+            jvalid_string(&st, pbEsc, pbUni);
+            *type = LAZY_STRING;
+            *val = p + 1;
+            *lenVal = st.p - p - 2;
+            return st.p;
+        case '{':
+        case '[':
+            *type = (*p == '{') ? LAZY_OBJECT : LAZY_OTHER;
+            jvalid_container(&st);
+            break;
+        case 'n':
+            *type = LAZY_NULL;
+            st.p += 4;
+            break;
+        case 't':
+        case 'f':
+            *type = LAZY_SCALAR;
+            st.p += (*p == 't') ? 4 : 5;
+            break;
+        default:
+            jvalid_number(&st, &bCanonical);
+            *type = bCanonical ? LAZY_SCALAR : LAZY_OTHER;
+            break;
+    }
+    *val = p;
+    *lenVal = st.p - p;
+    return st.p;
+}
+
+/* skip whitespace in validated text */
+static const uchar *lazy_skip_ws(const uchar *p) {
+    while (isspace(*p)) ++p;
+    return p;
+}
+
+/* Undo the simple escapes of validated string content into dst, returns
+ * the unescaped length. \u escapes must have been ruled out by the caller.
+ */
+static size_t lazy_unescape(const uchar *src, const size_t len, uchar *const dst) {
+    const uchar *const end = src + len;
+    size_t n = 0;
+
+    while (src < end) {
+        if (*src != '\\') {
+            dst[n++] = *src++;
+            continue;
+        }
+        switch (*++src) {
+            case 'b':
+                dst[n++] = '\b';
+                break;
+            case 'f':
+                dst[n++] = '\f';
+                break;
+            case 'n':
+                dst[n++] = '\n';
+                break;
+            case 'r':
+                dst[n++] = '\r';
+                break;
+            case 't':
+                dst[n++] = '\t';
+                break;
+            default:
+                dst[n++] = *src;
+                break;
+        }
+        ++src;
+    }
+    return n;
+}
+
+/**
+ * Validate and index the JSON object at the start of buf for lazy mode.
+ *
+ * @param buf      Buffer to parse; leading whitespace is skipped
+ * @param len      Length of buffer
+ * @param ppLazy   [OUT] index to hand to msgSetLazyJSON()
+ * @param consumed [OUT] bytes consumed, as for jfast_parse()
+ * @return JFAST_OK on success, JFAST_FALLBACK if the eager path must decide
+ */
+static int lazy_parse(const uchar *const buf,
+                      const size_t len,
+                      struct lazyJson **const ppLazy,
+                      size_t *const consumed) {
+    struct lazyJson *lj;
+    uchar *data;
+    uchar *escData;
+    const uchar *obj;
+    const uchar *p;
+    size_t lenJson;
+    jfast_t st;
+    uint32_t i;
+
+    memset(&st, 0, sizeof(st));
+    st.p = buf;
+    st.end = buf + len;
+    jfast_skip_ws(&st);
+    if (st.p == st.end || *st.p != '{') return JFAST_FALLBACK;
+    obj = st.p;
+    if (jvalid_container(&st) != JFAST_OK) return JFAST_FALLBACK;
+    lenJson = st.p - obj;
+    jfast_skip_ws(&st);
+    if (st.p < st.end && *st.p == '/') return JFAST_FALLBACK; /* could start a comment */
+    if (lenJson > UINT32_MAX / 2) return JFAST_FALLBACK;
+
+    const size_t size =
+        sizeof(struct lazyJson) + st.nMembers * sizeof(struct lazyMember) + lenJson + 1 + st.lenEscaped;
+    if ((lj = malloc(size)) == NULL) return JFAST_FALLBACK;
+    lj->size = size;
+    lj->lenJson = lenJson;
+    lj->nMembers = st.nMembers;
+    lj->bKeyEscapes = 0;
+    data = (uchar *)LAZY_DATA(lj);
+    memcpy(data, obj, lenJson);
+    data[lenJson] = '\0';
+    escData = data + lenJson + 1;
+
+    const uchar *const dataEnd = data + lenJson;
+    p = lazy_skip_ws(data + 1);
+    for (i = 0; i < lj->nMembers; ++i) {
+        struct lazyMember *const m = &lj->members[i];
+        const uchar *val;
+        size_t lenVal;
+        uint8_t type;
+        int bEsc, bUni;
+
+        p = lazy_value(p, dataEnd, &type, &val, &lenVal, &bEsc, &bUni);
+        m->offKey = val - data;
+        m->lenKey = lenVal;
+        if (bEsc) lj->bKeyEscapes = 1;
+        p = lazy_skip_ws(lazy_skip_ws(p) + 1); /* skip ':' */
+        p = lazy_value(p, dataEnd, &type, &val, &lenVal, &bEsc, &bUni);
+        if (bUni) {
+            type = LAZY_OTHER;
+        } else if (bEsc) {
+            lenVal = lazy_unescape(val, lenVal, escData);
+            val = escData;
+            escData += lenVal;
+        }
+        m->type = type;
+        m->offVal = val - data;
+        m->lenVal = lenVal;
+        p = lazy_skip_ws(lazy_skip_ws(p) + 1); /* skip ',' or '}' */
+    }
+
+    *ppLazy = lj;
+    *consumed = st.p - buf;
+    return JFAST_OK;
+}
+
+static void lazyJsonDestruct(void *const ctx) {
+    free(ctx);
+}
+
+static void *lazyJsonDup(const void *const ctx) {
+    const struct lazyJson *const lj = (const struct lazyJson *)ctx;
+    void *const copy = malloc(lj->size);
+
+    if (copy != NULL) memcpy(copy, lj, lj->size);
+    return copy;
+}
+
+static struct json_object *lazyJsonToJSON(const void *const ctx) {
+    const struct lazyJson *const lj = (const struct lazyJson *)ctx;
+    struct json_object *json = NULL;
+    uchar *buf = NULL;
+    size_t lenBuf = 0;
+    size_t consumed;
+
+    if (jfast_parse(&buf, &lenBuf, LAZY_DATA(lj), lj->lenJson, &json, &consumed) != JFAST_OK) {
+        json = json_tokener_parse((const char *)LAZY_DATA(lj));
+    }
+    free(buf);
+    return json;
+}
+
+/* find the last member named key in the validated object text at obj;
+ * returns 1 if found, 0 if absent and -1 if only the tree can tell
+ */
+static int lazy_find_member(const uchar *const obj,
+                            const uchar *const end,
+                            const uchar *const key,
+                            const size_t lenKey,
+                            uint8_t *const type,
+                            const uchar **const val,
+                            size_t *const lenVal) {
+    const uchar *p = lazy_skip_ws(obj + 1);
+    int r = 0;
+
+    while (*p == '"') {
+        const uchar *k, *v;
+        size_t lenK, lenV;
+        uint8_t kType, vType;
+        int bEsc, bUni;
+
+        p = lazy_value(p, end, &kType, &k, &lenK, &bEsc, &bUni);
+        if (bEsc) return -1;
+        p = lazy_skip_ws(lazy_skip_ws(p) + 1);
+        p = lazy_value(p, end, &vType, &v, &lenV, &bEsc, &bUni);
+        if (lenK == lenKey && !memcmp(k, key, lenKey)) {
+            /* values with escapes would need a buffer, leave them to the tree */
+            *type = bEsc ? LAZY_OTHER : vType;
+            *val = v;
+            *lenVal = lenV;
+            r = 1;
+        }
+        p = lazy_skip_ws(p);
+        if (*p != ',') break;
+        p = lazy_skip_ws(p + 1);
+    }
+    return r;
+}
+
+static int lazyJsonLookup(const void *const ctx,
+                          const uchar *const name,
+                          const int nameLen,
+                          const uchar **const pVal,
+                          rs_size_t *const pLen) {
+    const struct lazyJson *const lj = (const struct lazyJson *)ctx;
+    const uchar *const data = LAZY_DATA(lj);
+    const uchar *const end = name + nameLen;
+    const uchar *seg = name + 1;
+    const uchar *segEnd;
+    const uchar *val = NULL;
+    size_t lenVal = 0;
+    uint8_t type = LAZY_OTHER;
+    int bFound = 0;
+    int i;
+
+    /* subscripts and empty path segments follow the tree's rules */
+    if (nameLen < 2 || name[0] != '!' || lj->bKeyEscapes || memchr(name, '[', nameLen) != NULL)
+        return MSG_LAZYJSON_UNKNOWN;
+    if ((segEnd = memchr(seg, '!', end - seg)) == NULL) segEnd = end;
+    if (segEnd == seg) return MSG_LAZYJSON_UNKNOWN;
+    for (i = (int)lj->nMembers - 1; i >= 0; --i) { /* duplicates: the last one wins */
+        const struct lazyMember *const m = &lj->members[i];
+        if (m->lenKey == (size_t)(segEnd - seg) && !memcmp(data + m->offKey, seg, m->lenKey)) {
+            type = m->type;
+            val = data + m->offVal;
+            lenVal = m->lenVal;
+            bFound = 1;
+            break;
+        }
+    }
+    if (!bFound) return (segEnd == end) ? MSG_LAZYJSON_ABSENT : MSG_LAZYJSON_UNKNOWN;
+
+    while (segEnd != end) {
+        if (type != LAZY_OBJECT) return MSG_LAZYJSON_UNKNOWN;
+        seg = segEnd + 1;
+        if ((segEnd = memchr(seg, '!', end - seg)) == NULL) segEnd = end;
+        if (segEnd == seg) return MSG_LAZYJSON_UNKNOWN;
+        const int r = lazy_find_member(val, LAZY_DATA_END(lj), seg, segEnd - seg, &type, &val, &lenVal);
+        if (r < 0) return MSG_LAZYJSON_UNKNOWN;
+        if (r == 0) return (segEnd == end) ? MSG_LAZYJSON_ABSENT : MSG_LAZYJSON_UNKNOWN;
+    }
+
+    switch (type) {
+        case LAZY_STRING:
+            *pVal = val;
+            *pLen = (rs_size_t)lenVal;
+            return MSG_LAZYJSON_STRING;
+        case LAZY_NULL: /* the tree represents null as an empty string */
+            *pVal = (const uchar *)"";
+            *pLen = 0;
+            return MSG_LAZYJSON_STRING;
+        case LAZY_SCALAR:
+            *pVal = val;
+            *pLen = (rs_size_t)lenVal;
+            return MSG_LAZYJSON_SCALAR;
+        default:
+            return MSG_LAZYJSON_UNKNOWN;
+    }
+}
+
+static const struct msgLazyJsonOps lazyJsonOps = {lazyJsonDestruct, lazyJsonDup, lazyJsonToJSON, lazyJsonLookup};
+
+
+/* check for anything but whitespace in msg after position pos */
+static int has_trailing_data(const uchar *const msg, const size_t len, size_t pos) {
+    while (pos < len && isspace(msg[pos])) {
+        pos++;
+    }
+    return pos < len;
+}
+
 /**
  * Find the first valid JSON object in a message buffer using the actual JSON parser.
  * This function scans for '{' characters and uses json_tokener to validate complete objects.
@@ -218,6 +1036,7 @@ ENDtryResume
  * @param obj_len   [OUT] Length of JSON object
  * @param parsed_json [OUT] Already parsed JSON object (caller must release)
  * @param allow_trailing Whether trailing data after JSON is allowed
+ * @param ppLazy    [OUT] lazy mode index instead of parsed_json, NULL to parse eagerly
  * @return 0 on success, 1 if no JSON found, 2 if scan truncated, 3 if trailing data not allowed
  */
 static int find_first_json_object(wrkrInstanceData_t *pWrkrData,
@@ -228,12 +1047,14 @@ static int find_first_json_object(wrkrInstanceData_t *pWrkrData,
                                   size_t *obj_off,
                                   size_t *obj_len,
                                   struct json_object **parsed_json,
-                                  sbool allow_trailing) {
+                                  sbool allow_trailing,
+                                  struct lazyJson **ppLazy) {
     size_t i = start_off;
     size_t scan_end = start_off + max_scan;
     if (scan_end > len) scan_end = len;
 
     *parsed_json = NULL;
+    if (ppLazy != NULL) *ppLazy = NULL;
 
     /* Find potential JSON start positions ('{' characters) */
     while (i < scan_end) {
@@ -251,24 +1072,34 @@ static int find_first_json_object(wrkrInstanceData_t *pWrkrData,
 
         /* Try to parse JSON starting from this position, bounded by scan window */
         size_t remaining = scan_end - i;
-        json_tokener_reset(pWrkrData->tokener);
+        size_t parsed_len;
+        struct json_object *json;
+
+        if (ppLazy != NULL && lazy_parse(msg + i, remaining, ppLazy, &parsed_len) == JFAST_OK) {
+            if (!allow_trailing && has_trailing_data(msg, len, i + parsed_len)) {
+                free(*ppLazy);
+                *ppLazy = NULL;
+                return 3; /* trailing data not allowed */
+            }
+            *obj_off = i;
+            *obj_len = parsed_len;
+            return 0; /* success */
+        }
 
-        struct json_object *json = json_tokener_parse_ex(pWrkrData->tokener, (const char *)(msg + i), remaining);
+        if (jfast_parse(&pWrkrData->fastBuf, &pWrkrData->lenFastBuf, msg + i, remaining, &json, &parsed_len) !=
+            JFAST_OK) {
+            json_tokener_reset(pWrkrData->tokener);
+            json = json_tokener_parse_ex(pWrkrData->tokener, (const char *)(msg + i), remaining);
+            parsed_len = pWrkrData->tokener->char_offset;
+        }
 
         if (json != NULL && json_object_is_type(json, json_type_object)) {
             /* Valid JSON object found */
-            size_t parsed_len = pWrkrData->tokener->char_offset;
 
             /* Check full message for trailing data if allow_trailing is false */
-            if (!allow_trailing) {
-                size_t check_pos = i + parsed_len;
-                while (check_pos < len && isspace(msg[check_pos])) {
-                    check_pos++;
-                }
-                if (check_pos < len) {
-                    json_object_put(json); /* release the object */
-                    return 3; /* trailing data not allowed */
-                }
+            if (!allow_trailing && has_trailing_data(msg, len, i + parsed_len)) {
+                json_object_put(json); /* release the object */
+                return 3; /* trailing data not allowed */
             }
 
             *obj_off = i;
@@ -309,13 +1140,36 @@ finalize_it:
 
 static rsRetVal processJSONBuffer(wrkrInstanceData_t *pWrkrData, smsg_t *pMsg, char *buf, size_t lenBuf) {
     struct json_object *json;
+    size_t consumed;
     const char *errMsg;
     DEFiRet;
 
     assert(pWrkrData->tokener != NULL);
     DBGPRINTF("mmjsonparse: toParse: '%s'\n", buf);
-    json_tokener_reset(pWrkrData->tokener);
+    if (pWrkrData->pData->bLazy) {
+        struct lazyJson *lj;
+        if (lazy_parse((uchar *)buf, lenBuf, &lj, &consumed) == JFAST_OK) {
+            if (consumed < lenBuf) {
+                DBGPRINTF("mmjsonparse: Error parsing JSON '%s': Extra characters after JSON object\n", buf);
+                free(lj);
+                ABORT_FINALIZE(RS_RET_NO_CEE_MSG);
+            }
+            CHKiRet(msgSetLazyJSON(pMsg, lj, &lazyJsonOps));
+            FINALIZE;
+        }
+    }
+    if (jfast_parse(&pWrkrData->fastBuf, &pWrkrData->lenFastBuf, (uchar *)buf, lenBuf, &json, &consumed) ==
+        JFAST_OK) {
+        if (consumed < lenBuf) {
+            DBGPRINTF("mmjsonparse: Error parsing JSON '%s': Extra characters after JSON object\n", buf);
+            json_object_put(json);
+            ABORT_FINALIZE(RS_RET_NO_CEE_MSG);
+        }
+        msgAddJSON(pMsg, pWrkrData->pData->container, json, 0, 0);
+        FINALIZE;
+    }
 
+    json_tokener_reset(pWrkrData->tokener);
     json = json_tokener_parse_ex(pWrkrData->tokener, buf, lenBuf);
     if (Debug) {
         errMsg = NULL;
@@ -397,16 +1251,21 @@ BEGINdoAction_NoStrings
         size_t obj_off, obj_len;
         int scan_result;
         struct json_object *parsed_json = NULL;
+        struct lazyJson *lj = NULL;
 
         STATSCOUNTER_INC(pWrkrData->ctrScanAttempted, pWrkrData->mutCtrScanAttempted);
 
         scan_result = find_first_json_object(pWrkrData, buf, len, 0, pData->max_scan_bytes, &obj_off, &obj_len,
-                                             &parsed_json, pData->allow_trailing);
+                                             &parsed_json, pData->allow_trailing, pData->bLazy ? &lj : NULL);
 
         if (scan_result == 0) {
-            /* JSON object found and already parsed */
+            /* JSON object found and already parsed (or indexed in lazy mode) */
             STATSCOUNTER_INC(pWrkrData->ctrScanFound, pWrkrData->mutCtrScanFound);
-            iRet = processJSON(pWrkrData, pMsg, parsed_json);
+            if (lj != NULL) {
+                iRet = msgSetLazyJSON(pMsg, lj, &lazyJsonOps);
+            } else {
+                iRet = processJSON(pWrkrData, pMsg, parsed_json);
+            }
             if (iRet == RS_RET_OK) {
                 bSuccess = 1;
             } else {
@@ -513,12 +1372,21 @@ BEGINnewActInst
             }
         } else if (!strcmp(actpblk.descr[i].name, "allow_trailing")) {
             pData->allow_trailing = (int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "lazy")) {
+            pData->bLazy = (int)pvals[i].val.d.n;
         } else {
             dbgprintf("mmjsonparse: program error, non-handled param '%s'\n", actpblk.descr[i].name);
         }
     }
 
     if (pData->container == NULL) CHKmalloc(pData->container = (uchar *)strdup("!"));
+    if (pData->bLazy && strcmp((char *)pData->container, "!")) {
+        LogError(0, RS_RET_CONF_PARAM_INVLD,
+                 "mmjsonparse: lazy mode is only supported with container '$!', "
+                 "parsing container '%s' eagerly",
+                 pData->container);
+        pData->bLazy = 0;
+    }
     pData->lenCookie = strlen(pData->cookie);
     CODE_STD_FINALIZERnewActInst;
     cnfparamvalsDestruct(pvals, &actpblk);
@@ -701,6 +701,9 @@ BEGINdoAction_NoStrings
                      * data that would otherwise leak. */
                     MsgLock(pMsg);
                     MsgReleaseTurboResult(pMsg);
+                    /* a deferred $! tree (mmjsonparse lazy mode) came first,
+                     * so it must end up below the snapshot's fields */
+                    msgMaterializeLazyJSON(pMsg);
                     pMsg->turbo_result = (void *)snap;
                     pMsg->turbo_result_free = turbo_result_snapshot_free;
                     pMsg->turbo_result_to_json = turbo_result_to_json_cb;
@@ -2174,17 +2174,28 @@ finalize_it:
     RETiRet;
 }
 
+/* The bulk request is posted straight from the batch buffer. The reply
+ * checks treat the request as C string, so the buffer is NUL terminated.
+ * The terminator stays in the batch until initializeBatch() resets it; a
+ * retried submit finds it already there. As before, the body ends at the
+ * first NUL.
+ */
 static rsRetVal submitBatch(wrkrInstanceData_t *pWrkrData) {
-    char *cstr = NULL;
+    es_str_t *const data = pWrkrData->batch.data;
+    char *reqmsg;
     DEFiRet;
 
-    cstr = es_str2cstr(pWrkrData->batch.data, NULL);
-    dbgprintf("omelasticsearch: submitBatch, batch: '%s'\n", cstr);
+    if (es_strlen(data) == 0 || es_getBufAddr(data)[es_strlen(data) - 1] != '\0') {
+        if (es_addChar(&pWrkrData->batch.data, '\0') != 0) {
+            ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+        }
+    }
+    reqmsg = (char *)es_getBufAddr(pWrkrData->batch.data);
+    dbgprintf("omelasticsearch: submitBatch, batch: '%s'\n", reqmsg);
 
-    CHKiRet(curlPost(pWrkrData, (uchar *)cstr, strlen(cstr), NULL, pWrkrData->batch.nmemb));
+    CHKiRet(curlPost(pWrkrData, (uchar *)reqmsg, strlen(reqmsg), NULL, pWrkrData->batch.nmemb));
 
 finalize_it:
-    free(cstr);
     RETiRet;
 }
 
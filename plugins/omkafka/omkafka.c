@@ -86,6 +86,7 @@
 #include "statsobj.h"
 #include "unicode-helper.h"
 #include "datetime.h"
+#include "hashtable.h"
 
 MODULE_TYPE_OUTPUT;
 MODULE_TYPE_NOKEEP;
@@ -194,23 +195,6 @@ struct kafka_params {
 #define RESUBMIT 1
 #define NO_RESUBMIT 0
 
-#ifdef HAVE_ATOMIC_BUILTINS64
-static uint64 clockTopicAccess = 0;
-#else
-static unsigned clockTopicAccess = 0;
-#endif
-/* and the "tick" function */
-#ifndef HAVE_ATOMIC_BUILTINS
-static pthread_mutex_t mutClock;
-#endif
-static uint64 getClockTopicAccess(void) {
-#ifdef HAVE_ATOMIC_BUILTINS64
-    return ATOMIC_INC_AND_FETCH_uint64(&clockTopicAccess, &mutClock);
-#else
-    return ATOMIC_INC_AND_FETCH_unsigned(&clockTopicAccess, &mutClock);
-#endif
-}
-
 /* Needed for Kafka timestamp librdkafka > 0.9.4 */
 #define KAFKA_TimeStamp "\"%timestamp:::date-unixtimestamp%\""
 
@@ -224,12 +208,18 @@ static uint64 rtt_avg_usec;
 static uint64 throttle_avg_msec;
 static uint64 int_latency_avg_usec;
 
-/* dynamic topic cache */
+/* dynamic topic cache
+ * Entries are indexed by topic name in a hash table and additionally chained
+ * into an LRU list (head = most recently used). That keeps both lookup and
+ * eviction O(1), no matter how large dynatopic.cachesize is. The entry name
+ * is the hash table key and thus owned (and freed) by the hash table.
+ */
 struct s_dynaTopicCacheEntry {
     uchar *pName;
     rd_kafka_topic_t *pTopic;
-    uint64 clkTickAccessed;
     pthread_rwlock_t lock;
+    struct s_dynaTopicCacheEntry *lruPrev;
+    struct s_dynaTopicCacheEntry *lruNext;
 };
 typedef struct s_dynaTopicCacheEntry dynaTopicCacheEntry;
 
@@ -246,10 +236,12 @@ typedef struct _instanceData {
     uchar *topic;
     sbool dynaKey;
     sbool dynaTopic;
-    dynaTopicCacheEntry **dynCache;
+    struct hashtable *dynCache; /* topic name -> dynaTopicCacheEntry */
+    dynaTopicCacheEntry *dynCacheLruHead; /* most recently used */
+    dynaTopicCacheEntry *dynCacheLruTail; /* eviction candidate */
+    dynaTopicCacheEntry *pCurrElt; /* entry used for the previous message */
     pthread_mutex_t mutDynCache;
     rd_kafka_topic_t *pTopic;
-    int iCurrElt;
     int iCurrCacheSize;
     int bReportErrs;
     int iDynaTopicCacheSize;
@@ -468,51 +460,73 @@ static void closeTopic(instanceData *__restrict__ const pData) {
     free_topic(&pData->pTopic);
 }
 
-/* these dynaTopic* functions are only slightly modified versions of those found in omfile.c.
- * check the sources in omfile.c for more descriptive comments about each of these functions.
- * i will only put the bare descriptions in this one. 2015-01-09 - Tait Clarridge
+/* The dynaTopic* functions originally were slightly modified versions of the
+ * omfile dynafile cache. They now use a hash table plus LRU list, as topic
+ * names are looked up for every single message. 2015-01-09 - Tait Clarridge
  */
 
-/* delete a cache entry from the dynamic topic cache */
-/* must be called with lock(mutDynCache) */
-static rsRetVal dynaTopicDelCacheEntry(instanceData *__restrict__ const pData, const int iEntry, const int bFreeEntry) {
-    dynaTopicCacheEntry **pCache = pData->dynCache;
-    DEFiRet;
-    assert(pCache != NULL);
-
-    if (pCache[iEntry] == NULL) FINALIZE;
-    pthread_rwlock_wrlock(&pCache[iEntry]->lock);
-
-    DBGPRINTF("Removing entry %d for topic '%s' from dynaCache.\n", iEntry,
-              pCache[iEntry]->pName == NULL ? UCHAR_CONSTANT("[OPEN FAILED]") : pCache[iEntry]->pName);
-
-    if (pCache[iEntry]->pName != NULL) {
-        free(pCache[iEntry]->pName);
-        pCache[iEntry]->pName = NULL;
+static void dynaTopicLruUnlink(instanceData *__restrict__ const pData, dynaTopicCacheEntry *const entry) {
+    if (entry->lruPrev == NULL) {
+        pData->dynCacheLruHead = entry->lruNext;
+    } else {
+        entry->lruPrev->lruNext = entry->lruNext;
     }
+    if (entry->lruNext == NULL) {
+        pData->dynCacheLruTail = entry->lruPrev;
+    } else {
+        entry->lruNext->lruPrev = entry->lruPrev;
+    }
+    entry->lruPrev = entry->lruNext = NULL;
+}
 
-    pthread_rwlock_unlock(&pCache[iEntry]->lock);
-
-    if (bFreeEntry) {
-        pthread_rwlock_destroy(&pCache[iEntry]->lock);
-        free(pCache[iEntry]);
-        pCache[iEntry] = NULL;
+static void dynaTopicLruPushHead(instanceData *__restrict__ const pData, dynaTopicCacheEntry *const entry) {
+    entry->lruPrev = NULL;
+    entry->lruNext = pData->dynCacheLruHead;
+    if (pData->dynCacheLruHead != NULL) {
+        pData->dynCacheLruHead->lruPrev = entry;
     }
+    pData->dynCacheLruHead = entry;
+    if (pData->dynCacheLruTail == NULL) {
+        pData->dynCacheLruTail = entry;
+    }
+}
 
-finalize_it:
-    RETiRet;
+/* free a cache entry which is no longer linked into hash table or LRU list.
+ * The name is owned by the hash table and thus must already have been freed.
+ */
+static void dynaTopicDestructEntry(dynaTopicCacheEntry *const entry) {
+    pthread_rwlock_wrlock(&entry->lock);
+    free_topic(&entry->pTopic);
+    pthread_rwlock_unlock(&entry->lock);
+    pthread_rwlock_destroy(&entry->lock);
+    free(entry);
+}
+
+/* remove a cache entry from the dynamic topic cache and destroy it,
+ * including its topic handle.
+ * must be called with lock(mutDynCache)
+ */
+static void dynaTopicDelCacheEntry(instanceData *__restrict__ const pData, dynaTopicCacheEntry *const entry) {
+    DBGPRINTF("omkafka: removing topic '%s' from dynaTopic cache\n", entry->pName);
+    if (pData->pCurrElt == entry) {
+        pData->pCurrElt = NULL;
+    }
+    dynaTopicLruUnlink(pData, entry);
+    hashtable_remove(pData->dynCache, entry->pName); /* frees pName */
+    entry->pName = NULL;
+    --pData->iCurrCacheSize;
+    dynaTopicDestructEntry(entry);
 }
 
 /* clear the entire dynamic topic cache */
 static void dynaTopicFreeCacheEntries(instanceData *__restrict__ const pData) {
-    register int i;
     assert(pData != NULL);
 
     pthread_mutex_lock(&pData->mutDynCache);
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        dynaTopicDelCacheEntry(pData, i, 1);
+    while (pData->dynCacheLruHead != NULL) {
+        dynaTopicDelCacheEntry(pData, pData->dynCacheLruHead);
     }
-    pData->iCurrElt = -1; /* invalidate current element */
+    pData->pCurrElt = NULL; /* invalidate current element */
     pthread_mutex_unlock(&pData->mutDynCache);
 }
 
@@ -577,7 +591,9 @@ static rsRetVal prepareTopic(instanceData *__restrict__ const pData, const uchar
 
 /* check dynamic topic cache for existence of the already created topic.
  * if it does not exist, create a new one, or if we are currently using it
- * as of the last message, keep using it.
+ * as of the last message, keep using it. Messages of a batch frequently go
+ * to the same topic, so the previous entry is checked before the hash lookup.
+ * If the cache is full, the least recently used entry is evicted.
  *
  * must be called with read(rkLock)
  * must be called with mutDynCache locked
@@ -586,84 +602,46 @@ static rsRetVal ATTR_NONNULL() prepareDynTopic(instanceData *__restrict__ const
                                                const uchar *__restrict__ const newTopicName,
                                                rd_kafka_topic_t **topic,
                                                pthread_rwlock_t **lock) {
-    uint64 ctOldest;
-    int iOldest;
-    int i;
-    int iFirstFree;
     rsRetVal localRet;
-    dynaTopicCacheEntry **pCache;
     dynaTopicCacheEntry *entry = NULL;
+    dynaTopicCacheEntry *newEntry = NULL;
+    uchar *newName = NULL;
     rd_kafka_topic_t *tmpTopic = NULL;
     DEFiRet;
     assert(pData != NULL);
     assert(newTopicName != NULL);
 
-    pCache = pData->dynCache;
     /* first check, if we still have the current topic */
-    if ((pData->iCurrElt != -1) && !ustrcmp(newTopicName, pCache[pData->iCurrElt]->pName)) {
+    if (pData->pCurrElt != NULL && !ustrcmp(newTopicName, pData->pCurrElt->pName)) {
         /* great, we are all set */
-        pCache[pData->iCurrElt]->clkTickAccessed = getClockTopicAccess();
-        entry = pCache[pData->iCurrElt];
+        entry = pData->pCurrElt;
         STATSCOUNTER_INC(ctrCacheSkip, mutCtrCacheSkip);
         FINALIZE;
     }
 
-    /* ok, no luck. Now let's search the table if we find a matching spot.
-     * While doing so, we also prepare for creation of a new one.
-     */
-    pData->iCurrElt = -1;
-    iFirstFree = -1;
-    iOldest = 0;
-    ctOldest = getClockTopicAccess();
-    for (i = 0; i < pData->iCurrCacheSize; ++i) {
-        if (pCache[i] == NULL || pCache[i]->pName == NULL) {
-            if (iFirstFree == -1) iFirstFree = i;
-        } else { /*got an element, let's see if it matches */
-            if (!ustrcmp(newTopicName, pCache[i]->pName)) {
-                /* we found our element! */
-                entry = pCache[i];
-                pData->iCurrElt = i;
-                /* update "timestamp" for LRU */
-                pCache[i]->clkTickAccessed = getClockTopicAccess();
-                FINALIZE;
-            }
-            /* did not find it - so lets keep track of the counters for LRU */
-            if (pCache[i]->clkTickAccessed < ctOldest) {
-                ctOldest = pCache[i]->clkTickAccessed;
-                iOldest = i;
-            }
+    entry = hashtable_search(pData->dynCache, (void *)newTopicName);
+    if (entry != NULL) {
+        if (entry != pData->dynCacheLruHead) {
+            dynaTopicLruUnlink(pData, entry);
+            dynaTopicLruPushHead(pData, entry);
         }
+        pData->pCurrElt = entry;
+        FINALIZE;
     }
     STATSCOUNTER_INC(ctrCacheMiss, mutCtrCacheMiss);
 
-    /* invalidate iCurrElt as we may error-exit out of this function when the currrent
-     * iCurrElt has been freed or otherwise become unusable. This is a precaution, and
-     * performance-wise it may be better to do that in each of the exits. However, that
-     * is error-prone, so I prefer to do it here. -- rgerhards, 2010-03-02
+    /* invalidate pCurrElt as we may error-exit out of this function when the
+     * current entry has been evicted or otherwise become unusable.
      */
-    pData->iCurrElt = -1;
+    pData->pCurrElt = NULL;
 
-    if (iFirstFree == -1 && (pData->iCurrCacheSize < pData->iDynaTopicCacheSize)) {
-        /* there is space left, so set it to that index */
-        iFirstFree = pData->iCurrCacheSize++;
-    }
-
-    if (iFirstFree == -1) {
-        dynaTopicDelCacheEntry(pData, iOldest, 0);
+    if (pData->iCurrCacheSize >= pData->iDynaTopicCacheSize && pData->dynCacheLruTail != NULL) {
+        dynaTopicDelCacheEntry(pData, pData->dynCacheLruTail);
         STATSCOUNTER_INC(ctrCacheEvict, mutCtrCacheEvict);
-        iFirstFree = iOldest; /* this one *is* now free ;) */
-    } else {
-        pCache[iFirstFree] = NULL;
-    }
-    /* we need to allocate memory for the cache structure */
-    if (pCache[iFirstFree] == NULL) {
-        CHKmalloc(pCache[iFirstFree] = (dynaTopicCacheEntry *)calloc(1, sizeof(dynaTopicCacheEntry)));
-        CHKiRet(pthread_rwlock_init(&pCache[iFirstFree]->lock, NULL));
     }
 
     /* Ok, we finally can open the topic */
     localRet = createTopic(pData, newTopicName, &tmpTopic);
-
     if (localRet != RS_RET_OK) {
         LogError(0, localRet,
                  "Could not open dynamic topic '%s' "
@@ -672,20 +650,32 @@ static rsRetVal ATTR_NONNULL() prepareDynTopic(instanceData *__restrict__ const
         ABORT_FINALIZE(localRet);
     }
 
-    if ((pCache[iFirstFree]->pName = ustrdup(newTopicName)) == NULL) {
-        free_topic(&tmpTopic);
+    CHKmalloc(newEntry = (dynaTopicCacheEntry *)calloc(1, sizeof(dynaTopicCacheEntry)));
+    CHKiRet(pthread_rwlock_init(&newEntry->lock, NULL));
+    CHKmalloc(newName = ustrdup(newTopicName));
+    if (!hashtable_insert(pData->dynCache, newName, newEntry)) {
+        pthread_rwlock_destroy(&newEntry->lock);
         ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
     }
-    pCache[iFirstFree]->pTopic = tmpTopic;
-    pCache[iFirstFree]->clkTickAccessed = getClockTopicAccess();
-    entry = pCache[iFirstFree];
-    pData->iCurrElt = iFirstFree;
-    DBGPRINTF("Added new entry %d for topic cache, topic '%s'.\n", iFirstFree, newTopicName);
+    newEntry->pName = newName;
+    newEntry->pTopic = tmpTopic;
+    newName = NULL; /* now owned by hash table */
+    tmpTopic = NULL; /* now owned by cache entry */
+    dynaTopicLruPushHead(pData, newEntry);
+    ++pData->iCurrCacheSize;
+    entry = newEntry;
+    newEntry = NULL;
+    pData->pCurrElt = entry;
+    DBGPRINTF("omkafka: added topic '%s' to dynaTopic cache, %d entries now\n", newTopicName, pData->iCurrCacheSize);
 
 finalize_it:
     if (iRet == RS_RET_OK) {
         *topic = entry->pTopic;
         *lock = &entry->lock;
+    } else {
+        free(newName);
+        free(newEntry);
+        free_topic(&tmpTopic);
     }
     RETiRet;
 }
@@ -1860,7 +1850,8 @@ BEGINfreeInstance
     pthread_rwlock_wrlock(&pData->rkLock);
     closeKafka(pData);
     if (pData->dynaTopic && pData->dynCache != NULL) {
-        free(pData->dynCache);
+        dynaTopicFreeCacheEntries(pData);
+        hashtable_destroy(pData->dynCache, 0);
         pData->dynCache = NULL;
     }
     /* Persist failed messages */
@@ -2226,6 +2217,12 @@ BEGINnewActInst
         ABORT_FINALIZE(RS_RET_CONFIG_ERROR);
     }
 
+    if (pData->dynaTopic && pData->iDynaTopicCacheSize < 1) {
+        LogError(0, RS_RET_CONFIG_ERROR, "omkafka: dynatopic.cachesize must be at least 1, but is %d",
+                 pData->iDynaTopicCacheSize);
+        ABORT_FINALIZE(RS_RET_CONFIG_ERROR);
+    }
+
     iNumTpls = 2;
     if (pData->dynaKey) ++iNumTpls;
     if (pData->dynaTopic) ++iNumTpls;
@@ -2240,8 +2237,11 @@ BEGINnewActInst
     if (pData->dynaTopic) {
         CHKiRet(OMSRsetEntry(*ppOMSR, pData->dynaKey ? 3 : 2, ustrdup(pData->topic), OMSR_NO_RQD_TPL_OPTS));
         CHKmalloc(pData->dynCache =
-                      (dynaTopicCacheEntry **)calloc(pData->iDynaTopicCacheSize, sizeof(dynaTopicCacheEntry *)));
-        pData->iCurrElt = -1;
+                      create_hashtable(pData->iDynaTopicCacheSize, hash_from_string, key_equals_string, NULL));
+        pData->dynCacheLruHead = NULL;
+        pData->dynCacheLruTail = NULL;
+        pData->pCurrElt = NULL;
+        pData->iCurrCacheSize = 0;
     }
 
     pthread_mutex_lock(&closeTimeoutMut);
@@ -2282,7 +2282,6 @@ BEGINmodExit
     CODESTARTmodExit;
     statsobj.Destruct(&kafkaStats);
     CHKiRet(objRelease(statsobj, CORE_COMPONENT));
-    DESTROY_ATOMIC_HELPER_MUT(mutClock);
 
     pthread_mutex_lock(&closeTimeoutMut);
     int timeout = closeTimeout;
@@ -2317,8 +2316,6 @@ BEGINmodInit()
     CHKiRet(objUse(strm, CORE_COMPONENT));
     CHKiRet(objUse(statsobj, CORE_COMPONENT));
 
-    INIT_ATOMIC_HELPER_MUT(mutClock);
-
     DBGPRINTF("omkafka %s using librdkafka version %s, 0x%x\n", VERSION, rd_kafka_version_str(), rd_kafka_version());
     CHKiRet(statsobj.Construct(&kafkaStats));
     CHKiRet(statsobj.SetName(kafkaStats, (uchar *)"omkafka"));
@@ -1287,19 +1287,23 @@ static rsRetVal prepareDoActionParams(action_t *__restrict__ const pAction,
     struct json_object *json;
     actWrkrIParams_t *iparams;
     actWrkrInfo_t *__restrict__ pWrkrInfo;
+    struct tplPropCache *const pCache = wtiGetPropCache(pWti);
+    sbool bModifiesMsg = 0;
     DEFiRet;
 
     pWrkrInfo = &(pWti->actWrkrInfo[pAction->iActionNbr]);
     if (pAction->isTransactional) {
         CHKiRet(wtiNewIParam(pWti, pAction, &iparams));
         for (i = 0; i < pAction->iNumTpls; ++i) {
-            CHKiRet(tplToString(pAction->ppTpl[i], pMsg, &actParam(iparams, pAction->iNumTpls, 0, i), ttNow));
+            CHKiRet(tplToStringCached(pAction->ppTpl[i], pMsg, &actParam(iparams, pAction->iNumTpls, 0, i), ttNow,
+                                      pCache));
         }
     } else {
         for (i = 0; i < pAction->iNumTpls; ++i) {
             switch (pAction->peParamPassing[i]) {
                 case ACT_STRING_PASSING:
-                    CHKiRet(tplToString(pAction->ppTpl[i], pMsg, &(pWrkrInfo->p.nontx.actParams[i]), ttNow));
+                    CHKiRet(tplToStringCached(pAction->ppTpl[i], pMsg, &(pWrkrInfo->p.nontx.actParams[i]), ttNow,
+                                              pCache));
                     break;
                 /* note: ARRAY_PASSING mode has been removed in 8.26.0; if it
                  * is ever needed again, it can be found in 8.25.0.
@@ -1307,6 +1311,7 @@ static rsRetVal prepareDoActionParams(action_t *__restrict__ const pAction,
                  */
                 case ACT_MSG_PASSING:
                     pWrkrInfo->p.nontx.actParams[i].param = (void *)pMsg;
+                    bModifiesMsg = 1;
                     break;
                 case ACT_JSON_PASSING:
                     CHKiRet(tplToJSON(pAction->ppTpl[i], pMsg, &json, ttNow));
@@ -1323,6 +1328,10 @@ static rsRetVal prepareDoActionParams(action_t *__restrict__ const pAction,
     }
 
 finalize_it:
+    /* the action may modify the message (mm modules), so values cached
+     * so far must not be used by later actions.
+     */
+    if (bModifiesMsg && pCache != NULL) tplPropCacheInvalidate(pCache);
     RETiRet;
 }
 
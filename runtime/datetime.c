@@ -31,6 +31,7 @@
 #include <ctype.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
 #ifdef HAVE_SYS_TIME_H
     #include <sys/time.h>
 #endif
@@ -269,6 +270,93 @@ static int srSLMGParseInt32(uchar **ppsz, int *pLenStr) {
 }
 
 
+/* Per-thread cache of second-resolution timestamp work.
+ * Messages arrive in bursts that share the same second, so the formatters,
+ * syslogTime2time_t() and the parsers see the same date/time fields over
+ * and over again. We keep the last result of each of them per thread and
+ * reuse it as long as the inputs are identical. Only the sub-second part
+ * is computed for every call. The cache lives in thread-specific storage,
+ * so no locking is needed. If it cannot be allocated, we simply compute
+ * everything as before.
+ */
+typedef struct tsCache_s {
+    uint64_t key3339; /* second key and UTC offset of sz3339 */
+    uint32_t offs3339;
+    int len3339Offs;
+    char sz3339[19]; /* "yyyy-mm-ddThh:mm:ss" */
+    char sz3339Offs[7]; /* "Z" or "+hh:mm" */
+    uint64_t key3164;
+    int bBuggyDay3164;
+    char sz3164[16];
+    uint64_t keyMySQL;
+    char szMySQL[15];
+    uint64_t keyPgSQL;
+    char szPgSQL[20];
+    uint64_t keyTime_t;
+    uint32_t offsTime_t;
+    time_t tTime_t;
+    /* last parsed date/time texts and their decoded fields */
+    uchar parsed3339[19];
+    int bHaveParsed3339;
+    struct syslogTime fields3339;
+    uchar parsed3164[15];
+    int bHaveParsed3164;
+    struct syslogTime fields3164;
+} tsCache_t;
+
+static pthread_key_t keyTsCache;
+static int bHaveKeyTsCache = 0;
+
+static tsCache_t *getTsCache(void) {
+    tsCache_t *pCache;
+
+    if (!bHaveKeyTsCache) return NULL;
+    pCache = (tsCache_t *)pthread_getspecific(keyTsCache);
+    if (pCache == NULL) {
+        if ((pCache = calloc(1, sizeof(tsCache_t))) == NULL) return NULL;
+        if (pthread_setspecific(keyTsCache, pCache) != 0) {
+            DBGPRINTF("datetime: error setspecific keyTsCache\n");
+            free(pCache);
+            return NULL;
+        }
+    }
+    return pCache;
+}
+
+static void tsCacheInit(void) {
+    if (pthread_key_create(&keyTsCache, free) == 0) {
+        bHaveKeyTsCache = 1;
+    } else {
+        DBGPRINTF("datetime: pthread_key_create failed, timestamp cache disabled\n");
+    }
+}
+
+/* The key destructor only runs for threads that terminate. The calling
+ * thread (usually the main thread) still owns its cache, so free it here.
+ */
+static void tsCacheExit(void) {
+    if (!bHaveKeyTsCache) return;
+    bHaveKeyTsCache = 0;
+    free(pthread_getspecific(keyTsCache));
+    pthread_setspecific(keyTsCache, NULL);
+    pthread_key_delete(keyTsCache);
+}
+
+/* build a cache key from the second-resolution fields of a timestamp. The
+ * lowest bit is always set, so a zeroed cache entry never matches.
+ */
+static inline uint64_t tsSecondKey(const struct syslogTime *ts) {
+    return ((uint64_t)(uint16_t)ts->year << 48) | ((uint64_t)(uint8_t)ts->month << 40) |
+           ((uint64_t)(uint8_t)ts->day << 32) | ((uint64_t)(uint8_t)ts->hour << 24) |
+           ((uint64_t)(uint8_t)ts->minute << 16) | ((uint64_t)(uint8_t)ts->second << 8) | 1;
+}
+
+static inline uint32_t tsOffsetKey(const struct syslogTime *ts) {
+    return ((uint32_t)(uint8_t)ts->OffsetMode << 16) | ((uint32_t)(uint8_t)ts->OffsetHour << 8) |
+           (uint32_t)(uint8_t)ts->OffsetMinute;
+}
+
+
 /**
  * Parse a TIMESTAMP-3339.
  * updates the parse pointer position. The pTime parameter
@@ -295,6 +383,7 @@ static rsRetVal ParseTIMESTAMP3339(struct syslogTime *pTime, uchar **ppszTS, int
     int OffsetMinute; /* UTC offset in minutes */
     int lenStr;
     /* end variables to temporarily hold time information while we parse */
+    tsCache_t *const pCache = getTsCache();
     DEFiRet;
 
     assert(pTime != NULL);
@@ -302,6 +391,24 @@ static rsRetVal ParseTIMESTAMP3339(struct syslogTime *pTime, uchar **ppszTS, int
     assert(pszTS != NULL);
 
     lenStr = *pLenStr;
+
+    /* if the date and time are the same text as in the last timestamp we parsed,
+     * reuse its fields. A following digit would extend the seconds, so we require
+     * a non-digit there.
+     */
+    if (pCache != NULL && pCache->bHaveParsed3339 && lenStr > 19 && !isdigit(pszTS[19]) &&
+        !memcmp(pszTS, pCache->parsed3339, 19)) {
+        year = pCache->fields3339.year;
+        month = pCache->fields3339.month;
+        day = pCache->fields3339.day;
+        hour = pCache->fields3339.hour;
+        minute = pCache->fields3339.minute;
+        second = pCache->fields3339.second;
+        pszTS += 19;
+        lenStr -= 19;
+        goto parse_secfrac;
+    }
+
     year = srSLMGParseInt32(&pszTS, &lenStr);
 
     /* We take the liberty to accept slightly malformed timestamps e.g. in
@@ -338,6 +445,18 @@ static rsRetVal ParseTIMESTAMP3339(struct syslogTime *pTime, uchar **ppszTS, int
     second = srSLMGParseInt32(&pszTS, &lenStr);
     if (second < 0 || second > 60) ABORT_FINALIZE(RS_RET_INVLD_TIME);
 
+    if (pCache != NULL && pszTS - *ppszTS == 19) {
+        memcpy(pCache->parsed3339, *ppszTS, 19);
+        pCache->fields3339.year = year;
+        pCache->fields3339.month = month;
+        pCache->fields3339.day = day;
+        pCache->fields3339.hour = hour;
+        pCache->fields3339.minute = minute;
+        pCache->fields3339.second = second;
+        pCache->bHaveParsed3339 = 1;
+    }
+
+parse_secfrac:
     /* Now let's see if we have secfrac */
     if (lenStr > 0 && *pszTS == '.') {
         --lenStr;
@@ -455,6 +574,8 @@ static rsRetVal ParseTIMESTAMP3164(
     /* end variables to temporarily hold time information while we parse */
     int lenStr;
     uchar *pszTS;
+    uchar *pszMonth;
+    tsCache_t *const pCache = getTsCache();
     DEFiRet;
 
     assert(ppszTS != NULL);
@@ -477,6 +598,22 @@ static rsRetVal ParseTIMESTAMP3164(
         ++pszTS; /* skip SP */
     }
 
+    /* reuse the fields of the last parsed "Mon dd hh:mm:ss" if the text is the
+     * same. As with 3339, a following digit would extend the seconds.
+     */
+    pszMonth = pszTS;
+    if (pCache != NULL && pCache->bHaveParsed3164 && lenStr >= 15 && (lenStr == 15 || !isdigit(pszTS[15])) &&
+        !memcmp(pszTS, pCache->parsed3164, 15)) {
+        month = pCache->fields3164.month;
+        day = pCache->fields3164.day;
+        hour = pCache->fields3164.hour;
+        minute = pCache->fields3164.minute;
+        second = pCache->fields3164.second;
+        pszTS += 15;
+        lenStr -= 15;
+        goto parse_secfrac;
+    }
+
     /* If we look at the month (Jan, Feb, Mar, Apr, May, Jun, Jul, Aug, Sep, Oct, Nov, Dec),
      * we may see the following character sequences occur:
      *
@@ -668,6 +805,20 @@ static rsRetVal ParseTIMESTAMP3164(
     second = srSLMGParseInt32(&pszTS, &lenStr);
     if (second < 0 || second > 60) ABORT_FINALIZE(RS_RET_INVLD_TIME);
 
+    /* a year found in place of the hour is at least 16 bytes long, so a
+     * 15 byte text always is a plain "Mon dd hh:mm:ss".
+     */
+    if (pCache != NULL && pszTS - pszMonth == 15) {
+        memcpy(pCache->parsed3164, pszMonth, 15);
+        pCache->fields3164.month = month;
+        pCache->fields3164.day = day;
+        pCache->fields3164.hour = hour;
+        pCache->fields3164.minute = minute;
+        pCache->fields3164.second = second;
+        pCache->bHaveParsed3164 = 1;
+    }
+
+parse_secfrac:
     /* as an extension e.g. found in CISCO IOS, we support sub-second resultion.
      * It's presence is indicated by a dot immediately following the second.
      */
@@ -781,9 +932,18 @@ static int formatTimestampToMySQL(struct syslogTime *ts, char *pBuf) {
      * on user requests for this feature before doing anything.
      * rgerhards, 2007-06-26
      */
+    tsCache_t *const pCache = getTsCache();
+    uint64_t key;
+
     assert(ts != NULL);
     assert(pBuf != NULL);
 
+    key = tsSecondKey(ts);
+    if (pCache != NULL && pCache->keyMySQL == key) {
+        memcpy(pBuf, pCache->szMySQL, 15);
+        return 15;
+    }
+
     pBuf[0] = (ts->year / 1000) % 10 + '0';
     pBuf[1] = (ts->year / 100) % 10 + '0';
     pBuf[2] = (ts->year / 10) % 10 + '0';
@@ -799,14 +959,27 @@ static int formatTimestampToMySQL(struct syslogTime *ts, char *pBuf) {
     pBuf[12] = (ts->second / 10) % 10 + '0';
     pBuf[13] = ts->second % 10 + '0';
     pBuf[14] = '\0';
+    if (pCache != NULL) {
+        memcpy(pCache->szMySQL, pBuf, 15);
+        pCache->keyMySQL = key;
+    }
     return 15;
 }
 
 static int formatTimestampToPgSQL(struct syslogTime *ts, char *pBuf) {
     /* see note in formatTimestampToMySQL, applies here as well */
+    tsCache_t *const pCache = getTsCache();
+    uint64_t key;
+
     assert(ts != NULL);
     assert(pBuf != NULL);
 
+    key = tsSecondKey(ts);
+    if (pCache != NULL && pCache->keyPgSQL == key) {
+        memcpy(pBuf, pCache->szPgSQL, 20);
+        return 19;
+    }
+
     pBuf[0] = (ts->year / 1000) % 10 + '0';
     pBuf[1] = (ts->year / 100) % 10 + '0';
     pBuf[2] = (ts->year / 10) % 10 + '0';
@@ -827,6 +1000,10 @@ static int formatTimestampToPgSQL(struct syslogTime *ts, char *pBuf) {
     pBuf[17] = (ts->second / 10) % 10 + '0';
     pBuf[18] = ts->second % 10 + '0';
     pBuf[19] = '\0';
+    if (pCache != NULL) {
+        memcpy(pCache->szPgSQL, pBuf, 20);
+        pCache->keyPgSQL = key;
+    }
     return 19;
 }
 
@@ -898,10 +1075,27 @@ static int formatTimestamp3339(struct syslogTime *ts, char *pBuf) {
     int power;
     int secfrac;
     short digit;
+    tsCache_t *const pCache = getTsCache();
+    uint64_t key;
+    uint32_t offs;
 
     assert(ts != NULL);
     assert(pBuf != NULL);
 
+    key = tsSecondKey(ts);
+    offs = tsOffsetKey(ts);
+    if (pCache != NULL && pCache->key3339 == key && pCache->offs3339 == offs) {
+        /* same second and offset: only the fraction needs to be formatted */
+        memcpy(pBuf, pCache->sz3339, 19);
+        iBuf = 19;
+        if (ts->secfracPrecision > 0) {
+            pBuf[iBuf++] = '.';
+            iBuf += formatTimestampSecFrac(ts, pBuf + iBuf);
+        }
+        memcpy(pBuf + iBuf, pCache->sz3339Offs, pCache->len3339Offs + 1);
+        return iBuf + pCache->len3339Offs;
+    }
+
     /* start with fixed parts */
     /* year yyyy */
     pBuf[0] = (ts->year / 1000) % 10 + '0';
@@ -942,6 +1136,13 @@ static int formatTimestamp3339(struct syslogTime *ts, char *pBuf) {
         }
     }
 
+    if (pCache != NULL) {
+        memcpy(pCache->sz3339, pBuf, 19);
+        pCache->key3339 = key;
+        pCache->offs3339 = offs;
+        pCache->len3339Offs = iBuf; /* start of the offset, fixed below */
+    }
+
     if (ts->OffsetMode == 'Z') {
         pBuf[iBuf++] = 'Z';
     } else {
@@ -955,6 +1156,12 @@ static int formatTimestamp3339(struct syslogTime *ts, char *pBuf) {
 
     pBuf[iBuf] = '\0';
 
+    if (pCache != NULL) {
+        const int iOffs = pCache->len3339Offs;
+        pCache->len3339Offs = iBuf - iOffs;
+        memcpy(pCache->sz3339Offs, pBuf + iOffs, pCache->len3339Offs + 1);
+    }
+
     return iBuf;
 }
 
@@ -971,9 +1178,17 @@ static int formatTimestamp3339(struct syslogTime *ts, char *pBuf) {
  */
 static int formatTimestamp3164(struct syslogTime *ts, char *pBuf, int bBuggyDay) {
     int iDay;
+    tsCache_t *const pCache = getTsCache();
+    uint64_t key;
     assert(ts != NULL);
     assert(pBuf != NULL);
 
+    key = tsSecondKey(ts);
+    if (pCache != NULL && pCache->key3164 == key && pCache->bBuggyDay3164 == bBuggyDay) {
+        memcpy(pBuf, pCache->sz3164, 16);
+        return 16;
+    }
+
     pBuf[0] = monthNames[(ts->month - 1) % 12][0];
     pBuf[1] = monthNames[(ts->month - 1) % 12][1];
     pBuf[2] = monthNames[(ts->month - 1) % 12][2];
@@ -991,6 +1206,11 @@ static int formatTimestamp3164(struct syslogTime *ts, char *pBuf, int bBuggyDay)
     pBuf[13] = (ts->second / 10) % 10 + '0';
     pBuf[14] = ts->second % 10 + '0';
     pBuf[15] = '\0';
+    if (pCache != NULL) {
+        memcpy(pCache->sz3164, pBuf, 16);
+        pCache->key3164 = key;
+        pCache->bBuggyDay3164 = bBuggyDay;
+    }
     return 16; /* traditional: number of bytes written */
 }
 
@@ -1018,6 +1238,15 @@ static time_t syslogTime2time_t(const struct syslogTime *ts) {
     long MonthInDays, NumberOfYears, NumberOfDays;
     int utcOffset;
     time_t TimeInUnixFormat;
+    tsCache_t *const pCache = getTsCache();
+    uint64_t key;
+    uint32_t offs;
+
+    key = tsSecondKey(ts);
+    offs = tsOffsetKey(ts);
+    if (pCache != NULL && pCache->keyTime_t == key && pCache->offsTime_t == offs) {
+        return pCache->tTime_t;
+    }
 
     if (ts->year < 1970 || ts->year > 2100) {
         TimeInUnixFormat = 0;
@@ -1098,6 +1327,11 @@ static time_t syslogTime2time_t(const struct syslogTime *ts) {
     utcOffset = ts->OffsetHour * 3600 + ts->OffsetMinute * 60;
     if (ts->OffsetMode == '+') utcOffset *= -1; /* if timestamp is ahead, we need to "go back" to UTC */
     TimeInUnixFormat += utcOffset;
+    if (pCache != NULL) {
+        pCache->tTime_t = TimeInUnixFormat;
+        pCache->keyTime_t = key;
+        pCache->offsTime_t = offs;
+    }
 done:
     return TimeInUnixFormat;
 }
@@ -1382,7 +1616,17 @@ ENDobjQueryInterface(datetime)
  */
 BEGINAbstractObjClassInit(datetime, 1, OBJ_IS_CORE_MODULE) /* class, version */
     /* request objects we use */
+    tsCacheInit();
 ENDObjClassInit(datetime)
 
+
+/* Exit the datetime class. This is called from the obj class exit, after
+ * all other threads are gone.
+ */
+BEGINObjClassExit(datetime, OBJ_IS_CORE_MODULE) /* class, version */
+    CODESTARTObjClassExit(datetime);
+    tsCacheExit();
+ENDObjClassExit(datetime)
+
 /* vi:set ai:
  */
\ No newline at end of file
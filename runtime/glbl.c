@@ -134,6 +134,10 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"defaultnetstreamdriver", eCmdHdlrString, 0},
     {"defaultopensslengine", eCmdHdlrString, 0},
     {"netstreamdrivercaextrafiles", eCmdHdlrString, 0},
+    {"netstreamdriver.ktls", eCmdHdlrBinary, 0},
+    {"netstreamdriver.sessionresumption", eCmdHdlrBinary, 0},
+    {"netstreamdriver.sessionlifetime", eCmdHdlrPositiveInt, 0},
+    {"netstreamdriver.ticketkeyfile", eCmdHdlrString, 0},
     {"maxmessagesize", eCmdHdlrSize, 0},
     {"oversizemsg.errorfile", eCmdHdlrGetWord, 0},
     {"oversizemsg.report", eCmdHdlrBinary, 0},
@@ -199,6 +203,7 @@ static struct cnfparamdescr cnfparamdescr[] = {
     {"reverselookup.cache.ttl.default", eCmdHdlrNonNegInt, 0},
     {"reverselookup.cache.ttl.enable", eCmdHdlrBinary, 0},
     {"parser.supportcompressionextension", eCmdHdlrBinary, 0},
+    {"parser.adaptiveorder", eCmdHdlrBinary, 0},
     {"shutdown.queue.doublesize", eCmdHdlrBinary, 0},
     {"debug.files", eCmdHdlrArray, 0},
     {"debug.whitelist", eCmdHdlrBinary, 0},
@@ -287,6 +292,10 @@ SIMP_PROP_GET(DfltNetstrmDrvrCRLF, pszDfltNetstrmDrvrCRLF, uchar *)
 SIMP_PROP_GET(DfltNetstrmDrvrCertFile, pszDfltNetstrmDrvrCertFile, uchar *)
 SIMP_PROP_GET(DfltNetstrmDrvrKeyFile, pszDfltNetstrmDrvrKeyFile, uchar *)
 SIMP_PROP_GET(NetstrmDrvrCAExtraFiles, pszNetstrmDrvrCAExtraFiles, uchar *)
+SIMP_PROP_GET(NetstrmDrvrKTLS, bNetstrmDrvrKTLS, int)
+SIMP_PROP_GET(NetstrmDrvrSessResumption, bNetstrmDrvrSessResumption, int)
+SIMP_PROP_GET(NetstrmDrvrSessLifetime, iNetstrmDrvrSessLifetime, int)
+SIMP_PROP_GET(NetstrmDrvrTicketKeyFile, pszNetstrmDrvrTicketKeyFile, uchar *)
 SIMP_PROP_GET(ParserControlCharacterEscapePrefix, parser.cCCEscapeChar, uchar)
 SIMP_PROP_GET(ParserDropTrailingLFOnReception, parser.bDropTrailingLF, int)
 SIMP_PROP_GET(ParserDropTrailingCROnReception, parser.bDropTrailingCR, int)
@@ -1123,6 +1132,10 @@ BEGINobjQueryInterface(glbl)
     pIf->GetDfltNetstrmDrvr = GetDfltNetstrmDrvr;
     pIf->GetDfltOpensslEngine = GetDfltOpensslEngine;
     pIf->GetNetstrmDrvrCAExtraFiles = GetNetstrmDrvrCAExtraFiles;
+    pIf->GetNetstrmDrvrKTLS = GetNetstrmDrvrKTLS;
+    pIf->GetNetstrmDrvrSessResumption = GetNetstrmDrvrSessResumption;
+    pIf->GetNetstrmDrvrSessLifetime = GetNetstrmDrvrSessLifetime;
+    pIf->GetNetstrmDrvrTicketKeyFile = GetNetstrmDrvrTicketKeyFile;
     pIf->GetParserControlCharacterEscapePrefix = GetParserControlCharacterEscapePrefix;
     pIf->GetParserDropTrailingLFOnReception = GetParserDropTrailingLFOnReception;
     pIf->GetParserDropTrailingCROnReception = GetParserDropTrailingCROnReception;
@@ -1169,6 +1182,8 @@ static rsRetVal resetConfigVariables(uchar __attribute__((unused)) * pp, void __
     LocalHostNameOverride = NULL;
     free(loadConf->globals.oversizeMsgErrorFile);
     loadConf->globals.oversizeMsgErrorFile = NULL;
+    free(loadConf->globals.pszNetstrmDrvrTicketKeyFile);
+    loadConf->globals.pszNetstrmDrvrTicketKeyFile = NULL;
     loadConf->globals.oversizeMsgInputMode = glblOversizeMsgInputMode_Accept;
     loadConf->globals.reportChildProcessExits = REPORT_CHILD_PROCESS_EXITS_ERRORS;
     free(loadConf->globals.pszWorkDir);
@@ -1427,6 +1442,15 @@ rsRetVal glblDoneLoadCnf(void) {
         } else if (!strcmp(paramblk.descr[i].name, "netstreamdrivercaextrafiles")) {
             cstr = (uchar *)es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
             setNetstrmDrvrCAExtraFiles(NULL, cstr);
+        } else if (!strcmp(paramblk.descr[i].name, "netstreamdriver.ktls")) {
+            loadConf->globals.bNetstrmDrvrKTLS = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "netstreamdriver.sessionresumption")) {
+            loadConf->globals.bNetstrmDrvrSessResumption = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "netstreamdriver.sessionlifetime")) {
+            loadConf->globals.iNetstrmDrvrSessLifetime = (int)cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "netstreamdriver.ticketkeyfile")) {
+            free(loadConf->globals.pszNetstrmDrvrTicketKeyFile);
+            loadConf->globals.pszNetstrmDrvrTicketKeyFile = (uchar *)es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
         } else if (!strcmp(paramblk.descr[i].name, "preservefqdn")) {
             bPreserveFQDN = (int)cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "compactjsonstring")) {
@@ -1619,6 +1643,8 @@ rsRetVal glblDoneLoadCnf(void) {
             loadConf->globals.dnscacheEnableTTL = cnfparamvals[i].val.d.n;
         } else if (!strcmp(paramblk.descr[i].name, "parser.supportcompressionextension")) {
             loadConf->globals.bSupportCompressionExtension = cnfparamvals[i].val.d.n;
+        } else if (!strcmp(paramblk.descr[i].name, "parser.adaptiveorder")) {
+            loadConf->globals.bParserAdaptiveOrder = cnfparamvals[i].val.d.n;
         } else {
             dbgprintf(
                 "glblDoneLoadCnf: program error, non-handled "
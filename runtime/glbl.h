@@ -110,10 +110,14 @@ BEGINinterface(glbl) /* name must also be changed in ENDinterface macro! */
     SIMP_PROP(ParserEscapeControlCharactersCStyle, int);
     SIMP_PROP(ParseHOSTNAMEandTAG, int);
     SIMP_PROP(OptionDisallowWarning, int);
+    SIMP_PROP(NetstrmDrvrKTLS, int);
+    SIMP_PROP(NetstrmDrvrSessResumption, int);
+    SIMP_PROP(NetstrmDrvrSessLifetime, int);
+    SIMP_PROP(NetstrmDrvrTicketKeyFile, uchar *);
 
 #undef SIMP_PROP
 ENDinterface(glbl)
-#define glblCURR_IF_VERSION 11 /* increment whenever you change the interface structure! */
+#define glblCURR_IF_VERSION 13 /* increment whenever you change the interface structure! */
 /* version 2 had PreserveFQDN added - rgerhards, 2008-12-08 */
 
 /* the remaining prototypes */
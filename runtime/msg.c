@@ -95,6 +95,7 @@ struct json_object *global_var_root = NULL;
 #ifdef HAVE_LOGNORM_TURBO
 static int msgMaterializeTurboJSON(smsg_t *pMsg);
 #endif
+static rsRetVal jsonMerge(struct json_object *existing, struct json_object *json);
 
 /* static data */
 DEFobjStaticHelpers;
@@ -254,6 +255,18 @@ static rsRetVal jsonPathFindParent(
     struct json_object *jroot, uchar *name, uchar *leaf, struct json_object **parent, int bCreate);
 static uchar *jsonPathGetLeaf(uchar *name, int lenName);
 static json_bool jsonVarExtract(struct json_object *root, const char *key, struct json_object **value);
+static void msgJsonPathCacheInvalidate(smsg_t *const pMsg);
+static rsRetVal jsonPropFindParent(smsg_t *pMsg,
+                                   msgPropDescr_t *pProp,
+                                   struct json_object *jroot,
+                                   struct json_object **parent);
+static json_bool jsonPropExtractLeaf(const msgPropDescr_t *pProp,
+                                     struct json_object *parent,
+                                     struct json_object **value);
+static rsRetVal jsonPropLookup(smsg_t *pMsg,
+                               msgPropDescr_t *pProp,
+                               struct json_object *jroot,
+                               struct json_object **field);
 void getRawMsgAfterPRI(smsg_t *const pM, uchar **pBuf, int *piLen);
 
 
@@ -730,6 +743,11 @@ static rsRetVal msgBaseConstruct(smsg_t **ppThis) {
     pM->pRuleset = NULL;
     pM->json = NULL;
     pM->localvars = NULL;
+    pM->pJsonPathCache = NULL;
+    pM->pJsonShare = NULL;
+    pM->pLazyJson = NULL;
+    pM->pLazyJsonOps = NULL;
+    pM->iVarGen = 0;
 #ifdef HAVE_LOGNORM_TURBO
     pM->turbo_result = NULL;
     pM->turbo_result_free = NULL;
@@ -851,6 +869,73 @@ void MsgReleaseTurboResult(smsg_t *const pMsg) {
 }
 #endif
 
+
+/* drop the deferred $! tree without materializing it */
+static void msgLazyJsonRelease(smsg_t *const pMsg) {
+    if (pMsg->pLazyJson != NULL) pMsg->pLazyJsonOps->destruct(pMsg->pLazyJson);
+    __atomic_store_n(&pMsg->pLazyJson, NULL, __ATOMIC_RELAXED);
+    pMsg->pLazyJsonOps = NULL;
+}
+
+
+/* Message variables shared between MsgDup() copies.
+ *
+ * Instead of deep-copying $! and $. on every MsgDup(), the copies share both
+ * trees through a refcounted msgJsonShare. While a message points to a
+ * share, its json/localvars are the share's trees and must not be modified,
+ * nor handed out or serialized (json-c caches serializations in the object).
+ * Pure reads, like looking up a string value, are fine. Anything else calls
+ * msgJsonUnshare() first, which copies the trees - or simply takes them
+ * over if all other copies are gone. Messages that never touch their
+ * variables after duplication thus never copy them.
+ */
+struct msgJsonShare {
+    unsigned refs;
+    struct json_object *json;
+    struct json_object *localvars;
+};
+
+static void msgJsonShareRelease(struct msgJsonShare *const share) {
+    if (__atomic_sub_fetch(&share->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (share->json != NULL) json_object_put(share->json);
+        if (share->localvars != NULL) json_object_put(share->localvars);
+        free(share);
+    }
+}
+
+/* give pMsg private json/localvars trees. Must be called with pMsg->mut
+ * held. On failure, the message still uses the shared trees.
+ */
+rsRetVal msgJsonUnshare(smsg_t *const pMsg) {
+    struct msgJsonShare *const share = pMsg->pJsonShare;
+    struct json_object *json = NULL;
+    struct json_object *localvars = NULL;
+    DEFiRet;
+
+    if (share == NULL) FINALIZE;
+
+    if (__atomic_load_n(&share->refs, __ATOMIC_ACQUIRE) == 1) {
+        /* all other copies are gone, the trees are ours now */
+        free(share);
+        pMsg->pJsonShare = NULL;
+        FINALIZE;
+    }
+
+    if (share->json != NULL) CHKmalloc(json = jsonDeepCopy(share->json));
+    if (share->localvars != NULL) CHKmalloc(localvars = jsonDeepCopy(share->localvars));
+    pMsg->json = json;
+    pMsg->localvars = localvars;
+    pMsg->pJsonShare = NULL;
+    json = localvars = NULL;
+    msgJsonShareRelease(share);
+    msgJsonPathCacheInvalidate(pMsg);
+
+finalize_it:
+    if (json != NULL) json_object_put(json);
+    if (localvars != NULL) json_object_put(localvars);
+    RETiRet;
+}
+
 rsRetVal msgDestruct(smsg_t **ppThis) {
     DEFiRet;
     smsg_t *pThis;
@@ -897,8 +982,14 @@ rsRetVal msgDestruct(smsg_t **ppThis) {
         if (pThis->pCSAPPNAME != NULL) rsCStrDestruct(&pThis->pCSAPPNAME);
         if (pThis->pCSPROCID != NULL) rsCStrDestruct(&pThis->pCSPROCID);
         if (pThis->pCSMSGID != NULL) rsCStrDestruct(&pThis->pCSMSGID);
-        if (pThis->json != NULL) json_object_put(pThis->json);
-        if (pThis->localvars != NULL) json_object_put(pThis->localvars);
+        if (pThis->pJsonShare != NULL) {
+            msgJsonShareRelease(pThis->pJsonShare);
+        } else {
+            if (pThis->json != NULL) json_object_put(pThis->json);
+            if (pThis->localvars != NULL) json_object_put(pThis->localvars);
+        }
+        free(pThis->pJsonPathCache);
+        msgLazyJsonRelease(pThis);
 #ifdef HAVE_LOGNORM_TURBO
         MsgReleaseTurboResult(pThis);
 #endif
@@ -1089,8 +1180,38 @@ ENDobjDestruct
     }
 #endif
 
-    if (pOld->json != NULL) pNew->json = jsonDeepCopy(pOld->json);
-    if (pOld->localvars != NULL) pNew->localvars = jsonDeepCopy(pOld->localvars);
+    /* The deferred $! tree is a single small block, so the copy gets its
+     * own. If that fails, materialize so the tree is shared below. */
+    if (pOld->pLazyJson != NULL) {
+        if ((pNew->pLazyJson = pOld->pLazyJsonOps->dup(pOld->pLazyJson)) != NULL) {
+            pNew->pLazyJsonOps = pOld->pLazyJsonOps;
+        } else if (msgMaterializeLazyJSON(pOld) != RS_RET_OK) {
+            MsgUnlock(pOld);
+            msgDestruct(&pNew);
+            return NULL;
+        }
+    }
+
+    if (pOld->json != NULL || pOld->localvars != NULL) {
+        if (pOld->pJsonShare == NULL) {
+            struct msgJsonShare *const share = malloc(sizeof(struct msgJsonShare));
+            if (share != NULL) {
+                share->refs = 1; /* pOld, pNew is added below */
+                share->json = pOld->json;
+                share->localvars = pOld->localvars;
+                pOld->pJsonShare = share;
+            }
+        }
+        if (pOld->pJsonShare != NULL) {
+            __atomic_add_fetch(&pOld->pJsonShare->refs, 1, __ATOMIC_RELAXED);
+            pNew->pJsonShare = pOld->pJsonShare;
+            pNew->json = pOld->json;
+            pNew->localvars = pOld->localvars;
+        } else {
+            if (pOld->json != NULL) pNew->json = jsonDeepCopy(pOld->json);
+            if (pOld->localvars != NULL) pNew->localvars = jsonDeepCopy(pOld->localvars);
+        }
+    }
     MsgUnlock(pOld);
 
     /* we do not copy all other cache properties, as we do not even know
@@ -1143,6 +1264,7 @@ static const char *jsonToString(struct json_object *const json) {
 static rsRetVal MsgSerialize(smsg_t *pThis, strm_t *pStrm) {
     uchar *psz;
     int len;
+    rsRetVal localRet;
     DEFiRet;
 
     assert(pThis != NULL);
@@ -1155,6 +1277,10 @@ static rsRetVal MsgSerialize(smsg_t *pThis, strm_t *pStrm) {
     MsgUnlock(pThis);
     if (!materialized) ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
 #endif
+    MsgLock(pThis);
+    localRet = msgMaterializeLazyJSON(pThis);
+    MsgUnlock(pThis);
+    CHKiRet(localRet);
 
     /* then serialize elements */
     CHKiRet(obj.BeginSerialize(pStrm, (obj_t *)pThis));
@@ -1179,6 +1305,10 @@ static rsRetVal MsgSerialize(smsg_t *pThis, strm_t *pStrm) {
     CHKiRet(obj.SerializeProp(pStrm, UCHAR_CONSTANT("pszRcvFromIP"), PROPTYPE_PSZ, (void *)psz));
     psz = pThis->pszStrucData;
     CHKiRet(obj.SerializeProp(pStrm, UCHAR_CONSTANT("pszStrucData"), PROPTYPE_PSZ, (void *)psz));
+    MsgLock(pThis);
+    localRet = msgJsonUnshare(pThis);
+    MsgUnlock(pThis);
+    CHKiRet(localRet);
     if (pThis->json != NULL) {
         MsgLock(pThis);
         psz = (uchar *)jsonToString(pThis->json);
@@ -2330,7 +2460,12 @@ const uchar *msgGetJSONMESG(smsg_t *__restrict__ const pMsg) {
     json_object_object_add(json, "uuid", jval);
 #endif
 
-    json_object_object_add(json, "$!", json_object_get(pMsg->json));
+    /* serializing writes to the tree, so it must be complete and private */
+    MsgLock(pMsg);
+    if (msgMaterializeLazyJSON(pMsg) == RS_RET_OK && msgJsonUnshare(pMsg) == RS_RET_OK) {
+        json_object_object_add(json, "$!", json_object_get(pMsg->json));
+    }
+    MsgUnlock(pMsg);
 
     pRes = (uchar *)strdup(jsonToString(json));
     json_object_put(json);
@@ -3057,6 +3192,7 @@ static int msgMaterializeTurboJSON(smsg_t *pMsg) {
     struct json_object *snap_json = NULL;
 
     if (pMsg->turbo_result == NULL || pMsg->turbo_result_to_json == NULL) return 1;
+    if (msgJsonUnshare(pMsg) != RS_RET_OK) return 0;
 
     pMsg->turbo_result_to_json(pMsg->turbo_result, &snap_json);
 
@@ -3065,6 +3201,7 @@ static int msgMaterializeTurboJSON(smsg_t *pMsg) {
     if (snap_json == NULL) return 0;
 
     pMsg->turbo_result_to_json = NULL; /* materialized successfully */
+    msgJsonPathCacheInvalidate(pMsg);
 
     if (pMsg->json == NULL) {
         pMsg->json = snap_json;
@@ -3085,6 +3222,87 @@ static int msgMaterializeTurboJSON(smsg_t *pMsg) {
 #endif
 
 
+rsRetVal msgMaterializeLazyJSON(smsg_t *const pMsg) {
+    struct json_object *json;
+    DEFiRet;
+
+    if (pMsg->pLazyJson == NULL) FINALIZE;
+    CHKiRet(msgJsonUnshare(pMsg));
+    /* keep the deferred tree on failure so a later access may retry */
+    CHKmalloc(json = pMsg->pLazyJsonOps->toJSON(pMsg->pLazyJson));
+    msgLazyJsonRelease(pMsg);
+    msgJsonPathCacheInvalidate(pMsg);
+    if (pMsg->json == NULL) {
+        pMsg->json = json;
+    } else {
+        CHKiRet(jsonMerge(pMsg->json, json));
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+rsRetVal msgSetLazyJSON(smsg_t *const pMsg, void *const ctx, const struct msgLazyJsonOps *const ops) {
+    DEFiRet;
+
+    MsgLock(pMsg);
+#ifdef HAVE_LOGNORM_TURBO
+    /* a pending turbo snapshot was written first and must stay below us */
+    if (!msgMaterializeTurboJSON(pMsg)) {
+        ops->destruct(ctx);
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+#endif
+    /* the same for an earlier deferred tree */
+    iRet = msgMaterializeLazyJSON(pMsg);
+    if (iRet != RS_RET_OK) {
+        ops->destruct(ctx);
+        FINALIZE;
+    }
+    pMsg->pLazyJsonOps = ops;
+    __atomic_store_n(&pMsg->pLazyJson, ctx, __ATOMIC_RELAXED);
+    ++pMsg->iVarGen;
+
+finalize_it:
+    MsgUnlock(pMsg);
+    RETiRet;
+}
+
+
+/* Serve a $! property from the deferred tree without building it. Only
+ * valid while nothing else was written to $!, as the tree is merged below
+ * such writes. For MSG_LAZYJSON_STRING and _SCALAR, *pRes receives a
+ * malloc'ed copy of the value.
+ */
+static int msgLazyJsonLookup(smsg_t *const pMsg,
+                             msgPropDescr_t *const pProp,
+                             uchar **const pRes,
+                             rs_size_t *const pLen) {
+    const uchar *val;
+    rs_size_t vlen;
+    int r = MSG_LAZYJSON_UNKNOWN;
+
+    if (pProp->id != PROP_CEE || __atomic_load_n(&pMsg->pLazyJson, __ATOMIC_RELAXED) == NULL) return r;
+
+    MsgLock(pMsg);
+    if (pMsg->pLazyJson != NULL && pMsg->json == NULL) {
+        r = pMsg->pLazyJsonOps->lookup(pMsg->pLazyJson, pProp->name, pProp->nameLen, &val, &vlen);
+        if (r == MSG_LAZYJSON_STRING || r == MSG_LAZYJSON_SCALAR) {
+            if ((*pRes = malloc(vlen + 1)) == NULL) {
+                r = MSG_LAZYJSON_UNKNOWN;
+            } else {
+                memcpy(*pRes, val, vlen);
+                (*pRes)[vlen] = '\0';
+                *pLen = vlen;
+            }
+        }
+    }
+    MsgUnlock(pMsg);
+    return r;
+}
+
+
 /* helper function to obtain correct JSON root and mutex depending on
  * property type (essentially based on the property id. If a non-json
  * property id is given the function errors out.
@@ -3164,9 +3382,7 @@ finalize_it:
 /* Get a JSON-Property as string value  (used for various types of JSON-based vars) */
 rsRetVal getJSONPropVal(
     smsg_t *const pMsg, msgPropDescr_t *pProp, uchar **pRes, rs_size_t *buflen, unsigned short *pbMustBeFreed) {
-    uchar *leaf;
     struct json_object **jroot;
-    struct json_object *parent;
     struct json_object *field;
     pthread_mutex_t *mut = NULL;
     DEFiRet;
@@ -3215,20 +3431,32 @@ rsRetVal getJSONPropVal(
     }
 #endif
 
+    switch (msgLazyJsonLookup(pMsg, pProp, pRes, buflen)) {
+        case MSG_LAZYJSON_STRING:
+        case MSG_LAZYJSON_SCALAR:
+            *pbMustBeFreed = 1;
+            FINALIZE;
+        case MSG_LAZYJSON_ABSENT:
+            FINALIZE;
+        default:
+            break;
+    }
+
     CHKiRet(getJSONRootAndMutex(pMsg, pProp->id, &jroot, &mut));
     pthread_mutex_lock(mut);
 #ifdef HAVE_LOGNORM_TURBO
     msgMaterializeTurboJSON(pMsg);
 #endif
+    if (pProp->id == PROP_CEE) msgMaterializeLazyJSON(pMsg);
 
     if (*jroot == NULL) FINALIZE;
 
-    if (!strcmp((char *)pProp->name, "!")) {
-        field = *jroot;
-    } else {
-        leaf = jsonPathGetLeaf(pProp->name, pProp->nameLen);
-        CHKiRet(jsonPathFindParent(*jroot, pProp->name, leaf, &parent, 0));
-        if (jsonVarExtract(parent, (char *)leaf, &field) == FALSE) field = NULL;
+    CHKiRet(jsonPropLookup(pMsg, pProp, *jroot, &field));
+    if (field != NULL && pMsg->pJsonShare != NULL && mut == &pMsg->mut &&
+        json_object_get_type(field) != json_type_string) {
+        /* serializing writes to the object, so we need our own tree */
+        CHKiRet(msgJsonUnshare(pMsg));
+        CHKiRet(jsonPropLookup(pMsg, pProp, *jroot, &field));
     }
     if (field != NULL) {
         *pRes = (uchar *)strdup(jsonToString(field));
@@ -3263,8 +3491,8 @@ rsRetVal msgGetJSONPropJSONorString(smsg_t *const pMsg,
                                     struct json_object **pjson,
                                     uchar **pcstr) {
     struct json_object **jroot;
-    uchar *leaf;
     struct json_object *parent;
+    rs_size_t lenLazy;
     pthread_mutex_t *mut = NULL;
     DEFiRet;
 
@@ -3292,11 +3520,28 @@ rsRetVal msgGetJSONPropJSONorString(smsg_t *const pMsg,
     }
 #endif
 
+    switch (msgLazyJsonLookup(pMsg, pProp, pcstr, &lenLazy)) {
+        case MSG_LAZYJSON_STRING:
+            return RS_RET_OK;
+        case MSG_LAZYJSON_SCALAR:
+            /* numbers and booleans are handed out as json objects */
+            *pjson = json_tokener_parse((char *)*pcstr);
+            free(*pcstr);
+            *pcstr = NULL;
+            if (*pjson != NULL) return RS_RET_OK;
+            break;
+        case MSG_LAZYJSON_ABSENT:
+            return RS_RET_NOT_FOUND;
+        default:
+            break;
+    }
+
     CHKiRet(getJSONRootAndMutex(pMsg, pProp->id, &jroot, &mut));
     pthread_mutex_lock(mut);
 #ifdef HAVE_LOGNORM_TURBO
     msgMaterializeTurboJSON(pMsg);
 #endif
+    if (pProp->id == PROP_CEE) msgMaterializeLazyJSON(pMsg);
     if (!strcmp((char *)pProp->name, "!")) {
         *pjson = *jroot;
         FINALIZE;
@@ -3304,9 +3549,8 @@ rsRetVal msgGetJSONPropJSONorString(smsg_t *const pMsg,
     if (*jroot == NULL) {
         ABORT_FINALIZE(RS_RET_NOT_FOUND);
     }
-    leaf = jsonPathGetLeaf(pProp->name, pProp->nameLen);
-    CHKiRet(jsonPathFindParent(*jroot, pProp->name, leaf, &parent, 0));
-    if (jsonVarExtract(parent, (char *)leaf, pjson) == FALSE) {
+    CHKiRet(jsonPropFindParent(pMsg, pProp, *jroot, &parent));
+    if (jsonPropExtractLeaf(pProp, parent, pjson) == FALSE) {
         ABORT_FINALIZE(RS_RET_NOT_FOUND);
     }
     if (*pjson == NULL) {
@@ -3330,7 +3574,6 @@ finalize_it:
 /* Get a JSON-based-variable as native json object */
 rsRetVal msgGetJSONPropJSON(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object **pjson) {
     struct json_object **jroot;
-    uchar *leaf;
     struct json_object *parent;
     pthread_mutex_t *mut = NULL;
     DEFiRet;
@@ -3342,14 +3585,14 @@ rsRetVal msgGetJSONPropJSON(smsg_t *const pMsg, msgPropDescr_t *pProp, struct js
 #ifdef HAVE_LOGNORM_TURBO
     msgMaterializeTurboJSON(pMsg);
 #endif
+    if (pProp->id == PROP_CEE) msgMaterializeLazyJSON(pMsg);
 
     if (!strcmp((char *)pProp->name, "!")) {
         *pjson = *jroot;
         FINALIZE;
     }
-    leaf = jsonPathGetLeaf(pProp->name, pProp->nameLen);
-    CHKiRet(jsonPathFindParent(*jroot, pProp->name, leaf, &parent, 0));
-    if (jsonVarExtract(parent, (char *)leaf, pjson) == FALSE) {
+    CHKiRet(jsonPropFindParent(pMsg, pProp, *jroot, &parent));
+    if (jsonPropExtractLeaf(pProp, parent, pjson) == FALSE) {
         ABORT_FINALIZE(RS_RET_NOT_FOUND);
     }
 
@@ -4060,6 +4303,10 @@ uchar *MsgGetProp(smsg_t *__restrict__ const pMsg,
 #ifdef HAVE_LOGNORM_TURBO
             msgMaterializeTurboJSON(pMsg);
 #endif
+            if (msgMaterializeLazyJSON(pMsg) != RS_RET_OK || msgJsonUnshare(pMsg) != RS_RET_OK) {
+                MsgUnlock(pMsg);
+                RET_OUT_OF_MEMORY;
+            }
             if (pMsg->json == NULL) {
                 MsgUnlock(pMsg);
                 pRes = (uchar *)"{}";
@@ -5076,6 +5323,250 @@ finalize_it:
     RETiRet;
 }
 
+/* Pre-tokenized JSON property paths.
+ *
+ * msgPropDescrFill() splits the name of a JSON property once into its parent
+ * segments and leaf, with array subscripts already parsed. Lookups then walk
+ * the segments without re-scanning the name or copying keys. The parent
+ * prefix (e.g. "!a!b" for "!a!b!c") is hashed at the same time; it is the
+ * key for a small per-message cache of parent containers, so that templates
+ * accessing many fields of the same subtree walk it only once per message.
+ * The cache is reset whenever the message's JSON is modified.
+ */
+struct jsonPathSeg {
+    char *key; /* segment as written, including a possible subscript */
+    char *arrKey; /* key without subscript, NULL if there is none */
+    size_t arrIdx;
+};
+
+struct msgPropJsonPath_s {
+    int nParents; /* number of parent segments; segs[nParents] is the leaf */
+    int lenPrefix; /* length of the parent prefix in the property name */
+    uint64_t prefixHash;
+    struct jsonPathSeg segs[];
+};
+
+#define JSON_PATH_CACHE_SLOTS 8 /* must be a power of 2 */
+#define JSON_PATH_CACHE_PREFIX_MAX 64
+struct msgJsonPathCache {
+    struct {
+        struct json_object *parent; /* NULL if slot is empty */
+        uint64_t hash;
+        propid_t id;
+        int lenPrefix;
+        uchar prefix[JSON_PATH_CACHE_PREFIX_MAX];
+    } slot[JSON_PATH_CACHE_SLOTS];
+};
+
+static uint64_t jsonPathHash(const uchar *const buf, const int len) {
+    uint64_t h = 14695981039346656037ULL; /* FNV-1a */
+    int i;
+    for (i = 0; i < len; ++i) {
+        h ^= buf[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* fill a segment from [key, key+len), storing strings at *ppBuf. The
+ * subscript rules are the same as in jsonVarExtract().
+ */
+static void jsonPathSegFill(struct jsonPathSeg *const seg,
+                            const uchar *const key,
+                            const size_t len,
+                            char **const ppBuf) {
+    char *buf = *ppBuf;
+    const char *array_idx_start;
+    const char *array_idx_end = NULL;
+    char *array_idx_num_end_discovered = NULL;
+
+    memcpy(buf, key, len);
+    buf[len] = '\0';
+    seg->key = buf;
+    seg->arrKey = NULL;
+    buf += len + 1;
+
+    array_idx_start = strchr(seg->key, '[');
+    if (array_idx_start != NULL) array_idx_end = strchr(array_idx_start, ']');
+    if (array_idx_end != NULL && (size_t)(array_idx_end - seg->key + 1) == len) {
+        errno = 0;
+        const long idx = strtol(array_idx_start + 1, &array_idx_num_end_discovered, 10);
+        const size_t name_len = (size_t)(array_idx_start - seg->key);
+        if (errno == 0 && idx >= 0 && array_idx_num_end_discovered == array_idx_end &&
+            name_len < MAX_VARIABLE_NAME_LEN) {
+            memcpy(buf, seg->key, name_len);
+            buf[name_len] = '\0';
+            seg->arrKey = buf;
+            seg->arrIdx = (size_t)idx;
+            buf += name_len + 1;
+        }
+    }
+    *ppBuf = buf;
+}
+
+/* build the pre-tokenized path for pProp. If the name contains anything the
+ * compiled walk does not handle exactly like jsonPathFindParent(), no path is
+ * built and lookups use the name as before.
+ */
+static rsRetVal msgPropJsonPathCompile(msgPropDescr_t *const pProp) {
+    struct msgPropJsonPath_s *path = NULL;
+    uchar *const name = pProp->name;
+    uchar *leaf;
+    uchar *p;
+    uchar *segStart;
+    char *buf;
+    int nParents = 0;
+    DEFiRet;
+
+    pProp->jsonPath = NULL;
+    if (name == NULL || name[0] != '!' || name[1] == '\0') FINALIZE;
+
+    leaf = jsonPathGetLeaf(name, pProp->nameLen);
+    for (p = name + 1, segStart = p; p <= leaf - 1; ++p) {
+        if (p == leaf - 1 || *p == '!') {
+            if (p - segStart >= MAX_VARIABLE_NAME_LEN - 1) FINALIZE; /* let the slow path report it */
+            if (p > segStart) ++nParents;
+            segStart = p + 1;
+        }
+    }
+
+    CHKmalloc(path = malloc(sizeof(struct msgPropJsonPath_s) + (nParents + 1) * sizeof(struct jsonPathSeg) +
+                            2 * ((size_t)pProp->nameLen + nParents + 1)));
+    buf = (char *)&path->segs[nParents + 1];
+    path->nParents = 0;
+    for (p = name + 1, segStart = p; p <= leaf - 1; ++p) {
+        if (p == leaf - 1 || *p == '!') {
+            if (p > segStart) {
+                jsonPathSegFill(&path->segs[path->nParents++], segStart, (size_t)(p - segStart), &buf);
+            }
+            segStart = p + 1;
+        }
+    }
+    jsonPathSegFill(&path->segs[nParents], leaf, ustrlen(leaf), &buf);
+    path->lenPrefix = (nParents == 0) ? 0 : (int)(leaf - 1 - name);
+    path->prefixHash = jsonPathHash(name, path->lenPrefix);
+
+    pProp->jsonPath = path;
+    path = NULL;
+
+finalize_it:
+    free(path);
+    RETiRet;
+}
+
+static json_bool jsonPathSegExtract(struct json_object *root,
+                                    const struct jsonPathSeg *const seg,
+                                    struct json_object **value) {
+    if (seg->arrKey != NULL) {
+        struct json_object *arr = NULL;
+        if (json_object_object_get_ex(root, seg->arrKey, &arr) && json_object_is_type(arr, json_type_array)) {
+            const size_t len = json_object_array_length(arr);
+            if (len > seg->arrIdx) {
+                *value = json_object_array_get_idx(arr, seg->arrIdx);
+                if (*value != NULL) return TRUE;
+            }
+            return FALSE;
+        }
+    }
+    return json_object_object_get_ex(root, seg->key, value);
+}
+
+static void msgJsonPathCacheInvalidate(smsg_t *const pMsg) {
+    int i;
+    if (pMsg->pJsonPathCache == NULL) return;
+    for (i = 0; i < JSON_PATH_CACHE_SLOTS; ++i) pMsg->pJsonPathCache->slot[i].parent = NULL;
+}
+
+/* find the parent container of a JSON property. Must be called with the
+ * mutex guarding jroot held.
+ */
+static rsRetVal jsonPropFindParent(smsg_t *const pMsg,
+                                   msgPropDescr_t *const pProp,
+                                   struct json_object *const jroot,
+                                   struct json_object **const parent) {
+    const struct msgPropJsonPath_s *const path = pProp->jsonPath;
+    struct json_object *json;
+    int bCacheable;
+    int slot = 0;
+    int i;
+    DEFiRet;
+
+    if (path == NULL) {
+        uchar *const leaf = jsonPathGetLeaf(pProp->name, pProp->nameLen);
+        CHKiRet(jsonPathFindParent(jroot, pProp->name, leaf, parent, 0));
+        FINALIZE;
+    }
+
+    /* global variables are not per message, so they are never cached */
+    bCacheable = path->nParents > 0 && path->lenPrefix <= JSON_PATH_CACHE_PREFIX_MAX && pProp->id != PROP_GLOBAL_VAR;
+    if (bCacheable && pMsg->pJsonPathCache != NULL) {
+        slot = (int)(path->prefixHash & (JSON_PATH_CACHE_SLOTS - 1));
+        const struct msgJsonPathCache *const cache = pMsg->pJsonPathCache;
+        if (cache->slot[slot].parent != NULL && cache->slot[slot].hash == path->prefixHash &&
+            cache->slot[slot].id == pProp->id && cache->slot[slot].lenPrefix == path->lenPrefix &&
+            !memcmp(cache->slot[slot].prefix, pProp->name, path->lenPrefix)) {
+            *parent = cache->slot[slot].parent;
+            FINALIZE;
+        }
+    }
+
+    json = jroot;
+    for (i = 0; i < path->nParents; ++i) {
+        struct json_object *next;
+        if (jsonPathSegExtract(json, &path->segs[i], &next) == FALSE || next == NULL) {
+            ABORT_FINALIZE(RS_RET_JNAME_INVALID);
+        }
+        json = next;
+    }
+    *parent = json;
+
+    if (bCacheable) {
+        if (pMsg->pJsonPathCache == NULL) {
+            /* the cache is an optimization only, so allocation failure is fine */
+            pMsg->pJsonPathCache = calloc(1, sizeof(struct msgJsonPathCache));
+        }
+        if (pMsg->pJsonPathCache != NULL) {
+            slot = (int)(path->prefixHash & (JSON_PATH_CACHE_SLOTS - 1));
+            pMsg->pJsonPathCache->slot[slot].parent = json;
+            pMsg->pJsonPathCache->slot[slot].hash = path->prefixHash;
+            pMsg->pJsonPathCache->slot[slot].id = pProp->id;
+            pMsg->pJsonPathCache->slot[slot].lenPrefix = path->lenPrefix;
+            memcpy(pMsg->pJsonPathCache->slot[slot].prefix, pProp->name, path->lenPrefix);
+        }
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+static json_bool jsonPropExtractLeaf(const msgPropDescr_t *const pProp,
+                                     struct json_object *const parent,
+                                     struct json_object **const value) {
+    if (pProp->jsonPath != NULL) {
+        return jsonPathSegExtract(parent, &pProp->jsonPath->segs[pProp->jsonPath->nParents], value);
+    }
+    return jsonVarExtract(parent, (char *)jsonPathGetLeaf(pProp->name, pProp->nameLen), value);
+}
+
+/* look up a JSON property below jroot; *field is NULL if it does not exist */
+static rsRetVal jsonPropLookup(smsg_t *const pMsg,
+                               msgPropDescr_t *const pProp,
+                               struct json_object *const jroot,
+                               struct json_object **const field) {
+    struct json_object *parent;
+    DEFiRet;
+
+    if (!strcmp((char *)pProp->name, "!")) {
+        *field = jroot;
+        FINALIZE;
+    }
+    CHKiRet(jsonPropFindParent(pMsg, pProp, jroot, &parent));
+    if (jsonPropExtractLeaf(pProp, parent, field) == FALSE) *field = NULL;
+
+finalize_it:
+    RETiRet;
+}
+
 static rsRetVal jsonMerge(struct json_object *existing, struct json_object *json) {
     DEFiRet;
 
@@ -5095,8 +5586,10 @@ static rsRetVal jsonMerge(struct json_object *existing, struct json_object *json
 }
 
 /* find a JSON structure element (field or container doesn't matter).  */
-rsRetVal jsonFind(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object **jsonres) {
-    uchar *leaf;
+static rsRetVal jsonFindVar(smsg_t *const pMsg,
+                            msgPropDescr_t *pProp,
+                            struct json_object **jsonres,
+                            const int bPrivate) {
     struct json_object *parent;
     struct json_object *field;
     struct json_object **jroot = NULL;
@@ -5105,6 +5598,8 @@ rsRetVal jsonFind(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object
 
     CHKiRet(getJSONRootAndMutex(pMsg, pProp->id, &jroot, &mut));
     pthread_mutex_lock(mut);
+    if (pProp->id == PROP_CEE) CHKiRet(msgMaterializeLazyJSON(pMsg));
+    if (bPrivate && mut == &pMsg->mut) CHKiRet(msgJsonUnshare(pMsg));
 
     if (*jroot == NULL) {
         field = NULL;
@@ -5116,9 +5611,8 @@ rsRetVal jsonFind(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object
     } else if (!strcmp((char *)pProp->name, ".")) {
         field = *jroot;
     } else {
-        leaf = jsonPathGetLeaf(pProp->name, pProp->nameLen);
-        CHKiRet(jsonPathFindParent(*jroot, pProp->name, leaf, &parent, 0));
-        if (jsonVarExtract(parent, (char *)leaf, &field) == FALSE) field = NULL;
+        CHKiRet(jsonPropFindParent(pMsg, pProp, *jroot, &parent));
+        if (jsonPropExtractLeaf(pProp, parent, &field) == FALSE) field = NULL;
     }
     *jsonres = field;
 
@@ -5127,12 +5621,17 @@ finalize_it:
     RETiRet;
 }
 
+rsRetVal jsonFind(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object **jsonres) {
+    /* the caller gets a pointer into the tree, so it must not be shared */
+    return jsonFindVar(pMsg, pProp, jsonres, 1);
+}
+
 /* check if JSON variable exists (works on terminal var and container) */
 rsRetVal ATTR_NONNULL() msgCheckVarExists(smsg_t *const pMsg, msgPropDescr_t *pProp) {
     struct json_object *jsonres = NULL;
     DEFiRet;
 
-    CHKiRet(jsonFind(pMsg, pProp, &jsonres));
+    CHKiRet(jsonFindVar(pMsg, pProp, &jsonres, 0));
     if (jsonres == NULL) {
         iRet = RS_RET_NOT_FOUND;
     }
@@ -5155,6 +5654,17 @@ rsRetVal msgAddJSON(smsg_t *const pM, uchar *name, struct json_object *json, int
 #ifdef HAVE_LOGNORM_TURBO
     msgMaterializeTurboJSON(pM);
 #endif
+    if (mut == &pM->mut) {
+        ++pM->iVarGen;
+        /* a deferred $! tree was added before us, so it must be merged first */
+        iRet = (name[0] == '!') ? msgMaterializeLazyJSON(pM) : RS_RET_OK;
+        if (iRet == RS_RET_OK) iRet = msgJsonUnshare(pM);
+        if (iRet != RS_RET_OK) {
+            json_object_put(json);
+            FINALIZE;
+        }
+        msgJsonPathCacheInvalidate(pM);
+    }
 
     if (name[0] == '/') { /* globl var special handling */
         if (sharedReference) {
@@ -5238,6 +5748,12 @@ rsRetVal msgDelJSON(smsg_t *const pM, uchar *name) {
 
     CHKiRet(getJSONRootAndMutexByVarChar(pM, name[0], &jroot, &mut));
     pthread_mutex_lock(mut);
+    if (mut == &pM->mut) {
+        ++pM->iVarGen;
+        if (name[0] == '!') CHKiRet(msgMaterializeLazyJSON(pM));
+        CHKiRet(msgJsonUnshare(pM));
+        msgJsonPathCacheInvalidate(pM);
+    }
 
     if (*jroot == NULL) {
         DBGPRINTF("msgDelJSONVar; jroot empty in unset for property %s\n", name);
@@ -5526,6 +6042,9 @@ rsRetVal msgPropDescrFill(msgPropDescr_t *pProp, uchar *name, int nameLen) {
         /* we patch the root name, so that support functions do not need to
          * check for different root chars. */
         pProp->name[0] = '!';
+        CHKiRet(msgPropJsonPathCompile(pProp));
+    } else {
+        pProp->jsonPath = NULL;
     }
     pProp->id = id;
 finalize_it:
@@ -5534,7 +6053,10 @@ finalize_it:
 
 void msgPropDescrDestruct(msgPropDescr_t *pProp) {
     if (pProp != NULL) {
-        if (pProp->id == PROP_CEE || pProp->id == PROP_LOCAL_VAR || pProp->id == PROP_GLOBAL_VAR) free(pProp->name);
+        if (pProp->id == PROP_CEE || pProp->id == PROP_LOCAL_VAR || pProp->id == PROP_GLOBAL_VAR) {
+            free(pProp->name);
+            free(pProp->jsonPath);
+        }
     }
 }
 
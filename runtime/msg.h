@@ -113,6 +113,11 @@ struct msg {
         struct syslogTime tTIMESTAMP; /* (parsed) value of the timestamp */
         struct json_object *json;
         struct json_object *localvars;
+        struct msgJsonPathCache *pJsonPathCache; /* parent lookups for json/localvars, protected by mut */
+        struct msgJsonShare *pJsonShare; /* set while json/localvars are shared with MsgDup() copies */
+        void *pLazyJson; /* deferred $! tree, see msgSetLazyJSON(); protected by mut */
+        const struct msgLazyJsonOps *pLazyJsonOps;
+        unsigned iVarGen; /* bumped whenever $! or $. is modified, see tplPropCache */
     #ifdef HAVE_LOGNORM_TURBO
         /* Opaque turbo result slot — set by mmnormalize turbo path.
          * Enables zero-JSON data flow: template resolution reads fields
@@ -207,6 +212,35 @@ smsg_t *MsgDup(smsg_t *pOld);
  */
 void MsgReleaseTurboResult(smsg_t *pMsg);
     #endif
+/* results of msgLazyJsonOps.lookup() */
+    #define MSG_LAZYJSON_UNKNOWN 0 /* only the full tree can answer */
+    #define MSG_LAZYJSON_ABSENT 1 /* the property does not exist */
+    #define MSG_LAZYJSON_STRING 2 /* a string (or null) value, *val is its content */
+    #define MSG_LAZYJSON_SCALAR 3 /* a number or boolean, *val is its JSON text */
+/**
+ * @brief Callbacks of a deferred $! tree, see msgSetLazyJSON().
+ *
+ * The context is owned by the message and immutable; all callbacks are
+ * invoked with the message's mutex held.
+ */
+struct msgLazyJsonOps {
+    void (*destruct)(void *ctx);
+    void *(*dup)(const void *ctx); /**< private copy for MsgDup(), NULL on OOM */
+    struct json_object *(*toJSON)(const void *ctx); /**< full tree, NULL on error */
+    /** look up a "!a!b" property name; val points into ctx */
+    int (*lookup)(const void *ctx, const uchar *name, int nameLen, const uchar **val, rs_size_t *vlen);
+};
+/**
+ * @brief Add a JSON object to $! without building it yet.
+ *
+ * Semantically equivalent to msgAddJSON(pMsg, "!", tree): the tree is
+ * merged into $! by the first write to $! or the first read that needs
+ * more than the lookup callback can answer. Ownership of @p ctx passes
+ * to the message, also on error.
+ */
+rsRetVal msgSetLazyJSON(smsg_t *pMsg, void *ctx, const struct msgLazyJsonOps *ops);
+/** merge a deferred $! tree into $!; caller must hold the message mutex */
+rsRetVal msgMaterializeLazyJSON(smsg_t *pMsg);
 smsg_t *MsgAddRef(smsg_t *pM);
 void setProtocolVersion(smsg_t *pM, int iNewVersion);
 /** Set a message's input-name property.
@@ -313,6 +347,7 @@ rsRetVal getJSONPropVal(
 rsRetVal msgSetJSONFromVar(smsg_t *pMsg, uchar *varname, struct svar *var, int force_reset);
 rsRetVal msgDelJSON(smsg_t *pMsg, uchar *varname);
 rsRetVal jsonFind(smsg_t *const pMsg, msgPropDescr_t *pProp, struct json_object **jsonres);
+rsRetVal msgJsonUnshare(smsg_t *const pMsg);
 struct json_object *jsonDeepCopy(struct json_object *src);
 
 rsRetVal msgPropDescrFill(msgPropDescr_t *pProp, uchar *name, int nameLen);
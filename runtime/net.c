@@ -51,6 +51,8 @@
 #endif /* HAVE_GETIFADDRS */
 #include <sys/types.h>
 #include <arpa/inet.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "rsyslog.h"
 #include "syslogd-types.h"
@@ -505,6 +507,201 @@ static int mygetnameinfo(
 }
 
 
+/* ------------------------------ allowed sender lookup tree ------------------------------ */
+
+/* Allowed sender lists are compiled into a binary radix tree while they are
+ * built. Each IP entry becomes a prefix in the tree, so checking a sender is a
+ * single walk of at most 32 (IPv4) or 128 (IPv6) bits, regardless of the number
+ * of entries. IPv4 and IPv6 prefixes live in the same node array under two
+ * different roots. Entries that are no prefixes (hostname wildcards and IPv6
+ * addresses with a scope id) are kept in side tables and checked via MaskCmp().
+ * Hostname wildcards are only evaluated if the tree does not match, and their
+ * result is cached per sender address. Cache entries expire together with
+ * the DNS cache if dnscache TTL is enabled. The tree is owned by the list root.
+ */
+#define ACL_ROOT_V4 0
+#define ACL_ROOT_V6 1
+#define ACL_CACHE_SIZE 256 /* must be a power of 2 */
+
+typedef struct aclNode_s {
+    uint32_t child[2]; /* child node index; 0 means none, as no root is ever a child */
+    uint8_t bAllow; /* an allowed prefix ends at this node */
+} aclNode_t;
+
+typedef struct aclSideTbl_s {
+    struct AllowedSenders **pEntries;
+    int nEntries;
+    int maxEntries;
+} aclSideTbl_t;
+
+typedef struct aclCacheEntry_s {
+    sa_family_t family; /* 0 - slot unused */
+    uint8_t bAllow;
+    uint8_t addr[16];
+    time_t validUntil; /* 0 - never expires */
+} aclCacheEntry_t;
+
+struct aclTree_s {
+    aclNode_t *nodes;
+    uint32_t nNodes;
+    uint32_t maxNodes;
+    aclSideTbl_t named; /* hostname wildcard entries */
+    aclSideTbl_t scoped; /* IPv6 entries with scope id */
+    pthread_mutex_t mutCache;
+    aclCacheEntry_t *cache; /* allocated with the first hostname entry */
+};
+
+
+static struct aclTree_s *aclTreeConstruct(void) {
+    struct aclTree_s *pTree;
+
+    if ((pTree = calloc(1, sizeof(struct aclTree_s))) == NULL) return NULL;
+    pTree->maxNodes = 64;
+    if ((pTree->nodes = calloc(pTree->maxNodes, sizeof(aclNode_t))) == NULL) {
+        free(pTree);
+        return NULL;
+    }
+    pTree->nNodes = 2; /* the two roots */
+    pthread_mutex_init(&pTree->mutCache, NULL);
+    return pTree;
+}
+
+
+static void aclTreeDestruct(struct aclTree_s *pTree) {
+    if (pTree == NULL) return;
+    pthread_mutex_destroy(&pTree->mutCache);
+    free(pTree->nodes);
+    free(pTree->named.pEntries);
+    free(pTree->scoped.pEntries);
+    free(pTree->cache);
+    free(pTree);
+}
+
+
+static rsRetVal aclSideTblAdd(aclSideTbl_t *const pTbl, struct AllowedSenders *const pEntry) {
+    DEFiRet;
+
+    if (pTbl->nEntries == pTbl->maxEntries) {
+        const int newMax = (pTbl->maxEntries == 0) ? 8 : 2 * pTbl->maxEntries;
+        struct AllowedSenders **newEntries;
+        CHKmalloc(newEntries = realloc(pTbl->pEntries, newMax * sizeof(struct AllowedSenders *)));
+        pTbl->pEntries = newEntries;
+        pTbl->maxEntries = newMax;
+    }
+    pTbl->pEntries[pTbl->nEntries++] = pEntry;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* add the first `bits` bits of addr as prefix below root. Prefixes already
+ * covered by a shorter one are not added, as any match means "allowed".
+ */
+static rsRetVal aclTreeInsert(struct aclTree_s *const pTree,
+                              const uint32_t root,
+                              const uint8_t *const addr,
+                              const unsigned bits) {
+    uint32_t n = root;
+    DEFiRet;
+
+    for (unsigned i = 0; i < bits; ++i) {
+        if (pTree->nodes[n].bAllow) FINALIZE;
+        const int b = (addr[i / 8] >> (7 - i % 8)) & 1;
+        if (pTree->nodes[n].child[b] == 0) {
+            if (pTree->nNodes == pTree->maxNodes) {
+                aclNode_t *newNodes;
+                CHKmalloc(newNodes = realloc(pTree->nodes, 2 * pTree->maxNodes * sizeof(aclNode_t)));
+                pTree->nodes = newNodes;
+                pTree->maxNodes *= 2;
+            }
+            memset(&pTree->nodes[pTree->nNodes], 0, sizeof(aclNode_t));
+            pTree->nodes[n].child[b] = pTree->nNodes++;
+        }
+        n = pTree->nodes[n].child[b];
+    }
+    pTree->nodes[n].bAllow = 1;
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* returns 1 if any prefix below root matches the first `bits` bits of addr */
+static int aclTreeMatch(const struct aclTree_s *const pTree,
+                        const uint32_t root,
+                        const uint8_t *const addr,
+                        const unsigned bits) {
+    uint32_t n = root;
+
+    for (unsigned i = 0; i < bits; ++i) {
+        if (pTree->nodes[n].bAllow) return 1;
+        n = pTree->nodes[n].child[(addr[i / 8] >> (7 - i % 8)) & 1];
+        if (n == 0) return 0;
+    }
+    return pTree->nodes[n].bAllow;
+}
+
+
+/* compile a single list entry into the tree */
+static rsRetVal aclTreeAdd(struct aclTree_s *const pTree, struct AllowedSenders *const pEntry) {
+    struct sockaddr *const sa = pEntry->allowedSender.addr.NetAddr;
+    DEFiRet;
+
+    if (F_ISSET(pEntry->allowedSender.flags, ADDR_NAME)) {
+        if (pTree->cache == NULL) {
+            CHKmalloc(pTree->cache = calloc(ACL_CACHE_SIZE, sizeof(aclCacheEntry_t)));
+        }
+        CHKiRet(aclSideTblAdd(&pTree->named, pEntry));
+        FINALIZE;
+    }
+
+    switch (sa->sa_family) {
+        case AF_INET:
+            CHKiRet(aclTreeInsert(pTree, ACL_ROOT_V4, (const uint8_t *)&SIN(sa)->sin_addr, pEntry->SignificantBits));
+            break;
+        case AF_INET6:
+            if (SIN6(sa)->sin6_scope_id != 0) {
+                CHKiRet(aclSideTblAdd(&pTree->scoped, pEntry));
+            } else {
+                CHKiRet(aclTreeInsert(pTree, ACL_ROOT_V6, SIN6(sa)->sin6_addr.s6_addr, pEntry->SignificantBits));
+            }
+            break;
+        default:
+            /* can never match, see MaskCmp() */
+            break;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* get the cache slot for a sender address. Returns NULL for address
+ * families we do not cache.
+ */
+static aclCacheEntry_t *aclCacheSlot(const struct aclTree_s *const pTree,
+                                     const struct sockaddr *const pFrom,
+                                     const uint8_t **const pAddr,
+                                     size_t *const pLen) {
+    uint32_t hash = 2166136261u; /* FNV-1a */
+
+    if (pFrom->sa_family == AF_INET) {
+        *pAddr = (const uint8_t *)&SIN(pFrom)->sin_addr;
+        *pLen = 4;
+    } else if (pFrom->sa_family == AF_INET6) {
+        *pAddr = SIN6(pFrom)->sin6_addr.s6_addr;
+        *pLen = 16;
+    } else {
+        return NULL;
+    }
+    for (size_t i = 0; i < *pLen; ++i) {
+        hash = (hash ^ (*pAddr)[i]) * 16777619u;
+    }
+    return &pTree->cache[hash & (ACL_CACHE_SIZE - 1)];
+}
+
+
 /* This function adds an allowed sender entry to the ACL linked list.
  * In any case, a single entry is added. If an error occurs, the
  * function does its error reporting itself. All validity checks
@@ -517,6 +714,7 @@ static rsRetVal AddAllowedSenderEntry(struct AllowedSenders **ppRoot,
                                       struct NetAddr *iAllow,
                                       uint8_t iSignificantBits) {
     struct AllowedSenders *pEntry = NULL;
+    struct aclTree_s *pTree;
 
     assert(ppRoot != NULL);
     assert(ppLast != NULL);
@@ -530,6 +728,19 @@ static rsRetVal AddAllowedSenderEntry(struct AllowedSenders **ppRoot,
     pEntry->pNext = NULL;
     pEntry->SignificantBits = iSignificantBits;
 
+    /* compile into the lookup tree, which is owned by the list root */
+    if (*ppRoot == NULL) {
+        pEntry->pTree = aclTreeConstruct();
+        pTree = pEntry->pTree;
+    } else {
+        pTree = (*ppRoot)->pTree;
+    }
+    if (pTree == NULL || aclTreeAdd(pTree, pEntry) != RS_RET_OK) {
+        aclTreeDestruct(pEntry->pTree);
+        free(pEntry);
+        return RS_RET_OUT_OF_MEMORY;
+    }
+
     /* enqueue */
     if (*ppRoot == NULL) {
         *ppRoot = pEntry;
@@ -560,6 +771,7 @@ static void clearAllowedSenders(uchar *pszType) {
             free(pPrev->allowedSender.addr.HostWildcard);
         else
             free(pPrev->allowedSender.addr.NetAddr);
+        aclTreeDestruct(pPrev->pTree);
         free(pPrev);
     }
 
@@ -584,6 +796,7 @@ static void DestructAllowedSenders(struct AllowedSenders **ppRoot) {
             free(pPrev->allowedSender.addr.HostWildcard);
         else
             free(pPrev->allowedSender.addr.NetAddr);
+        aclTreeDestruct(pPrev->pTree);
         free(pPrev);
     }
 
@@ -1023,28 +1236,67 @@ static int isAllowedSenderList(struct AllowedSenders *pAllowRoot,
                                struct sockaddr *pFrom,
                                const char *pszFromHost,
                                int bChkDNS) {
-    struct AllowedSenders *pAllow;
-    int bNeededDNS = 0; /* partial check because we could not resolve DNS? */
-    int ret;
+    struct aclTree_s *pTree;
+    aclCacheEntry_t *pSlot;
+    const uint8_t *addr = NULL;
+    size_t lenAddr = 0;
+    int bAllow = 0;
+    int i;
 
     assert(pFrom != NULL);
 
     if (pAllowRoot == NULL) return 1; /* checking disabled, everything is valid! */
+    pTree = pAllowRoot->pTree;
+    assert(pTree != NULL); /* set up together with the root entry */
+
+    /* IP entries: a single prefix tree walk */
+    if (pFrom->sa_family == AF_INET) {
+        if (aclTreeMatch(pTree, ACL_ROOT_V4, (const uint8_t *)&SIN(pFrom)->sin_addr, 32)) return 1;
+    } else if (pFrom->sa_family == AF_INET6) {
+        const struct in6_addr *const ip6 = &SIN6(pFrom)->sin6_addr;
+        if (aclTreeMatch(pTree, ACL_ROOT_V6, ip6->s6_addr, 128)) return 1;
+        /* IPv4 entries also permit v4-mapped IPv6 senders */
+        if (IN6_IS_ADDR_V4MAPPED(ip6) && aclTreeMatch(pTree, ACL_ROOT_V4, ip6->s6_addr + 12, 32)) return 1;
+    }
+    for (i = 0; i < pTree->scoped.nEntries; ++i) {
+        struct AllowedSenders *const pAllow = pTree->scoped.pEntries[i];
+        if (MaskCmp(&(pAllow->allowedSender), pAllow->SignificantBits, pFrom, pszFromHost, bChkDNS) == 1) return 1;
+    }
+    if (pTree->named.nEntries == 0) return 0;
+
+    /* hostname wildcards: use the cached result for this sender, if any */
+    pSlot = aclCacheSlot(pTree, pFrom, &addr, &lenAddr);
+    if (pSlot != NULL) {
+        int bHit = 0;
+        pthread_mutex_lock(&pTree->mutCache);
+        if (pSlot->family == pFrom->sa_family && !memcmp(pSlot->addr, addr, lenAddr) &&
+            (pSlot->validUntil == 0 || pSlot->validUntil > time(NULL))) {
+            bHit = 1;
+            bAllow = pSlot->bAllow;
+        }
+        pthread_mutex_unlock(&pTree->mutCache);
+        if (bHit) return bAllow;
+    }
+    if (!bChkDNS) return 2; /* we need the DNS name to decide */
 
-    /* now we loop through the list of allowed senders. As soon as
-     * we find a match, we return back (indicating allowed). We loop
-     * until we are out of allowed senders. If so, we fall through the
-     * loop and the function's terminal return statement will indicate
-     * that the sender is disallowed.
-     */
-    for (pAllow = pAllowRoot; pAllow != NULL; pAllow = pAllow->pNext) {
-        ret = MaskCmp(&(pAllow->allowedSender), pAllow->SignificantBits, pFrom, pszFromHost, bChkDNS);
-        if (ret == 1)
-            return 1;
-        else if (ret == 2)
-            bNeededDNS = 2;
-    }
-    return bNeededDNS;
+    for (i = 0; i < pTree->named.nEntries; ++i) {
+        struct AllowedSenders *const pAllow = pTree->named.pEntries[i];
+        if (MaskCmp(&(pAllow->allowedSender), pAllow->SignificantBits, pFrom, pszFromHost, 1) == 1) {
+            bAllow = 1;
+            break;
+        }
+    }
+    if (pSlot != NULL) {
+        pthread_mutex_lock(&pTree->mutCache);
+        pSlot->family = pFrom->sa_family;
+        pSlot->bAllow = bAllow;
+        memcpy(pSlot->addr, addr, lenAddr);
+        pSlot->validUntil = (runConf != NULL && runConf->globals.dnscacheEnableTTL)
+                                ? time(NULL) + runConf->globals.dnscacheDefaultTTL
+                                : 0;
+        pthread_mutex_unlock(&pTree->mutCache);
+    }
+    return bAllow;
 }
 
 
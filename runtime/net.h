@@ -98,10 +98,13 @@ static inline size_t __attribute__((unused)) SALEN(struct sockaddr *sa) {
 }
 #endif
 
+struct aclTree_s; /* lookup tree for an allowed sender list, private to net.c */
+
 struct AllowedSenders {
     struct NetAddr allowedSender; /* ip address allowed */
     uint8_t SignificantBits; /* defines how many bits should be discarded (eqiv to mask) */
     struct AllowedSenders *pNext;
+    struct aclTree_s *pTree; /* compiled form of the whole list, only set in the list root */
 };
 
 
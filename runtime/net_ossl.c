@@ -696,9 +696,24 @@ static rsRetVal net_ossl_osslCtxInit(net_ossl_t *pThis, const SSL_METHOD *method
         net_ossl_set_ctx_verify_callback(pThis->ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT);
     }
 
-    SSL_CTX_set_timeout(pThis->ctx, 30); /* Default Session Timeout, TODO: Make configureable */
+    /* session (and ticket) lifetime, see netstreamDriver.sessionLifetime */
+    SSL_CTX_set_timeout(pThis->ctx, (runConf == NULL) ? 30 : glbl.GetNetstrmDrvrSessLifetime(runConf));
     SSL_CTX_set_mode(pThis->ctx, SSL_MODE_AUTO_RETRY);
 
+    if (runConf != NULL && glbl.GetNetstrmDrvrKTLS(runConf)) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(ENABLE_WOLFSSL)
+        /* OpenSSL only hands the session to the kernel if it supports the
+         * negotiated cipher, otherwise it silently stays in user space.
+         */
+        dbgprintf("osslCtxInit: enabling kernel TLS offload\n");
+        SSL_CTX_set_options(pThis->ctx, SSL_OP_ENABLE_KTLS);
+#else
+        LogMsg(0, RS_RET_NO_ERRCODE, LOG_WARNING,
+               "net_ossl: netstreamdriver.ktls is set, but the TLS library "
+               "rsyslog was built with does not support kernel TLS - ignored");
+#endif
+    }
+
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(ENABLE_WOLFSSL)
     /* Enable Support for automatic ephemeral/temporary DH parameter selection. */
     SSL_CTX_set_dh_auto(pThis->ctx, 1);
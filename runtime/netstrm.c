@@ -362,6 +362,45 @@ finalize_it:
     RETiRet;
 }
 
+/* send a gather list of buffers with a single driver call. Semantics of
+ * pLenBuf are the same as for Send(): on exit it holds the number of
+ * octets actually written, which may end in the middle of any iovec.
+ * Drivers without native support return RS_RET_NOT_IMPLEMENTED; a call
+ * with iovcnt == 0 can be used to probe for support without any I/O.
+ */
+static rsRetVal SendV(netstrm_t *pThis, const struct iovec *iov, int iovcnt, ssize_t *pLenBuf) {
+    DEFiRet;
+    NULL_CHECK(pThis);
+    if (pThis->Drvr.SendV == NULL) {
+        ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+    }
+    if (iovcnt == 0) {
+        *pLenBuf = 0;
+        FINALIZE;
+    }
+    iRet = pThis->Drvr.SendV(pThis->pDrvrData, iov, iovcnt, pLenBuf);
+
+finalize_it:
+    RETiRet;
+}
+
+/* check if the driver has completed the session handshake, so that the
+ * session is ready for data. Drivers without a handshake (plain tcp) do
+ * not implement this, their sessions are always ready.
+ */
+static rsRetVal IsHandshakeDone(netstrm_t *pThis, int *pbDone) {
+    DEFiRet;
+    NULL_CHECK(pThis);
+    if (pThis->Drvr.IsHandshakeDone == NULL) {
+        *pbDone = 1;
+        FINALIZE;
+    }
+    iRet = pThis->Drvr.IsHandshakeDone(pThis->pDrvrData, pbDone);
+
+finalize_it:
+    RETiRet;
+}
+
 /* Enable Keep-Alive handling for those drivers that support it.
  * rgerhards, 2009-06-02
  */
@@ -521,6 +560,8 @@ BEGINobjQueryInterface(netstrm)
     pIf->AbortDestruct = AbortDestruct;
     pIf->Rcv = Rcv;
     pIf->Send = Send;
+    pIf->SendV = SendV;
+    pIf->IsHandshakeDone = IsHandshakeDone;
     pIf->Connect = Connect;
     pIf->LstnInit = LstnInit;
     pIf->AcceptConnReq = AcceptConnReq;
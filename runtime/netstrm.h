@@ -97,8 +97,12 @@ BEGINinterface(netstrm) /* name must also be changed in ENDinterface macro! */
     rsRetVal (*SetDrvrTlsCertFile)(netstrm_t *pThis, const uchar *file);
     /* v18 -- allow remote server's TLS SNI to be set manually */
     rsRetVal (*SetDrvrRemoteSNI)(netstrm_t *pThis, uchar *pszRemoteSNI);
+    /* v21 -- gather write, RS_RET_NOT_IMPLEMENTED if the driver has no native support */
+    rsRetVal (*SendV)(netstrm_t *pThis, const struct iovec *iov, int iovcnt, ssize_t *pLenBuf);
+    /* v22 -- has the driver finished its (TLS) handshake? */
+    rsRetVal (*IsHandshakeDone)(netstrm_t *pThis, int *pbDone);
 ENDinterface(netstrm)
-#define netstrmCURR_IF_VERSION 20 /* increment whenever you change the interface structure! */
+#define netstrmCURR_IF_VERSION 22 /* increment whenever you change the interface structure! */
 /* interface version 3 added GetRemAddr()
  * interface version 4 added EnableKeepAlive() -- rgerhards, 2009-06-02
  * interface version 5 changed return of CheckConnection from void to rsRetVal -- alorbach, 2012-09-06
@@ -112,6 +116,8 @@ ENDinterface(netstrm)
  * interface version 18 added SetDrvrRemoteSNI -- jfcantu, 2020-01-15
  * interface version 19 added SetTcpUserTimeout
  * interface version 20 added SetDrvrTlsCAExtraFiles
+ * interface version 21 added SendV
+ * interface version 22 added IsHandshakeDone
  * */
 
 /* prototypes */
@@ -26,6 +26,7 @@
 #define INCLUDED_NSD_H
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 enum nsdsel_waitOp_e { NSDSEL_RD = 1, NSDSEL_WR = 2, NSDSEL_RDWR = 3 }; /**< the operation we wait for */
 
@@ -98,8 +99,17 @@ BEGINinterface(nsd) /* name must also be changed in ENDinterface macro! */
     /* v19 -- TLS revocation checking (OCSP/CRL) */
     rsRetVal (*SetTlsRevocationCheck)(nsd_t *pThis, int enabled);
 
+    /* v22 -- gather write; optional, NULL if the driver cannot write an iovec natively
+     * (e.g. TLS, where the library frames records). netstrm then returns
+     * RS_RET_NOT_IMPLEMENTED and callers fall back to Send().
+     */
+    rsRetVal (*SendV)(nsd_t *pThis, const struct iovec *iov, int iovcnt, ssize_t *pLenBuf);
+
+    /* v23 -- optional, NULL if the driver has no handshake (session usable once accepted) */
+    rsRetVal (*IsHandshakeDone)(nsd_t *pThis, int *pbDone);
+
 ENDinterface(nsd)
-#define nsdCURR_IF_VERSION 21 /* increment whenever you change the interface structure! */
+#define nsdCURR_IF_VERSION 23 /* increment whenever you change the interface structure! */
     /* interface version 4 added GetRemAddr()
      * interface version 5 added EnableKeepAlive() -- rgerhards, 2009-06-02
      * interface version 6 changed return of CheckConnection from void to rsRetVal -- alorbach, 2012-09-06
@@ -2077,6 +2077,15 @@ static rsRetVal GetSock(nsd_t *pNsd, int *pSock) {
 }
 
 
+/* check if the TLS handshake of the session has completed */
+static rsRetVal IsHandshakeDone(nsd_t *pNsd, int *pbDone) {
+    nsd_gtls_t *pThis = nsd_gtls_from_nsd(pNsd);
+    ISOBJ_TYPE_assert(pThis, nsd_gtls);
+    *pbDone = pThis->iMode == 0 || pThis->rtryCall != gtlsRtry_handshake;
+    return RS_RET_OK;
+}
+
+
 /* get the remote hostname. The returned hostname must be freed by the caller.
  * rgerhards, 2008-04-25
  */
@@ -2608,6 +2617,8 @@ BEGINobjQueryInterface(nsd_gtls)
     pIf->AcceptConnReq = AcceptConnReq;
     pIf->Rcv = Rcv;
     pIf->Send = Send;
+    pIf->SendV = NULL; /* gnutls_record_send() takes a single buffer */
+    pIf->IsHandshakeDone = IsHandshakeDone;
     pIf->Connect = Connect;
     pIf->GetSock = GetSock;
     pIf->SetSock = SetSock;
@@ -1489,6 +1489,8 @@ BEGINobjQueryInterface(nsd_mbedtls)
     pIf->AcceptConnReq = AcceptConnReq;
     pIf->Rcv = Rcv;
     pIf->Send = Send;
+    pIf->SendV = NULL; /* mbedtls_ssl_write() takes a single buffer */
+    pIf->IsHandshakeDone = NULL; /* not tracked, sessions count as ready once accepted */
     pIf->Connect = Connect;
     pIf->GetSock = GetSock;
     pIf->SetSock = SetSock;
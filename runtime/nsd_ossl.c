@@ -34,6 +34,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
 
 #include "rsyslog.h"
@@ -53,6 +54,19 @@
 #include "srUtils.h"
 #include "unicode-helper.h"
 #include "rsconf.h"
+#include "statsobj.h"
+
+/* TLS session resumption (client session cache and our own rotating or
+ * file-based ticket keys) needs the OpenSSL 1.1.1+ session API
+ */
+#if !defined(ENABLE_WOLFSSL) && !defined(LIBRESSL_VERSION_NUMBER) && OPENSSL_VERSION_NUMBER >= 0x10101000L
+    #define OSSL_SESS_RESUMPTION 1
+    #if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        #include <openssl/core_names.h>
+    #else
+        #include <openssl/hmac.h>
+    #endif
+#endif
 
 MODULE_TYPE_LIB
 MODULE_TYPE_KEEP;
@@ -60,10 +74,352 @@ MODULE_TYPE_KEEP;
 /* static data */
 DEFobjStaticHelpers;
 DEFobjCurrIf(glbl) DEFobjCurrIf(net) DEFobjCurrIf(datetime) DEFobjCurrIf(nsd_ptcp) DEFobjCurrIf(net_ossl)
+    DEFobjCurrIf(statsobj)
 
     /* Some prototypes for helper functions used inside openssl driver */
     static rsRetVal applyGnutlsPriorityString(nsd_ossl_t *const pNsd);
 
+/* module-wide session counters, see osslCountSession() */
+static statsobj_t *osslStats = NULL;
+STATSCOUNTER_DEF(ctrOsslSessions, mutCtrOsslSessions)
+STATSCOUNTER_DEF(ctrOsslKtlsSend, mutCtrOsslKtlsSend)
+STATSCOUNTER_DEF(ctrOsslKtlsRecv, mutCtrOsslKtlsRecv)
+STATSCOUNTER_DEF(ctrOsslResumed, mutCtrOsslResumed)
+
+#ifdef OSSL_SESS_RESUMPTION
+/* Client side TLS session cache. Every reconnect constructs a new driver
+ * instance and SSL_CTX, so sessions are kept here, keyed by target and
+ * the settings which identify us to it (see osslClientSessKey()).
+ * Connects are rare, so a small table with linear search does.
+ */
+    #define OSSL_CLIENT_SESS_MAX 64
+static struct {
+    char *pszKey;
+    SSL_SESSION *pSess;
+} osslClientSess[OSSL_CLIENT_SESS_MAX];
+static unsigned osslClientSessNext = 0; /* next slot to replace if table is full */
+static pthread_mutex_t mutOsslClientSess = PTHREAD_MUTEX_INITIALIZER;
+    #define OSSL_SESS_POLLS_MAX 32 /* sends to look for a TLS 1.3 ticket on, see osslClientSessPoll() */
+
+/* Session ticket keys, shared by all listeners. Either loaded from
+ * netstreamDriver.ticketKeyFile (80 bytes per key, the first one encrypts),
+ * or generated and rotated every session lifetime. Tickets from the
+ * previous key are still accepted, but renewed.
+ */
+    #define OSSL_TICKET_KEYS_MAX 4
+typedef struct {
+    unsigned char name[16];
+    unsigned char hmacKey[32];
+    unsigned char aesKey[32];
+} osslTicketKey_t;
+static osslTicketKey_t osslTicketKeys[OSSL_TICKET_KEYS_MAX];
+static int osslNumTicketKeys = 0;
+static int osslTicketKeysFromFile = 0;
+static time_t osslTicketKeyCreated = 0;
+static pthread_mutex_t mutOsslTicketKeys = PTHREAD_MUTEX_INITIALIZER;
+static int osslTicketKeyLifetime = 30;
+
+
+/* build the cache key for a client connection. The CA, CRL and cipher
+ * settings are part of it, as a resumed session is not verified again.
+ */
+static rsRetVal osslClientSessKey(nsd_ossl_t *const pThis, const uchar *const host, const uchar *const port) {
+    const net_ossl_t *const pNetOssl = pThis->pNetOssl;
+    DEFiRet;
+
+    if (asprintf(&pThis->pszSessKey, "%s:%s|%s|%d|%s|%s|%s|%s|%s|%s", host, port,
+                 (pThis->remoteSNI == NULL) ? "" : (const char *)pThis->remoteSNI, (int)pNetOssl->authMode,
+                 (pNetOssl->pszCAFile == NULL) ? "" : (const char *)pNetOssl->pszCAFile,
+                 (pNetOssl->pszCRLFile == NULL) ? "" : (const char *)pNetOssl->pszCRLFile,
+                 (pNetOssl->pszExtraCAFiles == NULL) ? "" : (const char *)pNetOssl->pszExtraCAFiles,
+                 (pNetOssl->pszCertFile == NULL) ? "" : (const char *)pNetOssl->pszCertFile,
+                 (pNetOssl->pszKeyFile == NULL) ? "" : (const char *)pNetOssl->pszKeyFile,
+                 (pThis->gnutlsPriorityString == NULL) ? "" : (const char *)pThis->gnutlsPriorityString) < 0) {
+        pThis->pszSessKey = NULL;
+        ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* store a session for the given key, takes over the reference to pSess */
+static void osslClientSessStore(const char *const pszKey, SSL_SESSION *const pSess) {
+    int iFree = -1;
+    int i;
+    char *pszKeyCopy;
+
+    pthread_mutex_lock(&mutOsslClientSess);
+    for (i = 0; i < OSSL_CLIENT_SESS_MAX; ++i) {
+        if (osslClientSess[i].pszKey == NULL) {
+            if (iFree == -1) iFree = i;
+        } else if (!strcmp(osslClientSess[i].pszKey, pszKey)) {
+            SSL_SESSION_free(osslClientSess[i].pSess);
+            osslClientSess[i].pSess = pSess;
+            goto done;
+        }
+    }
+    if (iFree == -1) {
+        iFree = osslClientSessNext;
+        osslClientSessNext = (osslClientSessNext + 1) % OSSL_CLIENT_SESS_MAX;
+        SSL_SESSION_free(osslClientSess[iFree].pSess);
+        free(osslClientSess[iFree].pszKey);
+        osslClientSess[iFree].pszKey = NULL;
+    }
+    if ((pszKeyCopy = strdup(pszKey)) == NULL) {
+        SSL_SESSION_free(pSess);
+    } else {
+        osslClientSess[iFree].pszKey = pszKeyCopy;
+        osslClientSess[iFree].pSess = pSess;
+    }
+done:
+    pthread_mutex_unlock(&mutOsslClientSess);
+}
+
+
+/* returns a new reference to a resumable session for the key, or NULL */
+static SSL_SESSION *osslClientSessGet(const char *const pszKey) {
+    SSL_SESSION *pSess = NULL;
+    int i;
+
+    pthread_mutex_lock(&mutOsslClientSess);
+    for (i = 0; i < OSSL_CLIENT_SESS_MAX; ++i) {
+        if (osslClientSess[i].pszKey != NULL && !strcmp(osslClientSess[i].pszKey, pszKey)) {
+            if (SSL_SESSION_is_resumable(osslClientSess[i].pSess)) {
+                pSess = osslClientSess[i].pSess;
+                SSL_SESSION_up_ref(pSess);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mutOsslClientSess);
+    return pSess;
+}
+
+
+/* drop the session for the key, e.g. after the peer rejected us */
+static void osslClientSessForget(const char *const pszKey) {
+    int i;
+
+    pthread_mutex_lock(&mutOsslClientSess);
+    for (i = 0; i < OSSL_CLIENT_SESS_MAX; ++i) {
+        if (osslClientSess[i].pszKey != NULL && !strcmp(osslClientSess[i].pszKey, pszKey)) {
+            SSL_SESSION_free(osslClientSess[i].pSess);
+            free(osslClientSess[i].pszKey);
+            osslClientSess[i].pszKey = NULL;
+            osslClientSess[i].pSess = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mutOsslClientSess);
+}
+
+
+/* called by OpenSSL for every new client session. With TLS 1.3, this
+ * happens after the handshake, when the server's ticket is read.
+ */
+static int osslNewClientSessCb(SSL *ssl, SSL_SESSION *pSess) {
+    nsd_ossl_t *const pThis = (nsd_ossl_t *)SSL_get_ex_data(ssl, 4);
+
+    if (pThis == NULL || pThis->pszSessKey == NULL) return 0;
+    dbgprintf("osslNewClientSessCb: [%p] caching session for '%s'\n", pThis, pThis->pszSessKey);
+    osslClientSessStore(pThis->pszSessKey, pSess);
+    pThis->bSessStored = 1;
+    return 1; /* we keep the reference */
+}
+
+
+/* enable client session resumption for this connection, if configured */
+static rsRetVal osslClientSessInit(nsd_ossl_t *const pThis, const uchar *const host, const uchar *const port) {
+    SSL_SESSION *pSess;
+    DEFiRet;
+
+    if (runConf == NULL || !glbl.GetNetstrmDrvrSessResumption(runConf)) FINALIZE;
+
+    CHKiRet(osslClientSessKey(pThis, host, port));
+    SSL_CTX_set_session_cache_mode(pThis->pNetOssl->ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(pThis->pNetOssl->ctx, osslNewClientSessCb);
+    SSL_set_ex_data(pThis->pNetOssl->ssl, 4, pThis);
+    if ((pSess = osslClientSessGet(pThis->pszSessKey)) != NULL) {
+        dbgprintf("osslClientSessInit: [%p] trying to resume session for '%s'\n", pThis, pThis->pszSessKey);
+        SSL_set_session(pThis->pNetOssl->ssl, pSess);
+        SSL_SESSION_free(pSess);
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* TLS 1.3 servers send their session tickets after the handshake, but we
+ * never read on client connections. So we look for them on the first sends,
+ * until a session has been stored. The socket is blocking and the server may
+ * not send any ticket at all, so we only peek if data is already waiting, and
+ * we do so with O_NONBLOCK temporarily set to never wait for a partial record.
+ */
+static void osslClientSessPoll(nsd_ossl_t *const pThis) {
+    struct pollfd pfd;
+    int sockflags;
+    char c;
+
+    ++pThis->iSessPolls;
+    if ((pfd.fd = SSL_get_fd(pThis->pNetOssl->ssl)) < 0) return;
+    if (!SSL_has_pending(pThis->pNetOssl->ssl)) {
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) != 1 || !(pfd.revents & POLLIN)) return;
+    }
+    if ((sockflags = fcntl(pfd.fd, F_GETFL)) == -1) return;
+    if (fcntl(pfd.fd, F_SETFL, sockflags | O_NONBLOCK) == -1) return;
+    if (SSL_peek(pThis->pNetOssl->ssl, &c, 1) <= 0) {
+        ERR_clear_error();
+    }
+    fcntl(pfd.fd, F_SETFL, sockflags);
+}
+
+
+/* generate a new ticket key, the current one becomes the previous one.
+ * Must be called with mutOsslTicketKeys locked.
+ */
+static int osslTicketKeyRotate(void) {
+    osslTicketKey_t key;
+
+    if (RAND_bytes((unsigned char *)&key, sizeof(key)) != 1) return 0;
+    osslTicketKeys[1] = osslTicketKeys[0];
+    osslTicketKeys[0] = key;
+    OPENSSL_cleanse(&key, sizeof(key));
+    if (osslNumTicketKeys < 2) ++osslNumTicketKeys;
+    osslTicketKeyCreated = time(NULL);
+    return 1;
+}
+
+
+    #if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        #define OSSL_TICKET_HMAC_CTX EVP_MAC_CTX
+    #else
+        #define OSSL_TICKET_HMAC_CTX HMAC_CTX
+    #endif
+/* session ticket key callback, see SSL_CTX_set_tlsext_ticket_key_evp_cb(3) */
+static int osslTicketKeyCb(SSL *ssl,
+                           unsigned char keyName[16],
+                           unsigned char *iv,
+                           EVP_CIPHER_CTX *cctx,
+                           OSSL_TICKET_HMAC_CTX *hctx,
+                           int enc) {
+    osslTicketKey_t key;
+    int ret = 1;
+    int i;
+
+    pthread_mutex_lock(&mutOsslTicketKeys);
+    if (enc) {
+        if (!osslTicketKeysFromFile &&
+            (osslNumTicketKeys == 0 || time(NULL) - osslTicketKeyCreated >= osslTicketKeyLifetime)) {
+            if (!osslTicketKeyRotate() && osslNumTicketKeys == 0) {
+                pthread_mutex_unlock(&mutOsslTicketKeys);
+                return 0; /* no ticket then */
+            }
+        }
+        key = osslTicketKeys[0];
+    } else {
+        for (i = 0; i < osslNumTicketKeys; ++i) {
+            if (!memcmp(keyName, osslTicketKeys[i].name, sizeof(osslTicketKeys[i].name))) break;
+        }
+        if (i == osslNumTicketKeys) {
+            pthread_mutex_unlock(&mutOsslTicketKeys);
+            return 0; /* unknown key, do a full handshake */
+        }
+        key = osslTicketKeys[i];
+        /* 2: issue a new ticket with the current key. TLS 1.3 clients use
+         * a ticket only once, so they always need a new one.
+         */
+        ret = (i == 0 && SSL_version(ssl) < TLS1_3_VERSION) ? 1 : 2;
+    }
+    pthread_mutex_unlock(&mutOsslTicketKeys);
+
+    if (enc) {
+        memcpy(keyName, key.name, sizeof(key.name));
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1 ||
+            EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aesKey, iv) != 1) {
+            ret = -1;
+        }
+    } else if (EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aesKey, iv) != 1) {
+        ret = -1;
+    }
+    if (ret != -1) {
+    #if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        OSSL_PARAM params[3];
+        params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey, sizeof(key.hmacKey));
+        params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *)"SHA256", 0);
+        params[2] = OSSL_PARAM_construct_end();
+        if (EVP_MAC_CTX_set_params(hctx, params) != 1) ret = -1;
+    #else
+        if (HMAC_Init_ex(hctx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), NULL) != 1) ret = -1;
+    #endif
+    }
+    OPENSSL_cleanse(&key, sizeof(key));
+    return ret;
+}
+
+
+/* load the ticket keys from netstreamDriver.ticketKeyFile. The layout is
+ * the same as nginx's ssl_session_ticket_key: 16 bytes key name, 32 bytes
+ * HMAC secret, 32 bytes AES key. Multiple keys may be concatenated, the
+ * first one is used for new tickets.
+ * Must be called with mutOsslTicketKeys locked.
+ */
+static rsRetVal osslTicketKeysLoad(const uchar *const pszFile) {
+    unsigned char buf[OSSL_TICKET_KEYS_MAX * sizeof(osslTicketKey_t) + 1];
+    FILE *fp = NULL;
+    size_t len;
+    DEFiRet;
+
+    if ((fp = fopen((const char *)pszFile, "r")) == NULL) {
+        LogError(errno, RS_RET_NO_FILE_ACCESS, "nsd_ossl: cannot open session ticket key file '%s'", pszFile);
+        ABORT_FINALIZE(RS_RET_NO_FILE_ACCESS);
+    }
+    len = fread(buf, 1, sizeof(buf), fp);
+    if (len == 0 || len % sizeof(osslTicketKey_t) != 0 || len > OSSL_TICKET_KEYS_MAX * sizeof(osslTicketKey_t)) {
+        LogError(0, RS_RET_INVALID_PARAMS,
+                 "nsd_ossl: session ticket key file '%s' must hold 1 to %d keys of %d bytes each", pszFile,
+                 OSSL_TICKET_KEYS_MAX, (int)sizeof(osslTicketKey_t));
+        ABORT_FINALIZE(RS_RET_INVALID_PARAMS);
+    }
+    memcpy(osslTicketKeys, buf, len);
+    osslNumTicketKeys = (int)(len / sizeof(osslTicketKey_t));
+    osslTicketKeysFromFile = 1;
+
+finalize_it:
+    OPENSSL_cleanse(buf, sizeof(buf));
+    if (fp != NULL) fclose(fp);
+    RETiRet;
+}
+
+
+/* set up session resumption for a listener context */
+static rsRetVal osslServerSessInit(nsd_ossl_t *const pThis) {
+    const uchar *const pszKeyFile = (runConf == NULL) ? NULL : glbl.GetNetstrmDrvrTicketKeyFile(runConf);
+    DEFiRet;
+
+    pthread_mutex_lock(&mutOsslTicketKeys);
+    osslTicketKeyLifetime = (runConf == NULL) ? 30 : glbl.GetNetstrmDrvrSessLifetime(runConf);
+    if (pszKeyFile != NULL && !osslTicketKeysFromFile) {
+        iRet = osslTicketKeysLoad(pszKeyFile);
+    }
+    pthread_mutex_unlock(&mutOsslTicketKeys);
+    CHKiRet(iRet);
+
+    #if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(pThis->pNetOssl->ctx, osslTicketKeyCb);
+    #else
+    SSL_CTX_set_tlsext_ticket_key_cb(pThis->pNetOssl->ctx, osslTicketKeyCb);
+    #endif
+
+finalize_it:
+    RETiRet;
+}
+#endif /* #ifdef OSSL_SESS_RESUMPTION */
+
 /* retry an interrupted OSSL operation */
 static rsRetVal doRetry(nsd_ossl_t *pNsd) {
     DEFiRet;
@@ -603,6 +959,7 @@ BEGINobjDestruct(nsd_ossl) /* be sure to specify the object type also in END and
     if (pThis->pTcp != NULL) {
         nsd_ptcp.Destruct(&pThis->pTcp);
     }
+    free(pThis->pszSessKey);
     if (pThis->pNetOssl != NULL) {
         net_ossl.Destruct(&pThis->pNetOssl);
     }
@@ -838,6 +1195,11 @@ static rsRetVal LstnInitDrvr(netstrm_t *const pThis) {
 #endif
     // Apply PriorityString after Ctx Creation
     applyGnutlsPriorityString(pNsdOssl);
+#ifdef OSSL_SESS_RESUMPTION
+    /* required for resumption when client certificates are verified */
+    SSL_CTX_set_session_id_context(pNsdOssl->pNetOssl->ctx, (const unsigned char *)"rsyslog", sizeof("rsyslog") - 1);
+    CHKiRet(osslServerSessInit(pNsdOssl));
+#endif
 finalize_it:
     RETiRet;
 }
@@ -885,6 +1247,15 @@ static rsRetVal GetSock(nsd_t *pNsd, int *pSock) {
     return nsd_ptcp.GetSock(pThis->pTcp, pSock);
 }
 
+
+/* check if the TLS handshake of the session has completed */
+static rsRetVal IsHandshakeDone(nsd_t *pNsd, int *pbDone) {
+    nsd_ossl_t *pThis = (nsd_ossl_t *)pNsd;
+    ISOBJ_TYPE_assert(pThis, nsd_ossl);
+    *pbDone = pThis->iMode == 0 || (pThis->pNetOssl->ssl != NULL && SSL_is_init_finished(pThis->pNetOssl->ssl));
+    return RS_RET_OK;
+}
+
 /* get the remote hostname. The returned hostname must be freed by the caller.
  * rgerhards, 2008-04-25
  */
@@ -971,6 +1342,36 @@ finalize_it:
 }
 
 
+/* Account for a completed handshake, resumed or not. If kernel TLS was requested, OpenSSL
+ * has now switched the record layer of either direction to the kernel if
+ * it could. SSL_read()/SSL_write() stay in use either way: with offload
+ * they become plain recvmsg()/sendmsg() calls, but OpenSSL still needs
+ * to handle alerts, key updates and shutdown.
+ */
+static void osslCountSession(nsd_ossl_t *const pNsd) {
+    STATSCOUNTER_INC(ctrOsslSessions, mutCtrOsslSessions);
+    if (SSL_session_reused(pNsd->pNetOssl->ssl)) {
+        STATSCOUNTER_INC(ctrOsslResumed, mutCtrOsslResumed);
+        pNsd->bSessStored = 1; /* the cached session is still good */
+    }
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(ENABLE_WOLFSSL)
+    if (SSL_get_options(pNsd->pNetOssl->ssl) & SSL_OP_ENABLE_KTLS) {
+        const int bSend = BIO_get_ktls_send(SSL_get_wbio(pNsd->pNetOssl->ssl));
+        const int bRecv = BIO_get_ktls_recv(SSL_get_rbio(pNsd->pNetOssl->ssl));
+        dbgprintf("osslCountSession: kernel TLS offload send %d, recv %d\n", bSend, bRecv);
+        if (bSend) {
+            STATSCOUNTER_INC(ctrOsslKtlsSend, mutCtrOsslKtlsSend);
+        }
+        if (bRecv) {
+            STATSCOUNTER_INC(ctrOsslKtlsRecv, mutCtrOsslKtlsRecv);
+        }
+    }
+#else
+    (void)pNsd;
+#endif
+}
+
+
 /* Perform all necessary actions for Handshake
  */
 rsRetVal osslHandshakeCheck(nsd_ossl_t *pNsd) {
@@ -1061,6 +1462,8 @@ rsRetVal osslHandshakeCheck(nsd_ossl_t *pNsd) {
         }
     }
 
+    osslCountSession(pNsd);
+
     /* Do post handshake stuff */
     CHKiRet(osslPostHandshakeCheck(pNsd));
 
@@ -1074,6 +1477,12 @@ finalize_it:
         /* If no error occurred, set socket to SSL mode */
         pNsd->iMode = 1;
     }
+#ifdef OSSL_SESS_RESUMPTION
+    else if (pNsd->pszSessKey != NULL) {
+        /* do not offer this session again, the peer may have changed */
+        osslClientSessForget(pNsd->pszSessKey);
+    }
+#endif
 
     RETiRet;
 }
@@ -1280,6 +1689,11 @@ static rsRetVal Send(nsd_t *pNsd, uchar *pBuf, ssize_t *pLenBuf) {
     if (pThis->rtryCall == osslRtry_recv) {
         CHKiRet(retrySendSideRecordRecv(pThis));
     }
+#ifdef OSSL_SESS_RESUMPTION
+    else if (pThis->pszSessKey != NULL && !pThis->bSessStored && pThis->iSessPolls < OSSL_SESS_POLLS_MAX) {
+        osslClientSessPoll(pThis);
+    }
+#endif
 
     while (1) {
         iSent = SSL_write(pThis->pNetOssl->ssl, pBuf, *pLenBuf);
@@ -1430,11 +1844,15 @@ static rsRetVal Connect(nsd_t *pNsd, int family, uchar *port, uchar *host, char
     CHKiRet(SetServerNameIfPresent(pThis, host));
 
     /* Store nsd_ossl_t* reference in SSL obj
-     * Index allocation: 0=pTcp, 1=permitExpiredCerts, 2=imdtls instance, 3=revocationCheck
+     * Index allocation: 0=pTcp, 1=permitExpiredCerts, 2=imdtls instance, 3=revocationCheck,
+     * 4=nsd_ossl (client session cache)
      */
     SSL_set_ex_data(pThis->pNetOssl->ssl, 0, pThis->pTcp);
     SSL_set_ex_data(pThis->pNetOssl->ssl, 1, &pThis->permitExpiredCerts);
     SSL_set_ex_data(pThis->pNetOssl->ssl, 3, &pThis->DrvrTlsRevocationCheck);
+#ifdef OSSL_SESS_RESUMPTION
+    CHKiRet(osslClientSessInit(pThis, host, port));
+#endif
 
     /* We now do the handshake */
     iRet = osslHandshakeCheck(pThis);
@@ -1713,6 +2131,8 @@ BEGINobjQueryInterface(nsd_ossl)
     pIf->AcceptConnReq = AcceptConnReq;
     pIf->Rcv = Rcv;
     pIf->Send = Send;
+    pIf->SendV = NULL; /* SSL_write() takes a single buffer */
+    pIf->IsHandshakeDone = IsHandshakeDone;
     pIf->Connect = Connect;
     pIf->GetSock = GetSock;
     pIf->SetSock = SetSock;
@@ -1751,7 +2171,21 @@ ENDobjQueryInterface(nsd_ossl)
  */
 BEGINObjClassExit(nsd_ossl, OBJ_IS_LOADABLE_MODULE) /* CHANGE class also in END MACRO! */
     CODESTARTObjClassExit(nsd_ossl);
+    if (osslStats != NULL) statsobj.Destruct(&osslStats);
+#ifdef OSSL_SESS_RESUMPTION
+    for (int i = 0; i < OSSL_CLIENT_SESS_MAX; ++i) {
+        if (osslClientSess[i].pszKey != NULL) {
+            SSL_SESSION_free(osslClientSess[i].pSess);
+            free(osslClientSess[i].pszKey);
+            osslClientSess[i].pszKey = NULL;
+        }
+    }
+    OPENSSL_cleanse(osslTicketKeys, sizeof(osslTicketKeys));
+    osslNumTicketKeys = 0;
+    osslTicketKeysFromFile = 0;
+#endif
     /* release objects we no longer need */
+    objRelease(statsobj, CORE_COMPONENT);
     objRelease(net_ossl, CORE_COMPONENT);
     objRelease(nsd_ptcp, LM_NSD_PTCP_FILENAME);
     objRelease(net, LM_NET_FILENAME);
@@ -1770,6 +2204,24 @@ BEGINObjClassInit(nsd_ossl, 1, OBJ_IS_LOADABLE_MODULE) /* class, version */
     CHKiRet(objUse(net, LM_NET_FILENAME));
     CHKiRet(objUse(nsd_ptcp, LM_NSD_PTCP_FILENAME));
     CHKiRet(objUse(net_ossl, CORE_COMPONENT));
+    CHKiRet(objUse(statsobj, CORE_COMPONENT));
+
+    CHKiRet(statsobj.Construct(&osslStats));
+    CHKiRet(statsobj.SetName(osslStats, UCHAR_CONSTANT("nsd_ossl")));
+    CHKiRet(statsobj.SetOrigin(osslStats, UCHAR_CONSTANT("nsd_ossl")));
+    STATSCOUNTER_INIT(ctrOsslSessions, mutCtrOsslSessions);
+    CHKiRet(statsobj.AddCounter(osslStats, UCHAR_CONSTANT("sessions"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &ctrOsslSessions));
+    STATSCOUNTER_INIT(ctrOsslKtlsSend, mutCtrOsslKtlsSend);
+    CHKiRet(statsobj.AddCounter(osslStats, UCHAR_CONSTANT("ktls.send"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &ctrOsslKtlsSend));
+    STATSCOUNTER_INIT(ctrOsslKtlsRecv, mutCtrOsslKtlsRecv);
+    CHKiRet(statsobj.AddCounter(osslStats, UCHAR_CONSTANT("ktls.recv"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &ctrOsslKtlsRecv));
+    STATSCOUNTER_INIT(ctrOsslResumed, mutCtrOsslResumed);
+    CHKiRet(statsobj.AddCounter(osslStats, UCHAR_CONSTANT("sessions.resumed"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &ctrOsslResumed));
+    CHKiRet(statsobj.ConstructFinalize(osslStats));
 ENDObjClassInit(nsd_ossl)
 
 
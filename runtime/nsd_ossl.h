@@ -62,6 +62,9 @@ struct nsd_ossl_s {
         int lenRcvBuf;
         /**< -1: empty, 0: connection closed, 1..NSD_OSSL_MAX_RCVBUF-1: data of that size present */
         int ptrRcvBuf; /**< offset for next recv operation if 0 < lenRcvBuf < NSD_OSSL_MAX_RCVBUF */
+        char *pszSessKey; /**< client session cache key, NULL if session resumption is not used */
+        int bSessStored; /**< 1 if a session for pszSessKey has been cached on this connection */
+        int iSessPolls; /**< number of reads done to pick up TLS 1.3 session tickets */
 
         /* OpenSSL and Config Cert vars inside net_ossl_t now */
         net_ossl_t *pNetOssl; /* OSSL shared Config and object vars are here */
@@ -38,6 +38,7 @@
 #include <unistd.h>
 #include <netinet/tcp.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 #include "rsyslog.h"
 #include "syslogd-types.h"
@@ -911,6 +912,36 @@ finalize_it:
 }
 
 
+/* gather-write variant of Send(). A partial write is reported through
+ * pLenBuf exactly like in Send(); the caller resumes at that offset.
+ */
+static rsRetVal SendV(nsd_t *pNsd, const struct iovec *iov, int iovcnt, ssize_t *pLenBuf) {
+    nsd_ptcp_t *pThis = (nsd_ptcp_t *)pNsd;
+    ssize_t written;
+    DEFiRet;
+    ISOBJ_TYPE_assert(pThis, nsd_ptcp);
+
+    written = writev(pThis->sock, iov, iovcnt);
+
+    if (written == -1) {
+        switch (errno) {
+            case EAGAIN:
+            case EINTR:
+                /* this is fine, just retry... */
+                written = 0;
+                break;
+            default:
+                ABORT_FINALIZE(RS_RET_IO_ERROR);
+                break;
+        }
+    }
+
+    *pLenBuf = written;
+finalize_it:
+    RETiRet;
+}
+
+
 /* Enable KEEPALIVE handling on the socket.
  * rgerhards, 2009-06-02
  */
@@ -1267,6 +1298,8 @@ BEGINobjQueryInterface(nsd_ptcp)
     pIf->SetPermPeers = SetPermPeers;
     pIf->Rcv = Rcv;
     pIf->Send = Send;
+    pIf->SendV = SendV;
+    pIf->IsHandshakeDone = NULL; /* plain tcp sessions are ready once accepted */
     pIf->LstnInit = LstnInit;
     pIf->AcceptConnReq = AcceptConnReq;
     pIf->Connect = Connect;
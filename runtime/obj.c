@@ -1337,6 +1337,7 @@ rsRetVal objClassExit(void) {
 	varClassExit(pModInfo);
 #endif
     moduleClassExit();
+    datetimeClassExit();
     RETiRet;
 }
 
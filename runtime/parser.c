@@ -42,13 +42,15 @@
 #include "unicode-helper.h"
 #include "dirty.h"
 #include "cfsysline.h"
+#include "statsobj.h"
 
 /* some defines */
 #define DEFUPRI (LOG_USER | LOG_NOTICE)
+#define PARSER_PREFIX_WORDS (65536 / 64) /* bit map of all two byte prefixes */
 
 /* definitions for objects we access */
 DEFobjStaticHelpers;
-DEFobjCurrIf(glbl) DEFobjCurrIf(datetime) DEFobjCurrIf(ruleset)
+DEFobjCurrIf(glbl) DEFobjCurrIf(datetime) DEFobjCurrIf(ruleset) DEFobjCurrIf(statsobj)
 
     /* static data */
 
@@ -60,6 +62,8 @@ BEGINobjDestruct(parser) /* be sure to specify the object type also in END and C
     if (pThis->pInst != NULL) {
         pThis->pModule->mod.pm.freeParserInst(pThis->pInst);
     }
+    if (pThis->stats != NULL) statsobj.Destruct(&pThis->stats);
+    free(pThis->pRejectedPrefixes);
     free(pThis->pName);
 ENDobjDestruct(parser)
 
@@ -214,10 +218,26 @@ static rsRetVal parserConstructFinalize(parser_t *pThis) {
     DEFiRet;
 
     ISOBJ_TYPE_assert(pThis, parser);
+
+    CHKiRet(statsobj.Construct(&pThis->stats));
+    CHKiRet(statsobj.SetName(pThis->stats, pThis->pName));
+    CHKiRet(statsobj.SetOrigin(pThis->stats, UCHAR_CONSTANT("core.parser")));
+    STATSCOUNTER_INIT(pThis->ctrAttempts, pThis->mutCtrAttempts);
+    CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("attempts"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &pThis->ctrAttempts));
+    STATSCOUNTER_INIT(pThis->ctrSuccesses, pThis->mutCtrSuccesses);
+    CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("successes"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &pThis->ctrSuccesses));
+    STATSCOUNTER_INIT(pThis->ctrHinted, pThis->mutCtrHinted);
+    CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("hinted"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                                &pThis->ctrHinted));
+    CHKiRet(statsobj.ConstructFinalize(pThis->stats));
+
     CHKiRet(AddParserToList(&loadConf->parsers.pParsLstRoot, pThis));
     DBGPRINTF("Parser '%s' added to list of available parsers.\n", pThis->pName);
 
 finalize_it:
+    if (iRet != RS_RET_OK && pThis->stats != NULL) statsobj.Destruct(&pThis->stats);
     RETiRet;
 }
 
@@ -245,13 +265,20 @@ rsRetVal parserConstructViaModAndName(modInfo_t *__restrict__ pMod, uchar *const
     if (localRet == RS_RET_OK) {
         CHKiRet(SetDoPRIParsing(pParser, RSTRUE));
     }
+    localRet = pMod->isCompatibleWithFeature(sFEATUREPrefixRejection);
+    if (localRet == RS_RET_OK) {
+        CHKmalloc(pParser->pRejectedPrefixes = calloc(PARSER_PREFIX_WORDS, sizeof(uint64_t)));
+    }
 
     CHKiRet(SetName(pParser, pName));
     CHKiRet(SetModPtr(pParser, pMod));
     pParser->pInst = pInst;
     CHKiRet(parserConstructFinalize(pParser));
 finalize_it:
-    if (iRet != RS_RET_OK) free(pParser);
+    if (iRet != RS_RET_OK && pParser != NULL) {
+        free(pParser->pRejectedPrefixes);
+        free(pParser);
+    }
     RETiRet;
 }
 
@@ -605,6 +632,73 @@ rsRetVal parserParsePRI(smsg_t *pMsg) {
 }
 
 
+/* Adaptive parser order (global parser.adaptiveOrder). Parsers that announce
+ * sFEATUREPrefixRejection decide whether to reject a message only by the two
+ * bytes after the PRI, and do not modify it when they do. For each of them we
+ * remember the prefixes they rejected in a 64k bit map. A parser is skipped
+ * if it rejected the prefix before, so it is only skipped where it would
+ * have rejected again, and the result is the same as for the configured
+ * order. Bits are only ever set, with relaxed atomics; a lost update only
+ * costs an additional parser call.
+ */
+
+/* get the prefix index of a message as the parser would see it, or -1 if
+ * the message is too short to have one.
+ */
+static int parserPrefixIdx(const smsg_t *const pMsg) {
+    const uchar *const p = pMsg->pszRawMsg + pMsg->offAfterPRI;
+
+    if (pMsg->iLenRawMsg - pMsg->offAfterPRI < 2) return -1;
+    return (p[0] << 8) | p[1];
+}
+
+static int parserPrefixRejected(parser_t *const pParser, const int idx) {
+    const uint64_t word = __atomic_load_n(&pParser->pRejectedPrefixes[idx / 64], __ATOMIC_RELAXED);
+    return (word >> (idx % 64)) & 1;
+}
+
+static void parserPrefixLearn(parser_t *const pParser, const int idx) {
+    __atomic_fetch_or(&pParser->pRejectedPrefixes[idx / 64], (uint64_t)1 << (idx % 64), __ATOMIC_RELAXED);
+}
+
+/* Do the sanitization and PRI parsing a parser asks for. The first parser
+ * that wants sanitization triggers it, and PRI parsing only happens together
+ * with it.
+ */
+static rsRetVal prepareMsgForParser(smsg_t *const pMsg,
+                                    parser_t *const pParser,
+                                    sbool *const pbIsSanitized,
+                                    sbool *const pbPRIisParsed) {
+    DEFiRet;
+
+    if (pParser->bDoSanitazion && *pbIsSanitized == RSFALSE) {
+        CHKiRet(SanitizeMsg(pMsg));
+        if (pParser->bDoPRIParsing && *pbPRIisParsed == RSFALSE) {
+            CHKiRet(parserParsePRI(pMsg));
+            *pbPRIisParsed = RSTRUE;
+        }
+        *pbIsSanitized = RSTRUE;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+static rsRetVal callParser(parser_t *const pParser, smsg_t *const pMsg) {
+    rsRetVal localRet;
+
+    STATSCOUNTER_INC(pParser->ctrAttempts, pParser->mutCtrAttempts);
+    if (pParser->pModule->mod.pm.parse2 == NULL)
+        localRet = pParser->pModule->mod.pm.parse(pMsg);
+    else
+        localRet = pParser->pModule->mod.pm.parse2(pParser->pInst, pMsg);
+    DBGPRINTF("Parser '%s' returned %d\n", pParser->pName, localRet);
+    if (localRet == RS_RET_OK) {
+        STATSCOUNTER_INC(pParser->ctrSuccesses, pParser->mutCtrSuccesses);
+    }
+    return localRet;
+}
+
 /* Parse a received message. The object's rawmsg property is taken and
  * parsed according to the relevant standards. This can later be
  * extended to support configured parsers.
@@ -614,6 +708,9 @@ static rsRetVal ParseMsg(smsg_t *pMsg) {
     rsRetVal localRet = RS_RET_ERR;
     parserList_t *pParserList;
     parser_t *pParser;
+    int bAdaptive;
+    int bSkipped = 0;
+    int idx = -1;
     sbool bIsSanitized;
     sbool bPRIisParsed;
     static int iErrMsgRateLimiter = 0;
@@ -643,24 +740,29 @@ static rsRetVal ParseMsg(smsg_t *pMsg) {
 
     bIsSanitized = RSFALSE;
     bPRIisParsed = RSFALSE;
+
+    bAdaptive = runConf->globals.bParserAdaptiveOrder;
     while (pParserList != NULL) {
         pParser = pParserList->pParser;
-        if (pParser->bDoSanitazion && bIsSanitized == RSFALSE) {
-            CHKiRet(SanitizeMsg(pMsg));
-            if (pParser->bDoPRIParsing && bPRIisParsed == RSFALSE) {
-                CHKiRet(parserParsePRI(pMsg));
-                bPRIisParsed = RSTRUE;
+        CHKiRet(prepareMsgForParser(pMsg, pParser, &bIsSanitized, &bPRIisParsed));
+        if (bAdaptive && pParser->pRejectedPrefixes != NULL) {
+            idx = parserPrefixIdx(pMsg);
+            if (idx != -1 && parserPrefixRejected(pParser, idx)) {
+                DBGPRINTF("Parser '%s' skipped, it rejected this prefix before\n", pParser->pName);
+                localRet = RS_RET_COULD_NOT_PARSE; /* what it returned before */
+                bSkipped = 1;
+                pParserList = pParserList->pNext;
+                continue;
             }
-            bIsSanitized = RSTRUE;
         }
-        if (pParser->pModule->mod.pm.parse2 == NULL)
-            localRet = pParser->pModule->mod.pm.parse(pMsg);
-        else
-            localRet = pParser->pModule->mod.pm.parse2(pParser->pInst, pMsg);
-        DBGPRINTF("Parser '%s' returned %d\n", pParser->pName, localRet);
+        localRet = callParser(pParser, pMsg);
         if (localRet != RS_RET_COULD_NOT_PARSE) break;
+        if (bAdaptive && pParser->pRejectedPrefixes != NULL && idx != -1) parserPrefixLearn(pParser, idx);
         pParserList = pParserList->pNext;
     }
+    if (localRet == RS_RET_OK && bSkipped) {
+        STATSCOUNTER_INC(pParser->ctrHinted, pParser->mutCtrHinted);
+    }
 
     /* We need to log a warning message and drop the message if we did not find a parser.
      * Note that we log at most the first 1000 message, as this may very well be a problem
@@ -740,6 +842,7 @@ BEGINObjClassExit(parser, OBJ_IS_CORE_MODULE) /* class, version */
     objRelease(glbl, CORE_COMPONENT);
     objRelease(datetime, CORE_COMPONENT);
     objRelease(ruleset, CORE_COMPONENT);
+    objRelease(statsobj, CORE_COMPONENT);
 ENDObjClassExit(parser)
 
 
@@ -752,4 +855,5 @@ BEGINObjClassInit(parser, 1, OBJ_IS_CORE_MODULE) /* class, version */
     CHKiRet(objUse(glbl, CORE_COMPONENT));
     CHKiRet(objUse(datetime, CORE_COMPONENT));
     CHKiRet(objUse(ruleset, CORE_COMPONENT));
+    CHKiRet(objUse(statsobj, CORE_COMPONENT));
 ENDObjClassInit(parser)
@@ -21,6 +21,12 @@
 #ifndef INCLUDED_PARSER_H
 #define INCLUDED_PARSER_H
 
+#include <string.h>
+#include "statsobj.h"
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
 /* we create a small helper object, a list of parsers, that we can use to
  * build a chain of them whereever this is needed (initially thought to be
  * used in ruleset.c as well as ourselvs).
@@ -40,6 +46,11 @@ struct parser_s {
         void *pInst; /* instance data for the parser (v2+ module interface) */
         sbool bDoSanitazion; /* do standard message sanitazion before calling parser? */
         sbool bDoPRIParsing; /* do standard PRI parsing before calling parser? */
+        uint64_t *pRejectedPrefixes; /* prefixes rejected before, if sFEATUREPrefixRejection */
+        statsobj_t *stats; /* impstats counters for this parser */
+        STATSCOUNTER_DEF(ctrAttempts, mutCtrAttempts)
+        STATSCOUNTER_DEF(ctrSuccesses, mutCtrSuccesses)
+        STATSCOUNTER_DEF(ctrHinted, mutCtrHinted)
 };
 
 /* interfaces */
@@ -76,4 +87,70 @@ rsRetVal parserConstructViaModAndName(modInfo_t *pMod, uchar *const pName, void
 rsRetVal parserParsePRI(smsg_t *pMsg);
 
 
+/* Header classification for the parser fast paths. The first bytes of a
+ * header are turned into bit masks of the delimiters the parsers care about
+ * (bit i describes p[i]), so fields can be extracted by offset. Anything
+ * that does not fit into the window is left to the byte-by-byte code.
+ */
+#define PARSER_HDR_WINDOW 64
+typedef struct parserHdrMasks_s {
+    uint64_t sp; /* SP characters */
+    uint64_t colon; /* ':' characters */
+    uint64_t nul; /* NUL bytes */
+    int len; /* number of bytes classified, at most PARSER_HDR_WINDOW */
+} parserHdrMasks_t;
+
+static inline void parserScanHdr(const uchar *const p, const int len, parserHdrMasks_t *const pMasks) {
+    int i;
+
+    pMasks->sp = pMasks->colon = pMasks->nul = 0;
+    pMasks->len = (len < PARSER_HDR_WINDOW) ? len : PARSER_HDR_WINDOW;
+#if defined(__SSE2__)
+    {
+        const __m128i vSP = _mm_set1_epi8(' ');
+        const __m128i vColon = _mm_set1_epi8(':');
+        const __m128i vNul = _mm_setzero_si128();
+        uchar bufTail[16];
+        __m128i v;
+
+        for (i = 0; i < pMasks->len; i += 16) {
+            if (pMasks->len - i >= 16) {
+                v = _mm_loadu_si128((const __m128i *)(p + i));
+            } else {
+                /* we must not read past the end, so the last partial block is scanned from a copy */
+                memset(bufTail, 'x', sizeof(bufTail));
+                memcpy(bufTail, p + i, pMasks->len - i);
+                v = _mm_loadu_si128((const __m128i *)bufTail);
+            }
+            pMasks->sp |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vSP)) << i;
+            pMasks->colon |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vColon)) << i;
+            pMasks->nul |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vNul)) << i;
+        }
+        return;
+    }
+#endif
+    for (i = 0; i < pMasks->len; ++i) {
+        if (p[i] == ' ')
+            pMasks->sp |= (uint64_t)1 << i;
+        else if (p[i] == ':')
+            pMasks->colon |= (uint64_t)1 << i;
+        else if (p[i] == '\0')
+            pMasks->nul |= (uint64_t)1 << i;
+    }
+}
+
+/* advance the masks by n bytes, as if the scan had started n bytes later */
+static inline void parserHdrMasksSkip(parserHdrMasks_t *const pMasks, const int n) {
+    if (n >= pMasks->len) {
+        pMasks->sp = pMasks->colon = pMasks->nul = 0;
+        pMasks->len = 0;
+    } else {
+        pMasks->sp >>= n;
+        pMasks->colon >>= n;
+        pMasks->nul >>= n;
+        pMasks->len -= n;
+    }
+}
+
+
 #endif /* #ifndef INCLUDED_PARSER_H */
@@ -219,6 +219,8 @@
 #include "statsobj.h"
 #include "parserif.h"
 #include "rsconf.h"
+#include "segdisk_codec.h"
+#include "segdisk_crc.h"
 
 #ifdef OS_SOLARIS
     #include <sched.h>
@@ -239,6 +241,16 @@ DEFobjCurrIf(glbl) DEFobjCurrIf(strm) DEFobjCurrIf(datetime) DEFobjCurrIf(statso
 #define OVERSIZE_QUEUE_WATERMARK 500000 /* when is a queue considered to be "overly large"? */
 #define MAX_DISK_QUEUE_FILES 10000000 /* maximum file number for disk queues */
 #define DISKQUEUE_CORRUPTION_RESYNC_MAX_BYTES (1024 * 1024)
+/* binary disk queue record: magic, payload length, payload CRC32C, payload.
+ * The first magic octet can never start a text object record ('<').
+ */
+#define DISKQUEUE_BINARY_MAGIC "\x1eRB1"
+#define DISKQUEUE_BINARY_MAGIC_LEN 4
+#define DISKQUEUE_BINARY_HDR_LEN 12
+#define DISKQUEUE_BINARY_MAX_RECORD (128u * 1024u * 1024u)
+/* adaptive DA spill: predictor sample window and default transfer batch */
+#define DA_PREDICTOR_WINDOW_MS 250
+#define DA_ADAPTIVE_SPILL_BATCH 1024
 
 
 /* forward-definitions */
@@ -247,6 +259,7 @@ static rsRetVal qqueueChkPersist(qqueue_t *pThis, int nUpdates);
 static rsRetVal RateLimiter(qqueue_t *pThis);
 static rsRetVal qqueueChkStopWrkrDA(qqueue_t *pThis);
 static rsRetVal GetDeqBatchSize(qqueue_t *pThis, int *pVal);
+static rsRetVal GetDeqBatchSizeDA(qqueue_t *pThis, int *pVal);
 static rsRetVal ConsumerDA(qqueue_t *pThis, wti_t *pWti);
 static rsRetVal batchProcessed(qqueue_t *pThis, wti_t *pWti);
 static rsRetVal qqueueMultiEnqObjNonDirect(qqueue_t *pThis, multi_submit_t *pMultiSub);
@@ -291,6 +304,11 @@ static struct cnfparamdescr cnfpdescr[] = {{"queue.filename", eCmdHdlrGetWord, 0
                                            {"queue.discardseverity", eCmdHdlrFacility, 0},
                                            {"queue.checkpointinterval", eCmdHdlrInt, 0},
                                            {"queue.syncqueuefiles", eCmdHdlrBinary, 0},
+                                           {"queue.segmentcompression", eCmdHdlrGetWord, 0},
+                                           {"queue.diskrecordformat", eCmdHdlrGetWord, 0},
+                                           {"queue.spillpolicy", eCmdHdlrGetWord, 0},
+                                           {"queue.spillhorizon", eCmdHdlrPositiveInt, 0},
+                                           {"queue.spillbatchsize", eCmdHdlrNonNegInt, 0},
                                            {"queue.type", eCmdHdlrQueueType, 0},
                                            {"queue.diskqueuetype", eCmdHdlrGetWord, 0},
                                            {"queue.diskqueueautoupgrade", eCmdHdlrBinary, 0},
@@ -490,6 +508,11 @@ void qqueueDbgPrint(qqueue_t *pThis) {
     dbgoprint((obj_t *)pThis, "queue.discardseverity: %d\n", pThis->iDiscardSeverity);
     dbgoprint((obj_t *)pThis, "queue.checkpointinterval: %d\n", pThis->iPersistUpdCnt);
     dbgoprint((obj_t *)pThis, "queue.syncqueuefiles: %d\n", pThis->bSyncQueueFiles);
+    dbgoprint((obj_t *)pThis, "queue.segmentcompression: %d\n", pThis->segdiskCompression);
+    dbgoprint((obj_t *)pThis, "queue.diskrecordformat: %d\n", pThis->diskRecordFormat);
+    dbgoprint((obj_t *)pThis, "queue.spillpolicy: %d\n", pThis->daSpillPolicy);
+    dbgoprint((obj_t *)pThis, "queue.spillhorizon: %d\n", pThis->daSpillHorizon);
+    dbgoprint((obj_t *)pThis, "queue.spillbatchsize: %d\n", pThis->daSpillBatchSize);
     dbgoprint((obj_t *)pThis, "queue.type: %d [%s]\n", pThis->qType, getQueueTypeName(pThis->qType));
     dbgoprint((obj_t *)pThis, "queue.workerthreads: %d\n", pThis->iNumWorkerThreads);
     dbgoprint((obj_t *)pThis, "queue.timeoutshutdown: %d\n", pThis->toQShutdown);
@@ -568,6 +591,11 @@ static void qqueueUpdateSegDiskStats(qqueue_t *pThis) {
     pThis->segdiskMaterializations = segdiskStatsInt(stats.materializations);
     pThis->segdiskDematerializations = segdiskStatsInt(stats.dematerializations);
     pThis->segdiskIdleCleanupFailures = segdiskStatsInt(stats.idle_cleanup_failures);
+    pThis->segdiskReadCalls = segdiskStatsInt(stats.read_calls);
+    pThis->segdiskCompressedSegments = segdiskStatsInt(stats.compressed_segments);
+    pThis->segdiskCompressionSavedBytes = segdiskStatsInt(stats.compression_saved_bytes);
+    pThis->segdiskGroupCommits = segdiskStatsInt(stats.group_commits);
+    pThis->segdiskGroupCommitRecords = segdiskStatsInt(stats.group_commit_records);
 }
 
 static rsRetVal qqueueSegDiskIdleTimeout(qqueue_t *pThis) {
@@ -671,6 +699,95 @@ static void queueDrain(qqueue_t *pThis) {
 /* --------------- code for disk-assisted (DA) queue modes -------------------- */
 
 
+static int64_t qqueueMonotonicMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/* project the time in ms until the in-memory queue is full at the current
+ * smoothed rates, -1 if it is not filling up. The result is also kept for
+ * impstats. The queue mutex must be locked.
+ */
+static int qqueueDATimeToFull(qqueue_t *pThis) {
+    const int64_t net = (int64_t)pThis->daFillRate - pThis->daDrainRate;
+    const int64_t room = pThis->iMaxQueueSize - getLogicalQueueSize(pThis);
+
+    if (net <= 0 || pThis->iMaxQueueSize <= 0) {
+        pThis->daTimeToFull = -1;
+    } else {
+        const int64_t ttf = (room > 0 ? room : 0) * 1000 / net;
+        pThis->daTimeToFull = ttf > INT_MAX ? INT_MAX : (int)ttf;
+    }
+    return pThis->daTimeToFull;
+}
+
+
+/* Close the current predictor sample window once it is old enough and fold
+ * its enqueue and memory-consumer rates into the smoothed rates (EWMA with
+ * weight 1/4). The queue mutex must be locked.
+ */
+static void qqueueDAPredictorUpdate(qqueue_t *pThis) {
+    const int64_t now = qqueueMonotonicMs();
+    const int64_t elapsed = now - pThis->daWindowStart;
+
+    if (pThis->daWindowStart == 0) {
+        pThis->daWindowStart = now;
+        return;
+    }
+    if (elapsed < DA_PREDICTOR_WINDOW_MS) return;
+
+    const int64_t fill = (int64_t)pThis->daWindowEnq * 1000 / elapsed;
+    const int64_t drain = (int64_t)pThis->daWindowDeq * 1000 / elapsed;
+    pThis->daFillRate = (int)((3 * (int64_t)pThis->daFillRate + fill) / 4);
+    pThis->daDrainRate = (int)((3 * (int64_t)pThis->daDrainRate + drain) / 4);
+    pThis->daWindowEnq = 0;
+    pThis->daWindowDeq = 0;
+    pThis->daWindowStart = now;
+    qqueueDATimeToFull(pThis);
+}
+
+
+/* decide whether a DA queue at or above its high watermark shall start
+ * spilling. The watermark policy always does. The adaptive policy projects
+ * the time until the in-memory queue is full from the smoothed fill and
+ * drain rates and spills only if that is below queue.spillHorizon, or if
+ * the queue has passed the midpoint between high watermark and capacity.
+ * Once started, spilling continues down to the low watermark (see
+ * qqueueChkStopWrkrDA()), which provides the hysteresis.
+ * The queue mutex must be locked.
+ */
+static sbool qqueueDAShouldSpill(qqueue_t *pThis) {
+    const int size = getLogicalQueueSize(pThis);
+
+    if (pThis->daSpillPolicy != QUEUE_DA_SPILL_ADAPTIVE || pThis->iMaxQueueSize <= 0) return 1;
+    if (pThis->daSpilling) return 1;
+    if (size >= pThis->iHighWtrMrk + (pThis->iMaxQueueSize - pThis->iHighWtrMrk) / 2) return 1;
+
+    const int ttf = qqueueDATimeToFull(pThis);
+    if (ttf != -1 && ttf <= pThis->daSpillHorizon) return 1;
+
+    if (!pThis->daSpillDeferred) {
+        pThis->daSpillDeferred = 1;
+        STATSCOUNTER_INC(pThis->ctrDASpillDeferred, pThis->mutCtrDASpillDeferred);
+        DBGOPRINT((obj_t *)pThis, "high watermark reached, but not spilling: fill %d/s, drain %d/s\n",
+                  pThis->daFillRate, pThis->daDrainRate);
+    }
+    return 0;
+}
+
+
+/* the DA worker stopped (or has nothing left to spill), so a new crossing of
+ * the high watermark must be evaluated from scratch again.
+ * The queue mutex must be locked.
+ */
+static void qqueueDASpillStopped(qqueue_t *pThis) {
+    if (pThis->daSpilling) DBGOPRINT((obj_t *)pThis, "DA spilling stopped\n");
+    pThis->daSpilling = 0;
+}
+
+
 /* returns the number of workers that should be advised at
  * this point in time. The mutex must be locked when
  * ths function is called. -- rgerhards, 2008-01-25
@@ -682,10 +799,19 @@ static rsRetVal qqueueAdviseMaxWorkers(qqueue_t *pThis) {
     ISOBJ_TYPE_assert(pThis, qqueue);
 
     if (!pThis->bEnqOnly) {
-        if (pThis->bIsDA && getLogicalQueueSize(pThis) >= pThis->iHighWtrMrk) {
+        if (pThis->bIsDA && pThis->daSpillPolicy == QUEUE_DA_SPILL_ADAPTIVE) {
+            qqueueDAPredictorUpdate(pThis);
+        }
+        if (pThis->bIsDA && getLogicalQueueSize(pThis) >= pThis->iHighWtrMrk && qqueueDAShouldSpill(pThis)) {
             DBGOPRINT((obj_t *)pThis, "(re)activating DA worker\n");
+            if (!pThis->daSpilling) {
+                pThis->daSpilling = 1;
+                STATSCOUNTER_INC(pThis->ctrDASpillStarts, pThis->mutCtrDASpillStarts);
+            }
             wtpAdviseMaxWorkers(pThis->pWtpDA, 1, DENY_WORKER_START_DURING_SHUTDOWN);
             /* The DA transfer pool intentionally has one worker. */
+        } else if (pThis->bIsDA && getLogicalQueueSize(pThis) < pThis->iHighWtrMrk) {
+            pThis->daSpillDeferred = 0;
         }
         if (getLogicalQueueSize(pThis) == 0) {
             iMaxWorkers = 0;
@@ -802,6 +928,7 @@ static rsRetVal StartDA(qqueue_t *pThis) {
     pThis->pqDA->daEngineMarkerPending =
         !engine_result.marker_present && !engine_result.classic_data && !engine_result.segmented_data;
     pThis->pqDA->diskQueueIdleTimeout = pThis->diskQueueIdleTimeout;
+    pThis->pqDA->segdiskCompression = pThis->segdiskCompression;
 
     CHKiRet(qqueueSetpAction(pThis->pqDA, pThis->pAction));
     CHKiRet(qqueueSetsizeOnDiskMax(pThis->pqDA, pThis->sizeOnDiskMax));
@@ -819,10 +946,15 @@ static rsRetVal StartDA(qqueue_t *pThis) {
     CHKiRet(qqueueSetiHighWtrMrk(pThis->pqDA, 0));
     CHKiRet(qqueueSetiDiscardMrk(pThis->pqDA, 0));
     pThis->pqDA->iDeqBatchSize = pThis->iDeqBatchSize;
+    if (pThis->daSpillPolicy == QUEUE_DA_SPILL_ADAPTIVE) {
+        /* read the spilled backlog back in the same large batches */
+        CHKiRet(GetDeqBatchSizeDA(pThis, &pThis->pqDA->iDeqBatchSize));
+    }
     pThis->pqDA->iMinDeqBatchSize = pThis->iMinDeqBatchSize;
     pThis->pqDA->iMinMsgsPerWrkr = pThis->iMinMsgsPerWrkr;
     pThis->pqDA->iLowWtrMrk = pThis->iLowWtrMrk;
     pThis->pqDA->onCorruption = pThis->onCorruption;
+    pThis->pqDA->diskRecordFormat = pThis->diskRecordFormat;
     if (pThis->useCryprov && child_type == QUEUETYPE_DISK) {
         /* hand over cryprov to DA queue - in-mem queue does no longer need it
          * and DA queue will be kept active from now on until termination.
@@ -892,7 +1024,7 @@ static rsRetVal ATTR_NONNULL() InitDA(qqueue_t *const pThis, const int bLockMute
     CHKiRet(wtpConstruct(&pThis->pWtpDA));
     CHKiRet(wtpSetDbgHdr(pThis->pWtpDA, pszBuf, lenBuf));
     CHKiRet(wtpSetpfChkStopWrkr(pThis->pWtpDA, (rsRetVal(*)(void *pUsr, int))qqueueChkStopWrkrDA));
-    CHKiRet(wtpSetpfGetDeqBatchSize(pThis->pWtpDA, (rsRetVal(*)(void *pUsr, int *))GetDeqBatchSize));
+    CHKiRet(wtpSetpfGetDeqBatchSize(pThis->pWtpDA, (rsRetVal(*)(void *pUsr, int *))GetDeqBatchSizeDA));
     CHKiRet(wtpSetpfDoWork(pThis->pWtpDA, (rsRetVal(*)(void *pUsr, void *pWti))ConsumerDA));
     CHKiRet(wtpSetpfObjProcessed(pThis->pWtpDA, (rsRetVal(*)(void *pUsr, wti_t *pWti))batchProcessed));
     CHKiRet(wtpSetpmutUsr(pThis->pWtpDA, pThis->mut));
@@ -1199,6 +1331,7 @@ static rsRetVal qConstructSegDisk(qqueue_t *pThis) {
         .checkpoint_interval = (unsigned int)pThis->iPersistUpdCnt,
         .sync_files = pThis->bSyncQueueFiles,
         .lazy_create = pThis->segdiskLazyCreate,
+        .compression = pThis->segdiskCompression,
     };
     int recovered = 0;
     DEFiRet;
@@ -1249,13 +1382,66 @@ finalize_it:
     RETiRet;
 }
 
+static sbool qqueueSegDiskNeedsGroupCommit(const qqueue_t *pThis) {
+    return pThis->qType == QUEUETYPE_SEGMENTED_DISK && pThis->bSyncQueueFiles && pThis->tVars.segdisk != NULL;
+}
+
+/* Group commit for segmentedDisk with queue.syncQueueFiles: the producer
+ * returns only once its appends are durable. The first waiter syncs for the
+ * whole group with the queue mutex released; producers that append meanwhile
+ * are released by the following sync.
+ * Must be called with the queue mutex locked.
+ */
+static rsRetVal qqueueSegDiskGroupCommit(qqueue_t *pThis) {
+    segdisk_store_t *const store = pThis->tVars.segdisk;
+    const uint64_t ticket = segdiskStoreSyncTicket(store);
+    segdisk_sync_group_t group;
+    DEFiRet;
+
+    while (!segdiskStoreSynced(store, ticket)) {
+        if (pThis->segdiskSyncRunning) {
+            pthread_cond_wait(&pThis->segdiskSyncDone, pThis->mut);
+            continue;
+        }
+        pThis->segdiskSyncRunning = 1;
+        iRet = segdiskStoreSyncBegin(store, &group);
+        if (iRet == RS_RET_OK) {
+            d_pthread_mutex_unlock(pThis->mut);
+            iRet = segdiskStoreSyncWrite(&group);
+            d_pthread_mutex_lock(pThis->mut);
+        }
+        segdiskStoreSyncEnd(store, &group, iRet);
+        pThis->segdiskSyncRunning = 0;
+        pthread_cond_broadcast(&pThis->segdiskSyncDone);
+        qqueueUpdateSegDiskStats(pThis);
+        if (iRet != RS_RET_OK) {
+            LogError(0, iRet, "%s: segmentedDisk could not sync queued records", obj.GetName((obj_t *)pThis));
+            FINALIZE;
+        }
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+/* The store claims a range of records under the queue mutex; checking and
+ * decoding them is done with the mutex released, so several workers decode
+ * disjoint batches in parallel. Out-of-order completion is handled by
+ * segdiskStoreCompleteBatch().
+ */
 static rsRetVal qDeqBatchSegDisk(qqueue_t *pThis, batch_t *batch, int max, int *skipped) {
     int discovered = 0;
-    const rsRetVal store_ret = segdiskStoreDequeueBatch(pThis->tVars.segdisk, batch, max, skipped, &discovered);
+    rsRetVal store_ret = segdiskStoreDequeueBatch(pThis->tVars.segdisk, batch, max, skipped, &discovered);
     if (discovered > 0) {
         qqueueAddPhysicalQueueSize(pThis, discovered);
         qqueueAddOverallQueueSize(discovered);
     }
+    if (store_ret == RS_RET_OK) {
+        d_pthread_mutex_unlock(pThis->mut);
+        segdiskStoreDecodeBatch(batch);
+        d_pthread_mutex_lock(pThis->mut);
+        store_ret = segdiskStoreFinishBatch(pThis->tVars.segdisk, batch, skipped);
+    }
     qqueueUpdateSegDiskStats(pThis);
     return store_ret == RS_RET_RETRY ? RS_RET_NO_DATA : store_ret;
 }
@@ -2090,6 +2276,45 @@ static rsRetVal qDestructDisk(qqueue_t *pThis) {
     RETiRet;
 }
 
+static void putDiskBinary32(uchar *const p, const uint32_t v) {
+    p[0] = (uchar)(v >> 24);
+    p[1] = (uchar)(v >> 16);
+    p[2] = (uchar)(v >> 8);
+    p[3] = (uchar)v;
+}
+
+static uint32_t getDiskBinary32(const uchar *const p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* write pMsg as a framed binary record. Each record carries its own
+ * format marker, so a queue file may hold binary and object records side
+ * by side and the format can be switched between restarts.
+ */
+static rsRetVal ATTR_NONNULL() qAddDiskBinary(qqueue_t *const pThis, smsg_t *const pMsg) {
+    uchar hdr[DISKQUEUE_BINARY_HDR_LEN];
+    unsigned char *payload = NULL;
+    size_t lenPayload = 0;
+    DEFiRet;
+
+    CHKiRet(segdiskCodecEncode(pMsg, &payload, &lenPayload));
+    if (lenPayload == 0 || lenPayload > DISKQUEUE_BINARY_MAX_RECORD) {
+        ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    }
+    memcpy(hdr, DISKQUEUE_BINARY_MAGIC, DISKQUEUE_BINARY_MAGIC_LEN);
+    putDiskBinary32(hdr + 4, (uint32_t)lenPayload);
+    putDiskBinary32(hdr + 8, segdiskCrc32c(payload, lenPayload));
+
+    CHKiRet(strm.RecordBegin(pThis->tVars.disk.pWrite));
+    CHKiRet(strm.Write(pThis->tVars.disk.pWrite, hdr, sizeof(hdr)));
+    CHKiRet(strm.Write(pThis->tVars.disk.pWrite, payload, lenPayload));
+    CHKiRet(strm.RecordEnd(pThis->tVars.disk.pWrite));
+
+finalize_it:
+    free(payload);
+    RETiRet;
+}
+
 static rsRetVal ATTR_NONNULL(1, 2) qAddDisk(qqueue_t *const pThis, smsg_t *pMsg) {
     DEFiRet;
     ISOBJ_TYPE_assert(pThis, qqueue);
@@ -2103,7 +2328,11 @@ static rsRetVal ATTR_NONNULL(1, 2) qAddDisk(qqueue_t *const pThis, smsg_t *pMsg)
     const int oldfile = strmGetCurrFileNum(pThis->tVars.disk.pWrite);
 
     CHKiRet(strm.SetWCntr(pThis->tVars.disk.pWrite, &nWriteCount));
-    CHKiRet((objSerialize(pMsg))(pMsg, pThis->tVars.disk.pWrite));
+    if (pThis->diskRecordFormat == QUEUE_DISK_RECORD_BINARY) {
+        CHKiRet(qAddDiskBinary(pThis, pMsg));
+    } else {
+        CHKiRet((objSerialize(pMsg))(pMsg, pThis->tVars.disk.pWrite));
+    }
     CHKiRet(strm.Flush(pThis->tVars.disk.pWrite));
     CHKiRet(strm.SetWCntr(pThis->tVars.disk.pWrite, NULL)); /* no more counting for now... */
 
@@ -2145,10 +2374,61 @@ static rsRetVal msgDeserializeFromVoid(void *pObj, strm_t *pStrm) {
     return MsgDeserialize((smsg_t *)pObj, pStrm);
 }
 
+/* read the rest of a binary record whose first magic octet has already
+ * been consumed. The remaining magic octets are checked one by one so that
+ * a false match during corruption resync consumes as little as possible.
+ */
+static rsRetVal qDeqDiskBinary(qqueue_t *pThis, smsg_t **ppMsg) {
+    strm_t *const pStrm = pThis->tVars.disk.pReadDeq;
+    uchar hdr[DISKQUEUE_BINARY_HDR_LEN];
+    uchar *payload = NULL;
+    uint32_t lenPayload;
+    int i;
+    DEFiRet;
+
+    *ppMsg = NULL;
+    for (i = 1; i < DISKQUEUE_BINARY_MAGIC_LEN; ++i) {
+        CHKiRet(strm.ReadChar(pStrm, &hdr[i]));
+        if (hdr[i] != (uchar)DISKQUEUE_BINARY_MAGIC[i]) {
+            CHKiRet(strm.UnreadChar(pStrm, hdr[i]));
+            ABORT_FINALIZE(RS_RET_INVALID_HEADER);
+        }
+    }
+    CHKiRet(strm.ReadBlock(pStrm, hdr + DISKQUEUE_BINARY_MAGIC_LEN,
+                           DISKQUEUE_BINARY_HDR_LEN - DISKQUEUE_BINARY_MAGIC_LEN));
+    lenPayload = getDiskBinary32(hdr + 4);
+    if (lenPayload == 0 || lenPayload > DISKQUEUE_BINARY_MAX_RECORD) {
+        ABORT_FINALIZE(RS_RET_INVALID_HEADER);
+    }
+    CHKmalloc(payload = malloc(lenPayload));
+    CHKiRet(strm.ReadBlock(pStrm, payload, lenPayload));
+    if (segdiskCrc32c(payload, lenPayload) != getDiskBinary32(hdr + 8)) {
+        ABORT_FINALIZE(RS_RET_INVALID_VALUE);
+    }
+    CHKiRet(segdiskCodecDecode(payload, lenPayload, ppMsg));
+
+finalize_it:
+    free(payload);
+    RETiRet;
+}
+
+/* dequeue one record, dispatching on its first octet. Text object records
+ * written by earlier versions (or with queue.diskRecordFormat="object")
+ * remain readable, which makes switching formats transparent.
+ */
 static rsRetVal qDeqDisk(qqueue_t *pThis, smsg_t **ppMsg) {
+    uchar c;
     DEFiRet;
-    iRet = objDeserializeWithMethods(ppMsg, (uchar *)"msg", sizeof("msg") - 1, pThis->tVars.disk.pReadDeq, NULL, NULL,
-                                     msgConstructFromVoid, NULL, msgDeserializeFromVoid);
+    iRet = strm.ReadChar(pThis->tVars.disk.pReadDeq, &c);
+    if (iRet == RS_RET_OK) {
+        if (c == (uchar)DISKQUEUE_BINARY_MAGIC[0]) {
+            iRet = qDeqDiskBinary(pThis, ppMsg);
+        } else {
+            strm.UnreadChar(pThis->tVars.disk.pReadDeq, c);
+            iRet = objDeserializeWithMethods(ppMsg, (uchar *)"msg", sizeof("msg") - 1, pThis->tVars.disk.pReadDeq,
+                                             NULL, NULL, msgConstructFromVoid, NULL, msgDeserializeFromVoid);
+        }
+    }
     if (iRet != RS_RET_OK) {
         LogError(0, iRet, "%s: qDeqDisk error happened at around offset %lld", obj.GetName((obj_t *)pThis),
                  (long long)pThis->tVars.disk.pReadDeq->iCurrOffs);
@@ -2199,13 +2479,15 @@ static rsRetVal qDeqDiskRecoverAfterCorruption(qqueue_t *pThis,
             break;
         }
         ++scanned;
-        if (c != '<') {
+        if (c == (uchar)DISKQUEUE_BINARY_MAGIC[0]) {
+            iRet = qDeqDiskBinary(pThis, ppMsg);
+        } else if (c == '<') {
+            CHKiRet(strm.UnreadChar(pThis->tVars.disk.pReadDeq, c));
+            iRet = objDeserializeWithMethods(ppMsg, (uchar *)"msg", sizeof("msg") - 1, pThis->tVars.disk.pReadDeq,
+                                             NULL, NULL, msgConstructFromVoid, NULL, msgDeserializeFromVoid);
+        } else {
             continue;
         }
-
-        CHKiRet(strm.UnreadChar(pThis->tVars.disk.pReadDeq, c));
-        iRet = objDeserializeWithMethods(ppMsg, (uchar *)"msg", sizeof("msg") - 1, pThis->tVars.disk.pReadDeq, NULL,
-                                         NULL, msgConstructFromVoid, NULL, msgDeserializeFromVoid);
         if (iRet == RS_RET_OK) {
             *pSkippedMsgs = 1;
             LogMsg(0, RS_RET_OK, LOG_WARNING,
@@ -2313,6 +2595,7 @@ static rsRetVal qqueueAdd(qqueue_t *pThis, smsg_t *pMsg) {
 
     CHKiRet(pThis->qAdd(pThis, pMsg));
 
+    if (pThis->bIsDA) ++pThis->daWindowEnq;
     if (pThis->bIsDA && pThis->pqDA != NULL && pThis->pqDA->segdiskDAChild) {
         /* Parent and DA child intentionally share this queue mutex. The idle
          * callback therefore observes this activity generation atomically
@@ -2492,6 +2775,9 @@ static rsRetVal tryShutdownWorkersWithinActionTimeout(qqueue_t *pThis) {
         } else {
             DBGOPRINT((obj_t *)pThis, "main queue DA worker pool shut down.\n");
         }
+        d_pthread_mutex_lock(pThis->mut);
+        qqueueDASpillStopped(pThis);
+        d_pthread_mutex_unlock(pThis->mut);
     }
 
     RETiRet;
@@ -2560,6 +2846,9 @@ static rsRetVal cancelWorkers(qqueue_t *pThis) {
         if (iRetLocal != RS_RET_OK) {
             DBGOPRINT((obj_t *)pThis, "unexpected state %d joining cancelled DA transfer workers\n", iRetLocal);
         }
+        d_pthread_mutex_lock(pThis->mut);
+        qqueueDASpillStopped(pThis);
+        d_pthread_mutex_unlock(pThis->mut);
     }
 
     RETiRet;
@@ -2666,6 +2955,8 @@ rsRetVal qqueueConstruct(qqueue_t **ppThis,
     pThis->diskQueueType = QDA_ENGINE_AUTO;
     pThis->effectiveDiskQueueType = QDA_ENGINE_AUTO;
     pThis->diskQueueIdleTimeout = 60000;
+    pThis->daSpillHorizon = 2000;
+    pThis->daTimeToFull = -1;
 
     pThis->pszFilePrefix = NULL;
     pThis->qType = qType;
@@ -3159,7 +3450,7 @@ static rsRetVal ATTR_NONNULL() DequeueConsumableElements(qqueue_t *const pThis,
         timeoutComp(&timeout, pThis->toMinDeqBatchSize); /* get absolute timeout */
     }
 
-    while ((iQueueSize = getLogicalQueueSize(pThis)) > 0 && nDequeued < pThis->iDeqBatchSize) {
+    while ((iQueueSize = getLogicalQueueSize(pThis)) > 0 && nDequeued < pWti->batch.maxElem) {
         int rd_fd = -1;
         int64_t rd_offs = 0;
         int wr_fd = -1;
@@ -3356,7 +3647,7 @@ static rsRetVal ATTR_NONNULL() DequeueConsumableElements(qqueue_t *const pThis,
             }
         }
         if (keep_running) {
-            keep_running = (getLogicalQueueSize(pThis) > 0) && (nDequeued < pThis->iDeqBatchSize);
+            keep_running = (getLogicalQueueSize(pThis) > 0) && (nDequeued < pWti->batch.maxElem);
         }
     }
 
@@ -3619,6 +3910,13 @@ static rsRetVal ConsumerReg(qqueue_t *pThis, wti_t *pWti) {
         FINALIZE;
     }
 
+    /* feed the DA spill predictor and the unspill counter of our parent */
+    if (pThis->bIsDA) {
+        pThis->daWindowDeq += pWti->batch.nElem;
+    } else if (pThis->pqParent != NULL) {
+        STATSCOUNTER_ADD(pThis->pqParent->ctrDAUnspilled, pThis->pqParent->mutCtrDAUnspilled, pWti->batch.nElem);
+    }
+
     /* we now have a non-idle batch of work, so we can release the queue mutex and process it */
     d_pthread_mutex_unlock(pThis->mut);
     bNeedReLock = 1;
@@ -3662,30 +3960,19 @@ finalize_it:
 }
 
 
-/* This is a special consumer to feed the disk-queue in disk-assisted mode.
- * When active, our own queue more or less acts as a memory buffer to the disk.
- * So this consumer just needs to drain the memory queue and submit entries
- * to the disk queue. The disk queue will then call the actual consumer from
- * the app point of view (we chain two queues here).
- * When this method is entered, the mutex is always locked and needs to be unlocked
- * as part of the processing.
- * rgerhards, 2008-01-14
+/* hand a DA batch over to the disk queue one message at a time, releasing
+ * the queue mutex while doing so. This is what the watermark spill policy
+ * does, so producers are never blocked for more than a single message.
+ * The mutex is locked when called and when returning.
  */
-static rsRetVal ConsumerDA(qqueue_t *pThis, wti_t *pWti) {
+static rsRetVal ConsumerDAEach(qqueue_t *pThis, wti_t *pWti) {
     int i;
+    int nEnq = 0;
     int iCancelStateSave;
-    int bNeedReLock = 0; /**< do we need to lock the mutex again? */
-    int skippedMsgs = 0;
     DEFiRet;
 
-    ISOBJ_TYPE_assert(pThis, qqueue);
-    ISOBJ_TYPE_assert(pWti, wti);
-
-    CHKiRet(DequeueForConsumer(pThis, pWti, &skippedMsgs));
-
     /* we now have a non-idle batch of work, so we can release the queue mutex and process it */
     d_pthread_mutex_unlock(pThis->mut);
-    bNeedReLock = 1;
 
     /* at this spot, we may be cancelled */
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &iCancelStateSave);
@@ -3693,37 +3980,133 @@ static rsRetVal ConsumerDA(qqueue_t *pThis, wti_t *pWti) {
     /* iterate over returned results and enqueue them in DA queue */
     for (i = 0; i < pWti->batch.nElem && !qqueueIsShutdownImmediate(pThis); i++) {
         iRet = qqueueEnqMsg(pThis->pqDA, eFLOWCTL_NO_DELAY, MsgAddRef(pWti->batch.pElem[i].pMsg));
-        if (iRet != RS_RET_OK) {
-            if (iRet == RS_RET_ERR_QUEUE_EMERGENCY) {
-                /* Queue emergency error occurred */
-                DBGOPRINT((obj_t *)pThis,
-                          "ConsumerDA:qqueueEnqMsg caught RS_RET_ERR_QUEUE_EMERGENCY,"
-                          "aborting loop.\n");
-                FINALIZE;
-            } else {
-                DBGOPRINT((obj_t *)pThis,
-                          "ConsumerDA:qqueueEnqMsg item (%d) returned "
-                          "with error state: '%d'\n",
-                          i, iRet);
-                if (pThis->pqDA->qType == QUEUETYPE_SEGMENTED_DISK) {
-                    /* The segmented child may fail before the event becomes
-                     * durable (for example while publishing its engine marker
-                     * or materializing the store). Leave this and the
-                     * remaining batch elements uncommitted so normal parent
-                     * retry handling preserves them. Classic DA behavior is
-                     * intentionally unchanged. */
-                    break;
-                }
+        if (iRet == RS_RET_OK) {
+            ++nEnq;
+        } else if (iRet == RS_RET_ERR_QUEUE_EMERGENCY) {
+            /* Queue emergency error occurred */
+            DBGOPRINT((obj_t *)pThis,
+                      "ConsumerDA:qqueueEnqMsg caught RS_RET_ERR_QUEUE_EMERGENCY,"
+                      "aborting loop.\n");
+            break;
+        } else {
+            DBGOPRINT((obj_t *)pThis,
+                      "ConsumerDA:qqueueEnqMsg item (%d) returned "
+                      "with error state: '%d'\n",
+                      i, iRet);
+            if (pThis->pqDA->qType == QUEUETYPE_SEGMENTED_DISK) {
+                /* The segmented child may fail before the event becomes
+                 * durable (for example while publishing its engine marker
+                 * or materializing the store). Leave this and the
+                 * remaining batch elements uncommitted so normal parent
+                 * retry handling preserves them. Classic DA behavior is
+                 * intentionally unchanged. */
+                break;
             }
         }
         pWti->batch.eltState[i] = BATCH_STATE_COMM; /* commited to other queue! */
     }
+    STATSCOUNTER_ADD(pThis->ctrDASpilled, pThis->mutCtrDASpilled, nEnq);
 
     /* but now cancellation is no longer permitted */
     pthread_setcancelstate(iCancelStateSave, NULL);
 
+    d_pthread_mutex_lock(pThis->mut);
+    RETiRet;
+}
+
+
+/* hand a DA batch over to the disk queue as a whole, which is what the
+ * adaptive spill policy does. The DA queue shares our mutex, so the batch is
+ * handed over without releasing it: one lock hold, one checkpoint check, one
+ * worker advise and, for a segmented DA queue, one group commit per batch
+ * instead of per message. Producers wait for the whole batch, which is why
+ * this is only done if the adaptive policy was selected. As with
+ * multi-submit, this must not be cancelled.
+ * The mutex is locked when called and when returning.
+ */
+static rsRetVal ConsumerDABatch(qqueue_t *pThis, wti_t *pWti) {
+    int i, j;
+    int nEnq = 0;
+    int iCancelStateSave;
+    rsRetVal localRet;
+    DEFiRet;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &iCancelStateSave);
+
+    /* iterate over returned results and enqueue them in DA queue */
+    for (i = 0; i < pWti->batch.nElem && !qqueueIsShutdownImmediate(pThis); i++) {
+        localRet = doEnqSingleObj(pThis->pqDA, eFLOWCTL_NO_DELAY, MsgAddRef(pWti->batch.pElem[i].pMsg));
+        if (localRet == RS_RET_OK) {
+            ++nEnq;
+        } else if (localRet == RS_RET_ERR_QUEUE_EMERGENCY) {
+            /* Queue emergency error occurred */
+            DBGOPRINT((obj_t *)pThis,
+                      "ConsumerDA:doEnqSingleObj caught RS_RET_ERR_QUEUE_EMERGENCY,"
+                      "aborting loop.\n");
+            iRet = localRet;
+            break;
+        } else {
+            DBGOPRINT((obj_t *)pThis,
+                      "ConsumerDA:doEnqSingleObj item (%d) returned "
+                      "with error state: '%d'\n",
+                      i, localRet);
+            if (pThis->pqDA->qType == QUEUETYPE_SEGMENTED_DISK) {
+                /* see ConsumerDAEach() */
+                iRet = localRet;
+                break;
+            }
+        }
+        pWti->batch.eltState[i] = BATCH_STATE_COMM; /* commited to other queue! */
+    }
+
+    if (nEnq > 0) qqueueChkPersist(pThis->pqDA, nEnq);
+    qqueueAdviseMaxWorkers(pThis->pqDA);
+    if (qqueueSegDiskNeedsGroupCommit(pThis->pqDA)) {
+        localRet = qqueueSegDiskGroupCommit(pThis->pqDA);
+        if (localRet != RS_RET_OK) {
+            /* nothing of this batch is known to be durable: keep it all in
+             * the parent for retry, accepting duplicates over loss */
+            for (j = 0; j < i; ++j) pWti->batch.eltState[j] = BATCH_STATE_RDY;
+            nEnq = 0;
+            if (iRet == RS_RET_OK) iRet = localRet;
+        }
+    }
+    STATSCOUNTER_ADD(pThis->ctrDASpilled, pThis->mutCtrDASpilled, nEnq);
+
+    pthread_setcancelstate(iCancelStateSave, NULL);
+    RETiRet;
+}
+
+
+/* This is a special consumer to feed the disk-queue in disk-assisted mode.
+ * When active, our own queue more or less acts as a memory buffer to the disk.
+ * So this consumer just needs to drain the memory queue and submit entries
+ * to the disk queue. The disk queue will then call the actual consumer from
+ * the app point of view (we chain two queues here).
+ * When this method is entered, the mutex is always locked; it is still
+ * locked when the method returns.
+ * rgerhards, 2008-01-14
+ */
+static rsRetVal ConsumerDA(qqueue_t *pThis, wti_t *pWti) {
+    int skippedMsgs = 0;
+    DEFiRet;
+
+    ISOBJ_TYPE_assert(pThis, qqueue);
+    ISOBJ_TYPE_assert(pWti, wti);
+
+    iRet = DequeueForConsumer(pThis, pWti, &skippedMsgs);
+    if (iRet == RS_RET_IDLE) qqueueDASpillStopped(pThis);
+    CHKiRet(iRet);
+
+    if (pThis->daSpillPolicy == QUEUE_DA_SPILL_ADAPTIVE) {
+        iRet = ConsumerDABatch(pThis, pWti);
+    } else {
+        iRet = ConsumerDAEach(pThis, pWti);
+    }
+    if (iRet == RS_RET_ERR_QUEUE_EMERGENCY) qqueueDASpillStopped(pThis);
+
 finalize_it:
-    /*	Check the last return state of qqueueEnqMsg. If an error was returned, we acknowledge it only.
+    /*	Check the last return state of the DA enqueue. If an error was returned, we acknowledge it only.
      *	Unless the error code is RS_RET_ERR_QUEUE_EMERGENCY, we reset the return state to RS_RET_OK.
      *	Otherwise the Caller functions would run into an infinite Loop trying to enqueue the
      *	same messages over and over again.
@@ -3743,15 +4126,12 @@ finalize_it:
      *	a pitfall due to unexpected states being passed on to the caller.
      */
     if (iRet != RS_RET_OK && iRet != RS_RET_ERR_QUEUE_EMERGENCY && iRet < 0) {
-        DBGOPRINT((obj_t *)pThis, "ConsumerDA:qqueueEnqMsg Resetting iRet from %d back to RS_RET_OK\n", iRet);
+        DBGOPRINT((obj_t *)pThis, "ConsumerDA:doEnqSingleObj Resetting iRet from %d back to RS_RET_OK\n", iRet);
         iRet = RS_RET_OK;
     } else {
-        DBGOPRINT((obj_t *)pThis, "ConsumerDA:qqueueEnqMsg returns with iRet %d\n", iRet);
+        DBGOPRINT((obj_t *)pThis, "ConsumerDA:doEnqSingleObj returns with iRet %d\n", iRet);
     }
 
-    /* now we are done, but potentially need to re-acquire the mutex */
-    if (bNeedReLock) d_pthread_mutex_lock(pThis->mut);
-
     RETiRet;
 }
 
@@ -3770,6 +4150,7 @@ static rsRetVal qqueueChkStopWrkrDA(qqueue_t *pThis) {
     if (getPhysicalQueueSize(pThis) <= pThis->iLowWtrMrk) {
         iRet = RS_RET_TERMINATE_NOW;
     }
+    if (iRet != RS_RET_OK) qqueueDASpillStopped(pThis);
 
     RETiRet;
 }
@@ -3804,6 +4185,27 @@ static rsRetVal GetDeqBatchSize(qqueue_t *pThis, int *pVal) {
 }
 
 
+/* return the batch size of the DA transfer worker: queue.spillBatchSize if
+ * set, otherwise the dequeue batch size, raised to DA_ADAPTIVE_SPILL_BATCH
+ * for the adaptive policy. Never more than the queue can hold.
+ */
+static rsRetVal GetDeqBatchSizeDA(qqueue_t *pThis, int *pVal) {
+    int n;
+    DEFiRet;
+    assert(pVal != NULL);
+    n = pThis->daSpillBatchSize;
+    if (n == 0) {
+        n = pThis->iDeqBatchSize;
+        if (pThis->daSpillPolicy == QUEUE_DA_SPILL_ADAPTIVE && n < DA_ADAPTIVE_SPILL_BATCH) {
+            n = DA_ADAPTIVE_SPILL_BATCH;
+        }
+    }
+    if (pThis->iMaxQueueSize > 0 && n > pThis->iMaxQueueSize) n = pThis->iMaxQueueSize;
+    *pVal = n;
+    RETiRet;
+}
+
+
 /* start up the queue - it must have been constructed and parameters defined
  * before.
  */
@@ -3916,6 +4318,7 @@ rsRetVal qqueueStart(rsconf_t *cnf, qqueue_t *pThis) /* this is the Construction
     pthread_cond_init(&pThis->notFull, NULL);
     pthread_cond_init(&pThis->belowFullDlyWtrMrk, NULL);
     pthread_cond_init(&pThis->belowLightDlyWtrMrk, NULL);
+    pthread_cond_init(&pThis->segdiskSyncDone, NULL);
 
     /* call type-specific constructor */
     CHKiRet(pThis->qConstruct(pThis)); /* this also sets bIsDA */
@@ -4040,6 +4443,27 @@ rsRetVal qqueueStart(rsconf_t *cnf, qqueue_t *pThis) /* this is the Construction
     CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("maxqsize"), ctrType_Int, CTR_FLAG_NONE,
                                 &pThis->ctrMaxqsize));
 
+    if (pThis->bIsDA) {
+        STATSCOUNTER_INIT(pThis->ctrDASpillStarts, pThis->mutCtrDASpillStarts);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.spill.starts"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrDASpillStarts));
+        STATSCOUNTER_INIT(pThis->ctrDASpillDeferred, pThis->mutCtrDASpillDeferred);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.spill.deferred"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrDASpillDeferred));
+        STATSCOUNTER_INIT(pThis->ctrDASpilled, pThis->mutCtrDASpilled);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.spilled"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrDASpilled));
+        STATSCOUNTER_INIT(pThis->ctrDAUnspilled, pThis->mutCtrDAUnspilled);
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.unspilled"), ctrType_IntCtr,
+                                    CTR_FLAG_RESETTABLE, &pThis->ctrDAUnspilled));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.fillRate"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->daFillRate));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.drainRate"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->daDrainRate));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("da.timeToFull"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->daTimeToFull));
+    }
+
     if (pThis->qType == QUEUETYPE_SEGMENTED_DISK) {
         CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("disk.usage"), ctrType_Int, CTR_FLAG_NONE,
                                     &pThis->segdiskBytes));
@@ -4071,6 +4495,16 @@ rsRetVal qqueueStart(rsconf_t *cnf, qqueue_t *pThis) /* this is the Construction
                                     &pThis->segdiskRecoveryBytes));
         CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("recovery.records"), ctrType_Int, CTR_FLAG_NONE,
                                     &pThis->segdiskRecoveryRecords));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("read.calls"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->segdiskReadCalls));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("compression.segments"), ctrType_Int,
+                                    CTR_FLAG_NONE, &pThis->segdiskCompressedSegments));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("compression.savedBytes"), ctrType_Int,
+                                    CTR_FLAG_NONE, &pThis->segdiskCompressionSavedBytes));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("sync.groupCommits"), ctrType_Int, CTR_FLAG_NONE,
+                                    &pThis->segdiskGroupCommits));
+        CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("sync.groupCommitRecords"), ctrType_Int,
+                                    CTR_FLAG_NONE, &pThis->segdiskGroupCommitRecords));
         CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("startup.payloadBytesRead"), ctrType_Int,
                                     CTR_FLAG_NONE, &pThis->segdiskStartupPayloadBytes));
         CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("startup.segmentFilesProbed"), ctrType_Int,
@@ -4247,6 +4681,9 @@ static rsRetVal DoSaveOnShutdown(qqueue_t *pThis) {
     timeoutComp(&tTimeout, QUEUE_TIMEOUT_ETERNAL);
     /* and run the primary queue's DA worker to drain the queue */
     iRetLocal = wtpShutdownAll(pThis->pWtpDA, wtpState_SHUTDOWN, &tTimeout);
+    d_pthread_mutex_lock(pThis->mut);
+    qqueueDASpillStopped(pThis);
+    d_pthread_mutex_unlock(pThis->mut);
     DBGOPRINT((obj_t *)pThis, "end queue persistence run, iRet %d, queue size log %d, phys %d\n", iRetLocal,
               getLogicalQueueSize(pThis), getPhysicalQueueSize(pThis));
     if (iRetLocal != RS_RET_OK) {
@@ -4341,6 +4778,7 @@ BEGINobjDestruct(qqueue) /* be sure to specify the object type also in END and C
         pthread_cond_destroy(&pThis->notFull);
         pthread_cond_destroy(&pThis->belowFullDlyWtrMrk);
         pthread_cond_destroy(&pThis->belowLightDlyWtrMrk);
+        pthread_cond_destroy(&pThis->segdiskSyncDone);
 
         DESTROY_ATOMIC_HELPER_MUT(pThis->mutQueueSize);
         DESTROY_ATOMIC_HELPER_MUT(pThis->mutLogDeq);
@@ -4617,6 +5055,11 @@ static rsRetVal qqueueMultiEnqObjNonDirect(qqueue_t *pThis, multi_submit_t *pMul
 finalize_it:
     /* make sure at least one worker is running. */
     qqueueAdviseMaxWorkers(pThis);
+    if (qqueueSegDiskNeedsGroupCommit(pThis)) {
+        /* one sync covers the whole submission */
+        localRet = qqueueSegDiskGroupCommit(pThis);
+        if (iRet == RS_RET_OK) iRet = localRet;
+    }
     /* and release the mutex */
     d_pthread_mutex_unlock(pThis->mut);
     pthread_setcancelstate(iCancelStateSave, NULL);
@@ -4667,6 +5110,10 @@ finalize_it:
     if (isNonDirectQ) {
         /* make sure at least one worker is running. */
         qqueueAdviseMaxWorkers(pThis);
+        if (qqueueSegDiskNeedsGroupCommit(pThis)) {
+            const rsRetVal localRet = qqueueSegDiskGroupCommit(pThis);
+            if (iRet == RS_RET_OK) iRet = localRet;
+        }
         /* and release the mutex */
         d_pthread_mutex_unlock(pThis->mut);
         pthread_setcancelstate(iCancelStateSave, NULL);
@@ -4995,6 +5442,50 @@ rsRetVal qqueueApplyCnfParam(qqueue_t *pThis, struct nvlst *lst) {
             pThis->iPersistUpdCnt = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "queue.syncqueuefiles")) {
             pThis->bSyncQueueFiles = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.segmentcompression")) {
+            char *mode;
+            CHKmalloc(mode = es_str2cstr(pvals[i].val.d.estr, NULL));
+            if (!strcasecmp(mode, "none")) {
+                pThis->segdiskCompression = SEGDISK_COMPRESSION_NONE;
+            } else if (!strcasecmp(mode, "zstd")) {
+                pThis->segdiskCompression = SEGDISK_COMPRESSION_ZSTD;
+                if (!segdiskBlockAvailable(SEGDISK_COMPRESSION_ZSTD)) {
+                    parser_errmsg("queue.segmentCompression: rsyslog was built without zstd; using 'none'");
+                    pThis->segdiskCompression = SEGDISK_COMPRESSION_NONE;
+                }
+            } else {
+                parser_errmsg("queue.segmentCompression: invalid value '%s'; using 'none'", mode);
+                pThis->segdiskCompression = SEGDISK_COMPRESSION_NONE;
+            }
+            free(mode);
+        } else if (!strcmp(pblk.descr[i].name, "queue.diskrecordformat")) {
+            char *mode;
+            CHKmalloc(mode = es_str2cstr(pvals[i].val.d.estr, NULL));
+            if (!strcasecmp(mode, "object")) {
+                pThis->diskRecordFormat = QUEUE_DISK_RECORD_OBJECT;
+            } else if (!strcasecmp(mode, "binary")) {
+                pThis->diskRecordFormat = QUEUE_DISK_RECORD_BINARY;
+            } else {
+                parser_errmsg("queue.diskRecordFormat: invalid value '%s'; using 'object'", mode);
+                pThis->diskRecordFormat = QUEUE_DISK_RECORD_OBJECT;
+            }
+            free(mode);
+        } else if (!strcmp(pblk.descr[i].name, "queue.spillpolicy")) {
+            char *mode;
+            CHKmalloc(mode = es_str2cstr(pvals[i].val.d.estr, NULL));
+            if (!strcasecmp(mode, "watermark")) {
+                pThis->daSpillPolicy = QUEUE_DA_SPILL_WATERMARK;
+            } else if (!strcasecmp(mode, "adaptive")) {
+                pThis->daSpillPolicy = QUEUE_DA_SPILL_ADAPTIVE;
+            } else {
+                parser_errmsg("queue.spillPolicy: invalid value '%s'; using 'watermark'", mode);
+                pThis->daSpillPolicy = QUEUE_DA_SPILL_WATERMARK;
+            }
+            free(mode);
+        } else if (!strcmp(pblk.descr[i].name, "queue.spillhorizon")) {
+            pThis->daSpillHorizon = pvals[i].val.d.n;
+        } else if (!strcmp(pblk.descr[i].name, "queue.spillbatchsize")) {
+            pThis->daSpillBatchSize = pvals[i].val.d.n;
         } else if (!strcmp(pblk.descr[i].name, "queue.type")) {
             pThis->qType = (queueType_t)pvals[i].val.d.n;
             if (pThis->qType == QUEUETYPE_DIRECT) {
@@ -5102,6 +5593,15 @@ rsRetVal qqueueApplyCnfParam(qqueue_t *pThis, struct nvlst *lst) {
         parser_errmsg("queue.diskQueueIdleTimeout does not apply to the classic disk engine; using 60000");
         pThis->diskQueueIdleTimeout = 60000;
     }
+    if (!is_da_memory_queue && (pThis->daSpillPolicy != QUEUE_DA_SPILL_WATERMARK || pThis->daSpillHorizon != 2000 ||
+                                pThis->daSpillBatchSize != 0)) {
+        parser_errmsg(
+            "queue.spillPolicy, queue.spillHorizon, and queue.spillBatchSize apply only to FixedArray or "
+            "LinkedList disk-assisted queues; ignoring these parameters");
+        pThis->daSpillPolicy = QUEUE_DA_SPILL_WATERMARK;
+        pThis->daSpillHorizon = 2000;
+        pThis->daSpillBatchSize = 0;
+    }
 
     checkUniqueDiskFile(pThis);
 
@@ -5177,8 +5677,10 @@ int queuesEqual(qqueue_t *pOld, qqueue_t *pNew) {
             NUM_EQUALS(iMinDeqBatchSize) && NUM_EQUALS(toMinDeqBatchSize) && NUM_EQUALS(sizeOnDiskMax) &&
             NUM_EQUALS(iHighWtrMrk) && NUM_EQUALS(iLowWtrMrk) && NUM_EQUALS(iFullDlyMrk) && NUM_EQUALS(iLightDlyMrk) &&
             NUM_EQUALS(iDiscardMrk) && NUM_EQUALS(iDiscardSeverity) && NUM_EQUALS(iPersistUpdCnt) &&
-            NUM_EQUALS(bSyncQueueFiles) && NUM_EQUALS(iNumWorkerThreads) && NUM_EQUALS(toQShutdown) &&
-            NUM_EQUALS(toActShutdown) && NUM_EQUALS(toEnq) && NUM_EQUALS(toWrkShutdown) &&
+            NUM_EQUALS(bSyncQueueFiles) && NUM_EQUALS(segdiskCompression) && NUM_EQUALS(diskRecordFormat) &&
+            NUM_EQUALS(daSpillPolicy) && NUM_EQUALS(daSpillHorizon) && NUM_EQUALS(daSpillBatchSize) &&
+            NUM_EQUALS(iNumWorkerThreads) &&
+            NUM_EQUALS(toQShutdown) && NUM_EQUALS(toActShutdown) && NUM_EQUALS(toEnq) && NUM_EQUALS(toWrkShutdown) &&
             NUM_EQUALS(iMinMsgsPerWrkr) && NUM_EQUALS(iMaxFileSize) && NUM_EQUALS(bSaveOnShutdown) &&
             NUM_EQUALS(iDeqSlowdown) && NUM_EQUALS(iDeqtWinFromHr) && NUM_EQUALS(iDeqtWinToHr) &&
             NUM_EQUALS(iSmpInterval) && NUM_EQUALS(takeFlowCtlFromMsg) && qdaLifecycleConfigEqual(&old_da, &new_da) &&
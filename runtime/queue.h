@@ -76,6 +76,18 @@ typedef enum {
     QUEUE_ON_CORRUPTION_IGNORE = 2
 } queueOnCorruption_t;
 
+/* record formats written by the classic disk queue */
+typedef enum {
+    QUEUE_DISK_RECORD_OBJECT = 0, /* text object serialization (MsgSerialize) */
+    QUEUE_DISK_RECORD_BINARY = 1 /* framed segdisk binary codec */
+} queueDiskRecordFormat_t;
+
+/* when a disk-assisted queue starts moving messages to disk */
+typedef enum {
+    QUEUE_DA_SPILL_WATERMARK = 0, /* whenever the high watermark is reached */
+    QUEUE_DA_SPILL_ADAPTIVE = 1 /* at the high watermark, if the queue is predicted to fill up */
+} queueDASpillPolicy_t;
+
 /* list member definition for linked list types of queues: */
 typedef struct qLinkedList_S {
     struct qLinkedList_S *pNext;
@@ -122,6 +134,7 @@ struct queue_s {
         int iDiscardSeverity; /* messages of this severity above are discarded on too-full queue */
         sbool bNeedDelQIF; /* does the QIF file need to be deleted when queue becomes empty? */
         queueOnCorruption_t onCorruption; /* what to do on queue corruption */
+        queueDiskRecordFormat_t diskRecordFormat; /* format of newly written classic disk records */
         int toQShutdown; /* timeout for regular queue shutdown in ms */
         int toActShutdown; /* timeout for long-running action shutdown in ms */
         int toWrkShutdown; /* timeout for idle workers in ms, -1 means indefinite (0 is immediate) */
@@ -167,6 +180,7 @@ struct queue_s {
         pthread_cond_t notFull;
         pthread_cond_t belowFullDlyWtrMrk; /* below eFLOWCTL_FULL_DELAY watermark */
         pthread_cond_t belowLightDlyWtrMrk; /* below eFLOWCTL_FULL_DELAY watermark */
+        pthread_cond_t segdiskSyncDone; /* a segmentedDisk group commit finished */
         int bThrdStateChanged; /* at least one thread state has changed if 1 */
         /* end sync variables */
         /* the following variables are always present, because they
@@ -195,9 +209,19 @@ struct queue_s {
         sbool diskQueueIdleTimeoutSet;
         sbool segdiskLazyCreate; /* create a fresh segmented store on first append */
         sbool segdiskDAChild; /* segmented child of an in-memory DA parent */
+        segdisk_compression_t segdiskCompression; /* codec for sealed segmented segments */
+        sbool segdiskSyncRunning; /* a producer is syncing on behalf of the group */
         sbool daEngineMarkerPending; /* publish the selected DA engine before first append */
         uint64_t daActivityGeneration; /* parent enqueue generation for the idle grace period */
         uint64_t segdiskIdleObservedActivity;
+        queueDASpillPolicy_t daSpillPolicy; /* when to start the DA worker */
+        int daSpillHorizon; /* adaptive: spill if projected time-to-full (ms) is below this */
+        int daSpillBatchSize; /* messages per DA transfer batch, 0 - automatic */
+        sbool daSpilling; /* DA worker advised and low watermark not yet reached */
+        sbool daSpillDeferred; /* adaptive policy declined the current high watermark crossing */
+        int64_t daWindowStart; /* predictor sample window start, monotonic ms */
+        int daWindowEnq; /* messages enqueued in the sample window */
+        int daWindowDeq; /* messages consumed from memory in the sample window */
         struct queue_s *pqDA; /* queue for disk-assisted modes */
         struct queue_s *pqParent; /* pointer to the parent (if this is a child queue) */
         int bDAEnqOnly; /* EnqOnly setting for DA queue */
@@ -242,6 +266,13 @@ struct queue_s {
         STATSCOUNTER_DEF(ctrFDscrd, mutCtrFDscrd)
         STATSCOUNTER_DEF(ctrNFDscrd, mutCtrNFDscrd)
         int ctrMaxqsize; /* NOT guarded by a mutex */
+        STATSCOUNTER_DEF(ctrDASpillStarts, mutCtrDASpillStarts)
+        STATSCOUNTER_DEF(ctrDASpillDeferred, mutCtrDASpillDeferred)
+        STATSCOUNTER_DEF(ctrDASpilled, mutCtrDASpilled)
+        STATSCOUNTER_DEF(ctrDAUnspilled, mutCtrDAUnspilled)
+        int daFillRate; /* smoothed enqueue rate, msgs/s */
+        int daDrainRate; /* smoothed memory consumer rate, msgs/s */
+        int daTimeToFull; /* projected ms until full, -1 - not filling */
         int segdiskBytes;
         int segdiskSegments;
         int segdiskCheckpoints;
@@ -262,6 +293,11 @@ struct queue_s {
         int segdiskMaterializations;
         int segdiskDematerializations;
         int segdiskIdleCleanupFailures;
+        int segdiskReadCalls;
+        int segdiskCompressedSegments;
+        int segdiskCompressionSavedBytes;
+        int segdiskGroupCommits;
+        int segdiskGroupCommitRecords;
         int iSmpInterval; /* line interval of sampling logs */
         int isRunning;
 };
@@ -311,6 +311,7 @@ static void cnfSetDefaults(rsconf_t *pThis) {
     pThis->templates.root = NULL;
     pThis->templates.last = NULL;
     pThis->templates.lastStatic = NULL;
+    pThis->templates.nPropCols = 0;
     pThis->actions.nbrActions = 0;
     pThis->actions.iActionNbr = 0;
     pThis->actions.action_names = NULL;
@@ -367,6 +368,11 @@ static void cnfSetDefaults(rsconf_t *pThis) {
     pThis->globals.shutdownQueueDoubleSize = 0;
     pThis->globals.optionDisallowWarning = 1;
     pThis->globals.bSupportCompressionExtension = 1;
+    pThis->globals.bParserAdaptiveOrder = 0;
+    pThis->globals.bNetstrmDrvrKTLS = 0;
+    pThis->globals.bNetstrmDrvrSessResumption = 0;
+    pThis->globals.iNetstrmDrvrSessLifetime = 30;
+    pThis->globals.pszNetstrmDrvrTicketKeyFile = NULL;
 #ifdef ENABLE_LIBLOGGING_STDLOG
     pThis->globals.stdlog_hdl = stdlog_open("rsyslogd", 0, STDLOG_SYSLOG, NULL);
     pThis->globals.stdlog_chanspec = NULL;
@@ -503,6 +509,7 @@ BEGINobjDestruct(rsconf) /* be sure to specify the object type also in END and C
     free(pThis->globals.pszDfltNetstrmDrvrKeyFile);
     free(pThis->globals.pszDfltNetstrmDrvr);
     free(pThis->globals.oversizeMsgErrorFile);
+    free(pThis->globals.pszNetstrmDrvrTicketKeyFile);
 #ifdef ENABLE_LIBLOGGING_STDLOG
     stdlog_close(pThis->globals.stdlog_hdl);
     free(pThis->globals.stdlog_chanspec);
@@ -1257,6 +1264,9 @@ static rsRetVal activate(rsconf_t *cnf) {
         CHKiRet(glblSetMaxOpenFiles(NULL, cnf->globals.iMaxOpenFiles));
     }
 
+    /* template entries are final now and no worker renders yet */
+    tplCompileAll(cnf);
+
     /* the output part and the queue is now ready to run. So it is a good time
      * to initialize the inputs. Please note that the net code above should be
      * shuffled to down here once we have everything in input modules.
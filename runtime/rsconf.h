@@ -131,6 +131,10 @@ struct globals_s {
     uchar *pszDfltNetstrmDrvrKeyFile; /* default key file for the netstrm driver (server) */
     uchar *pszDfltNetstrmDrvr; /* module name of default netstream driver */
     uchar *pszNetstrmDrvrCAExtraFiles; /* CA extra file for the netstrm driver */
+    int bNetstrmDrvrKTLS; /* let the netstrm driver offload TLS records to the kernel, if possible */
+    int bNetstrmDrvrSessResumption; /* resume TLS sessions when reconnecting to a target */
+    int iNetstrmDrvrSessLifetime; /* seconds a TLS session (or ticket) can be resumed */
+    uchar *pszNetstrmDrvrTicketKeyFile; /* TLS session ticket keys, generated if not set */
     uchar *pszDfltOpensslEngine; /* custom openssl engine */
     uchar *oversizeMsgErrorFile; /* File where oversize messages are written to */
     int reportOversizeMsg; /* shall error messages be generated for oversize messages? */
@@ -174,6 +178,7 @@ struct globals_s {
     int shutdownQueueDoubleSize;
     int optionDisallowWarning; /* complain if message from disallowed sender is received */
     int bSupportCompressionExtension;
+    int bParserAdaptiveOrder; /* skip parsers that rejected a message prefix before? */
 #ifdef ENABLE_LIBLOGGING_STDLOG
     stdlog_channel_t stdlog_hdl; /* handle to be used for stdlog */
     uchar *stdlog_chanspec;
@@ -227,6 +232,7 @@ struct templates_s {
     struct template *root; /* the root of the template list */
     struct template *last; /* points to the last element of the template list */
     struct template *lastStatic; /* last static element of the template list */
+    int nPropCols; /* number of property cache columns, set by tplCompileAll() */
 };
 
 struct parsers_s {
@@ -0,0 +1,79 @@
+/* Block compression for sealed segmentedDisk segments.
+ *
+ * The store frames and checksums blocks itself; this file only hides whether
+ * a compression library is available. Without libzstd every call except
+ * segdiskBlockAvailable() reports RS_RET_ZLIB_ERR, and configuration refuses
+ * to enable compression.
+ *
+ * This file is part of the rsyslog project, released under ASL 2.0.
+ */
+#include "config.h"
+#include <stdlib.h>
+#ifdef ENABLE_LIBZSTD
+    #include <zstd.h>
+#endif
+#include "segdisk_block.h"
+
+/* favour speed: compression runs on the enqueue path */
+#define SEGDISK_ZSTD_LEVEL 1
+
+sbool segdiskBlockAvailable(segdisk_compression_t compression) {
+#ifdef ENABLE_LIBZSTD
+    return compression == SEGDISK_COMPRESSION_ZSTD;
+#else
+    (void)compression;
+    return 0;
+#endif
+}
+
+size_t segdiskBlockBound(size_t raw_len) {
+#ifdef ENABLE_LIBZSTD
+    return ZSTD_compressBound(raw_len);
+#else
+    return raw_len;
+#endif
+}
+
+rsRetVal segdiskBlockCompress(
+    segdisk_block_ctx_t *ctx, const void *raw, size_t raw_len, void *out, size_t out_cap, size_t *out_len) {
+#ifdef ENABLE_LIBZSTD
+    if (ctx->cctx == NULL && (ctx->cctx = ZSTD_createCCtx()) == NULL) return RS_RET_OUT_OF_MEMORY;
+    const size_t n = ZSTD_compressCCtx(ctx->cctx, out, out_cap, raw, raw_len, SEGDISK_ZSTD_LEVEL);
+    if (ZSTD_isError(n)) return RS_RET_ZLIB_ERR;
+    *out_len = n;
+    return RS_RET_OK;
+#else
+    (void)ctx;
+    (void)raw;
+    (void)raw_len;
+    (void)out;
+    (void)out_cap;
+    (void)out_len;
+    return RS_RET_ZLIB_ERR;
+#endif
+}
+
+rsRetVal segdiskBlockDecompress(
+    segdisk_block_ctx_t *ctx, const void *comp, size_t comp_len, void *raw, size_t raw_len) {
+#ifdef ENABLE_LIBZSTD
+    if (ctx->dctx == NULL && (ctx->dctx = ZSTD_createDCtx()) == NULL) return RS_RET_OUT_OF_MEMORY;
+    const size_t n = ZSTD_decompressDCtx(ctx->dctx, raw, raw_len, comp, comp_len);
+    return (ZSTD_isError(n) || n != raw_len) ? RS_RET_ZLIB_ERR : RS_RET_OK;
+#else
+    (void)ctx;
+    (void)comp;
+    (void)comp_len;
+    (void)raw;
+    (void)raw_len;
+    return RS_RET_ZLIB_ERR;
+#endif
+}
+
+void segdiskBlockCtxFree(segdisk_block_ctx_t *ctx) {
+#ifdef ENABLE_LIBZSTD
+    ZSTD_freeCCtx(ctx->cctx);
+    ZSTD_freeDCtx(ctx->dctx);
+#endif
+    ctx->cctx = NULL;
+    ctx->dctx = NULL;
+}
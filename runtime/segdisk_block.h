@@ -0,0 +1,28 @@
+/* Block compression for sealed segmentedDisk segments. */
+#ifndef INCLUDED_SEGDISK_BLOCK_H
+#define INCLUDED_SEGDISK_BLOCK_H
+
+#include <stddef.h>
+#include "rsyslog.h"
+
+/** Compression applied to segments once they are sealed. */
+typedef enum segdisk_compression_e {
+    SEGDISK_COMPRESSION_NONE = 0,
+    SEGDISK_COMPRESSION_ZSTD = 1,
+} segdisk_compression_t;
+
+/** Reusable compression and decompression contexts. Zero-initialize. */
+typedef struct segdisk_block_ctx_s {
+    void *cctx;
+    void *dctx;
+} segdisk_block_ctx_t;
+
+sbool segdiskBlockAvailable(segdisk_compression_t compression);
+size_t segdiskBlockBound(size_t raw_len);
+rsRetVal segdiskBlockCompress(
+    segdisk_block_ctx_t *ctx, const void *raw, size_t raw_len, void *out, size_t out_cap, size_t *out_len);
+rsRetVal segdiskBlockDecompress(
+    segdisk_block_ctx_t *ctx, const void *comp, size_t comp_len, void *raw, size_t raw_len);
+void segdiskBlockCtxFree(segdisk_block_ctx_t *ctx);
+
+#endif
@@ -212,6 +212,12 @@ rsRetVal segdiskCodecEncode(smsg_t *msg, unsigned char **buf, size_t *len) {
     text = getRcvFromPort(msg);
     ADD(add_bytes(&b, F_RCVFROMPORT, text, strlen((char *)text)));
     if (msg->pszStrucData != NULL) ADD(add_bytes(&b, F_STRUCTURED_DATA, msg->pszStrucData, msg->lenStrucData));
+    /* serializing writes to the json objects, so they must be complete and not shared */
+    MsgLock(msg);
+    r = msgMaterializeLazyJSON(msg);
+    if (r == RS_RET_OK) r = msgJsonUnshare(msg);
+    MsgUnlock(msg);
+    if (r != RS_RET_OK) goto fail;
     ADD(add_json(&b, F_JSON, msg, msg->json));
     ADD(add_json(&b, F_LOCALVARS, msg, msg->localvars));
     ADD(add_cstr(&b, F_APPNAME, msg, msg->pCSAPPNAME));
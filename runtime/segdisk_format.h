@@ -4,5 +4,9 @@
 #define INCLUDED_SEGDISK_FORMAT_H
 
 #define SEGDISK_CODEC_VERSION 1
+/* Segment header codec version of a sealed segment whose record area is
+ * stored as compressed blocks. The records inside the blocks still use
+ * SEGDISK_CODEC_VERSION; the state file never carries this value. */
+#define SEGDISK_CODEC_VERSION_BLOCKS 2
 
 #endif
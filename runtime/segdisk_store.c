@@ -25,6 +25,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include "errmsg.h"
+#include "segdisk_block.h"
 #include "segdisk_codec.h"
 #include "segdisk_crc.h"
 #include "segdisk_state.h"
@@ -41,9 +42,26 @@
 #define FOOT_LEN 48u
 #define MAX_RECORD_SIZE (128u * 1024u * 1024u)
 #define RECOVERY_SCAN_BUDGET (1024u * 1024u)
+#define READ_WINDOW_LEN (1024u * 1024u)
+#define WRITEBACK_CHUNK (1024u * 1024u)
+#define BLK_MAGIC "RSBLKZ02"
+#define BLK_HDR_LEN 40u
+#define BLK_RAW_LEN (64u * 1024u)
+#define BLK_FLAG_STORED 1u
 #define STATE_FLAG_RECOVERY 1u
 #define STATE_FLAG_DEMATERIALIZING 2u
 
+/* One compressed block of a sealed segment. raw_off and raw_len describe
+ * the bytes it restores in the uncompressed segment layout. */
+typedef struct segdisk_block_s {
+    int64_t raw_off;
+    int64_t file_off;
+    uint32_t raw_len;
+    uint32_t comp_len;
+    uint32_t crc;
+    uint16_t flags;
+} segdisk_block_t;
+
 typedef struct segdisk_segment_s {
     uint64_t id;
     uint64_t first_sequence;
@@ -54,9 +72,37 @@ typedef struct segdisk_segment_s {
     uint32_t rolling_crc;
     sbool sealed;
     sbool recovery;
+    sbool compressed;
     char *path;
+    segdisk_block_t *blocks;
+    size_t block_count;
 } segdisk_segment_t;
 
+/* Rewrite of one sealed segment into compressed blocks, advanced one block
+ * per store call so the queue lock is never held for a whole segment. */
+typedef struct segdisk_zjob_s {
+    uint64_t segment; /* 0: no job */
+    int src_fd;
+    int dst_fd;
+    int64_t raw_pos;
+    int64_t raw_end;
+    int64_t src_size;
+    int64_t dst_size;
+    char *path;
+    char *tmp_path;
+    unsigned char *raw;
+    unsigned char *out;
+    size_t out_cap;
+} segdisk_zjob_t;
+
+/* Payload of a dequeued record, copied out of the read window so that it can
+ * be checked and decoded without the queue lock. */
+typedef struct segdisk_raw_record_s {
+    size_t off;
+    uint32_t len;
+    uint32_t crc;
+} segdisk_raw_record_t;
+
 typedef struct segdisk_batch_ctx_s {
     uint64_t sequence;
     uint64_t end_segment;
@@ -68,6 +114,11 @@ typedef struct segdisk_batch_ctx_s {
     unsigned int refs;
     sbool pending;
     sbool complete;
+    segdisk_raw_record_t *raw_records; /* until segdiskStoreFinishBatch() */
+    unsigned char *raw;
+    size_t raw_len;
+    size_t raw_cap;
+    int decode_failures;
     struct segdisk_batch_ctx_s *next;
 } segdisk_batch_ctx_t;
 
@@ -102,6 +153,25 @@ struct segdisk_store_s {
     uint64_t read_segment_id;
     int64_t read_offset;
     segdisk_segment_t *read_segment;
+    /* Dequeue read window: one descriptor per read segment and a buffer that
+     * holds a contiguous span of it, so records are decoded in place. */
+    int read_fd;
+    uint64_t read_fd_segment;
+    unsigned char *rbuf;
+    size_t rbuf_cap;
+    int64_t rbuf_off;
+    size_t rbuf_len;
+    unsigned char *zbuf;
+    size_t zbuf_cap;
+    segdisk_block_ctx_t zctx;
+    segdisk_zjob_t zjob;
+    uint64_t zjob_next; /* lowest sealed segment not yet considered */
+    /* Group commit with sync_files: appends advance appended_gen without
+     * syncing; durable_gen is the generation known to be on stable storage.
+     * Records of sealed segments are always durable. */
+    uint64_t appended_gen;
+    uint64_t durable_gen;
+    int64_t writeback_end; /* active-segment offset handed to writeback */
     segdisk_segment_t *active;
     segdisk_batch_ctx_t *pending_head;
     segdisk_batch_ctx_t *pending_tail;
@@ -181,8 +251,34 @@ static int sync_file_data(const int fd) {
 #endif
 }
 
+static void mark_durable(segdisk_store_t *s, uint64_t target) {
+    if (target <= s->durable_gen) return;
+    s->stats.group_commit_records += target - s->durable_gen;
+    s->durable_gen = target;
+}
+
+/* Make all appended records durable while the lock is held. */
+static rsRetVal sync_active_appends(segdisk_store_t *s) {
+    if (s->durable_gen == s->appended_gen) return RS_RET_OK;
+    if (s->active_fd >= 0 && sync_file_data(s->active_fd) != 0) return RS_RET_IO_ERROR;
+    ++s->stats.group_commits;
+    mark_durable(s, s->appended_gen);
+    return RS_RET_OK;
+}
+
+static void free_batch_raw(segdisk_batch_ctx_t *ctx) {
+    free(ctx->raw_records);
+    free(ctx->raw);
+    ctx->raw_records = NULL;
+    ctx->raw = NULL;
+    ctx->raw_len = ctx->raw_cap = 0;
+}
+
 static void release_batch_ctx(segdisk_batch_ctx_t *ctx) {
-    if (--ctx->refs == 0) free(ctx);
+    if (--ctx->refs == 0) {
+        free_batch_raw(ctx);
+        free(ctx);
+    }
 }
 
 static void put16(unsigned char *p, uint16_t v) {
@@ -355,10 +451,14 @@ static rsRetVal write_state(segdisk_store_t *s, sbool force_sync, sbool topology
     unsigned char b[STATE_SLOT_LEN];
     const uint64_t next_generation = s->generation + 1;
     segdisk_state_image_t state;
+    /* the state may name records of the active segment; never publish it
+     * ahead of their data */
+    rsRetVal r = sync_active_appends(s);
+    if (r != RS_RET_OK) return r;
     capture_state_image(s, &state);
     segdiskStateEncode(&state, next_generation, b);
     const int slot = (int)(next_generation & 1u);
-    rsRetVal r = pwrite_full(s->state_fd, b, sizeof(b), slot * STATE_SLOT_LEN);
+    r = pwrite_full(s->state_fd, b, sizeof(b), slot * STATE_SLOT_LEN);
     if (r == RS_RET_OK && (force_sync || s->cfg.sync_files) && sync_file_data(s->state_fd) != 0) r = RS_RET_IO_ERROR;
     if (r == RS_RET_OK) {
         s->generation = next_generation;
@@ -389,7 +489,8 @@ static int segment_name(const char *name) {
     unsigned long long id;
     char suffix[16];
     if (sscanf(name, "segment-%20llu.%15s", &id, suffix) != 2) return 0;
-    return !strcmp(suffix, "seg") || !strcmp(suffix, "open") || !strcmp(suffix, "recover");
+    return !strcmp(suffix, "seg") || !strcmp(suffix, "open") || !strcmp(suffix, "recover") ||
+           !strcmp(suffix, "ztmp");
 }
 
 static rsRetVal remove_remaining_segments(segdisk_store_t *s) {
@@ -467,15 +568,20 @@ static rsRetVal validate_segment_header(segdisk_store_t *s, int fd, segdisk_segm
     unsigned char b[SEG_HDR_LEN];
     rsRetVal r = read_full_at(fd, b, sizeof(b), 0);
     if (r != RS_RET_OK || memcmp(b, SEG_MAGIC, 8) || get16(b + 8) != STORE_VERSION ||
-        get16(b + 10) != SEGDISK_CODEC_VERSION || memcmp(b + 12, s->uuid, 16) || get64(b + 28) != seg->id ||
-        get32(b + 44) != SEG_HDR_LEN || get32(b + 48) != segdiskCrc32c(b, 48))
+        (get16(b + 10) != SEGDISK_CODEC_VERSION && get16(b + 10) != SEGDISK_CODEC_VERSION_BLOCKS) ||
+        memcmp(b + 12, s->uuid, 16) || get64(b + 28) != seg->id || get32(b + 44) != SEG_HDR_LEN ||
+        get32(b + 48) != segdiskCrc32c(b, 48))
         return RS_RET_INVALID_VALUE;
     seg->first_sequence = get64(b + 36);
+    /* only the compressor writes block segments, always after sealing */
+    seg->compressed = get16(b + 10) == SEGDISK_CODEC_VERSION_BLOCKS;
+    if (seg->compressed && !seg->sealed) return RS_RET_INVALID_VALUE;
     return RS_RET_OK;
 }
 
 static void free_segment(segdisk_segment_t **seg) {
     if (*seg == NULL) return;
+    free((*seg)->blocks);
     free((*seg)->path);
     free(*seg);
     *seg = NULL;
@@ -493,6 +599,46 @@ static rsRetVal probe_segment_path(segdisk_store_t *s, uint64_t id, const char *
     return saved_errno == ENOENT ? RS_RET_FILE_NOT_FOUND : RS_RET_IO_ERROR;
 }
 
+/* Read the block headers of a compressed segment. The blocks must restore a
+ * gap-free uncompressed layout starting right after the segment header; the
+ * logical data end replaces the physical one so that record offsets, the
+ * commit frontier and the state file never see the compressed layout.
+ */
+static rsRetVal load_block_index(int fd, segdisk_segment_t *seg, int64_t file_end) {
+    size_t cap = 0;
+    int64_t pos = SEG_HDR_LEN;
+    int64_t raw = SEG_HDR_LEN;
+    while (pos < file_end) {
+        unsigned char h[BLK_HDR_LEN];
+        if (file_end - pos < (int64_t)BLK_HDR_LEN) return RS_RET_INVALID_VALUE;
+        const rsRetVal r = read_full_at(fd, h, sizeof(h), pos);
+        if (r != RS_RET_OK) return r;
+        if (memcmp(h, BLK_MAGIC, 8) || get16(h + 8) != STORE_VERSION || get32(h + 36) != segdiskCrc32c(h, 36) ||
+            get64(h + 12) != (uint64_t)raw || get32(h + 20) == 0 || get32(h + 20) > BLK_RAW_LEN ||
+            get32(h + 24) > file_end - pos - BLK_HDR_LEN ||
+            ((get16(h + 10) & BLK_FLAG_STORED) && get32(h + 24) != get32(h + 20)))
+            return RS_RET_INVALID_VALUE;
+        if (seg->block_count == cap) {
+            const size_t ncap = cap == 0 ? 16 : cap * 2;
+            segdisk_block_t *const nb = realloc(seg->blocks, ncap * sizeof(*nb));
+            if (nb == NULL) return RS_RET_OUT_OF_MEMORY;
+            seg->blocks = nb;
+            cap = ncap;
+        }
+        segdisk_block_t *const b = &seg->blocks[seg->block_count++];
+        b->raw_off = raw;
+        b->raw_len = get32(h + 20);
+        b->file_off = pos + BLK_HDR_LEN;
+        b->comp_len = get32(h + 24);
+        b->crc = get32(h + 28);
+        b->flags = get16(h + 10);
+        raw += b->raw_len;
+        pos += BLK_HDR_LEN + b->comp_len;
+    }
+    seg->data_end = raw;
+    return RS_RET_OK;
+}
+
 static rsRetVal load_segment(segdisk_store_t *s, uint64_t id, segdisk_segment_t **out) {
     segdisk_segment_t *seg = calloc(1, sizeof(*seg));
     if (seg == NULL) return RS_RET_OUT_OF_MEMORY;
@@ -536,6 +682,7 @@ static rsRetVal load_segment(segdisk_store_t *s, uint64_t id, segdisk_segment_t
                 seg->record_count = get64(foot + 32);
                 seg->rolling_crc = get32(foot + 40);
                 seg->data_end = st.st_size - FOOT_LEN;
+                if (seg->compressed) r = load_block_index(fd, seg, st.st_size - FOOT_LEN);
             }
         }
     } else if (r == RS_RET_OK) {
@@ -692,6 +839,8 @@ static rsRetVal seal_active(segdisk_store_t *s) {
         free(sealed);
         return r;
     }
+    if (s->cfg.sync_files) mark_durable(s, s->appended_gen);
+    s->writeback_end = 0;
     test_fault(s, SEGDISK_TEST_FAULT_SEAL_WRITTEN);
     if (rename(s->active->path, sealed) != 0) {
         restore_active_after_seal_failure(s);
@@ -707,6 +856,7 @@ static rsRetVal seal_active(segdisk_store_t *s) {
     s->active->data_end = s->active->file_size - FOOT_LEN;
     s->stats.bytes += FOOT_LEN;
     s->last_data_segment = s->active->id;
+    if (s->cfg.compression != SEGDISK_COMPRESSION_NONE && s->zjob_next == 0) s->zjob_next = s->active->id;
     if (s->read_segment != NULL && s->read_segment->id == s->active->id) {
         free(s->read_segment->path);
         s->read_segment->path = read_path;
@@ -760,6 +910,142 @@ static void update_retry_overage(segdisk_store_t *s) {
         s->stats.retry_overage_max_bytes = s->stats.retry_overage_bytes;
 }
 
+static void zjob_abort(segdisk_store_t *s) {
+    segdisk_zjob_t *const j = &s->zjob;
+    if (j->segment == 0) return;
+    if (j->src_fd >= 0) close(j->src_fd);
+    if (j->dst_fd >= 0) close(j->dst_fd);
+    if (j->tmp_path != NULL && unlink(j->tmp_path) == 0) s->stats.bytes -= j->dst_size;
+    free(j->path);
+    free(j->tmp_path);
+    free(j->raw);
+    free(j->out);
+    memset(j, 0, sizeof(*j));
+    j->src_fd = j->dst_fd = -1;
+}
+
+static rsRetVal zjob_begin(segdisk_store_t *s, uint64_t id) {
+    segdisk_zjob_t *const j = &s->zjob;
+    unsigned char h[SEG_HDR_LEN];
+    struct stat st;
+    j->segment = id;
+    j->src_fd = j->dst_fd = -1;
+    j->out_cap = BLK_HDR_LEN + segdiskBlockBound(BLK_RAW_LEN);
+    j->path = segment_path(s, id, "seg");
+    j->tmp_path = segment_path(s, id, "ztmp");
+    j->raw = malloc(BLK_RAW_LEN);
+    j->out = malloc(j->out_cap);
+    if (j->path == NULL || j->tmp_path == NULL || j->raw == NULL || j->out == NULL) return RS_RET_OUT_OF_MEMORY;
+    j->src_fd = open(j->path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (j->src_fd < 0 || fstat(j->src_fd, &st) != 0) return RS_RET_IO_ERROR;
+    if (st.st_size < (int64_t)(SEG_HDR_LEN + FOOT_LEN)) return RS_RET_INVALID_VALUE;
+    rsRetVal r = read_full_at(j->src_fd, h, sizeof(h), 0);
+    if (r != RS_RET_OK) return r;
+    if (memcmp(h, SEG_MAGIC, 8) || get16(h + 10) != SEGDISK_CODEC_VERSION || get32(h + 48) != segdiskCrc32c(h, 48))
+        return RS_RET_INVALID_VALUE;
+    j->src_size = st.st_size;
+    j->raw_pos = SEG_HDR_LEN;
+    j->raw_end = st.st_size - FOOT_LEN;
+    j->dst_fd = open(j->tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (j->dst_fd < 0) return RS_RET_IO_ERROR;
+    put16(h + 10, SEGDISK_CODEC_VERSION_BLOCKS);
+    put32(h + 48, segdiskCrc32c(h, 48));
+    r = write_full(j->dst_fd, h, sizeof(h));
+    if (r != RS_RET_OK) return r;
+    j->dst_size = SEG_HDR_LEN;
+    s->stats.bytes += SEG_HDR_LEN;
+    return RS_RET_OK;
+}
+
+/* Compress the next block of the job. Once the record area is done, the
+ * original footer is appended and the result atomically replaces the sealed
+ * segment, unless it did not save space.
+ */
+static rsRetVal zjob_step(segdisk_store_t *s) {
+    segdisk_zjob_t *const j = &s->zjob;
+    if (j->raw_pos < j->raw_end) {
+        const size_t n = j->raw_end - j->raw_pos < (int64_t)BLK_RAW_LEN ? (size_t)(j->raw_end - j->raw_pos)
+                                                                         : BLK_RAW_LEN;
+        unsigned char *const h = j->out;
+        size_t comp_len = 0;
+        uint16_t flags = 0;
+        rsRetVal r = read_full_at(j->src_fd, j->raw, n, j->raw_pos);
+        if (r == RS_RET_OK)
+            r = segdiskBlockCompress(&s->zctx, j->raw, n, h + BLK_HDR_LEN, j->out_cap - BLK_HDR_LEN, &comp_len);
+        if (r != RS_RET_OK) return r;
+        if (comp_len >= n) {
+            /* incompressible data is stored as is */
+            memcpy(h + BLK_HDR_LEN, j->raw, n);
+            comp_len = n;
+            flags = BLK_FLAG_STORED;
+        }
+        memset(h, 0, BLK_HDR_LEN);
+        memcpy(h, BLK_MAGIC, 8);
+        put16(h + 8, STORE_VERSION);
+        put16(h + 10, flags);
+        put64(h + 12, (uint64_t)j->raw_pos);
+        put32(h + 20, (uint32_t)n);
+        put32(h + 24, (uint32_t)comp_len);
+        put32(h + 28, segdiskCrc32c(h + BLK_HDR_LEN, comp_len));
+        put32(h + 36, segdiskCrc32c(h, 36));
+        r = write_full(j->dst_fd, h, BLK_HDR_LEN + comp_len);
+        if (r != RS_RET_OK) return r;
+        j->dst_size += BLK_HDR_LEN + comp_len;
+        s->stats.bytes += BLK_HDR_LEN + comp_len;
+        j->raw_pos += n;
+        return RS_RET_OK;
+    }
+    unsigned char foot[FOOT_LEN];
+    rsRetVal r = read_full_at(j->src_fd, foot, sizeof(foot), j->raw_end);
+    if (r == RS_RET_OK) r = write_full(j->dst_fd, foot, sizeof(foot));
+    if (r != RS_RET_OK) return r;
+    j->dst_size += FOOT_LEN;
+    s->stats.bytes += FOOT_LEN;
+    if (j->dst_size >= j->src_size) {
+        /* nothing gained, keep the original */
+        zjob_abort(s);
+        return RS_RET_OK;
+    }
+    if (s->cfg.sync_files && sync_file_data(j->dst_fd) != 0) return RS_RET_IO_ERROR;
+    const int dst_fd = j->dst_fd;
+    j->dst_fd = -1;
+    if (close(dst_fd) != 0) return RS_RET_IO_ERROR;
+    if (rename(j->tmp_path, j->path) != 0) return RS_RET_IO_ERROR;
+    s->stats.bytes -= j->src_size;
+    ++s->stats.compressed_segments;
+    s->stats.compression_saved_bytes += (uint64_t)(j->src_size - j->dst_size);
+    free(j->tmp_path);
+    j->tmp_path = NULL; /* renamed: zjob_abort() must not unlink or unaccount it */
+    zjob_abort(s);
+    return s->cfg.sync_files ? sync_dir(s) : RS_RET_OK;
+}
+
+/* Advance sealed-segment compression by at most one block. Only segments
+ * beyond the read cursor are compressed; the reader itself never has to
+ * deal with a segment that changes underneath it. Failures are logged and
+ * leave the segment uncompressed.
+ */
+static void compress_sealed_step(segdisk_store_t *s) {
+    if (s->cfg.compression == SEGDISK_COMPRESSION_NONE || s->dir_fd < 0) return;
+    const uint64_t reader = s->read_segment_id != 0 ? s->read_segment_id : s->first_live_segment;
+    if (s->zjob.segment != 0 && s->zjob.segment <= reader) zjob_abort(s);
+    rsRetVal r = RS_RET_OK;
+    if (s->zjob.segment == 0) {
+        while (s->zjob_next != 0 && s->zjob_next <= reader) ++s->zjob_next;
+        if (s->zjob_next == 0 || s->zjob_next > s->last_data_segment ||
+            (s->active_segment != 0 && s->zjob_next >= s->active_segment))
+            return;
+        r = zjob_begin(s, s->zjob_next++);
+    }
+    const uint64_t id = s->zjob.segment;
+    if (r == RS_RET_OK) r = zjob_step(s);
+    if (r != RS_RET_OK) {
+        LogError(0, r, "%s: segmentedDisk could not compress segment %" PRIu64 "; it stays uncompressed",
+                 s->queue_name, id);
+        zjob_abort(s);
+    }
+}
+
 static rsRetVal append_record(segdisk_store_t *s, smsg_t *msg, sbool internal, int64_t *written) {
     if (s->dir_fd < 0) {
         const rsRetVal materialize_ret = materialize_empty(s);
@@ -789,7 +1075,6 @@ static rsRetVal append_record(segdisk_store_t *s, smsg_t *msg, sbool internal, i
         if (r != RS_RET_OK) return r;
     }
     r = write_full(s->active_fd, record, len);
-    if (r == RS_RET_OK && s->cfg.sync_files && sync_file_data(s->active_fd) != 0) r = RS_RET_IO_ERROR;
     if (r == RS_RET_OK) {
         s->active->data_end += len;
         s->active->file_size += len;
@@ -799,12 +1084,26 @@ static rsRetVal append_record(segdisk_store_t *s, smsg_t *msg, sbool internal, i
         ++s->known_queue_size;
         s->stats.bytes += len;
         if (written != NULL) *written = len;
+        if (s->cfg.sync_files) {
+            /* made durable by the caller's group commit, or by the next
+             * state write for internal retries */
+            ++s->appended_gen;
+#ifdef HAVE_SYNC_FILE_RANGE
+            if (s->active->file_size - s->writeback_end >= (int64_t)WRITEBACK_CHUNK) {
+                /* start writeback early so the group fdatasync finds less dirty data */
+                (void)sync_file_range(s->active_fd, s->writeback_end, s->active->file_size - s->writeback_end,
+                                      SYNC_FILE_RANGE_WRITE);
+                s->writeback_end = s->active->file_size;
+            }
+#endif
+        }
     }
     free(record);
     if (r == RS_RET_OK && s->active->record_count == 1 && s->cfg.max_file_size > 0 &&
         s->active->file_size + FOOT_LEN > s->cfg.max_file_size)
         r = seal_active(s);
     if (r == RS_RET_OK && internal) update_retry_overage(s);
+    if (r == RS_RET_OK) compress_sealed_step(s);
     return r;
 }
 
@@ -812,45 +1111,188 @@ static sbool segment_is_undiscovered(const segdisk_store_t *s, uint64_t id) {
     return id != 0 && id <= s->discovery_through_segment;
 }
 
+static void reader_reset(segdisk_store_t *s) {
+    if (s->read_fd >= 0) close(s->read_fd);
+    s->read_fd = -1;
+    s->read_fd_segment = 0;
+    s->rbuf_off = 0;
+    s->rbuf_len = 0;
+    if (s->rbuf_cap > READ_WINDOW_LEN + BLK_RAW_LEN) {
+        /* do not keep an oversized record buffer around */
+        free(s->rbuf);
+        s->rbuf = NULL;
+        s->rbuf_cap = 0;
+    }
+}
+
+static rsRetVal reserve_buffer(unsigned char **buf, size_t *cap, size_t need) {
+    if (need <= *cap) return RS_RET_OK;
+    unsigned char *const nb = realloc(*buf, need);
+    if (nb == NULL) return RS_RET_OUT_OF_MEMORY;
+    *buf = nb;
+    *cap = need;
+    return RS_RET_OK;
+}
+
+/* Decompress the blocks of a compressed segment that cover [off, off + len)
+ * into the window, extended by following blocks up to READ_WINDOW_LEN. The
+ * compressed span is fetched with one pread. A block that fails its CRC or
+ * decompression ends the window; if the requested range is not covered,
+ * *bad_end receives the end of the damaged block and RS_RET_INVALID_VALUE
+ * is returned so the caller can account and skip it.
+ */
+static rsRetVal reader_fill_blocks(
+    segdisk_store_t *s, const segdisk_segment_t *seg, int64_t off, size_t len, int64_t *bad_end) {
+    size_t lo = 0;
+    size_t hi = seg->block_count;
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (seg->blocks[mid].raw_off <= off)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    const segdisk_block_t *const first = &seg->blocks[lo];
+    size_t last = lo;
+    int64_t raw_end = first->raw_off + first->raw_len;
+    while (last + 1 < seg->block_count &&
+           (raw_end < off + (int64_t)len || raw_end - first->raw_off < (int64_t)READ_WINDOW_LEN)) {
+        ++last;
+        raw_end += seg->blocks[last].raw_len;
+    }
+    const size_t comp_span = (size_t)(seg->blocks[last].file_off + seg->blocks[last].comp_len - first->file_off);
+    rsRetVal r = reserve_buffer(&s->zbuf, &s->zbuf_cap, comp_span);
+    if (r == RS_RET_OK) r = reserve_buffer(&s->rbuf, &s->rbuf_cap, (size_t)(raw_end - first->raw_off));
+    if (r != RS_RET_OK) return r;
+    s->rbuf_len = 0;
+    r = read_full_at(s->read_fd, s->zbuf, comp_span, first->file_off);
+    ++s->stats.read_calls;
+    if (r != RS_RET_OK) return r;
+    s->rbuf_off = first->raw_off;
+    for (size_t i = lo; i <= last; ++i) {
+        const segdisk_block_t *const b = &seg->blocks[i];
+        const unsigned char *const comp = s->zbuf + (b->file_off - first->file_off);
+        unsigned char *const raw = s->rbuf + (b->raw_off - first->raw_off);
+        if (segdiskCrc32c(comp, b->comp_len) != b->crc) {
+            r = RS_RET_INVALID_VALUE;
+        } else if (b->flags & BLK_FLAG_STORED) {
+            memcpy(raw, comp, b->raw_len);
+        } else {
+            r = segdiskBlockDecompress(&s->zctx, comp, b->comp_len, raw, b->raw_len);
+            if (r == RS_RET_ZLIB_ERR) r = RS_RET_INVALID_VALUE;
+        }
+        if (r == RS_RET_OUT_OF_MEMORY) return r;
+        if (r != RS_RET_OK) {
+            if (s->rbuf_off + (int64_t)s->rbuf_len >= off + (int64_t)len) break;
+            *bad_end = b->raw_off + b->raw_len;
+            return RS_RET_INVALID_VALUE;
+        }
+        s->rbuf_len += b->raw_len;
+    }
+#ifdef POSIX_FADV_WILLNEED
+    if (last + 1 < seg->block_count)
+        (void)posix_fadvise(s->read_fd, seg->blocks[last + 1].file_off - BLK_HDR_LEN, READ_WINDOW_LEN,
+                            POSIX_FADV_WILLNEED);
+#endif
+    return RS_RET_OK;
+}
+
+/* Return a pointer to [off, off + len) of seg. A miss refills the window with
+ * one pread of up to READ_WINDOW_LEN bytes, bounded by the segment's data end,
+ * and asks the kernel to prefetch the following span. The descriptor stays
+ * valid across the seal rename, and bytes below data_end are never rewritten,
+ * so a window filled from the active segment remains correct. Offsets of a
+ * compressed segment are logical; see reader_fill_blocks().
+ */
+static rsRetVal reader_window(segdisk_store_t *s,
+                              const segdisk_segment_t *seg,
+                              int64_t off,
+                              size_t len,
+                              const unsigned char **out,
+                              int64_t *bad_end) {
+    if (s->read_fd < 0 || s->read_fd_segment != seg->id) {
+        reader_reset(s);
+        s->read_fd = open(seg->path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+        if (s->read_fd < 0) return RS_RET_IO_ERROR;
+        s->read_fd_segment = seg->id;
+#ifdef POSIX_FADV_SEQUENTIAL
+        (void)posix_fadvise(s->read_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+    if (off >= s->rbuf_off && off + (int64_t)len <= s->rbuf_off + (int64_t)s->rbuf_len) {
+        *out = s->rbuf + (off - s->rbuf_off);
+        return RS_RET_OK;
+    }
+    if (off + (int64_t)len > seg->data_end) return RS_RET_EOF;
+    if (seg->compressed) {
+        const rsRetVal r = reader_fill_blocks(s, seg, off, len, bad_end);
+        if (r != RS_RET_OK) return r;
+        *out = s->rbuf + (off - s->rbuf_off);
+        return RS_RET_OK;
+    }
+    size_t want = len > READ_WINDOW_LEN ? len : READ_WINDOW_LEN;
+    if ((int64_t)want > seg->data_end - off) want = (size_t)(seg->data_end - off);
+    rsRetVal r = reserve_buffer(&s->rbuf, &s->rbuf_cap, want);
+    if (r != RS_RET_OK) return r;
+    s->rbuf_len = 0;
+    r = read_full_at(s->read_fd, s->rbuf, want, off);
+    ++s->stats.read_calls;
+    if (r != RS_RET_OK) return r;
+    s->rbuf_off = off;
+    s->rbuf_len = want;
+#ifdef POSIX_FADV_WILLNEED
+    if (off + (int64_t)want < seg->data_end)
+        (void)posix_fadvise(s->read_fd, off + (off_t)want, READ_WINDOW_LEN, POSIX_FADV_WILLNEED);
+#endif
+    *out = s->rbuf;
+    return RS_RET_OK;
+}
+
+/* Find the next framed record at or after *off. On success, payload points
+ * into the read window and stays valid until the next window refill; its
+ * CRC is checked by the caller. */
 static rsRetVal record_at(segdisk_store_t *s,
                           segdisk_segment_t *seg,
                           int64_t *off,
-                          smsg_t **msg,
+                          const unsigned char **payload_out,
+                          uint32_t *payload_len,
+                          uint32_t *payload_crc,
                           uint64_t *sequence,
                           int *skipped,
                           int *discovered,
                           size_t *scan_budget) {
     if (seg->id == s->active_segment && s->active != NULL) seg->data_end = s->active->data_end;
-    const int fd = open(seg->path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
-    if (fd < 0) return RS_RET_IO_ERROR;
     while (*off + (int64_t)REC_HDR_LEN <= seg->data_end) {
-        unsigned char h[REC_HDR_LEN];
-        rsRetVal r = read_full_at(fd, h, sizeof(h), *off);
-        if (r != RS_RET_OK) {
-            close(fd);
-            return r;
+        const unsigned char *h;
+        int64_t bad_end = 0;
+        rsRetVal r = reader_window(s, seg, *off, REC_HDR_LEN, &h, &bad_end);
+        if (r == RS_RET_INVALID_VALUE && bad_end > *off) {
+            /* damaged compressed block: its records cannot be restored */
+            ++s->stats.corruption_events;
+            s->stats.corruption_bytes += (uint64_t)(bad_end - *off);
+            *off = bad_end;
+            continue;
         }
+        if (r != RS_RET_OK) return r;
         if (memcmp(h, REC_MAGIC, 8) || get16(h + 8) != STORE_VERSION || get32(h + 24) != segdiskCrc32c(h, 24) ||
             get32(h + 12) > MAX_RECORD_SIZE || *off + REC_HDR_LEN + get32(h + 12) > seg->data_end) {
             ++s->stats.corruption_events;
             ++s->stats.corruption_bytes;
             ++s->stats.recovery_bytes;
             ++*off;
-            if (*scan_budget == 0) {
-                close(fd);
-                return RS_RET_RETRY;
-            }
+            if (*scan_budget == 0) return RS_RET_RETRY;
             --*scan_budget;
             continue;
         }
         const uint32_t n = get32(h + 12);
-        unsigned char *payload = malloc(n == 0 ? 1 : n);
-        if (payload == NULL) {
-            close(fd);
-            return RS_RET_OUT_OF_MEMORY;
-        }
-        r = read_full_at(fd, payload, n, *off + REC_HDR_LEN);
+        const uint32_t crc = get32(h + 28);
         *sequence = get64(h + 16);
+        /* header and payload are normally in the same window; this only
+         * refills when the record straddles the window end */
+        const unsigned char *payload;
+        r = reader_window(s, seg, *off, REC_HDR_LEN + n, &payload, &bad_end);
+        if (r == RS_RET_OUT_OF_MEMORY) return r;
+        if (r == RS_RET_OK) payload += REC_HDR_LEN;
         const sbool newly_discovered = segment_is_undiscovered(s, seg->id);
         if (newly_discovered) {
             ++*discovered;
@@ -859,16 +1301,15 @@ static rsRetVal record_at(segdisk_store_t *s,
             s->stats.recovery_bytes += REC_HDR_LEN + n;
         }
         *off += REC_HDR_LEN + n;
-        if (r != RS_RET_OK || segdiskCrc32c(payload, n) != get32(h + 28) ||
-            segdiskCodecDecode(payload, n, msg) != RS_RET_OK) {
-            free(payload);
+        if (r != RS_RET_OK) {
             ++s->stats.corruption_events;
             ++s->stats.corruption_records;
             ++*skipped;
             continue;
         }
-        free(payload);
-        close(fd);
+        *payload_out = payload;
+        *payload_len = n;
+        *payload_crc = crc;
         return RS_RET_OK;
     }
     if (*off < seg->data_end && seg->id != s->active_segment) {
@@ -877,7 +1318,6 @@ static rsRetVal record_at(segdisk_store_t *s,
         s->stats.recovery_bytes += tail;
         *off = seg->data_end;
     }
-    close(fd);
     return RS_RET_NO_DATA;
 }
 
@@ -891,7 +1331,8 @@ static void append_pending(segdisk_store_t *s, segdisk_batch_ctx_t *ctx) {
 }
 
 static rsRetVal unlink_segment_id(segdisk_store_t *s, uint64_t id, sbool account) {
-    const char *const suffixes[] = {"seg", "recover", "open"};
+    /* a ztmp file is a compression leftover from a crash and never accounted */
+    const char *const suffixes[] = {"seg", "recover", "open", "ztmp"};
     rsRetVal r = RS_RET_OK;
     for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
         char *path = segment_path(s, id, suffixes[i]);
@@ -902,7 +1343,7 @@ static rsRetVal unlink_segment_id(segdisk_store_t *s, uint64_t id, sbool account
                 r = RS_RET_IO_ERROR;
             else {
                 test_fault(s, SEGDISK_TEST_FAULT_SEGMENT_UNLINKED);
-                if (account) {
+                if (account && strcmp(suffixes[i], "ztmp")) {
                     s->stats.bytes -= st.st_size;
                     if (s->stats.segments > 0) --s->stats.segments;
                 }
@@ -1216,6 +1657,8 @@ rsRetVal segdiskStoreOpen(segdisk_store_t **out, const segdisk_store_config_t *c
     if (s == NULL) return RS_RET_OUT_OF_MEMORY;
     rsRetVal fail_ret = RS_RET_IO_ERROR;
     s->dir_fd = s->state_fd = s->active_fd = -1;
+    s->read_fd = -1;
+    s->zjob.src_fd = s->zjob.dst_fd = -1;
     s->cfg = *cfg;
     s->committed_offset = SEG_HDR_LEN;
     s->persisted_writer_end = SEG_HDR_LEN;
@@ -1339,6 +1782,11 @@ fail:
     if (s->dir_fd >= 0) close(s->dir_fd);
     free_segment(&s->active);
     free_segment(&s->read_segment);
+    zjob_abort(s);
+    reader_reset(s);
+    free(s->rbuf);
+    free(s->zbuf);
+    segdiskBlockCtxFree(&s->zctx);
     free(s->dir);
     free(s->queue_name);
     free(s);
@@ -1349,6 +1797,39 @@ rsRetVal segdiskStoreAppend(segdisk_store_t *s, smsg_t *msg, sbool internal, int
     return append_record(s, msg, internal, written);
 }
 
+uint64_t segdiskStoreSyncTicket(const segdisk_store_t *s) {
+    return s->appended_gen;
+}
+
+sbool segdiskStoreSynced(const segdisk_store_t *s, uint64_t ticket) {
+    return s->durable_gen >= ticket;
+}
+
+rsRetVal segdiskStoreSyncBegin(segdisk_store_t *s, segdisk_sync_group_t *group) {
+    group->target = s->appended_gen;
+    group->fd = -1;
+    if (s->durable_gen == s->appended_gen) return RS_RET_OK;
+    if (s->active_fd < 0) return RS_RET_IO_ERROR;
+    /* a private descriptor stays valid if the segment is sealed and its
+     * descriptor closed while the lock is dropped */
+    group->fd = fcntl(s->active_fd, F_DUPFD_CLOEXEC, 0);
+    return group->fd < 0 ? RS_RET_IO_ERROR : RS_RET_OK;
+}
+
+rsRetVal segdiskStoreSyncWrite(segdisk_sync_group_t *group) {
+    if (group->fd < 0) return RS_RET_OK;
+    return sync_file_data(group->fd) == 0 ? RS_RET_OK : RS_RET_IO_ERROR;
+}
+
+void segdiskStoreSyncEnd(segdisk_store_t *s, segdisk_sync_group_t *group, rsRetVal r) {
+    if (group->fd >= 0) {
+        close(group->fd);
+        group->fd = -1;
+        if (r == RS_RET_OK) ++s->stats.group_commits;
+    }
+    if (r == RS_RET_OK) mark_durable(s, group->target);
+}
+
 sbool segdiskStoreMayHaveData(const segdisk_store_t *s) {
     if (s == NULL) return 0;
     if (s->delete_first != 0) return 1;
@@ -1380,6 +1861,10 @@ rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *s, batch_t *batch, int max, i
     }
     segdisk_batch_ctx_t *ctx = calloc(1, sizeof(*ctx));
     if (ctx == NULL) return RS_RET_OUT_OF_MEMORY;
+    if (max > 0 && (ctx->raw_records = malloc((size_t)max * sizeof(*ctx->raw_records))) == NULL) {
+        free(ctx);
+        return RS_RET_OUT_OF_MEMORY;
+    }
     ctx->sequence = s->next_batch_sequence++;
     ctx->refs = 1;
     ctx->pending = 1;
@@ -1393,6 +1878,7 @@ rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *s, batch_t *batch, int max, i
         if (s->read_segment == NULL) {
             if (s->read_segment_id == 0) s->read_segment_id = s->first_live_segment;
             while (s->read_segment_id != 0 && s->read_segment_id <= s->last_data_segment) {
+                if (s->zjob.segment == s->read_segment_id) zjob_abort(s);
                 rsRetVal r = load_segment(s, s->read_segment_id, &s->read_segment);
                 if (r == RS_RET_FILE_NOT_FOUND) {
                     ++s->stats.corruption_events;
@@ -1406,7 +1892,7 @@ rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *s, batch_t *batch, int max, i
                     continue;
                 }
                 if (r != RS_RET_OK) {
-                    free(ctx);
+                    release_batch_ctx(ctx);
                     return r;
                 }
                 if (s->committed_segment == s->read_segment_id && s->committed_offset >= SEG_HDR_LEN &&
@@ -1418,10 +1904,13 @@ rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *s, batch_t *batch, int max, i
             }
             if (s->read_segment == NULL) break;
         }
-        smsg_t *msg = NULL;
+        const unsigned char *payload = NULL;
+        uint32_t len = 0;
+        uint32_t crc = 0;
         uint64_t sequence = 0;
         const int skipped_before = *skipped;
-        rsRetVal r = record_at(s, s->read_segment, &s->read_offset, &msg, &sequence, skipped, discovered, &scan_budget);
+        rsRetVal r = record_at(s, s->read_segment, &s->read_offset, &payload, &len, &crc, &sequence, skipped,
+                               discovered, &scan_budget);
         consumed += *skipped - skipped_before;
         if (r == RS_RET_RETRY) {
             ++s->stats.recovery_pending;
@@ -1431,29 +1920,37 @@ rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *s, batch_t *batch, int max, i
         if (r == RS_RET_NO_DATA) {
             if (s->read_segment->id == s->active_segment) break;
             ++s->read_segment_id;
+            reader_reset(s);
             s->read_offset = SEG_HDR_LEN;
             free_segment(&s->read_segment);
             continue;
         }
+        if (r == RS_RET_OK) r = reserve_buffer(&ctx->raw, &ctx->raw_cap, ctx->raw_len + len);
         if (r != RS_RET_OK) {
-            free(ctx);
+            release_batch_ctx(ctx);
             return r;
         }
+        memcpy(ctx->raw + ctx->raw_len, payload, len);
+        ctx->raw_records[n].off = ctx->raw_len;
+        ctx->raw_records[n].len = len;
+        ctx->raw_records[n].crc = crc;
+        ctx->raw_len += len;
         ++consumed;
         ctx->end_segment = s->read_segment->id;
         ctx->end_offset = s->read_offset;
         ctx->end_record_sequence = sequence;
-        batch->pElem[n].pMsg = msg;
+        batch->pElem[n].pMsg = NULL;
         batch->eltState[n] = BATCH_STATE_RDY;
         ++n;
     }
     if (consumed == 0) {
-        free(ctx);
+        release_batch_ctx(ctx);
         return recovery_pending ? RS_RET_RETRY : RS_RET_NO_DATA;
     }
     ctx->records = consumed;
     append_pending(s, ctx);
     if (n == 0) {
+        free_batch_raw(ctx);
         ctx->complete = 1;
         const rsRetVal r = advance_completed(s);
         return r == RS_RET_OK ? RS_RET_NO_DATA : r;
@@ -1465,6 +1962,46 @@ rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *s, batch_t *batch, int max, i
     return RS_RET_OK;
 }
 
+void segdiskStoreDecodeBatch(batch_t *batch) {
+    segdisk_batch_ctx_t *const ctx = batch->storeData;
+    for (int i = 0; i < batch->nElem; ++i) {
+        const segdisk_raw_record_t *const rec = &ctx->raw_records[i];
+        const unsigned char *const payload = ctx->raw + rec->off;
+        batch->pElem[i].pMsg = NULL;
+        if (segdiskCrc32c(payload, rec->len) != rec->crc ||
+            segdiskCodecDecode(payload, rec->len, &batch->pElem[i].pMsg) != RS_RET_OK) {
+            batch->pElem[i].pMsg = NULL;
+            ++ctx->decode_failures;
+        }
+    }
+}
+
+rsRetVal segdiskStoreFinishBatch(segdisk_store_t *s, batch_t *batch, int *skipped) {
+    segdisk_batch_ctx_t *const ctx = batch->storeData;
+    free_batch_raw(ctx);
+    if (ctx->decode_failures == 0) return RS_RET_OK;
+    s->stats.corruption_events += ctx->decode_failures;
+    s->stats.corruption_records += ctx->decode_failures;
+    *skipped += ctx->decode_failures;
+    ctx->decode_failures = 0;
+    int n = 0;
+    for (int i = 0; i < batch->nElem; ++i) {
+        if (batch->pElem[i].pMsg == NULL) continue;
+        batch->pElem[n].pMsg = batch->pElem[i].pMsg;
+        batch->eltState[n] = batch->eltState[i];
+        ++n;
+    }
+    batch->nElem = n;
+    if (n != 0) return RS_RET_OK;
+    /* every record was corrupt: retire the batch like an all-corrupt dequeue */
+    batch->storeData = NULL;
+    batch->nElemDeq = 0;
+    ctx->complete = 1;
+    release_batch_ctx(ctx);
+    const rsRetVal r = advance_completed(s);
+    return r == RS_RET_OK ? RS_RET_NO_DATA : r;
+}
+
 rsRetVal segdiskStoreCompleteBatch(segdisk_store_t *s, batch_t *batch, int *committed, int *retried) {
     segdisk_batch_ctx_t *ctx = batch->storeData;
     if (ctx == NULL) return RS_RET_INTERNAL_ERROR;
@@ -1533,6 +2070,8 @@ static void reset_after_dematerialize(segdisk_store_t *s) {
     s->known_queue_size = 0;
     s->updates_since_checkpoint = 0;
     s->dematerializing = 0;
+    s->durable_gen = s->appended_gen;
+    s->writeback_end = 0;
     s->stats.bytes = 0;
     s->stats.segments = 0;
     s->stats.retry_overage_bytes = 0;
@@ -1616,6 +2155,7 @@ rsRetVal segdiskStoreDematerialize(segdisk_store_t *s) {
         if (close(s->active_fd) != 0 && r == RS_RET_OK) r = RS_RET_IO_ERROR;
         s->active_fd = -1;
     }
+    zjob_abort(s);
     if (r == RS_RET_OK) r = remove_remaining_segments(s);
     if (r == RS_RET_OK) r = sync_dir(s);
     if (r == RS_RET_OK) test_fault(s, SEGDISK_TEST_FAULT_IDLE_SEGMENTS_UNLINKED);
@@ -1624,6 +2164,15 @@ rsRetVal segdiskStoreDematerialize(segdisk_store_t *s) {
     if (r == RS_RET_OK) r = sync_dir(s);
     free_segment(&s->active);
     free_segment(&s->read_segment);
+    reader_reset(s);
+    free(s->rbuf);
+    free(s->zbuf);
+    segdiskBlockCtxFree(&s->zctx);
+    s->rbuf = NULL;
+    s->rbuf_cap = 0;
+    s->zbuf = NULL;
+    s->zbuf_cap = 0;
+    s->zjob_next = 0;
     if (r == RS_RET_OK && rmdir(s->dir) != 0 && errno != ENOENT) r = RS_RET_IO_ERROR;
     if (r == RS_RET_OK) test_fault(s, SEGDISK_TEST_FAULT_IDLE_DIRECTORY_REMOVED);
     if (r == RS_RET_OK) {
@@ -1701,6 +2250,11 @@ rsRetVal segdiskStoreClose(segdisk_store_t **ps, sbool empty) {
     }
     free_segment(&s->active);
     free_segment(&s->read_segment);
+    zjob_abort(s);
+    reader_reset(s);
+    free(s->rbuf);
+    free(s->zbuf);
+    segdiskBlockCtxFree(&s->zctx);
     while (s->pending_head != NULL) {
         segdisk_batch_ctx_t *n = s->pending_head->next;
         s->pending_head->pending = 0;
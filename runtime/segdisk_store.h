@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include "rsyslog.h"
 #include "batch.h"
+#include "segdisk_block.h"
 
 /** Opaque segmented queue store. All access is serialized by its queue lock. */
 typedef struct segdisk_store_s segdisk_store_t;
@@ -13,7 +14,8 @@ typedef struct segdisk_store_s segdisk_store_t;
 /** Configuration captured when a segmented store object is constructed.
  *
  * lazy_create keeps a DA child unmaterialized until its first append. It does
- * not change the eager lifecycle of a pure segmentedDisk queue.
+ * not change the eager lifecycle of a pure segmentedDisk queue. compression
+ * selects the codec sealed segments ahead of the reader are rewritten with.
  */
 typedef struct segdisk_store_config_s {
     const char *work_dir;
@@ -24,6 +26,7 @@ typedef struct segdisk_store_config_s {
     unsigned int checkpoint_interval;
     sbool sync_files;
     sbool lazy_create;
+    segdisk_compression_t compression;
 } segdisk_store_config_t;
 
 /** Monotonic operation counters and current physical store gauges.
@@ -31,6 +34,11 @@ typedef struct segdisk_store_config_s {
  * bytes and segments describe the current topology. The remaining fields are
  * cumulative counters, including lazy materialization and idle-cleanup
  * outcomes; startup_payload_bytes_read is expected to remain zero.
+ * read_calls counts dequeue read-window refills, each one positional read.
+ * compressed_segments and compression_saved_bytes count sealed segments that
+ * were rewritten compressed and the file bytes this saved. group_commits
+ * counts record-data syncs with sync_files and group_commit_records the
+ * appends they made durable.
  */
 typedef struct segdisk_store_stats_s {
     int64_t bytes;
@@ -53,8 +61,19 @@ typedef struct segdisk_store_stats_s {
     uint64_t materializations;
     uint64_t dematerializations;
     uint64_t idle_cleanup_failures;
+    uint64_t read_calls;
+    uint64_t compressed_segments;
+    uint64_t compression_saved_bytes;
+    uint64_t group_commits;
+    uint64_t group_commit_records;
 } segdisk_store_stats_t;
 
+/** One group commit in progress; see segdiskStoreSyncBegin(). */
+typedef struct segdisk_sync_group_s {
+    uint64_t target;
+    int fd;
+} segdisk_sync_group_t;
+
 #ifdef ENABLE_IMDIAG
 typedef enum segdisk_test_fault_point_e {
     SEGDISK_TEST_FAULT_NONE = 0,
@@ -88,10 +107,30 @@ typedef enum segdisk_test_fault_point_e {
  * Close destroys the object; Dematerialize resets the same object for a later
  * lazy append. GetStats and test-fault operations are safe before lazy
  * materialization.
+ *
+ * With sync_files, Append does not sync. A producer takes a ticket after its
+ * appends and waits until Synced reports it durable. One producer at a time
+ * runs SyncBegin, then SyncWrite with the queue mutex released, then SyncEnd;
+ * SyncWrite touches nothing but the group and must be called without the
+ * mutex. State writes sync pending appends first, so internal retries and
+ * checkpoints never get ahead of record data.
+ *
+ * DequeueBatch claims records and copies their raw payloads into the batch;
+ * the messages are NULL until DecodeBatch, which touches only the batch and
+ * is meant to run without the mutex, so workers decode in parallel.
+ * FinishBatch (mutex held) then drops records that failed their checksum or
+ * decoding and returns RS_RET_NO_DATA when none remain.
  */
 rsRetVal segdiskStoreOpen(segdisk_store_t **store, const segdisk_store_config_t *config, int *queue_size);
 rsRetVal segdiskStoreAppend(segdisk_store_t *store, smsg_t *msg, sbool internal_retry, int64_t *written);
+uint64_t segdiskStoreSyncTicket(const segdisk_store_t *store);
+sbool segdiskStoreSynced(const segdisk_store_t *store, uint64_t ticket);
+rsRetVal segdiskStoreSyncBegin(segdisk_store_t *store, segdisk_sync_group_t *group);
+rsRetVal segdiskStoreSyncWrite(segdisk_sync_group_t *group);
+void segdiskStoreSyncEnd(segdisk_store_t *store, segdisk_sync_group_t *group, rsRetVal result);
 rsRetVal segdiskStoreDequeueBatch(segdisk_store_t *store, batch_t *batch, int max, int *skipped, int *discovered);
+void segdiskStoreDecodeBatch(batch_t *batch);
+rsRetVal segdiskStoreFinishBatch(segdisk_store_t *store, batch_t *batch, int *skipped);
 rsRetVal segdiskStoreCompleteBatch(segdisk_store_t *store, batch_t *batch, int *committed, int *retried);
 rsRetVal segdiskStoreCheckpoint(segdisk_store_t *store, sbool force_sync);
 rsRetVal segdiskStoreDematerialize(segdisk_store_t *store);
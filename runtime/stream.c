@@ -818,6 +818,47 @@ static rsRetVal strmUnreadChar(strm_t *pThis, uchar c) {
     return RS_RET_OK;
 }
 
+
+/* read exactly lenBuf octets into pBuf. This is equivalent to calling
+ * strmReadChar() lenBuf times, but copies whole spans out of the I/O
+ * buffer. Like strmReadChar(), the read may cross into the next file of
+ * a circular stream. RS_RET_EOF is returned if the stream ends early; the
+ * octets read up to that point are consumed.
+ */
+static rsRetVal strmReadBlock(strm_t *pThis, uchar *pBuf, size_t lenBuf) {
+    int padBytes;
+    size_t lenCopy;
+    DEFiRet;
+
+    assert(pThis != NULL);
+    assert(pBuf != NULL || lenBuf == 0);
+
+    if (lenBuf > 0 && pThis->iUngetC != -1) {
+        *pBuf++ = pThis->iUngetC;
+        ++pThis->iCurrOffs;
+        pThis->iUngetC = -1;
+        --lenBuf;
+    }
+
+    while (lenBuf > 0) {
+        if (pThis->iBufPtr >= pThis->iBufPtrMax) {
+            padBytes = 0;
+            CHKiRet(strmReadBuf(pThis, &padBytes));
+            pThis->iCurrOffs += padBytes;
+        }
+        lenCopy = pThis->iBufPtrMax - pThis->iBufPtr;
+        if (lenCopy > lenBuf) lenCopy = lenBuf;
+        memcpy(pBuf, pThis->pIOBuf + pThis->iBufPtr, lenCopy);
+        pThis->iBufPtr += lenCopy;
+        pThis->iCurrOffs += lenCopy;
+        pBuf += lenCopy;
+        lenBuf -= lenCopy;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
 /* read a 'paragraph' from a strm file.
  * A paragraph may be terminated by a LF, by a LFLF, or by LF<not whitespace> depending on the option set.
  * The termination LF characters are read, but are
@@ -2393,6 +2434,7 @@ BEGINobjQueryInterface(strm)
     pIf->Destruct = strmDestruct;
     pIf->ReadChar = strmReadChar;
     pIf->UnreadChar = strmUnreadChar;
+    pIf->ReadBlock = strmReadBlock;
     pIf->ReadLine = strmReadLine;
     pIf->SeekCurrOffs = strmSeekCurrOffs;
     pIf->Write = strmWrite;
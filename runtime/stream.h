@@ -231,8 +231,10 @@ BEGINinterface(strm) /* name must also be changed in ENDinterface macro! */
     /* v9 added  2013-04-04 */
     INTERFACEpropSetMeth(strm, cryprov, cryprov_if_t *);
     INTERFACEpropSetMeth(strm, cryprovData, void *);
+    /* v18 added 2026-10-19 */
+    rsRetVal (*ReadBlock)(strm_t *pThis, uchar *pBuf, size_t lenBuf);
 ENDinterface(strm)
-#define strmCURR_IF_VERSION 17 /* increment whenever you change the interface structure! */
+#define strmCURR_IF_VERSION 18 /* increment whenever you change the interface structure! */
     /* V10, 2013-09-10: added new parameter bEscapeLF, changed mode to uint8_t (rgerhards) */
     /* V11, 2015-12-03: added new parameter bReopenOnTruncate */
     /* V12, 2015-12-11: added new parameter trimLineOverBytes, changed mode to uint32_t */
@@ -241,6 +243,7 @@ ENDinterface(strm)
     /* V15, ?? - description missing */
     /* V16, 2026-01-28: added new parameter bSizeLimitCmdPassFileName (rgerhards) */
     /* V17, 2026-06-23: added bNoFollowFinal stream property setter */
+    /* V18, 2026-10-19: added ReadBlock() for length-prefixed binary records */
 
 #define strmGetCurrFileNum(pStrm) ((pStrm)->iCurrFNum)
 
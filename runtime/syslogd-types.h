@@ -48,7 +48,8 @@ typedef enum _syslogFeature {
     sFEATURERepeatedMsgReduction = 1, /* for output modules */
     sFEATURENonCancelInputTermination = 2, /* for input modules */
     sFEATUREAutomaticSanitazion = 3, /* for parser modules */
-    sFEATUREAutomaticPRIParsing = 4 /* for parser modules */
+    sFEATUREAutomaticPRIParsing = 4, /* for parser modules */
+    sFEATUREPrefixRejection = 5 /* for parser modules: rejects by the 2 bytes after PRI only */
 } syslogFeature;
 
 /* we define our own facility and severities */
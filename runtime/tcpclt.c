@@ -271,6 +271,63 @@ finalize_it:
 }
 
 
+/* Variant of TCPSendBldFrame() for callers that registered a send-parts
+ * callback. Instead of allocating and copying a complete frame, only the
+ * framing octets are computed: the octet-count header is written to hdr
+ * (which must hold at least 16 bytes) and *pLenTrl tells whether the
+ * framing delimiter must follow the message. The message itself is left
+ * untouched so the caller can gather header, message and trailer with a
+ * single write.
+ */
+static rsRetVal TCPSendBldFrameParts(
+    tcpclt_t *pThis, const char *msg, const size_t len, char *hdr, size_t *pLenHdr, size_t *pLenTrl) {
+    DEFiRet;
+    const int bIsCompressed = *msg == 'z'; /* see TCPSendBldFrame() for why this matters */
+
+    *pLenHdr = 0;
+    *pLenTrl = 0;
+    if (!bIsCompressed && pThis->tcp_framing == TCP_FRAMING_OCTET_STUFFING) {
+        if (*(msg + len - 1) != (char)pThis->tcp_framingDelimiter) *pLenTrl = 1;
+    } else {
+        if (len > (size_t)INT_MAX) {
+            LogError(0, RS_RET_OUT_OF_MEMORY,
+                     "Error: TCP frame too large for octet-counted framing header. Message is lost.");
+            ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+        }
+        const int iLenHdr = snprintf(hdr, 16, "%d ", (int)len);
+        if (iLenHdr < 0) {
+            ABORT_FINALIZE(RS_RET_ERR);
+        }
+        *pLenHdr = (size_t)iLenHdr;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+
+/* keep a copy of the frame just sent so that it can be resent after a
+ * reconnect. For frames built by TCPSendBldFrame(), hdr and trailer are
+ * empty. Failing to allocate is silently ignored, see Send().
+ */
+static void storePrevFrame(
+    tcpclt_t *pThis, const char *hdr, const size_t lenHdr, const char *msg, const size_t len, const size_t lenTrl) {
+    const size_t lenFrame = lenHdr + len + lenTrl;
+
+    if (pThis->prevMsg != NULL) free(pThis->prevMsg);
+    /* if we can not alloc a new buffer, we silently ignore it. The worst that
+     * happens is that we lose our message recovery buffer - anything else would
+     * be worse, so don't try anything ;) -- rgerhards, 2008-03-12
+     */
+    if ((pThis->prevMsg = malloc(lenFrame)) != NULL) {
+        memcpy(pThis->prevMsg, hdr, lenHdr);
+        memcpy(pThis->prevMsg + lenHdr, msg, len);
+        if (lenTrl != 0) pThis->prevMsg[lenHdr + len] = (char)pThis->tcp_framingDelimiter;
+        pThis->lenPrevMsg = lenFrame;
+    }
+}
+
+
 /* Sends a TCP message. It is first checked if the
  * session is open and, if not, it is opened. Then the send
  * is tried. If it fails, one silent re-try is made. If the send
@@ -302,17 +359,30 @@ static int Send(tcpclt_t *pThis, void *pData, char *msg, size_t len) {
     int bDone = 0;
     int retry = 0;
     int bMsgMustBeFreed = 0; /* must msg be freed at end of function? 0 - no, 1 - yes */
+    char frameHdr[16];
+    size_t lenHdr = 0;
+    size_t lenTrl = 0;
+    const int bSendParts = pThis->sendPartsFunc != NULL;
 
     ISOBJ_TYPE_assert(pThis, tcpclt);
     assert(pData != NULL);
     assert(msg != NULL);
     assert(len > 0);
 
-    CHKiRet(TCPSendBldFrame(pThis, &msg, &len, &bMsgMustBeFreed));
+    if (bSendParts) {
+        CHKiRet(TCPSendBldFrameParts(pThis, msg, len, frameHdr, &lenHdr, &lenTrl));
+    } else {
+        CHKiRet(TCPSendBldFrame(pThis, &msg, &len, &bMsgMustBeFreed));
+    }
 
     while (!bDone) { /* loop is broken when send succeeds or error occurs */
         CHKiRet(pThis->initFunc(pData));
-        iRet = pThis->sendFunc(pData, msg, len);
+        if (bSendParts) {
+            iRet = pThis->sendPartsFunc(pData, frameHdr, lenHdr, msg, len, (const char *)&pThis->tcp_framingDelimiter,
+                                        lenTrl);
+        } else {
+            iRet = pThis->sendFunc(pData, msg, len);
+        }
 
         if (iRet == RS_RET_RETRY) {
             bDone = 1;
@@ -327,15 +397,7 @@ static int Send(tcpclt_t *pThis, void *pData, char *msg, size_t len) {
              * However, if not requested, we do NOT need to do all the stuff needed for it.
              */
             if (pThis->bResendLastOnRecon == 1) {
-                if (pThis->prevMsg != NULL) free(pThis->prevMsg);
-                /* if we can not alloc a new buffer, we silently ignore it. The worst that
-                 * happens is that we lose our message recovery buffer - anything else would
-                 * be worse, so don't try anything ;) -- rgerhards, 2008-03-12
-                 */
-                if ((pThis->prevMsg = malloc(len)) != NULL) {
-                    memcpy(pThis->prevMsg, msg, len);
-                    pThis->lenPrevMsg = len;
-                }
+                storePrevFrame(pThis, frameHdr, lenHdr, msg, len, lenTrl);
             }
 
             /* we are done with this record */
@@ -385,6 +447,17 @@ static rsRetVal SetSendFrame(tcpclt_t *pThis, rsRetVal (*pCB)(void *, char *, si
     pThis->sendFunc = pCB;
     RETiRet;
 }
+/* register a callback that receives each frame as header, message and
+ * trailer. If set, it is used instead of the SetSendFrame() callback for
+ * regular sends; the latter is still needed to resend the previous
+ * frame after a reconnect.
+ */
+static rsRetVal SetSendFrameParts(tcpclt_t *pThis,
+                                  rsRetVal (*pCB)(void *, const char *, size_t, char *, size_t, const char *, size_t)) {
+    DEFiRet;
+    pThis->sendPartsFunc = pCB;
+    RETiRet;
+}
 static rsRetVal SetFraming(tcpclt_t *pThis, TCPFRAMINGMODE framing) {
     DEFiRet;
     pThis->tcp_framing = framing;
@@ -450,6 +523,7 @@ BEGINobjQueryInterface(tcpclt)
     pIf->SetSendPrepRetry = SetSendPrepRetry;
     pIf->SetFraming = SetFraming;
     pIf->SetFramingDelimiter = SetFramingDelimiter;
+    pIf->SetSendFrameParts = SetSendFrameParts;
 
 finalize_it:
 ENDobjQueryInterface(tcpclt)
@@ -41,6 +41,10 @@ typedef struct tcpclt_s {
         rsRetVal (*initFunc)(void *);
         rsRetVal (*sendFunc)(void *, char *, size_t);
         rsRetVal (*prepRetryFunc)(void *);
+        /* optional: receives header, message and trailer separately so the caller
+         * can gather them without an intermediate frame copy (see SetSendFrameParts)
+         */
+        rsRetVal (*sendPartsFunc)(void *, const char *, size_t, char *, size_t, const char *, size_t);
 } tcpclt_t;
 
 
@@ -59,8 +63,11 @@ BEGINinterface(tcpclt) /* name must also be changed in ENDinterface macro! */
     rsRetVal (*SetFraming)(tcpclt_t *, TCPFRAMINGMODE framing);
     /* v4, 2017-06-10*/
     rsRetVal (*SetFramingDelimiter)(tcpclt_t *, uchar tcp_framingDelimiter);
+    /* v6, 2026-10-19 */
+    rsRetVal (*SetSendFrameParts)(tcpclt_t *,
+                                  rsRetVal (*)(void *, const char *, size_t, char *, size_t, const char *, size_t));
 ENDinterface(tcpclt)
-#define tcpcltCURR_IF_VERSION 5 /* increment whenever you change the interface structure! */
+#define tcpcltCURR_IF_VERSION 6 /* increment whenever you change the interface structure! */
 
 
 /* prototypes */
@@ -55,6 +55,7 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <sys/socket.h>
+#include <time.h>
 #if HAVE_FCNTL_H
     #include <fcntl.h>
 #endif
@@ -102,7 +103,7 @@ DEFobjCurrIf(regexp);
 #define NSPOLL_MAX_EVENTS_PER_WAIT 128
 
 
-static void enqueueWork(tcpsrv_io_descr_t *const pioDescr);
+static void enqueueWork(workQueue_t *const queue, tcpsrv_io_descr_t *const pioDescr);
 
 /* We check which event notification mechanism we have and use the best available one.
  * We switch back from library-specific drivers, because event notification always works
@@ -979,6 +980,52 @@ finalize_it:
 #endif
 
 
+/* monotonic time in microseconds, used for handshake duration accounting */
+static uint64_t hsNowUs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000 + (uint64_t)t.tv_nsec / 1000;
+}
+
+
+/**
+ * @brief Account for the end of a session handshake and resume parked listeners.
+ *
+ * Called by the handshake pool once a session left the handshake phase, either
+ * because the handshake completed (@p bSuccess != 0) or because the session is
+ * about to be closed. If `handshake.maxPending` had paused accepting, listeners
+ * that are parked are handed back to the handshake queue as soon as the number
+ * of pending handshakes is below the limit again.
+ *
+ * @pre `pioDescr->bInHandshake` is set and the handshake pool is running.
+ */
+static void ATTR_NONNULL() hsFinished(tcpsrv_io_descr_t *const pioDescr, const int bSuccess) {
+    tcpsrv_t *const pThis = pioDescr->pSrv;
+
+    assert(pioDescr->bInHandshake);
+    pioDescr->bInHandshake = 0;
+    if (bSuccess) {
+        STATSCOUNTER_INC(pThis->ctrHsDone, pThis->mutCtrHsDone);
+        STATSCOUNTER_ADD(pThis->ctrHsTime, pThis->mutCtrHsTime, hsNowUs() - pioDescr->tHandshakeStart);
+    } else {
+        STATSCOUNTER_INC(pThis->ctrHsFailed, pThis->mutCtrHsFailed);
+    }
+
+    pthread_mutex_lock(&pThis->mutHs);
+    --pThis->hsPending;
+    if (pThis->hsMaxPending == 0 || (unsigned)pThis->hsPending < pThis->hsMaxPending) {
+        for (int i = 0; i < pThis->iLstnCurr; ++i) {
+            tcpsrv_io_descr_t *const pLstn = pThis->ppioDescrPtr[i];
+            if (pLstn != NULL && pLstn->bParked) {
+                pLstn->bParked = 0;
+                enqueueWork(&pThis->hsQueue, pLstn);
+            }
+        }
+    }
+    pthread_mutex_unlock(&pThis->mutHs);
+}
+
+
 /**
  * @brief Receive and dispatch data for a TCP session with starvation control and EPOLL re-arm.
  *
@@ -987,6 +1034,9 @@ finalize_it:
  *  - Starvation: after `starvationMaxReads`, enqueue `pioDescr` (handoff) and return (no re-arm).
  *  - Would-block (RS_RET_RETRY): re-arm EPOLLONESHOT and return.
  *  - Close/error: exit the loop and close the session after unlocking.
+ *  - Handshake pool: a session with `bInHandshake` set is served by the handshake
+ *    pool. Once the handshake is done it is handed off to the data workers (if data
+ *    was already read) or re-armed so that the next event goes to a data worker.
  *
  * Locking:
  *  - If workQueue.numWrkr > 1, this function locks `pSess->mut` on entry and always unlocks
@@ -1024,7 +1074,7 @@ static rsRetVal ATTR_NONNULL(1)
     }
 
     /* explicit state machine */
-    enum RecvState { RS_READING, RS_STARVATION, RS_DONE_REARM, RS_DONECLOSE, RS_DONE_HANDOFF };
+    enum RecvState { RS_READING, RS_STARVATION, RS_HANDSHAKE_DONE, RS_DONE_REARM, RS_DONECLOSE, RS_DONE_HANDOFF };
     enum RecvState state = RS_READING;
 
 #if defined(ENABLE_IMTCP_EPOLL)
@@ -1045,7 +1095,7 @@ static rsRetVal ATTR_NONNULL(1)
     assert(pioDescr->ioDirection == NSDSEL_RD || pioDescr->ioDirection == NSDSEL_WR);
 
     /* Loop while in non-terminal states (positive check for readability). */
-    while (state == RS_READING || state == RS_STARVATION) {
+    while (state == RS_READING || state == RS_STARVATION || state == RS_HANDSHAKE_DONE) {
         switch (state) {
             case RS_READING:
                 /* maxReads==0 is intentional and documented: it disables starvation protection. */
@@ -1069,6 +1119,12 @@ static rsRetVal ATTR_NONNULL(1)
                                 STATSCOUNTER_ADD(wrkrData->ctrEmptyRead, wrkrData->mutCtrEmptyRead, 1);
                             }
 #endif
+                            if (pioDescr->bInHandshake) {
+                                int bDone = 0;
+                                if (netstrm.IsHandshakeDone(pSess->pStrm, &bDone) == RS_RET_OK && bDone) {
+                                    hsFinished(pioDescr, 1); /* next event goes to a data worker */
+                                }
+                            }
                             state = RS_DONE_REARM; /* would block → exit and re-arm */
                             break;
 
@@ -1081,6 +1137,9 @@ static rsRetVal ATTR_NONNULL(1)
                             if (localRet != RS_RET_OK && localRet != RS_RET_QUEUE_FULL) {
                                 LogError(oserr, localRet, "Tearing down TCP Session from %s:%s", peerIP, peerPort);
                                 state = RS_DONECLOSE;
+                            } else if (pioDescr->bInHandshake) {
+                                hsFinished(pioDescr, 1);
+                                state = RS_HANDSHAKE_DONE;
                             }
                             break;
 
@@ -1097,13 +1156,19 @@ static rsRetVal ATTR_NONNULL(1)
                 }
                 break;
 
+            case RS_HANDSHAKE_DONE:
+                /* more data may be pending - let the data workers continue */
+                enqueueWork(&pThis->workQueue, pioDescr);
+                state = RS_DONE_HANDOFF;
+                break;
+
             case RS_STARVATION:
                 dbgprintf("starvation avoidance triggered, ctr=%u, maxReads=%u\n", read_calls, maxReads);
                 assert(pThis->workQueue.numWrkr > 1);
 #if defined(ENABLE_IMTCP_EPOLL)
                 STATSCOUNTER_INC(wrkrData->ctrStarvation, wrkrData->mutCtrStarvation);
 #endif
-                enqueueWork(pioDescr);
+                enqueueWork(&pThis->workQueue, pioDescr);
                 state = RS_DONE_HANDOFF; /* queued behind existing work → exit, no re-arm */
                 break;
 
@@ -1131,6 +1196,9 @@ static rsRetVal ATTR_NONNULL(1)
     }
 
     if (state == RS_DONECLOSE) {
+        if (pioDescr->bInHandshake) {
+            hsFinished(pioDescr, 0);
+        }
         closeSess(pThis, pioDescr); /* also frees pioDescr in epoll builds */
     }
 
@@ -1166,6 +1234,18 @@ static rsRetVal ATTR_NONNULL(1) doSingleAccept(tcpsrv_io_descr_t *const pioDescr
         pDescrNew->ioDirection = NSDSEL_RD;
         CHKiRet(netstrm.GetSock(pNewSess->pStrm, &pDescrNew->sock));
         pDescrNew->ptr.pSess = pNewSess;
+        if (pThis->hsQueue.numWrkr > 0) {
+            int bDone = 1;
+            CHKiRet(netstrm.IsHandshakeDone(pNewSess->pStrm, &bDone));
+            if (!bDone) {
+                /* must be accounted before the session can show up in epoll */
+                pDescrNew->bInHandshake = 1;
+                pDescrNew->tHandshakeStart = hsNowUs();
+                pthread_mutex_lock(&pThis->mutHs);
+                ++pThis->hsPending;
+                pthread_mutex_unlock(&pThis->mutHs);
+            }
+        }
         CHKiRet(epoll_Ctl(pThis, pDescrNew, 0, EPOLL_CTL_ADD));
 #endif
 
@@ -1184,6 +1264,11 @@ finalize_it:
                  "to process incoming connection %s with error %d",
                  (cnf_params->pszInputName == NULL) ? (uchar *)"*UNSET*" : cnf_params->pszInputName, connInfo, iRet);
         if (pDescrNew != NULL) {
+            if (pDescrNew->bInHandshake) {
+                pthread_mutex_lock(&pThis->mutHs);
+                --pThis->hsPending;
+                pthread_mutex_unlock(&pThis->mutHs);
+            }
             DESTROY_ATOMIC_HELPER_MUT(pDescrNew->mut_isInError);
             free(pDescrNew);
         }
@@ -1194,6 +1279,32 @@ no_more_data:
 }
 
 
+/* check if accepting must pause because handshake.maxPending handshakes are in
+ * progress. If so, the listener is parked; it is not re-armed until hsFinished()
+ * hands it back to the handshake pool.
+ */
+static int ATTR_NONNULL() hsParkListener(tcpsrv_io_descr_t *const pioDescr) {
+    tcpsrv_t *const pThis = pioDescr->pSrv;
+    int bParked = 0;
+
+    if (pThis->hsQueue.numWrkr == 0 || pThis->hsMaxPending == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&pThis->mutHs);
+    if ((unsigned)pThis->hsPending >= pThis->hsMaxPending) {
+        pioDescr->bParked = 1;
+        bParked = 1;
+    }
+    pthread_mutex_unlock(&pThis->mutHs);
+    if (bParked) {
+        STATSCOUNTER_INC(pThis->ctrHsParked, pThis->mutCtrHsParked);
+        DBGPRINTF("tcpsrv: %d handshakes pending, pausing accept on listener %d\n", pThis->hsMaxPending,
+                  pioDescr->id);
+    }
+    return bParked;
+}
+
+
 /* This function processes all pending accepts on this fd */
 static rsRetVal ATTR_NONNULL(1)
     doAccept(tcpsrv_io_descr_t *const pioDescr, tcpsrvWrkrData_t *const wrkrData ATTR_UNUSED) {
@@ -1204,6 +1315,13 @@ static rsRetVal ATTR_NONNULL(1)
 #endif
 
     while (bRun) {
+        if (hsParkListener(pioDescr)) {
+            /* no re-arm: hsFinished() resumes us once handshakes complete */
+#if defined(ENABLE_IMTCP_EPOLL)
+            STATSCOUNTER_ADD(wrkrData->ctrAccept, wrkrData->mutCtrAccept, nAccept);
+#endif
+            FINALIZE;
+        }
         iRet = doSingleAccept(pioDescr);
         if (iRet != RS_RET_OK) {
             bRun = 0;
@@ -1216,9 +1334,10 @@ static rsRetVal ATTR_NONNULL(1)
     if (pioDescr->pSrv->workQueue.numWrkr > 1) {
         STATSCOUNTER_ADD(wrkrData->ctrAccept, wrkrData->mutCtrAccept, nAccept);
     }
-    rearmIoEvent(pioDescr); /* listeners must ALWAYS be re-armed */
+    rearmIoEvent(pioDescr); /* listeners must ALWAYS be re-armed, unless parked above */
 #endif
 
+finalize_it:
     RETiRet;
 }
 
@@ -1248,7 +1367,8 @@ static void ATTR_NONNULL() * wrkr(void *arg); /* forward-def of wrkr */
  *
  * @details
  *  This function allocates worker arrays, initializes synchronization primitives,
- *  and spawns `workQueue.numWrkr` threads running `wrkr()`.
+ *  and spawns `queue->numWrkr` threads running `wrkr()`. Used for both the
+ *  data worker pool (`workQueue`) and the handshake pool (`hsQueue`).
  *
  *  ### Why all cleanup happens in `finalize_it`
  *  This routine runs during initialization. If we fail here, the process is very
@@ -1268,21 +1388,21 @@ static void ATTR_NONNULL() * wrkr(void *arg); /* forward-def of wrkr */
  *  `pthread_join()` on each. Worker threads block in `pthread_cond_wait()` which is
  *  a POSIX cancellation point, so cancellation is reliable here.
  *
- *  @param pThis Server instance (must have `workQueue.numWrkr > 1`).
+ *  @param queue Queue to start the workers for (must have `numWrkr > 0`).
  *  @retval RS_RET_OK on success; error code on failure (resources cleaned up).
  */
-static rsRetVal ATTR_NONNULL() startWrkrPool(tcpsrv_t *const pThis) {
+static rsRetVal ATTR_NONNULL() startWrkrPool(workQueue_t *const queue) {
     DEFiRet;
-    workQueue_t *const queue = &pThis->workQueue;
     int mut_initialized = 0;
     int cond_initialized = 0;
     unsigned created = 0;
 
-    assert(queue->numWrkr > 1);
+    assert(queue->numWrkr > 0);
 
     /* Initialize queue state first. */
     queue->head = NULL;
     queue->tail = NULL;
+    queue->iLen = 0;
 
     /* Allocate arrays. */
     CHKmalloc(queue->wrkr_tids = calloc(queue->numWrkr, sizeof(pthread_t)));
@@ -1300,9 +1420,9 @@ static rsRetVal ATTR_NONNULL() startWrkrPool(tcpsrv_t *const pThis) {
     cond_initialized = 1;
 
     /* Spawn workers. */
-    pThis->currWrkrs = 0;
+    queue->currWrkrs = 0;
     for (unsigned i = 0; i < queue->numWrkr; ++i) {
-        if (pthread_create(&queue->wrkr_tids[i], &default_thread_attr, wrkr, pThis) != 0) {
+        if (pthread_create(&queue->wrkr_tids[i], &default_thread_attr, wrkr, queue) != 0) {
             iRet = RS_RET_ERR;
             break;
         }
@@ -1347,11 +1467,9 @@ finalize_it:
  * This function can be called multiple times or in partial-init states.
  * It checks preconditions and only performs cleanup operations that are safe.
  */
-static void ATTR_NONNULL() stopWrkrPool(tcpsrv_t *const pThis) {
-    workQueue_t *const queue = &pThis->workQueue;
-
+static void ATTR_NONNULL() stopWrkrPool(workQueue_t *const queue) {
     /* Guard against being called when pool was never started or already stopped. */
-    if (queue->numWrkr <= 1 || queue->wrkr_tids == NULL) {
+    if (queue->numWrkr == 0 || queue->wrkr_tids == NULL) {
         return;
     }
 
@@ -1377,8 +1495,7 @@ static void ATTR_NONNULL() stopWrkrPool(tcpsrv_t *const pThis) {
     queue->wrkr_data = NULL;
 }
 
-static tcpsrv_io_descr_t ATTR_NONNULL() * dequeueWork(tcpsrv_t *pSrv) {
-    workQueue_t *const queue = &pSrv->workQueue;
+static tcpsrv_io_descr_t ATTR_NONNULL() * dequeueWork(workQueue_t *const queue) {
     tcpsrv_io_descr_t *pioDescr;
 
     pthread_mutex_lock(&queue->mut);
@@ -1396,6 +1513,7 @@ static tcpsrv_io_descr_t ATTR_NONNULL() * dequeueWork(tcpsrv_t *pSrv) {
     if (queue->head == NULL) {
         queue->tail = NULL;
     }
+    --queue->iLen;
 finalize_it:
     pthread_mutex_unlock(&queue->mut);
     return pioDescr;
@@ -1404,7 +1522,7 @@ finalize_it:
 /**
  * @brief Queue a ready I/O descriptor for worker processing (best-effort).
  *
- * Appends @p pioDescr to the work FIFO and signals one worker. Performs its
+ * Appends @p pioDescr to the FIFO of @p queue and signals one worker. Performs its
  * own locking; callers must not hold workQueue::mut. No epoll re-arm is done here.
  *
  * Intent:
@@ -1419,14 +1537,12 @@ finalize_it:
  *
  * Preconditions:
  *  - @p pioDescr != NULL and @p pioDescr->pSrv != NULL.
- *  - Multi-thread mode active (workQueue.numWrkr > 1).
+ *  - The workers of @p queue are running (data pool: workQueue.numWrkr > 1).
  *
  * Postconditions:
  *  - @p pioDescr is placed at the queue tail and one worker is signaled.
  */
-static void ATTR_NONNULL() enqueueWork(tcpsrv_io_descr_t *const pioDescr) {
-    workQueue_t *const queue = &pioDescr->pSrv->workQueue;
-
+static void ATTR_NONNULL() enqueueWork(workQueue_t *const queue, tcpsrv_io_descr_t *const pioDescr) {
     pthread_mutex_lock(&queue->mut);
     pioDescr->next = NULL;
     if (queue->tail == NULL) {
@@ -1436,6 +1552,7 @@ static void ATTR_NONNULL() enqueueWork(tcpsrv_io_descr_t *const pioDescr) {
         queue->tail->next = pioDescr;
     }
     queue->tail = pioDescr;
+    ++queue->iLen;
 
     pthread_cond_signal(&queue->workRdy);
     pthread_mutex_unlock(&queue->mut);
@@ -1443,12 +1560,12 @@ static void ATTR_NONNULL() enqueueWork(tcpsrv_io_descr_t *const pioDescr) {
 
 /* Worker thread function */
 static void ATTR_NONNULL() * wrkr(void *arg) {
-    tcpsrv_t *const pThis = (tcpsrv_t *)arg;
-    workQueue_t *const queue = &pThis->workQueue;
+    workQueue_t *const queue = (workQueue_t *)arg;
+    tcpsrv_t *const pThis = queue->pSrv;
     tcpsrv_io_descr_t *pioDescr;
 
     pthread_mutex_lock(&queue->mut);
-    const int wrkrIdx = pThis->currWrkrs++;
+    const int wrkrIdx = queue->currWrkrs++;
     pthread_mutex_unlock(&queue->mut);
     int deinit_stats = 0;
     rsRetVal localRet;
@@ -1456,10 +1573,10 @@ static void ATTR_NONNULL() * wrkr(void *arg) {
     tcpsrvWrkrData_t *const wrkrData = &(queue->wrkr_data[wrkrIdx]);
 
     uchar shortThrdName[16];
-    snprintf((char *)shortThrdName, sizeof(shortThrdName), "w%d/%s", wrkrIdx,
+    snprintf((char *)shortThrdName, sizeof(shortThrdName), "%c%d/%s", queue->wrkrPrefix, wrkrIdx,
              (pThis->pszInputName == NULL) ? (uchar *)"tcpsrv" : pThis->pszInputName);
     uchar thrdName[32];
-    snprintf((char *)thrdName, sizeof(thrdName), "w%d/%s", wrkrIdx,
+    snprintf((char *)thrdName, sizeof(thrdName), "%c%d/%s", queue->wrkrPrefix, wrkrIdx,
              (pThis->pszInputName == NULL) ? (uchar *)"tcpsrv" : pThis->pszInputName);
     dbgSetThrdName(thrdName);
 
@@ -1529,7 +1646,7 @@ static void ATTR_NONNULL() * wrkr(void *arg) {
 
     /**** main loop ****/
     while (1) {
-        pioDescr = dequeueWork(pThis);
+        pioDescr = dequeueWork(queue);
         if (pioDescr == NULL) {
             break;
         }
@@ -1561,7 +1678,8 @@ static rsRetVal ATTR_NONNULL() processWorkset(const int numEntries, tcpsrv_io_de
     DEFiRet;
     assert(numEntries > 0);
     if (numEntries <= 0 || pioDescr[0] == NULL || pioDescr[0]->pSrv == NULL) return RS_RET_INTERNAL_ERROR;
-    numWrkr = pioDescr[0]->pSrv->workQueue.numWrkr; /* pSrv is always the same! */
+    tcpsrv_t *const pSrv = pioDescr[0]->pSrv; /* pSrv is always the same! */
+    numWrkr = pSrv->workQueue.numWrkr;
 
     DBGPRINTF("tcpsrv: ready to process %d event entries\n", numEntries);
 
@@ -1569,8 +1687,12 @@ static rsRetVal ATTR_NONNULL() processWorkset(const int numEntries, tcpsrv_io_de
         if (numWrkr == 1) {
             /* we process all on this thread, no need for context switch */
             processWorksetItem(pioDescr[i], NULL);
+        } else if (pSrv->hsQueue.numWrkr > 0 &&
+                   (pioDescr[i]->ptrType == NSD_PTR_TYPE_LSTN || pioDescr[i]->bInHandshake)) {
+            /* accepts and handshakes must not hold up data workers */
+            enqueueWork(&pSrv->hsQueue, pioDescr[i]);
         } else {
-            enqueueWork(pioDescr[i]);
+            enqueueWork(&pSrv->workQueue, pioDescr[i]);
         }
     }
     RETiRet;
@@ -1758,9 +1880,11 @@ static rsRetVal ATTR_NONNULL() RunEpoll(tcpsrv_t *const pThis) {
 
     /* Workers can still process listener events queued just before shutdown.
      * Join them before freeing listener descriptors so rearmIoEvent() cannot
-     * observe descriptor storage that RunEpoll() is tearing down.
+     * observe descriptor storage that RunEpoll() is tearing down. The handshake
+     * pool goes first, as its workers hand sessions over to the data workers.
      */
-    stopWrkrPool(pThis);
+    stopWrkrPool(&pThis->hsQueue);
+    stopWrkrPool(&pThis->workQueue);
 
     /* remove the tcp listen sockets from the epoll set */
     for (i = 0; i < pThis->iLstnCurr; ++i) {
@@ -1775,6 +1899,45 @@ finalize_it:
 #endif
 
 
+/* set up the statistics of the handshake pool. Failure is not fatal, the pool
+ * then simply runs without statistics.
+ */
+static void ATTR_NONNULL() hsStatsInit(tcpsrv_t *const pThis) {
+    uchar statname[64];
+    rsRetVal localRet;
+
+    /* counters are updated even if the stats object cannot be created */
+    STATSCOUNTER_INIT(pThis->ctrHsDone, pThis->mutCtrHsDone);
+    STATSCOUNTER_INIT(pThis->ctrHsFailed, pThis->mutCtrHsFailed);
+    STATSCOUNTER_INIT(pThis->ctrHsTime, pThis->mutCtrHsTime);
+    STATSCOUNTER_INIT(pThis->ctrHsParked, pThis->mutCtrHsParked);
+    if ((localRet = statsobj.Construct(&pThis->hsStats)) != RS_RET_OK) {
+        LogMsg(0, localRet, LOG_WARNING,
+               "tcpsrv could not create handshake statistics (inputname: '%s'). "
+               "Processing is otherwise unaffected",
+               (pThis->pszInputName == NULL) ? (uchar *)"*UNSET*" : pThis->pszInputName);
+        pThis->hsStats = NULL;
+        return;
+    }
+    snprintf((char *)statname, sizeof(statname), "handshake/%s",
+             (pThis->pszInputName == NULL) ? (uchar *)"tcpsrv" : pThis->pszInputName);
+    statsobj.SetName(pThis->hsStats, statname);
+    statsobj.SetOrigin(pThis->hsStats, (uchar *)"imtcp");
+    statsobj.AddCounter(pThis->hsStats, UCHAR_CONSTANT("completed"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                        &(pThis->ctrHsDone));
+    statsobj.AddCounter(pThis->hsStats, UCHAR_CONSTANT("failed"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                        &(pThis->ctrHsFailed));
+    statsobj.AddCounter(pThis->hsStats, UCHAR_CONSTANT("time.us"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                        &(pThis->ctrHsTime));
+    statsobj.AddCounter(pThis->hsStats, UCHAR_CONSTANT("paused"), ctrType_IntCtr, CTR_FLAG_RESETTABLE,
+                        &(pThis->ctrHsParked));
+    statsobj.AddCounter(pThis->hsStats, UCHAR_CONSTANT("pending"), ctrType_Int, CTR_FLAG_NONE, &(pThis->hsPending));
+    statsobj.AddCounter(pThis->hsStats, UCHAR_CONSTANT("backlog"), ctrType_Int, CTR_FLAG_NONE,
+                        &(pThis->hsQueue.iLen));
+    statsobj.ConstructFinalize(pThis->hsStats);
+}
+
+
 /* This function is called to gather input. It tries doing that via the epoll()
  * interface. If the driver does not support that, it falls back to calling its
  * select() equivalent.
@@ -1796,7 +1959,7 @@ static rsRetVal ATTR_NONNULL() Run(tcpsrv_t *const pThis) {
 
     eventNotify_init(pThis);
     if (pThis->workQueue.numWrkr > 1) {
-        iRet = startWrkrPool(pThis);
+        iRet = startWrkrPool(&pThis->workQueue);
         if (iRet != RS_RET_OK) {
             LogError(errno, iRet,
                      "tcpsrv could not start worker pool "
@@ -1805,6 +1968,20 @@ static rsRetVal ATTR_NONNULL() Run(tcpsrv_t *const pThis) {
             pThis->workQueue.numWrkr = 1;
         }
     }
+    /* the handshake pool only makes sense on top of the data worker pool */
+    if (pThis->workQueue.numWrkr > 1 && pThis->hsQueue.numWrkr > 0) {
+        hsStatsInit(pThis);
+        iRet = startWrkrPool(&pThis->hsQueue);
+        if (iRet != RS_RET_OK) {
+            LogError(errno, iRet,
+                     "tcpsrv could not start handshake worker pool "
+                     "- handshakes are done by regular workers '%s')",
+                     (pThis->pszInputName == NULL) ? (uchar *)"*UNSET*" : pThis->pszInputName);
+            pThis->hsQueue.numWrkr = 0;
+        }
+    } else {
+        pThis->hsQueue.numWrkr = 0;
+    }
 #if defined(ENABLE_IMTCP_EPOLL)
     iRet = RunEpoll(pThis);
 #else
@@ -1812,7 +1989,11 @@ static rsRetVal ATTR_NONNULL() Run(tcpsrv_t *const pThis) {
     iRet = RunPoll(pThis);
 #endif
 
-    stopWrkrPool(pThis);
+    stopWrkrPool(&pThis->hsQueue);
+    stopWrkrPool(&pThis->workQueue);
+    if (pThis->hsStats != NULL) {
+        statsobj.Destruct(&pThis->hsStats);
+    }
     eventNotify_exit(pThis);
 
 finalize_it:
@@ -1845,6 +2026,11 @@ BEGINobjConstruct(tcpsrv) /* be sure to specify the object type also in END macr
     pThis->compressionMaxExpansionRatio = TCPSRV_COMPRESS_MAX_EXPANSION_RATIO_DEFAULT;
     pThis->compressionMaxDecompressedBytesPerReceive = TCPSRV_COMPRESS_MAX_DECOMPRESSED_BYTES_PER_RECEIVE_DEFAULT;
     pThis->compressionMaxTotalZstdWindowBytes = TCPSRV_COMPRESS_MAX_TOTAL_ZSTD_WINDOW_BYTES_DEFAULT;
+    pThis->workQueue.pSrv = pThis;
+    pThis->workQueue.wrkrPrefix = 'w';
+    pThis->hsQueue.pSrv = pThis;
+    pThis->hsQueue.wrkrPrefix = 'h';
+    pthread_mutex_init(&pThis->mutHs, NULL);
 ENDobjConstruct(tcpsrv)
 
 
@@ -1903,7 +2089,8 @@ BEGINobjDestruct(tcpsrv) /* be sure to specify the object type also in END and C
     CODESTARTobjDestruct(tcpsrv);
     if (pThis->OnDestruct != NULL) pThis->OnDestruct(pThis->pUsr);
 
-    stopWrkrPool(pThis);
+    stopWrkrPool(&pThis->hsQueue);
+    stopWrkrPool(&pThis->workQueue);
 
     deinit_tcp_listener(pThis);
 
@@ -1920,6 +2107,7 @@ BEGINobjDestruct(tcpsrv) /* be sure to specify the object type also in END and C
     free(pThis->ppLstnPort);
     free(pThis->ppioDescrPtr);
     free(pThis->pszOrigin);
+    pthread_mutex_destroy(&pThis->mutHs);
     DESTROY_ATOMIC_HELPER_MUT(pThis->mut_sessions);
 ENDobjDestruct(tcpsrv)
 
@@ -2404,6 +2592,18 @@ static rsRetVal ATTR_NONNULL(1) SetNumWrkr(tcpsrv_t *pThis, const int numWrkr) {
 }
 
 
+static rsRetVal ATTR_NONNULL(1) SetNumHandshakeWrkr(tcpsrv_t *pThis, const int numWrkr) {
+    pThis->hsQueue.numWrkr = numWrkr;
+    return RS_RET_OK;
+}
+
+
+static rsRetVal ATTR_NONNULL(1) SetHandshakeMaxPending(tcpsrv_t *pThis, const unsigned int maxPending) {
+    pThis->hsMaxPending = maxPending;
+    return RS_RET_OK;
+}
+
+
 /* queryInterface function
  * rgerhards, 2008-02-29
  */
@@ -2481,6 +2681,8 @@ BEGINobjQueryInterface(tcpsrv)
     pIf->SetSynBacklog = SetSynBacklog;
     pIf->SetNumWrkr = SetNumWrkr;
     pIf->SetStarvationMaxReads = SetStarvationMaxReads;
+    pIf->SetNumHandshakeWrkr = SetNumHandshakeWrkr;
+    pIf->SetHandshakeMaxPending = SetHandshakeMaxPending;
 
 finalize_it:
 ENDobjQueryInterface(tcpsrv)
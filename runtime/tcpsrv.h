@@ -113,6 +113,10 @@ typedef struct workQueue_s {
     unsigned numWrkr; /* how many workers to spawn */
     pthread_t *wrkr_tids; /* array of thread IDs */
     tcpsrvWrkrData_t *wrkr_data;
+    tcpsrv_t *pSrv; /* server this queue belongs to */
+    char wrkrPrefix; /* first char of worker thread names: 'w' (data) or 'h' (handshake) */
+    int currWrkrs; /* workers started so far, used to assign worker indexes */
+    int iLen; /* current number of queued entries */
 } workQueue_t;
 
 /**
@@ -132,6 +136,9 @@ struct tcpsrv_io_descr_s {
                     * unrecoverable error at the network layer. */
     tcpsrv_t *pSrv; /* our server object */
     tcpsrv_io_descr_t *next; /* for use in workQueue_t */
+    sbool bInHandshake; /* session handshake not yet done, served by the handshake pool */
+    sbool bParked; /* listener not re-armed because of handshake.maxPending */
+    uint64_t tHandshakeStart; /* monotonic usecs when the session was accepted */
 #if defined(ENABLE_IMTCP_EPOLL)
     struct epoll_event event; /* to re-enable EPOLLONESHOT */
 #endif
@@ -225,7 +232,16 @@ struct tcpsrv_s {
         rsRetVal (*OnMsgReceive)(tcps_sess_t *, uchar *pszMsg, int iLenMsg); /* submit message callback */
         /* work queue */
         workQueue_t workQueue;
-        int currWrkrs;
+        /* handshake pool: accepts and sessions in handshake, if enabled */
+        workQueue_t hsQueue;
+        unsigned hsMaxPending; /**< max sessions in handshake before accepts pause, 0 = unlimited */
+        int hsPending; /**< sessions currently in handshake, protected by mutHs */
+        pthread_mutex_t mutHs;
+        statsobj_t *hsStats;
+        STATSCOUNTER_DEF(ctrHsDone, mutCtrHsDone)
+        STATSCOUNTER_DEF(ctrHsFailed, mutCtrHsFailed)
+        STATSCOUNTER_DEF(ctrHsTime, mutCtrHsTime)
+        STATSCOUNTER_DEF(ctrHsParked, mutCtrHsParked)
 };
 
 
@@ -356,9 +372,12 @@ BEGINinterface(tcpsrv) /* name must also be changed in ENDinterface macro! */
      */
     rsRetVal (*SetNetworkNamespace)(tcpsrv_t *pThis, tcpLstnParams_t *const cnf_params,
                                     const char *const networkNamespace);
+    /* added v33 -- TLS handshake pool */
+    rsRetVal (*SetNumHandshakeWrkr)(tcpsrv_t *pThis, int);
+    rsRetVal (*SetHandshakeMaxPending)(tcpsrv_t *pThis, unsigned int);
 
 ENDinterface(tcpsrv)
-#define tcpsrvCURR_IF_VERSION 32 /* increment whenever you change the interface structure! */
+#define tcpsrvCURR_IF_VERSION 33 /* increment whenever you change the interface structure! */
 /* change for v4:
  * - SetAddtlFrameDelim() added -- rgerhards, 2008-12-10
  * - SetInputName() added -- rgerhards, 2008-12-10
@@ -49,6 +49,7 @@
 #include "msg.h"
 #include "parserif.h"
 #include "unicode-helper.h"
+#include "atomic.h"
 
 /* states for lazily built JSON tree used in list templates with jsonf mode */
 #define TPL_JSON_TREE_NOT_BUILT 0
@@ -850,6 +851,385 @@ static int tplParseNonNegativeInt(uchar **const pp, int *const out) {
 }
 
 
+/* Render plans.
+ *
+ * When a config is activated, plain text templates (no strgen, no subtree,
+ * no jsonf) are flattened into an array of ops. Adjacent constants are
+ * merged into a single span, the escape mode is resolved once, and the most
+ * common properties without options are fetched directly instead of taking
+ * the generic MsgGetProp() path. tplToString() uses the plan if present and
+ * walks the entry list otherwise.
+ */
+enum tplPlanOpType {
+    TPL_OP_CONST = 0, /* constant span */
+    TPL_OP_MSG = 1, /* msg property without options */
+    TPL_OP_HOSTNAME = 2, /* hostname property without options */
+    TPL_OP_PROP = 3 /* any other field, via MsgGetProp() */
+};
+
+struct tplPlanOp {
+    enum tplPlanOpType type;
+    rs_size_t lenConst; /* TPL_OP_CONST only */
+    const uchar *pConst; /* TPL_OP_CONST only, points into plan's pConstBuf */
+    struct templateEntry *pTpe; /* field ops only */
+};
+
+struct tplRenderPlan {
+    int nOps;
+    int escMode; /* escape mode applied to field values */
+    uchar *pConstBuf; /* storage for all merged constant spans */
+    struct tplPlanOp ops[];
+};
+
+/* upper bound for the buffer presize hint, so that a single oversized
+ * message does not make every later render reserve a huge buffer.
+ */
+#define TPL_LEN_HINT_MAX (64 * 1024)
+
+static void tplPlanFree(struct tplRenderPlan *const pPlan) {
+    if (pPlan == NULL) return;
+    free(pPlan->pConstBuf);
+    free(pPlan);
+}
+
+static enum tplPlanOpType tplPlanFieldOp(const struct templateEntry *const pTpe) {
+    if (pTpe->bComplexProcessing) return TPL_OP_PROP;
+    switch (pTpe->data.field.msgProp.id) {
+        case PROP_MSG:
+            return TPL_OP_MSG;
+        case PROP_HOSTNAME:
+            return TPL_OP_HOSTNAME;
+        default:
+            return TPL_OP_PROP;
+    }
+}
+
+/* build the render plan for a single template. Templates which cannot be
+ * expressed as a plan are left alone (pPlan stays NULL).
+ */
+static rsRetVal tplCompilePlan(struct template *const pTpl) {
+    struct tplRenderPlan *pPlan = NULL;
+    struct templateEntry *pTpe;
+    struct tplPlanOp *pOp = NULL;
+    uchar *pConstEnd;
+    size_t lenConst = 0;
+    int nOps = 0;
+    int bPrevConst = 0;
+    DEFiRet;
+
+    if (pTpl->pPlan != NULL || pTpl->pStrgen != NULL || pTpl->bHaveSubtree || pTpl->optFormatEscape == JSONF) {
+        FINALIZE;
+    }
+
+    for (pTpe = pTpl->pEntryRoot; pTpe != NULL; pTpe = pTpe->pNext) {
+        if (pTpe->eEntryType == CONSTANT) {
+            if (pTpe->data.constant.iLenConstant <= 0) continue;
+            if (!bPrevConst) ++nOps;
+            CHKiRet(tplAddSize(lenConst, (size_t)pTpe->data.constant.iLenConstant, &lenConst));
+            bPrevConst = 1;
+        } else if (pTpe->eEntryType == FIELD) {
+            ++nOps;
+            bPrevConst = 0;
+        } else {
+            FINALIZE; /* keep the generic path, it reports the logic error */
+        }
+    }
+    if (lenConst > INT_MAX) FINALIZE;
+
+    CHKmalloc(pPlan = calloc(1, sizeof(struct tplRenderPlan) + (size_t)nOps * sizeof(struct tplPlanOp)));
+    if (lenConst > 0) {
+        CHKmalloc(pPlan->pConstBuf = malloc(lenConst));
+    }
+    pPlan->escMode = pTpl->optFormatEscape;
+    pConstEnd = pPlan->pConstBuf;
+
+    for (pTpe = pTpl->pEntryRoot; pTpe != NULL; pTpe = pTpe->pNext) {
+        if (pTpe->eEntryType == CONSTANT) {
+            const int len = pTpe->data.constant.iLenConstant;
+            if (len <= 0) continue;
+            if (pOp == NULL || pOp->type != TPL_OP_CONST) {
+                pOp = &pPlan->ops[pPlan->nOps++];
+                pOp->type = TPL_OP_CONST;
+                pOp->pConst = pConstEnd;
+                pOp->lenConst = 0;
+            }
+            memcpy(pConstEnd, pTpe->data.constant.pConstant, len);
+            pConstEnd += len;
+            pOp->lenConst += len;
+        } else {
+            pOp = &pPlan->ops[pPlan->nOps++];
+            pOp->type = tplPlanFieldOp(pTpe);
+            pOp->pTpe = pTpe;
+        }
+    }
+
+    pTpl->pPlan = pPlan;
+    pPlan = NULL;
+
+finalize_it:
+    tplPlanFree(pPlan);
+    RETiRet;
+}
+
+/* Property cache columns.
+ *
+ * Only values that depend on nothing but the message are cached: system
+ * properties (time of "now", uptime, ...) and global variables are not.
+ * Plain properties without options are already cheap to fetch, so only
+ * entries with options, timestamps and message variables get a column.
+ */
+static int tplPropCacheable(const struct templateEntry *const pTpe) {
+    const propid_t id = pTpe->data.field.msgProp.id;
+
+    if (pTpe->eEntryType != FIELD) return 0;
+    if (id == PROP_GLOBAL_VAR || (id >= PROP_SYS_NOW && id <= PROP_SYS_NOW_UXTIMESTAMP && id != PROP_UUID)) return 0;
+    return pTpe->bComplexProcessing || id == PROP_TIMESTAMP || id == PROP_TIMEGENERATED || id == PROP_CEE ||
+           id == PROP_CEE_ALL_JSON || id == PROP_CEE_ALL_JSON_PLAIN || id == PROP_LOCAL_VAR;
+}
+
+/* do two field entries always produce the same value for a message? Entries
+ * with a regex are only equal to themselves, as regex_t cannot be compared.
+ * The field name is part of the value for jsonf/jsonfr, so it must match too.
+ */
+static int tplEntriesEqual(const struct templateEntry *const a, const struct templateEntry *const b) {
+    if (a == b) return 1;
+#ifdef FEATURE_REGEXP
+    if (a->data.field.has_regex || b->data.field.has_regex) return 0;
+#endif
+    return a->bComplexProcessing == b->bComplexProcessing && a->data.field.msgProp.id == b->data.field.msgProp.id &&
+           a->data.field.msgProp.nameLen == b->data.field.msgProp.nameLen &&
+           (a->data.field.msgProp.nameLen == 0 ||
+            !memcmp(a->data.field.msgProp.name, b->data.field.msgProp.name, a->data.field.msgProp.nameLen)) &&
+           a->lenFieldName == b->lenFieldName &&
+           (a->lenFieldName == 0 || !memcmp(a->fieldName, b->fieldName, a->lenFieldName)) &&
+           a->data.field.iFromPos == b->data.field.iFromPos && a->data.field.iToPos == b->data.field.iToPos &&
+           a->data.field.iFieldNr == b->data.field.iFieldNr && a->data.field.has_fields == b->data.field.has_fields &&
+           a->data.field.field_delim == b->data.field.field_delim &&
+#ifdef STRICT_GPLV3
+           a->data.field.field_expand == b->data.field.field_expand &&
+#endif
+           a->data.field.eDateFormat == b->data.field.eDateFormat &&
+           a->data.field.eCaseConv == b->data.field.eCaseConv &&
+           !memcmp(&a->data.field.options, &b->data.field.options, sizeof(a->data.field.options));
+}
+
+/* assign property cache columns to the field ops of all render plans */
+static void tplAssignPropCols(rsconf_t *const conf) {
+    struct templateEntry **ppCols = NULL;
+    struct templateEntry **ppNew;
+    struct template *pTpl;
+    int maxCols = 0;
+    int nCols = 0;
+    int i, j;
+
+    for (pTpl = conf->templates.root; pTpl != NULL; pTpl = pTpl->pNext) {
+        if (pTpl->pPlan == NULL) continue;
+        for (i = 0; i < pTpl->pPlan->nOps; ++i) {
+            struct templateEntry *const pTpe = pTpl->pPlan->ops[i].pTpe;
+            if (pTpl->pPlan->ops[i].type != TPL_OP_PROP || pTpe->data.field.iPropCol != 0 ||
+                !tplPropCacheable(pTpe)) {
+                continue;
+            }
+            for (j = 0; j < nCols && !tplEntriesEqual(ppCols[j], pTpe); ++j)
+                ;
+            if (j == nCols) {
+                if (nCols == maxCols) {
+                    maxCols = (maxCols == 0) ? 16 : 2 * maxCols;
+                    if ((ppNew = realloc(ppCols, maxCols * sizeof(*ppCols))) == NULL) goto done;
+                    ppCols = ppNew;
+                }
+                ppCols[nCols++] = pTpe;
+            }
+            pTpe->data.field.iPropCol = j + 1;
+        }
+    }
+done:
+    conf->templates.nPropCols = nCols;
+    DBGPRINTF("template property cache uses %d columns\n", nCols);
+    free(ppCols);
+}
+
+/* compile render plans for all templates of a config. Must be called before
+ * any action worker can render templates of that config. Failure to compile
+ * is not fatal, the affected template simply uses the generic path.
+ */
+void tplCompileAll(rsconf_t *conf) {
+    struct template *pTpl;
+
+    for (pTpl = conf->templates.root; pTpl != NULL; pTpl = pTpl->pNext) {
+        if (tplCompilePlan(pTpl) != RS_RET_OK) {
+            DBGPRINTF("template '%s': could not compile render plan, using generic path\n", pTpl->pszName);
+        }
+    }
+    tplAssignPropCols(conf);
+}
+
+/* drop all cached values, e.g. because the message changed */
+void tplPropCacheInvalidate(struct tplPropCache *const pCache) {
+    int i;
+
+    for (i = 0; i < pCache->nOwned; ++i) {
+        free(pCache->pEntries[pCache->pOwned[i]].pVal);
+    }
+    pCache->nOwned = 0;
+    pCache->pMsg = NULL;
+    if (++pCache->gen == 0) { /* wrapped, entries of the first round would look valid */
+        for (i = 0; i < pCache->nCols; ++i) pCache->pEntries[i].gen = 0;
+        pCache->gen = 1;
+    }
+}
+
+void tplPropCacheDestruct(struct tplPropCache *const pCache) {
+    if (pCache == NULL) return;
+    tplPropCacheInvalidate(pCache);
+    free(pCache->pEntries);
+    free(pCache->pOwned);
+    free(pCache);
+}
+
+/* make room for nCols columns, cached values are kept */
+static rsRetVal tplPropCacheGrow(struct tplPropCache *const pCache, const int nCols) {
+    struct tplPropCacheEntry *pEntries;
+    int *pOwned;
+    DEFiRet;
+
+    CHKmalloc(pEntries = realloc(pCache->pEntries, nCols * sizeof(struct tplPropCacheEntry)));
+    pCache->pEntries = pEntries;
+    CHKmalloc(pOwned = realloc(pCache->pOwned, nCols * sizeof(int)));
+    pCache->pOwned = pOwned;
+    memset(pCache->pEntries + pCache->nCols, 0, (nCols - pCache->nCols) * sizeof(struct tplPropCacheEntry));
+    pCache->nCols = nCols;
+    if (pCache->gen == 0) pCache->gen = 1;
+
+finalize_it:
+    RETiRet;
+}
+
+/* obtain the value of a cached field entry. The value belongs to the cache
+ * and stays valid until the cache is invalidated.
+ */
+static uchar *tplPropCacheGet(struct tplPropCache *const pCache,
+                              smsg_t *const pMsg,
+                              struct templateEntry *const pTpe,
+                              rs_size_t *const pLenVal,
+                              struct syslogTime *const ttNow) {
+    const int col = pTpe->data.field.iPropCol - 1;
+    struct tplPropCacheEntry *pEntry;
+    unsigned short bMustBeFreed = 0;
+
+    if (pCache->pMsg != pMsg || pCache->msgVarGen != pMsg->iVarGen) {
+        tplPropCacheInvalidate(pCache);
+        pCache->pMsg = pMsg;
+        pCache->msgVarGen = pMsg->iVarGen;
+    }
+    pEntry = &pCache->pEntries[col];
+    if (pEntry->gen != pCache->gen) {
+        pEntry->pVal = MsgGetProp(pMsg, pTpe, &pTpe->data.field.msgProp, &pEntry->lenVal, &bMustBeFreed, ttNow);
+        if (pEntry->pVal == NULL) {
+            DBGPRINTF("template property evaluation returned NULL, using empty value\n");
+            pEntry->pVal = UCHAR_CONSTANT("");
+            pEntry->lenVal = 0;
+            bMustBeFreed = 0;
+        }
+        pEntry->bMustBeFreed = bMustBeFreed;
+        if (bMustBeFreed) pCache->pOwned[pCache->nOwned++] = col;
+        pEntry->gen = pCache->gen;
+    }
+    *pLenVal = pEntry->lenVal;
+    return pEntry->pVal;
+}
+
+/* render a template via its compiled plan. This is the equivalent of the
+ * entry walk in tplToString() for non-jsonf templates. Once the output
+ * buffer has reached its typical size, no allocation is done for constant,
+ * msg and hostname ops.
+ */
+static rsRetVal tplRenderPlan(struct template *const pTpl,
+                              const struct tplRenderPlan *const pPlan,
+                              smsg_t *const pMsg,
+                              actWrkrIParams_t *const iparam,
+                              struct syslogTime *const ttNow,
+                              struct tplPropCache *const pCache) {
+    size_t iBuf = 0;
+    uchar *pVal = NULL;
+    rs_size_t iLenVal;
+    unsigned short bMustBeFreed = 0;
+    const int lenHint = PREFER_LOAD_INT(&pTpl->lenHint);
+    int i;
+    DEFiRet;
+
+    /* establishes iBuf < lenBuf, which all checks below rely on */
+    if ((size_t)lenHint >= iparam->lenBuf) {
+        CHKiRet(ExtendBuf(iparam, (size_t)lenHint + 1));
+    }
+
+    for (i = 0; i < pPlan->nOps; ++i) {
+        const struct tplPlanOp *const pOp = &pPlan->ops[i];
+        switch (pOp->type) {
+            case TPL_OP_CONST:
+                pVal = (uchar *)pOp->pConst;
+                iLenVal = pOp->lenConst;
+                break;
+            case TPL_OP_MSG:
+                pVal = getMSG(pMsg);
+                iLenVal = getMSGLen(pMsg);
+                break;
+            case TPL_OP_HOSTNAME:
+                pVal = (uchar *)getHOSTNAME(pMsg);
+                iLenVal = getHOSTNAMELen(pMsg);
+                break;
+            case TPL_OP_PROP:
+            default:
+                if (pCache != NULL && pOp->pTpe->data.field.iPropCol != 0) {
+                    pVal = tplPropCacheGet(pCache, pMsg, pOp->pTpe, &iLenVal, ttNow);
+                } else {
+                    pVal = MsgGetProp(pMsg, pOp->pTpe, &pOp->pTpe->data.field.msgProp, &iLenVal, &bMustBeFreed,
+                                      ttNow);
+                }
+                break;
+        }
+        if (pOp->type != TPL_OP_CONST) {
+            if (pVal == NULL) {
+                DBGPRINTF("template property evaluation returned NULL, using empty value\n");
+                pVal = UCHAR_CONSTANT("");
+                iLenVal = 0;
+                bMustBeFreed = 0;
+            }
+            if (pPlan->escMode != NO_ESCAPE) doEscape(&pVal, &iLenVal, &bMustBeFreed, pPlan->escMode);
+        }
+
+        if (iLenVal > 0) {
+            if ((size_t)iLenVal >= iparam->lenBuf - iBuf) {
+                size_t neededLen;
+                CHKiRet(tplAddSize(iBuf, (size_t)iLenVal + 1, &neededLen));
+                CHKiRet(ExtendBuf(iparam, neededLen));
+            }
+            memcpy(iparam->param + iBuf, pVal, iLenVal);
+            iBuf += iLenVal;
+        }
+
+        if (bMustBeFreed) {
+            free(pVal);
+            bMustBeFreed = 0;
+        }
+    }
+
+    iparam->param[iBuf] = '\0';
+    iparam->lenStr = iBuf;
+
+    /* the hint only grows, so workers sharing a template rarely write it */
+    if (iBuf > (size_t)lenHint && lenHint < TPL_LEN_HINT_MAX) {
+        PREFER_STORE_INT(&pTpl->lenHint, (iBuf > TPL_LEN_HINT_MAX) ? TPL_LEN_HINT_MAX : (int)iBuf);
+    }
+
+finalize_it:
+    if (bMustBeFreed) {
+        free(pVal);
+    }
+    RETiRet;
+}
+
+
 /* This functions converts a template into a string.
  *
  * The function takes a pointer to a template and a pointer to a msg object
@@ -864,6 +1244,18 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
                      smsg_t *__restrict__ const pMsg,
                      actWrkrIParams_t *__restrict__ const iparam,
                      struct syslogTime *const ttNow) {
+    return tplToStringCached(pTpl, pMsg, iparam, ttNow, NULL);
+}
+
+
+/* same as tplToString(), but field values of render plans are taken from
+ * and stored in the worker's property cache (if pCache is not NULL).
+ */
+rsRetVal tplToStringCached(struct template *__restrict__ const pTpl,
+                           smsg_t *__restrict__ const pMsg,
+                           actWrkrIParams_t *__restrict__ const iparam,
+                           struct syslogTime *const ttNow,
+                           struct tplPropCache *pCache) {
     DEFiRet;
     struct templateEntry *__restrict__ pTpe;
     size_t iBuf;
@@ -909,6 +1301,15 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
         }
     }
 
+    if (pTpl->pPlan != NULL) {
+        if (pCache != NULL && pCache->nCols < runConf->templates.nPropCols &&
+            tplPropCacheGrow(pCache, runConf->templates.nPropCols) != RS_RET_OK) {
+            pCache = NULL; /* render uncached */
+        }
+        CHKiRet(tplRenderPlan(pTpl, pTpl->pPlan, pMsg, iparam, ttNow, pCache));
+        FINALIZE;
+    }
+
     /* loop through the template. We obtain one value
      * and copy it over to our dynamic string buffer. Then, we
      * free the obtained value (if requested). We continue this
@@ -3023,6 +3424,7 @@ void tplDeleteAll(rsconf_t *conf) {
         free(pTplDel->pszName);
         if (pTplDel->bHaveSubtree) msgPropDescrDestruct(&pTplDel->subtree);
         tplJsonNodeFree(pTplDel->pJsonRoot);
+        tplPlanFree(pTplDel->pPlan);
         free(pTplDel);
     }
 }
@@ -3075,6 +3477,7 @@ void tplDeleteNew(rsconf_t *conf) {
         free(pTplDel->pszName);
         if (pTplDel->bHaveSubtree) msgPropDescrDestruct(&pTplDel->subtree);
         tplJsonNodeFree(pTplDel->pJsonRoot);
+        tplPlanFree(pTplDel->pPlan);
         free(pTplDel);
     }
 }
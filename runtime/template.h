@@ -36,6 +36,7 @@
     #include "stringbuf.h"
 
 struct tplJsonNode;
+struct tplRenderPlan;
 
 struct template {
     struct template *pNext;
@@ -61,6 +62,8 @@ struct template {
     char bJsonTreeEnabled;
     struct tplJsonNode *pJsonRoot;
     char bJsonTreeBuilt;
+    struct tplRenderPlan *pPlan; /**< compiled render plan, NULL if the entry list must be walked */
+    int lenHint; /**< recent rendered size, used to presize output buffers (racy by design) */
     unsigned bUsedAsDynafile : 1; /**< template renders an omfile dynamic file name */
     unsigned bUsedAsNonDynafile : 1; /**< template also has a non-dynafile use */
     unsigned bWarnedDynafileMixedUse : 1; /**< mixed-use warning was already emitted */
@@ -145,6 +148,7 @@ struct templateEntry {
     #endif
 
 
+            int iPropCol; /* column in the worker property cache (1-based), 0 if not cached */
             enum tplFormatTypes eDateFormat;
             enum tplFormatCaseConvTypes eCaseConv;
             struct { /* bit fields! */
@@ -182,6 +186,29 @@ struct templateEntry {
 };
 
 
+/* Property values shared by all templates a worker renders for the same
+ * message. tplCompileAll() maps each cacheable field entry to a column;
+ * equal entries of different templates share one. The cache is emptied at
+ * the start of each batch, when the next message is rendered, when the
+ * message's variables change, and after a message modification action ran.
+ */
+struct tplPropCacheEntry {
+    uchar *pVal;
+    rs_size_t lenVal;
+    unsigned short bMustBeFreed;
+    unsigned gen; /* valid if equal to the cache's gen */
+};
+
+struct tplPropCache {
+    smsg_t *pMsg; /* message the valid entries belong to */
+    unsigned msgVarGen; /* pMsg->iVarGen when the entries were filled */
+    unsigned gen;
+    int nCols;
+    int nOwned;
+    int *pOwned; /* columns holding values we must free */
+    struct tplPropCacheEntry *pEntries;
+};
+
 /* interfaces */
 BEGINinterface(tpl) /* name must also be changed in ENDinterface macro! */
 ENDinterface(tpl)
@@ -198,6 +225,7 @@ void tplDeleteAll(rsconf_t *conf);
 void tplDeleteNew(rsconf_t *conf);
 void tplPrintList(rsconf_t *conf);
 void tplLastStaticInit(rsconf_t *conf, struct template *tpl);
+void tplCompileAll(rsconf_t *conf);
 rsRetVal ExtendBuf(actWrkrIParams_t *const iparam, const size_t iMinSize);
 int tplRequiresDateCall(struct template *pTpl);
 void tplNoteUse(struct template *pTpl, int bDynafile);
@@ -212,6 +240,13 @@ rsRetVal tplToString(struct template *__restrict__ const pTpl,
                      smsg_t *__restrict__ const pMsg,
                      actWrkrIParams_t *__restrict__ const iparam,
                      struct syslogTime *const ttNow);
+rsRetVal tplToStringCached(struct template *__restrict__ const pTpl,
+                           smsg_t *__restrict__ const pMsg,
+                           actWrkrIParams_t *__restrict__ const iparam,
+                           struct syslogTime *const ttNow,
+                           struct tplPropCache *const pCache);
+void tplPropCacheInvalidate(struct tplPropCache *const pCache);
+void tplPropCacheDestruct(struct tplPropCache *const pCache);
 
 rsRetVal templateInit(void);
 rsRetVal tplProcessCnf(struct cnfobj *o);
@@ -298,10 +298,12 @@ struct multi_submit_s {
 };
 
 /* the following structure is a helper to describe a message property */
+struct msgPropJsonPath_s;
 struct msgPropDescr_s {
     propid_t id;
     uchar *name; /* name and lenName are only set for dynamic */
     int nameLen; /* properties (JSON) */
+    struct msgPropJsonPath_s *jsonPath; /* pre-tokenized name for JSON properties, may be NULL */
 };
 
 /* some forward-definitions from the grammar */
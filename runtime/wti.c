@@ -264,6 +264,17 @@ finalize_it:
     RETiRet;
 }
 
+/* return the worker's template property cache, which is created on first
+ * use. NULL means no memory, templates are then rendered uncached.
+ */
+struct tplPropCache *wtiGetPropCache(wti_t *const pWti) {
+    if (pWti->pPropCache == NULL) {
+        pWti->pPropCache = calloc(1, sizeof(struct tplPropCache));
+        if (pWti->pPropCache != NULL) pWti->pPropCache->gen = 1;
+    }
+    return pWti->pPropCache;
+}
+
 
 /* Destructor */
 BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODESTART macros! */
@@ -279,6 +290,7 @@ BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODE
     /* actual destruction */
     batchFree(&pThis->batch);
     free(pThis->actWrkrInfo);
+    tplPropCacheDestruct(pThis->pPropCache);
     pthread_cond_destroy(&pThis->pcondBusy);
     DESTROY_ATOMIC_HELPER_MUT(pThis->mutIsRunning);
     free(pThis->pszDbgHdr);
@@ -94,6 +94,7 @@ struct wti_s {
                                     */
             uint16_t rulesetCallDepth; /* synchronous ruleset call nesting depth */
         } execState; /* state for the execution engine */
+        struct tplPropCache *pPropCache; /* template property values of the current message, NULL until used */
 };
 
 
@@ -151,8 +152,11 @@ static inline void __attribute__((unused)) wtiResetExecState(wti_t *const pWti,
     pWti->execState.bPrevWasSuspended = 0;
     pWti->execState.bDoAutoCommit = (batchNumMsgs(pBatch) == 1);
     pWti->execState.rulesetCallDepth = 0;
+    /* messages of the previous batch may be gone, so their addresses may be reused */
+    if (pWti->pPropCache != NULL) tplPropCacheInvalidate(pWti->pPropCache);
 }
 
 
 rsRetVal wtiNewIParam(wti_t *const pWti, action_t *const pAction, actWrkrIParams_t **piparams);
+struct tplPropCache *wtiGetPropCache(wti_t *const pWti);
 #endif /* #ifndef WTI_H_INCLUDED */
@@ -0,0 +1,53 @@
+#!/bin/bash
+# Verify allowedSender ACLs with a large number of entries. The lists hold
+# 3000 CIDRs that do not cover the test sender. The allow list additionally
+# contains 127.0.0.1, the block list a non-matching hostname wildcard, which
+# must be evaluated after the prefix lookup failed.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+require_plugin imtcp
+
+export NUMMESSAGES=3
+TCP_ALLOW_LOG="${RSYSLOG_DYNNAME}.tcp-allow.log"
+TCP_BLOCK_LOG="${RSYSLOG_DYNNAME}.tcp-block.must-not-exist"
+
+CIDRS=""
+for i in $(seq 0 2999); do
+	CIDRS="$CIDRS\"10.$((i / 250)).$((i % 250)).0/24\","
+done
+
+generate_conf
+add_conf '
+module(load="../plugins/imtcp/.libs/imtcp")
+
+input(type="imtcp" address="127.0.0.1" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcp_allow_port"
+      allowedSender=['$CIDRS'"127.0.0.1"] ruleset="tcp_allow")
+input(type="imtcp" address="127.0.0.1" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcp_block_port"
+      allowedSender=['$CIDRS'"*.does-not-exist.invalid"] ruleset="tcp_block")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+ruleset(name="tcp_allow") {
+	action(type="omfile" template="outfmt" file="'$TCP_ALLOW_LOG'")
+}
+ruleset(name="tcp_block") {
+	action(type="omfile" template="outfmt" file="'$TCP_BLOCK_LOG'")
+}
+
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'")
+'
+startup
+
+assign_file_content TCP_ALLOW_PORT "${RSYSLOG_DYNNAME}.tcp_allow_port"
+assign_file_content TCP_BLOCK_PORT "${RSYSLOG_DYNNAME}.tcp_block_port"
+
+tcpflood -p"$TCP_ALLOW_PORT" -m"$NUMMESSAGES" -M "msgnum:tcp-allow"
+tcpflood --check-only -p"$TCP_BLOCK_PORT" -m1 -M "msgnum:tcp-block"
+tcpflood --check-only -p"$TCP_BLOCK_PORT" -m1 -M "msgnum:tcp-block"
+
+wait_file_lines "$TCP_ALLOW_LOG" "$NUMMESSAGES" 100
+shutdown_when_empty
+wait_shutdown
+
+content_check --regex "connection request from disallowed sender .* discarded"
+check_file_not_exists "$TCP_BLOCK_LOG"
+exit_test
@@ -0,0 +1,79 @@
+#!/bin/bash
+# Test the DA spill policies of a disk-assisted main queue via the da.*
+# impstats counters. The consumer is slowed down in all cases:
+# - adaptive, the queue keeps filling up: messages are paced in faster than
+#   they are consumed. queue.size is so large that the midpoint rule never
+#   applies, so only the time-to-full projection can start the spill, and
+#   the whole sequence is delivered through the batched DA transfer.
+# - adaptive, a burst far below queue.size that the workers catch up with:
+#   spilling must be deferred and nothing be written to disk.
+# - default (watermark) policy: the first crossing of the high watermark
+#   must spill, without any deferral.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+require_plugin impstats
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+export RSTB_IMDIAG_INJECT_DELAY_MODE=full
+
+# $1 - case name, $2 - queue size, $3 - additional main_queue() parameters,
+# $4 - main queue stats to wait for before shutdown. CONSUMER_USEC is the
+# per-message consumer delay.
+run_case() {
+	STATS_FILE="$PWD/${RSYSLOG_DYNNAME}.$1.stats.log"
+	rm -rf "$RSYSLOG_OUT_LOG" "${RSYSLOG_DYNNAME}.spool"
+	generate_conf
+	add_conf '
+module(load="../plugins/impstats/.libs/impstats" log.file="'$STATS_FILE'" interval="1")
+$ModLoad ../plugins/omtesting/.libs/omtesting
+global(workDirectory="'${RSYSLOG_DYNNAME}'.spool")
+main_queue(queue.type="LinkedList" queue.filename="mainq" queue.size="'$2'"
+	queue.highWatermark="800" queue.lowWatermark="400" '"$3"'
+	queue.timeoutShutdown="10000")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if ($msg contains "msgnum:") then {
+	:omtesting:sleep 0 '${CONSUMER_USEC}'
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+}
+'
+	startup
+	injectmsg
+	wait_file_lines
+	wait_content "main Q: .*$4" "$STATS_FILE"
+	shutdown_when_empty
+	wait_shutdown
+	seq_check
+}
+
+# $1 - counter, $2 - regex its value must match in the last main queue stats
+check_counter() {
+	value=$(grep 'main Q: ' "$STATS_FILE" | tail -1 | sed -n "s/.* $1=\([0-9]*\).*/\1/p")
+	if ! [[ "$value" =~ ^$2$ ]]; then
+		echo "FAIL: $1=$value in $STATS_FILE, expected $2"
+		cat "$STATS_FILE"
+		error_exit 1
+	fi
+}
+
+export NUMMESSAGES=4000
+export IMDIAG_INJECTMSG_DELAY_MS=1
+CONSUMER_USEC=2000
+run_case filling 100000 'queue.spillPolicy="adaptive" queue.spillHorizon="600000" queue.spillBatchSize="256"' \
+	'da.unspilled=[1-9]'
+unset IMDIAG_INJECTMSG_DELAY_MS
+check_counter da.spill.starts '[1-9][0-9]*'
+check_counter da.spilled '[1-9][0-9]*'
+check_counter da.unspilled '[1-9][0-9]*'
+
+export NUMMESSAGES=5000
+CONSUMER_USEC=100
+run_case burst 100000 'queue.spillPolicy="adaptive" queue.spillHorizon="1"' 'da.spill.deferred=[1-9]'
+check_counter da.spill.deferred '[1-9][0-9]*'
+check_counter da.spill.starts 0
+check_counter da.spilled 0
+
+export NUMMESSAGES=10000
+run_case watermark 2000 '' 'da.spilled=[1-9]'
+check_counter da.spill.starts '[1-9][0-9]*'
+check_counter da.spill.deferred 0
+check_counter da.spilled '[1-9][0-9]*'
+exit_test
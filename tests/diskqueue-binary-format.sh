@@ -0,0 +1,47 @@
+#!/bin/bash
+# Test switching the classic disk queue record format between restarts.
+# Object records written by the first instance must remain readable after
+# the queue is switched to the binary codec, and a queue file that holds
+# both record formats must drain completely once switched back.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+$ModLoad ../plugins/omtesting/.libs/omtesting
+
+global(workDirectory="'$RSYSLOG_DYNNAME'.spool")
+main_queue(queue.type="Disk" queue.filename="mainq"
+	queue.timeoutShutdown="1" queue.saveOnShutdown="on"
+	queue.diskRecordFormat=`echo $RSYSLOG_DISKQ_FORMAT`)
+
+$template outfmt,"%msg:F,58:2%\n"
+template(name="dynfile" type="string" string=`echo $RSYSLOG_OUT_LOG`) # trick to use relative path names!
+:msg, contains, "msgnum:" ?dynfile;outfmt
+
+$IncludeConfig '${RSYSLOG_DYNNAME}'work-delay.conf
+'
+echo "*.*     :omtesting:sleep 0 1000" > ${RSYSLOG_DYNNAME}work-delay.conf
+
+export RSYSLOG_DISKQ_FORMAT="object"
+startup
+injectmsg 0 2000
+shutdown_immediate
+wait_shutdown
+
+export RSYSLOG_DISKQ_FORMAT="binary"
+startup
+injectmsg 2000 2000
+shutdown_immediate
+wait_shutdown
+if ! cat "$RSYSLOG_DYNNAME".spool/mainq.0* | grep -qa $'\x1eRB1'; then
+	echo "FAIL: no binary record found in the disk queue files"
+	error_exit 1
+fi
+
+echo "#" > ${RSYSLOG_DYNNAME}work-delay.conf
+export RSYSLOG_DISKQ_FORMAT="object"
+startup
+shutdown_when_empty
+wait_shutdown
+seq_check 0 3999 -d
+exit_test
@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+# imkafka must fall back to a single consumer when consumer.threads is
+# requested without a consumergroup the broker could balance across.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+require_plugin imkafka
+
+generate_conf
+add_conf '
+module(load="../plugins/imkafka/.libs/imkafka")
+
+input(type="imkafka"
+      topic="static"
+      broker="127.0.0.1:9"
+      consumer.threads="4")
+'
+
+../tools/rsyslogd -N1 -f"${TESTCONF_NM}.conf" -M"$RSYSLOG_MODDIR" >"${RSYSLOG_DYNNAME}.log" 2>&1
+content_check "requires a consumergroup to distribute partitions" "${RSYSLOG_DYNNAME}.log"
+
+exit_test
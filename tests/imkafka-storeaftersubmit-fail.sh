@@ -0,0 +1,74 @@
+#!/bin/bash
+# imkafka with offset.storeAfterSubmit must not lose messages whose submission
+# to the rsyslog core failed: the failed burst has to be consumed again before
+# offsets of later bursts are stored. The ruleset's disk queue can not write
+# its first segment file at first (a directory is in the way), so submission
+# fails until the directory is removed. All messages must arrive afterwards.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+check_command_available kcat
+export KEEP_KAFKA_RUNNING="YES"
+
+export TESTMESSAGES=1000
+export TESTMESSAGESFULL=$TESTMESSAGES
+# Set EXTRA_EXITCHECK to dump kafka/zookeeperlogfiles on failure only.
+export EXTRA_EXITCHECK=dumpkafkalogs
+export EXTRA_EXIT=kafka
+
+RANDTOPIC="$(printf '%08x' "$(( (RANDOM<<16) ^ RANDOM ))")"
+export RANDTOPIC
+
+download_kafka
+stop_zookeeper
+stop_kafka
+
+start_zookeeper
+start_kafka
+wait_for_kafka_startup
+create_kafka_topic $RANDTOPIC '.dep_wrk' '22181'
+
+mkdir -p "$RSYSLOG_DYNNAME.spool/imkfail.00000001"
+
+generate_conf
+add_conf '
+global(workDirectory="'$RSYSLOG_DYNNAME.spool'")
+main_queue(queue.timeoutactioncompletion="60000" queue.timeoutshutdown="60000")
+
+module(load="../plugins/impstats/.libs/impstats" log.file="'$RSYSLOG_DYNNAME'.stats" interval="1")
+module(load="../plugins/imkafka/.libs/imkafka")
+input(	type="imkafka"
+	topic="'$RANDTOPIC'"
+	broker="127.0.0.1:29092"
+	consumergroup="storeaftersubmit-fail"
+	ruleset="kafka"
+	batchsize="10"
+	offset.storeAfterSubmit="on"
+	confParam=[ "compression.codec=none",
+		"session.timeout.ms=10000",
+		"socket.timeout.ms=5000",
+		"socket.keepalive.enable=true",
+		"reconnect.backoff.jitter.ms=1000",
+		"enable.partition.eof=false" ]
+	)
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+ruleset(name="kafka" queue.type="Disk" queue.filename="imkfail") {
+	if ($msg contains "msgnum:") then {
+		action( type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt" )
+	}
+}
+'
+startup
+injectmsg_kcat
+wait_content 'imkafka: origin=imkafka .*failures=[1-9]' "$RSYSLOG_DYNNAME.stats"
+rmdir "$RSYSLOG_DYNNAME.spool/imkfail.00000001"
+wait_seq_check 1 $TESTMESSAGESFULL -d
+shutdown_when_empty
+wait_shutdown
+
+delete_kafka_topic $RANDTOPIC '.dep_wrk' '22181'
+
+seq_check 1 $TESTMESSAGESFULL -d
+
+exit_test
@@ -0,0 +1,39 @@
+#!/bin/bash
+# checks that TLS reception works with a dedicated handshake worker pool and
+# that all handshakes are counted by it. A low handshake.maxPending is used so
+# that accepting is paused and resumed during the test.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+generate_conf
+add_conf '
+global(	defaultNetstreamDriverCAFile="'$srcdir/tls-certs/ca.pem'"
+	defaultNetstreamDriverCertFile="'$srcdir/tls-certs/cert.pem'"
+	defaultNetstreamDriverKeyFile="'$srcdir/tls-certs/key.pem'"
+)
+
+module(load="../plugins/impstats/.libs/impstats" log.file="'$RSYSLOG_DYNNAME'.stats" interval="1")
+module(	load="../plugins/imtcp/.libs/imtcp"
+	StreamDriver.Name="ossl"
+	StreamDriver.Mode="1"
+	StreamDriver.AuthMode="anon"
+	workerThreads="4"
+	handshake.workerThreads="2"
+	handshake.maxPending="2" )
+input(type="imtcp" name="hspool" address="127.0.0.1" port="0"
+	listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(	type="omfile"
+					template="outfmt"
+					file=`echo $RSYSLOG_OUT_LOG`)
+'
+startup
+tcpflood -p$TCPFLOOD_PORT -c20 -m$NUMMESSAGES -Ttls -x$srcdir/tls-certs/ca.pem -Z$srcdir/tls-certs/cert.pem -z$srcdir/tls-certs/key.pem
+wait_file_lines
+wait_for_stats_flush $RSYSLOG_DYNNAME.stats
+shutdown_when_empty
+wait_shutdown
+seq_check
+custom_content_check 'handshake/hspool: origin=imtcp completed=20 failed=0 ' $RSYSLOG_DYNNAME.stats
+exit_test
@@ -0,0 +1,43 @@
+#!/bin/bash
+# Check that the mmjsonparse fast-path builder and the json_tokener
+# fallback produce the same trees. The first messages use the strict
+# subset the fast path handles, the later ones need the fallback.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+module(load="../plugins/mmjsonparse/.libs/mmjsonparse")
+
+template(name="outfmt" type="string" string="parsesuccess=%parsesuccess% json=%$!%\n")
+
+if $msg contains "FINDJSON" then {
+    action(type="mmjsonparse" mode="find-json")
+} else {
+    action(type="mmjsonparse")
+}
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+startup
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":{"b":[1,-2,{"c":null}]},"t":true,"f":false}'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee: { "s" : "x\ny\"z" , "k\"ey" : "" }  '
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":1,"a":2}'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"u":"\u0041"}'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":1,}'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":1} extra'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":[1,2]]'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: FINDJSON {x} {"a":[1,{"b":"c"}]} tail'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: FINDJSON {"a": {"b":"c"} {"n":1}'
+shutdown_when_empty
+wait_shutdown
+
+export EXPECTED='parsesuccess=OK json={ "a": { "b": [ 1, -2, { "c": null } ] }, "t": true, "f": false }
+parsesuccess=OK json={ "s": "x\ny\"z", "k\"ey": "" }
+parsesuccess=OK json={ "a": 2 }
+parsesuccess=OK json={ "u": "A" }
+parsesuccess=OK json={ "a": 1 }
+parsesuccess=FAIL json={ "msg": "{\"a\":1} extra" }
+parsesuccess=FAIL json={ "msg": "{\"a\":[1,2]]" }
+parsesuccess=OK json={ "a": [ 1, { "b": "c" } ] }
+parsesuccess=OK json={ "b": "c" }'
+cmp_exact
+exit_test
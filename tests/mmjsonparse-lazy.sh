@@ -0,0 +1,36 @@
+#!/bin/bash
+# Check mmjsonparse lazy mode: properties are read from the deferred tree,
+# writes and full-tree access see the same content as an eager parse.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+module(load="../plugins/mmjsonparse/.libs/mmjsonparse")
+
+template(name="outfmt" type="string"
+	 string="a=%$!a% c=%$!b!c% n=%$!n% i=%$!i% s=%$!s% missing=%$!nope% all=%$!%\n")
+
+if $msg contains "FINDJSON" then {
+    action(type="mmjsonparse" mode="find-json" lazy="on")
+} else {
+    action(type="mmjsonparse" lazy="on")
+}
+if $!i == 42 then {
+    set $!a = "changed";
+}
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+startup
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":"x","b":{"c":"y"},"n":null,"i":42,"s":"q\"r"}'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":"x","b":{"c":"y"},"n":null,"i":7,"s":"q\"r"}'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: FINDJSON prefix {"a":"z","i":1} tail'
+injectmsg_literal '<167>Jan 16 16:57:54 host TAG: @cee:{"a":1,}'
+shutdown_when_empty
+wait_shutdown
+
+export EXPECTED='a=changed c=y n= i=42 s=q"r missing= all={ "a": "changed", "b": { "c": "y" }, "n": null, "i": 42, "s": "q\"r" }
+a=x c=y n= i=7 s=q"r missing= all={ "a": "x", "b": { "c": "y" }, "n": null, "i": 7, "s": "q\"r" }
+a=z c= n= i=1 s= missing= all={ "a": "z", "i": 1 }
+a=1 c= n= i= s= missing= all={ "a": 1 }'
+cmp_exact
+exit_test
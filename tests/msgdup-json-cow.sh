@@ -0,0 +1,30 @@
+#!/bin/bash
+# check that message variables shared between MsgDup() copies stay
+# independent when either copy modifies them afterwards
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+export SEQ_CHECK_FILE="$RSYSLOG_OUT_LOG"
+OUT2="${RSYSLOG_DYNNAME}.out2.log"
+generate_conf
+add_conf '
+template(name="dup" type="string" string="%$!n%\n")
+template(name="orig" type="string" string="%$!n%%$.v%\n")
+
+if $msg contains "msgnum" then {
+	set $!n = field($msg, 58, 2);
+	set $.v = "L";
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="dup"
+	       queue.type="linkedList" action.copymsg="on")
+	set $!n = "x";
+	unset $.v;
+	action(type="omfile" file="'$OUT2'" template="orig")
+}
+'
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+seq_check
+content_count_check --regex "^x$" $NUMMESSAGES "$OUT2"
+exit_test
@@ -0,0 +1,128 @@
+#!/bin/bash
+# Check the _bulk request bodies omelasticsearch posts. The batch buffer is
+# posted in place, so each body must consist of exactly the rendered
+# metadata and document lines of its batch: no terminating NUL and nothing
+# left over from the previous batch. maxbytes makes sure there are several
+# batches. The oracle is a local HTTP endpoint that captures all bodies.
+. ${srcdir:=.}/diag.sh init
+require_plugin omelasticsearch
+export NUMMESSAGES=100
+
+if ! command -v python3 >/dev/null 2>&1; then
+	printf 'SKIP: python3 is required for local omelasticsearch capture server\n'
+	skip_test
+fi
+
+cat > "$RSYSLOG_DYNNAME.capture-es.py" <<'PY'
+import http.server
+import json
+import pathlib
+import socketserver
+import sys
+
+base = pathlib.Path(sys.argv[1])
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_GET(self):
+        data = json.dumps({
+            'version': {
+                'number': '7.10.0',
+                'distribution': 'elasticsearch',
+                'build_flavor': 'default',
+            },
+            'tagline': 'You Know, for Search',
+        }).encode()
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def do_POST(self):
+        length = int(self.headers.get('Content-Length', '0'))
+        body = self.rfile.read(length)
+        with open(base.with_suffix('.bulk.bodies'), 'a') as f:
+            f.write(json.dumps(body.decode('latin-1')) + '\n')
+        items = ','.join(['{"index":{"status":201}}'] * (body.count(b'\n') // 2))
+        data = ('{"errors":false,"items":[' + items + ']}').encode()
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def log_message(self, fmt, *args):
+        return
+
+with socketserver.TCPServer(('127.0.0.1', 0), Handler) as httpd:
+    base.with_suffix('.capture.port').write_text(str(httpd.server_address[1]))
+    httpd.serve_forever()
+PY
+
+python3 "$RSYSLOG_DYNNAME.capture-es.py" "$RSYSLOG_DYNNAME" &
+capture_pid=$!
+cleanup_capture() {
+	kill "$capture_pid" 2>/dev/null || true
+	wait "$capture_pid" 2>/dev/null || true
+}
+trap cleanup_capture EXIT
+
+wait_file_exists "$RSYSLOG_DYNNAME.capture.port" 10
+capture_port=$(cat "$RSYSLOG_DYNNAME.capture.port")
+
+generate_conf
+add_conf '
+module(load="../plugins/omelasticsearch/.libs/omelasticsearch")
+template(name="msgTpl" type="string" string="{\"msgnum\":\"%msg:F,58:2%\"}")
+
+if $msg contains "msgnum:" then {
+action(type="omelasticsearch"
+       server="127.0.0.1"
+       serverport="'$capture_port'"
+       bulkmode="on"
+       maxbytes="1k"
+       searchIndex="rsyslog_testbench"
+       template="msgTpl"
+       esversion.major="7"
+       action.resumeRetryCount="0"
+       action.resumeInterval="1")
+}
+'
+
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+wait_file_exists "$RSYSLOG_DYNNAME.bulk.bodies" 10
+
+python3 - "$RSYSLOG_DYNNAME.bulk.bodies" "$NUMMESSAGES" <<'PY'
+import json
+import sys
+from pathlib import Path
+
+bodies = [json.loads(l) for l in Path(sys.argv[1]).read_text().splitlines()]
+msgnums = []
+if len(bodies) < 2:
+    raise SystemExit('expected several batches, got %d' % len(bodies))
+for body in bodies:
+    if '\0' in body:
+        raise SystemExit('NUL byte in bulk body: ' + repr(body))
+    if not body.endswith('\n'):
+        raise SystemExit('bulk body does not end with a newline: ' + repr(body))
+    lines = body[:-1].split('\n')
+    if len(lines) % 2 != 0:
+        raise SystemExit('odd bulk body line count: ' + repr(lines))
+    for metadata, document in zip(lines[0::2], lines[1::2]):
+        if json.loads(metadata)['index']['_index'] != 'rsyslog_testbench':
+            raise SystemExit('unexpected metadata line: ' + repr(metadata))
+        msgnums.append(int(json.loads(document)['msgnum']))
+if sorted(msgnums) != list(range(int(sys.argv[2]))):
+    raise SystemExit('unexpected messages: ' + repr(msgnums))
+PY
+if [ $? -ne 0 ]; then
+	error_exit 1
+fi
+
+exit_test
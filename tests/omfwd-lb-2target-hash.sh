@@ -0,0 +1,46 @@
+#!/bin/bash
+# Verify that pool.distribution="hash" routes all messages with the same key
+# to the same TCP target. All injected messages share one hostname, so one
+# receiver must get the complete sequence and the other none at all.
+# Released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+export NUMMESSAGES=1000
+
+start_minitcpsrvr $RSYSLOG_OUT_LOG  1
+start_minitcpsrvr $RSYSLOG2_OUT_LOG 2
+
+add_conf '
+$MainMsgQueueTimeoutShutdown 10000
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+template(name="hashkey" type="string" string="%hostname%")
+module(load="builtin:omfwd" template="outfmt")
+
+if $msg contains "msgnum:" then {
+	action(type="omfwd" target=["127.0.0.1", "127.0.0.1"]
+	                    port=["'$MINITCPSRVR_PORT1'", "'$MINITCPSRVR_PORT2'"]
+		protocol="tcp"
+		pool.distribution="hash" pool.hashtemplate="hashkey"
+		pool.resumeInterval="10"
+		action.resumeRetryCount="-1" action.resumeInterval="5")
+}
+'
+
+startup
+injectmsg
+shutdown_when_empty
+wait_shutdown
+
+touch "$RSYSLOG_OUT_LOG" "$RSYSLOG2_OUT_LOG"
+target1_actual="$(wc -l < "$RSYSLOG_OUT_LOG")"
+target2_actual="$(wc -l < "$RSYSLOG2_OUT_LOG")"
+if [ "$target1_actual" -ne 0 ] && [ "$target2_actual" -ne 0 ]; then
+	echo "ERROR: messages with the same key were split: $target1_actual / $target2_actual"
+	error_exit 100
+fi
+
+export SEQ_CHECK_FILE="$RSYSLOG_DYNNAME.log-combined"
+cat "$RSYSLOG_OUT_LOG" "$RSYSLOG2_OUT_LOG" > "$SEQ_CHECK_FILE"
+seq_check
+exit_test
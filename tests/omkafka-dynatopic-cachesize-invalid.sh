@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+# omkafka must reject a dynatopic cache that cannot hold a single topic
+# instead of creating an unusable topic cache.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+require_plugin omkafka
+
+generate_conf
+add_conf '
+module(load="../plugins/omkafka/.libs/omkafka")
+
+template(name="topic" type="string" string="%programname%")
+
+action(type="omkafka"
+       topic="topic"
+       dynatopic="on"
+       dynatopic.cachesize="0"
+       broker="127.0.0.1:9")
+'
+
+../tools/rsyslogd -N1 -f"${TESTCONF_NM}.conf" -M"$RSYSLOG_MODDIR" >"${RSYSLOG_DYNNAME}.log" 2>&1
+content_check "dynatopic.cachesize must be at least 1" "${RSYSLOG_DYNNAME}.log"
+
+exit_test
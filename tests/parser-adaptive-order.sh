@@ -0,0 +1,68 @@
+#!/bin/bash
+# check that parser.adaptiveOrder does not change parsing results. The same
+# messages are sent with the option off and on, and the outputs must match.
+# The chain contains overlapping parsers: rsyslog.rfc3164 also accepts what
+# rsyslog.lastline and rsyslog.rfc5424 accept, and those messages are sent
+# after rsyslog.rfc5424 has learned to reject the RFC3164 prefix. The hinted
+# counter of rsyslog.rfc3164 shows that parsers were actually skipped.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+require_plugin impstats
+
+# $1 - value of parser.adaptiveOrder
+run_case() {
+	STATS_FILE="$PWD/${RSYSLOG_DYNNAME}.$1.stats.log"
+	rm -f "$RSYSLOG_OUT_LOG"
+	generate_conf
+	add_conf '
+global(parser.adaptiveOrder="'$1'")
+module(load="../plugins/impstats/.libs/impstats" log.file="'$STATS_FILE'" interval="1")
+module(load="../plugins/pmlastmsg/.libs/pmlastmsg")
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" address="127.0.0.1" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port" ruleset="ruleset1")
+
+template(name="outfmt" type="string" string="%protocol-version%|%syslogtag%|%msg%\n")
+
+ruleset(name="ruleset1" parser=["rsyslog.lastline","rsyslog.rfc5424","rsyslog.rfc3164"]) {
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+}
+'
+	startup
+	tcpflood -m20 -M "\"<167>Mar  6 16:57:54 172.20.245.8 TAG: Rest of message...\""
+	tcpflood -m1 -M "\"<13>last message repeated 5 times\""
+	tcpflood -m1 -M "\"<167>Mar  6 16:57:55 172.20.245.8 TAG: after lastline\""
+	tcpflood -m1 -M "\"<34>1 2003-11-11T22:14:15.003Z mymachine.example.com su - ID47 rfc5424 message\""
+	tcpflood -m1 -M "\"<13>last message repeated 7 times\""
+	tcpflood -m1 -M "\"<167>Mar  6 16:57:56 172.20.245.8 TAG: after rfc5424\""
+	wait_file_lines "$RSYSLOG_OUT_LOG" 25
+	wait_content 'rsyslog.rfc3164: origin=core.parser .*successes=22 ' "$STATS_FILE"
+	shutdown_when_empty
+	wait_shutdown
+	mv "$RSYSLOG_OUT_LOG" "$RSYSLOG_OUT_LOG.$1"
+}
+
+run_case off
+run_case on
+
+cmp "$RSYSLOG_OUT_LOG.off" "$RSYSLOG_OUT_LOG.on"
+if [ ! $? -eq 0 ]; then
+	echo "results differ from the configured order:"
+	diff "$RSYSLOG_OUT_LOG.off" "$RSYSLOG_OUT_LOG.on"
+	error_exit 1
+fi
+
+content_count_check --regex '|last message repeated [57] times$' 2 "$RSYSLOG_OUT_LOG.on"
+content_count_check '|rfc5424 message' 1 "$RSYSLOG_OUT_LOG.on"
+content_count_check '|TAG:|' 22 "$RSYSLOG_OUT_LOG.on"
+
+if ! grep -q 'rsyslog.rfc3164: origin=core.parser .*hinted=[1-9]' "$PWD/${RSYSLOG_DYNNAME}.on.stats.log"; then
+	echo "FAIL: no hinted parse in the stats with parser.adaptiveOrder=on"
+	cat "$PWD/${RSYSLOG_DYNNAME}.on.stats.log"
+	error_exit 1
+fi
+if grep -q 'origin=core.parser .*hinted=[1-9]' "$PWD/${RSYSLOG_DYNNAME}.off.stats.log"; then
+	echo "FAIL: hinted parse in the stats with parser.adaptiveOrder=off"
+	cat "$PWD/${RSYSLOG_DYNNAME}.off.stats.log"
+	error_exit 1
+fi
+exit_test
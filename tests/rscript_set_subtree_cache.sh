@@ -0,0 +1,30 @@
+#!/bin/bash
+# check that cached JSON parent lookups see set/unset/reset of the subtree
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%$!a!b!c% %$!a!b!d% %$.x!y%\n")
+
+if $msg contains "msgnum" then {
+	set $!a!b!c = "1";
+	set $!a!b!d = "2";
+	set $.x!y = "q";
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+	unset $!a;
+	set $!a!b!c = "3";
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+	reset $!a!b!d = "4";
+	unset $.x;
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg 0 1
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='1 2 q
+3  q
+3 4 '
+cmp_exact
+exit_test
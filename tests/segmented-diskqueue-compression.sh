@@ -0,0 +1,62 @@
+#!/bin/bash
+# Verify queue.segmentCompression="zstd": sealed segments of a blocked
+# segmentedDisk backlog are rewritten compressed, and every record is
+# delivered from the compressed segments after a restart.
+# This file is part of the rsyslog project, released under ASL 2.0.
+. ${srcdir:=.}/diag.sh init
+require_plugin impstats
+export NUMMESSAGES=20000
+SPOOL_DIR="${RSYSLOG_DYNNAME}.spool"
+STATS_FILE="$PWD/${RSYSLOG_DYNNAME}.stats.log"
+
+write_conf() {
+	generate_conf
+	add_conf '
+module(load="../plugins/omtesting/.libs/omtesting")
+module(load="../plugins/impstats/.libs/impstats" log.file="'"$STATS_FILE"'"
+	interval="1" resetCounters="off" ruleset="stats")
+ruleset(name="stats") { stop }
+global(workDirectory="'"$SPOOL_DIR"'")
+main_queue(
+	queue.type="segmentedDisk"
+	queue.filename="mainq"
+	queue.maxFileSize="256k"
+	queue.segmentCompression="zstd"
+	queue.dequeueBatchSize="256"
+	queue.saveOnShutdown="on"
+)
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+'"$1"'
+if ($msg contains "msgnum:") then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+}
+
+write_conf ':omtesting:sleep 10 0'
+startup
+injectmsg 0 "$NUMMESSAGES"
+# stats are cumulative; wait for an interval that covers the injection
+./msleep 2500
+segments=$(grep 'main Q: origin=core.queue' "$STATS_FILE" | tail -n 1 |
+	sed -E 's/.*compression\.segments=([0-9]+).*/\1/')
+saved=$(grep 'main Q: origin=core.queue' "$STATS_FILE" | tail -n 1 |
+	sed -E 's/.*compression\.savedBytes=([0-9]+).*/\1/')
+if [ -z "$segments" ] || [ "$segments" -eq 0 ] || [ -z "$saved" ] || [ "$saved" -eq 0 ]; then
+	echo "FAIL: no sealed segment was compressed"
+	cat "$STATS_FILE"
+	error_exit 1
+fi
+shutdown_immediate
+. "$srcdir/diag.sh" kill-immediate
+wait_shutdown
+rm -f "$RSYSLOG_OUT_LOG"
+
+write_conf '# no delay on restart'
+startup
+wait_seq_check 0 $((NUMMESSAGES - 1)) -d
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 1)) -d
+rm -rf "${RSYSLOG_DYNNAME}.spool"
+exit_test
@@ -1,7 +1,7 @@
 #!/bin/bash
 # Exercise segmentedDisk with syncQueueFiles enabled. Exact sequence delivery
-# plus forced-state-write statistics prove the synchronous durability path is
-# active without relying on timing.
+# plus forced-state-write and group-commit statistics prove the synchronous
+# durability path is active without relying on timing.
 . ${srcdir:=.}/diag.sh init
 require_plugin impstats
 export NUMMESSAGES=1000
@@ -20,9 +20,16 @@ if ($msg contains "msgnum:") then
 '
 startup
 injectmsg
+# let one stats interval cover the injected records
+./msleep 1500
 shutdown_when_empty
 wait_shutdown
 seq_check
 wait_content 'state.forcedWrites=' "$STATS_FILE"
+if ! grep -q 'sync\.groupCommits=[1-9]' "$STATS_FILE"; then
+	echo "FAIL: records were not synced by group commit"
+	cat "$STATS_FILE"
+	error_exit 1
+fi
 rm -rf "${RSYSLOG_DYNNAME}.spool"
 exit_test
@@ -0,0 +1,48 @@
+#!/bin/bash
+# Drain a restart backlog with several segmentedDisk workers. Batches are
+# decoded outside the queue lock and completed out of order; every record
+# must still be delivered and the queue must shut down empty.
+# This file is part of the rsyslog project, released under ASL 2.0.
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+SPOOL_DIR="${RSYSLOG_DYNNAME}.spool"
+
+write_conf() {
+	generate_conf
+	add_conf '
+module(load="../plugins/omtesting/.libs/omtesting")
+global(workDirectory="'"$SPOOL_DIR"'")
+main_queue(
+	queue.type="segmentedDisk"
+	queue.filename="mainq"
+	queue.maxFileSize="256k"
+	queue.dequeueBatchSize="64"
+	queue.workerThreads="4"
+	queue.workerThreadMinimumMessages="64"
+	queue.checkpointInterval="16"
+	queue.saveOnShutdown="on"
+)
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+'"$1"'
+if ($msg contains "msgnum:") then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+}
+
+write_conf ':omtesting:sleep 10 0'
+startup
+injectmsg 0 "$NUMMESSAGES"
+shutdown_immediate
+. "$srcdir/diag.sh" kill-immediate
+wait_shutdown
+rm -f "$RSYSLOG_OUT_LOG"
+
+write_conf '# no delay on restart'
+startup
+wait_seq_check 0 $((NUMMESSAGES - 1)) -d
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 1)) -d
+rm -rf "${RSYSLOG_DYNNAME}.spool"
+exit_test
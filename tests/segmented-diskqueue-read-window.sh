@@ -0,0 +1,68 @@
+#!/bin/bash
+# Verify that segmentedDisk drains a restart backlog through its read window:
+# every record is delivered and the number of dequeue reads stays far below
+# one per record. The first instance is killed with its output blocked so the
+# backlog is only read back after restart.
+# This file is part of the rsyslog project, released under ASL 2.0.
+. ${srcdir:=.}/diag.sh init
+require_plugin impstats
+export NUMMESSAGES=20000
+SPOOL_DIR="${RSYSLOG_DYNNAME}.spool"
+STATS_FILE="$PWD/${RSYSLOG_DYNNAME}.stats.log"
+
+write_conf() {
+	generate_conf
+	add_conf '
+module(load="../plugins/omtesting/.libs/omtesting")
+module(load="../plugins/impstats/.libs/impstats" log.file="'"$STATS_FILE"'"
+	interval="1" resetCounters="off" ruleset="stats")
+ruleset(name="stats") { stop }
+global(workDirectory="'"$SPOOL_DIR"'")
+main_queue(
+	queue.type="segmentedDisk"
+	queue.filename="mainq"
+	queue.maxFileSize="256k"
+	queue.dequeueBatchSize="256"
+	queue.saveOnShutdown="on"
+)
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+'"$1"'
+if ($msg contains "msgnum:") then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+}
+
+write_conf ':omtesting:sleep 10 0'
+startup
+injectmsg 0 "$NUMMESSAGES"
+shutdown_immediate
+. "$srcdir/diag.sh" kill-immediate
+wait_shutdown
+rm -f "$RSYSLOG_OUT_LOG"
+
+write_conf '# no delay on restart'
+: > "$STATS_FILE"
+startup
+wait_seq_check 0 $((NUMMESSAGES - 1)) -d
+# stats are cumulative; wait for an interval that covers the full drain
+./msleep 2500
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $((NUMMESSAGES - 1)) -d
+
+read_calls=$(grep 'main Q: origin=core.queue' "$STATS_FILE" | tail -n 1 |
+	sed -E 's/.*read\.calls=([0-9]+).*/\1/')
+if [ -z "$read_calls" ] || [ "$read_calls" -eq 0 ]; then
+	echo "FAIL: main queue did not report read.calls"
+	cat "$STATS_FILE"
+	error_exit 1
+fi
+if [ "$read_calls" -gt $((NUMMESSAGES / 20)) ]; then
+	printf 'FAIL: draining %d records took %d reads; expected batched window reads\n' \
+		"$NUMMESSAGES" "$read_calls"
+	cat "$STATS_FILE"
+	error_exit 1
+fi
+rm -rf "${RSYSLOG_DYNNAME}.spool"
+exit_test
@@ -0,0 +1,71 @@
+#!/bin/bash
+# testing sending and receiving via TLS with anon auth, rebind and session
+# resumption. The sender reconnects every 1000 messages, those reconnects
+# must resume the previous TLS session.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=25000
+export QUEUE_EMPTY_CHECK_FUNC=wait_file_lines
+
+#receiver
+generate_conf
+add_conf '
+global(
+	defaultNetstreamDriverCAFile="'$srcdir/testsuites/x.509/ca.pem'"
+	defaultNetstreamDriverCertFile="'$srcdir/testsuites/x.509/client-cert.pem'"
+	defaultNetstreamDriverKeyFile="'$srcdir/testsuites/x.509/client-key.pem'"
+	defaultNetstreamDriver="ossl"
+)
+
+module(load="../plugins/impstats/.libs/impstats" log.file="'$RSYSLOG_DYNNAME'.stats" interval="1")
+module(	load="../plugins/imtcp/.libs/imtcp"
+	StreamDriver.Name="ossl"
+	StreamDriver.Mode="1"
+	StreamDriver.AuthMode="anon" )
+# then SENDER sends to this port (not tcpflood!)
+input(type="imtcp" address="127.0.0.1" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(	type="omfile"
+					template="outfmt"
+					file="'$RSYSLOG_OUT_LOG'")
+'
+startup
+
+#sender
+export PORT_RCVR=$TCPFLOOD_PORT # save TCPFLOOD_PORT, generate_conf will overwrite it!
+generate_conf 2
+add_conf '
+global(
+	defaultNetstreamDriverCAFile="'$srcdir/testsuites/x.509/ca.pem'"
+	defaultNetstreamDriverCertFile="'$srcdir/testsuites/x.509/client-cert.pem'"
+	defaultNetstreamDriverKeyFile="'$srcdir/testsuites/x.509/client-key.pem'"
+	defaultNetstreamDriver="ossl"
+	netstreamDriver.sessionResumption="on"
+)
+
+*.*	action(type="omfwd" target="127.0.0.1" port="'$PORT_RCVR'" protocol="tcp"
+		StreamDriver="ossl" StreamDriverMode="1" StreamDriverAuthMode="anon"
+		RebindInterval="1000")
+' 2
+startup 2
+
+# now inject the messages into instance 2. It will connect to instance 1,
+# and that instance will record the data.
+injectmsg2
+shutdown_when_empty 2
+wait_shutdown 2
+wait_for_stats_flush $RSYSLOG_DYNNAME.stats
+# now it is time to stop the receiver as well
+shutdown_when_empty
+wait_shutdown
+
+export SEQ_CHECK_OPTIONS=-d
+seq_check
+if ! grep -q 'nsd_ossl: origin=nsd_ossl .*sessions.resumed=[1-9]' $RSYSLOG_DYNNAME.stats; then
+	echo "FAIL: receiver did not resume any TLS session, stats:"
+	cat -n $RSYSLOG_DYNNAME.stats
+	error_exit 1
+fi
+
+exit_test
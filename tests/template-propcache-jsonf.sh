@@ -0,0 +1,39 @@
+#!/bin/bash
+# check that jsonf properties which only differ in their outname do not share
+# a property cache value, as the field name is part of the rendered value.
+# The templates must not use option.jsonf: those are rendered without a
+# render plan and thus never get a property cache column.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="first" type="list") {
+	constant(value="{")
+	property(outname="first" name="msg" format="jsonf")
+	constant(value="}\n")
+}
+template(name="second" type="list") {
+	constant(value="{")
+	property(outname="second" name="msg" format="jsonf")
+	constant(value="}\n")
+}
+template(name="third" type="list") {
+	constant(value="{")
+	property(outname="third" name="msg" format="jsonfr")
+	constant(value="}\n")
+}
+
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="first")
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="second")
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="third")
+'
+startup
+injectmsg_literal '<167>2003-01-16T16:57:54 host TAG: msgnum:1'
+shutdown_when_empty
+wait_shutdown
+
+export EXPECTED='{"first":" msgnum:1"}
+{"second":" msgnum:1"}
+{"third":" msgnum:1"}'
+cmp_exact
+exit_test
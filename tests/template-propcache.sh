@@ -0,0 +1,30 @@
+#!/bin/bash
+# check that template property values shared between actions are refreshed
+# when message variables are set and after a message modification module ran
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+module(load="../plugins/mmjsonparse/.libs/mmjsonparse")
+
+template(name="outfmt" type="string" string="%$!x%|%msg:::uppercase%|%timereported:::date-year%\n")
+template(name="other" type="string" string="%timereported:::date-year% %msg:::uppercase%\n")
+
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="other")
+set $!x = "1";
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+action(type="mmjsonparse" cookie="")
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+startup
+injectmsg_literal '<167>2003-01-16T16:57:54 host TAG: {"x":"2"}'
+shutdown_when_empty
+wait_shutdown
+
+export EXPECTED='| {"X":"2"}|2003
+2003  {"X":"2"}
+1| {"X":"2"}|2003
+2| {"X":"2"}|2003'
+cmp_exact
+exit_test
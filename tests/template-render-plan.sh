@@ -0,0 +1,33 @@
+#!/bin/bash
+# check list templates rendered via compiled plans: merged constants,
+# direct msg/hostname fetch, escaping, generic fields and buffer growth
+# This is part of the rsyslog testbench, licensed under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="list" option.sql="on") {
+	constant(value="[")
+	constant(value="h=")
+	property(name="hostname")
+	constant(value=" ")
+	property(name="msg")
+	constant(value="|")
+	property(name="syslogtag" caseconversion="upper")
+	constant(value="]\n")
+}
+if $syslogtag == "app" then {
+	action(type="omfile" template="outfmt" file="'${RSYSLOG_OUT_LOG}'")
+}
+'
+startup
+LONGMSG=$(printf 'x%.0s' $(seq 1 3000))
+injectmsg_literal "<165>1 2003-03-01T01:00:00.000Z host app - - - it's short"
+injectmsg_literal "<165>1 2003-03-01T01:00:00.000Z host app - - - $LONGMSG"
+injectmsg_literal "<165>1 2003-03-01T01:00:00.000Z h2 app - - - end"
+shutdown_when_empty
+wait_shutdown
+export EXPECTED="[h=host it\\'s short|APP]
+[h=host $LONGMSG|APP]
+[h=h2 end|APP]"
+cmp_exact
+exit_test
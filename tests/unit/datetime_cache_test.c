@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+/*
+ * Copyright 2026 Rainer Gerhards and Adiscon GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+/**
+ * @file datetime_cache_test.c
+ * @brief Differential coverage for the per-thread timestamp cache.
+ *
+ * Pseudo-random timestamps, mostly sharing a second, are formatted, converted
+ * and parsed with the cache enabled and once more with it disabled. The oracle
+ * is the uncached result, which must match byte for byte. The seed is fixed,
+ * so a failure can be reproduced.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* Keep the static helpers unit-testable without linking the runtime. */
+#include "../../runtime/datetime.c"
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            fprintf(stderr, "CHECK failed at %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1);                                                                        \
+        }                                                                                   \
+    } while (0)
+
+#define NUM_ROUNDS 200000
+
+/* stubs for the runtime symbols datetime.c references */
+int Debug = 0;
+rsconf_t *runConf = NULL;
+#ifndef DEBUGLESS
+void r_dbgprintf(const char *srcname, const char *fmt, ...) {}
+#endif
+void LogError(const int iErrno, const int iErrCode, const char *fmt, ...) {}
+tzinfo_t *glblFindTimezone(rsconf_t *cnf, char *id) {
+    return NULL;
+}
+rsRetVal objGetObjInterface(obj_if_t *pIf) {
+    return RS_RET_NOT_IMPLEMENTED;
+}
+
+static uint32_t rngState = 2463534242u;
+
+static uint32_t rnd(const uint32_t n) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % n;
+}
+
+/* change the timestamp a little: usually only the fraction, sometimes one of
+ * the fields that are part of the cache keys.
+ */
+static void nextTime(struct syslogTime *ts) {
+    static const char offsModes[] = {'+', '-', 'Z'};
+    int i;
+
+    switch (rnd(16)) {
+        case 0:
+            ts->year = (rnd(8) == 0) ? 1960 + rnd(150) : 2000 + rnd(38);
+            break;
+        case 1:
+            ts->month = 1 + rnd(12);
+            break;
+        case 2:
+            ts->day = 1 + rnd(31);
+            break;
+        case 3:
+            ts->hour = rnd(24);
+            break;
+        case 4:
+            ts->minute = rnd(60);
+            break;
+        case 5:
+        case 6:
+            ts->second = rnd(61);
+            break;
+        case 7:
+            ts->OffsetMode = offsModes[rnd(3)];
+            ts->OffsetHour = rnd(15);
+            ts->OffsetMinute = rnd(4) * 15;
+            break;
+        default:
+            break;
+    }
+    ts->secfracPrecision = rnd(7);
+    ts->secfrac = 0;
+    for (i = 0; i < ts->secfracPrecision; ++i) ts->secfrac = ts->secfrac * 10 + rnd(10);
+}
+
+static void checkFormatters(struct syslogTime *ts) {
+    char cached[64];
+    char plain[64];
+    int bBuggyDay = rnd(2);
+    time_t tCached;
+    int len;
+
+    bHaveKeyTsCache = 1;
+    len = formatTimestamp3339(ts, cached);
+    bHaveKeyTsCache = 0;
+    CHECK(formatTimestamp3339(ts, plain) == len);
+    CHECK(strcmp(cached, plain) == 0);
+
+    bHaveKeyTsCache = 1;
+    len = formatTimestamp3164(ts, cached, bBuggyDay);
+    bHaveKeyTsCache = 0;
+    CHECK(formatTimestamp3164(ts, plain, bBuggyDay) == len);
+    CHECK(strcmp(cached, plain) == 0);
+
+    bHaveKeyTsCache = 1;
+    len = formatTimestampToMySQL(ts, cached);
+    bHaveKeyTsCache = 0;
+    CHECK(formatTimestampToMySQL(ts, plain) == len);
+    CHECK(strcmp(cached, plain) == 0);
+
+    bHaveKeyTsCache = 1;
+    len = formatTimestampToPgSQL(ts, cached);
+    bHaveKeyTsCache = 0;
+    CHECK(formatTimestampToPgSQL(ts, plain) == len);
+    CHECK(strcmp(cached, plain) == 0);
+
+    bHaveKeyTsCache = 1;
+    tCached = syslogTime2time_t(ts);
+    bHaveKeyTsCache = 0;
+    CHECK(syslogTime2time_t(ts) == tCached);
+}
+
+/* occasionally damage a rendered timestamp, so the rejection paths are
+ * compared as well.
+ */
+static void mangle(char *const buf) {
+    const size_t len = strlen(buf);
+    static const char junk[] = "0a9: -T.Z+";
+
+    if (len == 0) return;
+    switch (rnd(8)) {
+        case 0:
+            buf[rnd(len)] = junk[rnd(sizeof(junk) - 1)];
+            break;
+        case 1:
+            buf[rnd(len)] = '\0';
+            break;
+        default:
+            break;
+    }
+}
+
+/* parse buf with the cache enabled and disabled and compare all results */
+static void checkParser(const char *const buf, const int b3164, const int bDetectYear) {
+    struct syslogTime tCached;
+    struct syslogTime tPlain;
+    uchar *pCached = (uchar *)buf;
+    uchar *pPlain = (uchar *)buf;
+    int lenCached = strlen(buf);
+    int lenPlain = lenCached;
+    rsRetVal retCached;
+    rsRetVal retPlain;
+
+    memset(&tCached, 0, sizeof(tCached));
+    memset(&tPlain, 0, sizeof(tPlain));
+    bHaveKeyTsCache = 1;
+    if (b3164)
+        retCached = ParseTIMESTAMP3164(&tCached, &pCached, &lenCached, NO_PARSE3164_TZSTRING, bDetectYear);
+    else
+        retCached = ParseTIMESTAMP3339(&tCached, &pCached, &lenCached);
+    bHaveKeyTsCache = 0;
+    if (b3164)
+        retPlain = ParseTIMESTAMP3164(&tPlain, &pPlain, &lenPlain, NO_PARSE3164_TZSTRING, bDetectYear);
+    else
+        retPlain = ParseTIMESTAMP3339(&tPlain, &pPlain, &lenPlain);
+
+    CHECK(retCached == retPlain);
+    CHECK(pCached == pPlain);
+    CHECK(lenCached == lenPlain);
+    CHECK(memcmp(&tCached, &tPlain, sizeof(tCached)) == 0);
+}
+
+static void checkParsers(struct syslogTime *ts) {
+    static const char *const suffixes[] = {" host msg", "", "1 host", ":x", " 2026 12:00:00 x"};
+    char ts3339[64];
+    char ts3164[64];
+    char buf[128];
+
+    bHaveKeyTsCache = 0;
+    formatTimestamp3339(ts, ts3339);
+    formatTimestamp3164(ts, ts3164, rnd(2));
+
+    snprintf(buf, sizeof(buf), "%s%s", ts3339, suffixes[rnd(5)]);
+    mangle(buf);
+    checkParser(buf, 0, 0);
+
+    snprintf(buf, sizeof(buf), "%s%s", ts3164, suffixes[rnd(5)]);
+    mangle(buf);
+    checkParser(buf, 1, rnd(2));
+}
+
+int main(void) {
+    struct syslogTime ts;
+    int i;
+
+    memset(&ts, 0, sizeof(ts));
+    ts.timeType = 2;
+    ts.year = 2026;
+    ts.month = 10;
+    ts.day = 19;
+    ts.OffsetMode = '+';
+
+    tsCacheInit();
+    CHECK(bHaveKeyTsCache);
+    for (i = 0; i < NUM_ROUNDS; ++i) {
+        nextTime(&ts);
+        checkFormatters(&ts);
+        checkParsers(&ts);
+    }
+
+    /* the class exit must release the key and the calling thread's cache */
+    bHaveKeyTsCache = 1;
+    CHECK(getTsCache() != NULL);
+    tsCacheExit();
+    CHECK(!bHaveKeyTsCache);
+    CHECK(getTsCache() == NULL);
+
+    printf("datetime cache: %d rounds without difference\n", NUM_ROUNDS);
+    return 0;
+}
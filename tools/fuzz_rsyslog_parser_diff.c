@@ -0,0 +1,151 @@
+/*
+ * Differential fuzz target for the RFC 3164 and RFC 5424 parser fast paths.
+ * Every input is parsed twice by each parser, once with the header fast
+ * path enabled and once with the byte-by-byte code only. Any difference in
+ * the return code or in the resulting message properties aborts.
+ */
+#include "config.h"
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rsyslog.h"
+#include "msg.h"
+#include "parser.h"
+#include "pmrfc3164.h"
+#include "pmrfc5424.h"
+#include "rsconf.h"
+#include "stringbuf.h"
+
+DEFobjCurrIf(obj);
+
+static void fuzzAbortOnError(const rsRetVal ret) {
+    if (ret != RS_RET_OK) abort();
+}
+
+static void fuzzCleanup(void) {
+    pmrfc5424FuzzExit();
+    pmrfc3164FuzzExit();
+    fuzzAbortOnError(rsrtExit());
+}
+
+static void fuzzCmpStr(const char *const what, const uchar *const a, const uchar *const b) {
+    if (a == NULL && b == NULL) return;
+    if (a == NULL || b == NULL || strcmp((const char *)a, (const char *)b)) {
+        fprintf(stderr, "fast path mismatch in %s: '%s' vs '%s'\n", what, a == NULL ? "(null)" : (const char *)a,
+                b == NULL ? "(null)" : (const char *)b);
+        abort();
+    }
+}
+
+static const uchar *fuzzCStr(cstr_t *const pStr) {
+    return (pStr == NULL) ? NULL : rsCStrGetSzStrNoNULL(pStr);
+}
+
+static smsg_t *fuzzParse(const uint8_t *data,
+                         const size_t size,
+                         rsRetVal (*parseFn)(smsg_t *),
+                         void (*setFastPathFn)(const int),
+                         const int bFastPath,
+                         rsRetVal *pRet) {
+    smsg_t *msg = NULL;
+
+    fuzzAbortOnError(msgConstruct(&msg));
+    MsgSetRawMsg(msg, (const char *)data, size);
+    msg->msgFlags = NEEDS_PARSING | PARSE_HOSTNAME;
+    fuzzAbortOnError(parserParsePRI(msg));
+    /* both runs must see the same reception time, IGNDATE is not set */
+    memset(&msg->tRcvdAt, 0, sizeof(msg->tRcvdAt));
+    memset(&msg->tTIMESTAMP, 0, sizeof(msg->tTIMESTAMP));
+
+    setFastPathFn(bFastPath);
+    *pRet = parseFn(msg);
+    setFastPathFn(1);
+    return msg;
+}
+
+static void fuzzDiffParser(const uint8_t *data,
+                           const size_t size,
+                           rsRetVal (*parseFn)(smsg_t *),
+                           void (*setFastPathFn)(const int)) {
+    smsg_t *fast;
+    smsg_t *slow;
+    rsRetVal retFast;
+    rsRetVal retSlow;
+    uchar *tagFast;
+    uchar *tagSlow;
+    int lenTagFast;
+    int lenTagSlow;
+    uchar *sdFast;
+    uchar *sdSlow;
+    rs_size_t lenSdFast;
+    rs_size_t lenSdSlow;
+
+    fast = fuzzParse(data, size, parseFn, setFastPathFn, 1, &retFast);
+    slow = fuzzParse(data, size, parseFn, setFastPathFn, 0, &retSlow);
+
+    if (retFast != retSlow || fast->offMSG != slow->offMSG || fast->iProtocolVersion != slow->iProtocolVersion ||
+        memcmp(&fast->tTIMESTAMP, &slow->tTIMESTAMP, sizeof(fast->tTIMESTAMP))) {
+        fprintf(stderr, "fast path mismatch: ret %d/%d offMSG %d/%d\n", retFast, retSlow, fast->offMSG, slow->offMSG);
+        abort();
+    }
+    if (getHOSTNAMELen(fast) != getHOSTNAMELen(slow) ||
+        memcmp(getHOSTNAME(fast), getHOSTNAME(slow), getHOSTNAMELen(fast))) {
+        fprintf(stderr, "fast path mismatch in HOSTNAME\n");
+        abort();
+    }
+    getTAG(fast, &tagFast, &lenTagFast, LOCK_MUTEX);
+    getTAG(slow, &tagSlow, &lenTagSlow, LOCK_MUTEX);
+    if (lenTagFast != lenTagSlow || memcmp(tagFast, tagSlow, lenTagFast)) {
+        fprintf(stderr, "fast path mismatch in TAG\n");
+        abort();
+    }
+    fuzzCmpStr("APP-NAME", fuzzCStr(fast->pCSAPPNAME), fuzzCStr(slow->pCSAPPNAME));
+    fuzzCmpStr("PROCID", fuzzCStr(fast->pCSPROCID), fuzzCStr(slow->pCSPROCID));
+    fuzzCmpStr("MSGID", fuzzCStr(fast->pCSMSGID), fuzzCStr(slow->pCSMSGID));
+    MsgGetStructuredData(fast, &sdFast, &lenSdFast);
+    MsgGetStructuredData(slow, &sdSlow, &lenSdSlow);
+    if (lenSdFast != lenSdSlow || memcmp(sdFast, sdSlow, lenSdFast)) {
+        fprintf(stderr, "fast path mismatch in STRUCTURED-DATA\n");
+        abort();
+    }
+
+    fuzzAbortOnError(msgDestruct(&fast));
+    fuzzAbortOnError(msgDestruct(&slow));
+}
+
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerInitialize(int *argc __attribute__((unused)), char ***argv) {
+    const char *errObj = "rsyslog runtime";
+    const char *slash;
+    static char modulePath[PATH_MAX];
+    int len;
+
+    slash = strrchr((*argv)[0], '/');
+    if (slash == NULL) {
+        len = snprintf(modulePath, sizeof(modulePath), "runtime/.libs");
+    } else {
+        len = snprintf(modulePath, sizeof(modulePath), "%.*s/../runtime/.libs", (int)(slash - (*argv)[0]), (*argv)[0]);
+    }
+    if (len < 0 || (size_t)len >= sizeof(modulePath) || setenv("RSYSLOG_MODDIR", modulePath, 1) != 0) abort();
+
+    fuzzAbortOnError(rsrtInit(&errObj, &obj));
+    fuzzAbortOnError(pmrfc3164FuzzInit());
+    fuzzAbortOnError(pmrfc5424FuzzInit());
+    if (atexit(fuzzCleanup) != 0) abort();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, const size_t size) {
+    if (size > INT_MAX) return 0;
+
+    fuzzDiffParser(data, size, pmrfc3164FuzzParse, pmrfc3164FuzzSetFastPath);
+    fuzzDiffParser(data, size, pmrfc5424FuzzParse, pmrfc5424FuzzSetFastPath);
+    return 0;
+}
@@ -37,6 +37,7 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 #include <zlib.h>
 #ifdef ENABLE_LIBZSTD
     #include <zstd.h>
@@ -157,6 +158,11 @@ typedef struct _instanceData {
     uint8_t compressionMode;
     sbool strmCompFlushOnTxEnd; /* flush stream compression on transaction end? */
     unsigned poolResumeInterval;
+#define POOL_DISTRIB_ROUNDROBIN 0
+#define POOL_DISTRIB_HASH 1 /* sticky, keyed by pool.hashtemplate */
+    int poolDistribution;
+    uchar *pszHashTplName; /* template rendering the distribution key */
+    int iNumTpls; /* 2 if the hash key template is requested */
     int ratelimitInterval;
     int ratelimitBurst;
     uchar *pszRatelimitName;
@@ -187,6 +193,20 @@ typedef struct targetData {
     int offsSndBuf; /* next free spot in send buffer */
     time_t ttResume;
     targetStats_t *pTargetStats;
+    uint64_t hashSeed; /* rendezvous hashing seed, derived from target and port */
+    sbool bHashTried; /* already tried for the current message (hash distribution) */
+/* gather list used instead of sndBuf copies if the stream driver can write iovecs.
+ * Entries point into the action's template strings and are only valid during
+ * commitTransaction(); anything not sent by then is copied into sndBuf.
+ */
+#define OMFWD_VEC_MAX_IOV 256 /* well below IOV_MAX, one writev() per batch */
+#define OMFWD_VEC_META_SIZE 2048 /* octet-count headers and delimiters */
+    sbool bVecSend; /* connection supports gather writes (plain TCP, no compression) */
+    int nVecIov; /* pending entries in vecIov */
+    int lenVecMeta; /* used bytes in vecMeta */
+    size_t lenVecPending; /* octets described by vecIov */
+    struct iovec vecIov[OMFWD_VEC_MAX_IOV];
+    uchar vecMeta[OMFWD_VEC_META_SIZE];
 /* sndBuf buffer size is intensionally fixed -- see no good reason to make configurable */
 #define SNDBUF_FIXED_BUFFER_SIZE (16 * 1024)
     uchar sndBuf[SNDBUF_FIXED_BUFFER_SIZE];
@@ -198,6 +218,7 @@ typedef struct wrkrInstanceData {
     int nXmit; /* number of transmissions since last (re-)bind */
     unsigned actualTarget;
     unsigned wrkrID; /* an internal monotonically increasing id for correlating worker messages */
+    sbool bNoSendmmsg; /* kernel lacks sendmmsg(), use per-message UDP sends */
 } wrkrInstanceData_t;
 static unsigned wrkrID = 0;
 
@@ -282,6 +303,8 @@ static struct cnfparamdescr actpdescr[] = {
     {"udp.sendbuf", eCmdHdlrSize, 0},
     {"template", eCmdHdlrGetWord, 0},
     {"pool.resumeinterval", eCmdHdlrPositiveInt, 0},
+    {"pool.distribution", eCmdHdlrGetWord, 0},
+    {"pool.hashtemplate", eCmdHdlrGetWord, 0},
     {"ratelimit.interval", eCmdHdlrInt, 0},
     {"ratelimit.burst", eCmdHdlrInt, 0},
     {"ratelimit.name", eCmdHdlrString, 0}};
@@ -323,6 +346,8 @@ ENDinitConfVars
 static rsRetVal doTryResume(targetData_t *);
 static rsRetVal doCompressionFinish(targetData_t *);
 static rsRetVal TCPSendBuf(targetData_t *, uchar *, unsigned, sbool);
+static rsRetVal TCPFlushPending(targetData_t *, sbool);
+static void TCPVecMaterialize(targetData_t *);
 
 /* this function gets the default template. It coordinates action between
  * old-style and new-style configuration parts.
@@ -812,12 +837,12 @@ static void DestructTargetData(targetData_t *const pTarget, const sbool bIsRebin
     }
 
     pTarget->bInDestruct = RSTRUE;
-    if (pTarget->bIsConnected && pTarget->offsSndBuf != 0) {
-        rsRetVal localRet = TCPSendBuf(pTarget, pTarget->sndBuf, pTarget->offsSndBuf, IS_FLUSH);
-        if (localRet == RS_RET_OK || localRet == RS_RET_DEFER_COMMIT || localRet == RS_RET_PREVIOUS_COMMITTED) {
-            pTarget->offsSndBuf = 0;
-        }
+    if (pTarget->bIsConnected) {
+        TCPFlushPending(pTarget, IS_FLUSH);
     }
+    /* whatever could not be sent must survive the end of the transaction */
+    TCPVecMaterialize(pTarget);
+    pTarget->bVecSend = 0;
 
     doCompressionFinish(pTarget);
 
@@ -986,6 +1011,48 @@ ENDcreateInstance
 
 /* Among others, all worker-specific targets are initialized here.
  */
+/* FNV-1a over a buffer; used for pool.distribution="hash" keys and seeds */
+static uint64_t poolHashBuf(uint64_t h, const uchar *const buf, const size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        h ^= buf[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+#define POOL_HASH_INIT 0xcbf29ce484222325ULL
+
+/* final avalanche (splitmix64), so that key ^ seed scores are well spread */
+static uint64_t poolHashMix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/* Rendezvous (highest random weight) hashing: each target scores the key
+ * with its own seed and the best connected target not yet tried for this
+ * message wins. When a target goes away, only the keys it owned move to
+ * their next best target; they return once it is back.
+ */
+static targetData_t *poolSelectHashTarget(wrkrInstanceData_t *const pWrkrData, const uint64_t keyHash) {
+    targetData_t *pBest = NULL;
+    uint64_t bestScore = 0;
+
+    for (int j = 0; j < pWrkrData->pData->nTargets; ++j) {
+        targetData_t *const pTarget = &(pWrkrData->target[j]);
+        if (!pTarget->bIsConnected || pTarget->bHashTried) continue;
+        const uint64_t score = poolHashMix(keyHash ^ pTarget->hashSeed);
+        if (pBest == NULL || score > bestScore) {
+            pBest = pTarget;
+            bestScore = score;
+        }
+    }
+    return pBest;
+}
+
+
 BEGINcreateWrkrInstance
     CODESTARTcreateWrkrInstance;
     time_t ttNow;
@@ -1011,6 +1078,12 @@ BEGINcreateWrkrInstance
         pWrkrData->target[i].bInDestruct = RSFALSE;
         pWrkrData->target[i].offsSndBuf = 0;
         pWrkrData->target[i].ttResume = ttNow;
+        /* same seed in every worker and across restarts, so keys always map alike */
+        uint64_t seed = poolHashBuf(POOL_HASH_INIT, (uchar *)pWrkrData->target[i].target_name,
+                                    strlen(pWrkrData->target[i].target_name));
+        seed = poolHashBuf(seed, (const uchar *)":", 1);
+        pWrkrData->target[i].hashSeed =
+            poolHashBuf(seed, (uchar *)pWrkrData->target[i].port, strlen(pWrkrData->target[i].port));
     }
     iRet = initTCP(pWrkrData);
     LogMsg(0, RS_RET_DEBUG, LOG_DEBUG, "omfwd: worker with id %u initialized", pWrkrData->wrkrID);
@@ -1039,6 +1112,7 @@ ENDsetActionInfo
 BEGINfreeInstance
     CODESTARTfreeInstance;
     free(pData->tplName);
+    free(pData->pszHashTplName);
     free(pData->pszStrmDrvr);
     free(pData->pszStrmDrvrAuthMode);
     free(pData->pszStrmDrvrPermitExpiredCerts);
@@ -1104,6 +1178,39 @@ ENDdbgPrintInstInfo
  * rgehards, 2007-12-20
  */
 #define UDP_MAX_MSGSIZE 65507 /* limit per RFC definition */
+
+/* send one datagram via one socket. If the system considers it too large,
+ * it is truncated in steps and retried. Returns the number of bytes sent
+ * or -1, in which case *pErrno holds the reason.
+ */
+static ssize_t UDPSendDatagram(targetStats_t *const pTargetStats,
+                               const int sock,
+                               const uchar *const msg,
+                               const size_t len,
+                               const struct addrinfo *const r,
+                               int *const pErrno) {
+    size_t lenThisTry = len;
+    ssize_t lsent;
+
+    while (1) {
+        lsent = sendto(sock, msg, lenThisTry, 0, r->ai_addr, r->ai_addrlen);
+        if (lsent == (ssize_t)lenThisTry) {
+            ATOMIC_ADD_uint64(&pTargetStats->sentBytes, &pTargetStats->mut_sentBytes, lenThisTry);
+            return lsent;
+        }
+        *pErrno = errno;
+        if (*pErrno != EMSGSIZE) {
+            return -1;
+        }
+        const size_t newlen = (lenThisTry > 1024) ? lenThisTry - 1024 : 512;
+        LogError(0, RS_RET_UDP_MSGSIZE_TOO_LARGE,
+                 "omfwd/udp: send failed due to message being too "
+                 "large for this system. Message size was %u bytes. "
+                 "Truncating to %u bytes and retrying.",
+                 (unsigned)lenThisTry, (unsigned)newlen);
+        lenThisTry = newlen;
+    }
+}
 static rsRetVal UDPSend(wrkrInstanceData_t *__restrict__ const pWrkrData, uchar *__restrict__ const msg, size_t len) {
     DEFiRet;
     struct addrinfo *r;
@@ -1151,32 +1258,16 @@ static rsRetVal UDPSend(wrkrInstanceData_t *__restrict__ const pWrkrData, uchar
     for (r = pTarget->f_addr; r; r = r->ai_next) {
         int runSockArrayLoop = 1;
         for (i = 0; runSockArrayLoop && (i < *pTarget->pSockArray); i++) {
-            int try_send = 1;
-            size_t lenThisTry = len;
-            while (try_send) {
-                int sendErrno;
-                lsent = sendto(pTarget->pSockArray[i + 1], msg, lenThisTry, 0, r->ai_addr, r->ai_addrlen);
-                sendErrno = errno;
-                if (lsent == (ssize_t)lenThisTry) {
-                    bSendSuccess = RSTRUE;
-                    ATOMIC_ADD_uint64(&pTargetStats->sentBytes, &pTargetStats->mut_sentBytes, lenThisTry);
-                    try_send = 0;
-                    runSockArrayLoop = 0;
-                } else if (sendErrno == EMSGSIZE) {
-                    const size_t newlen = (lenThisTry > 1024) ? lenThisTry - 1024 : 512;
-                    LogError(0, RS_RET_UDP_MSGSIZE_TOO_LARGE,
-                             "omfwd/udp: send failed due to message being too "
-                             "large for this system. Message size was %u bytes. "
-                             "Truncating to %u bytes and retrying.",
-                             (unsigned)lenThisTry, (unsigned)newlen);
-                    lenThisTry = newlen;
-                } else {
-                    reInit = RSTRUE;
-                    lasterrno = sendErrno;
-                    lasterr_sock = pTarget->pSockArray[i + 1];
-                    LogError(lasterrno, RS_RET_ERR_UDPSEND, "omfwd/udp: socket %d: sendto() error", lasterr_sock);
-                    try_send = 0;
-                }
+            int sendErrno = 0;
+            lsent = UDPSendDatagram(pTargetStats, pTarget->pSockArray[i + 1], msg, len, r, &sendErrno);
+            if (lsent >= 0) {
+                bSendSuccess = RSTRUE;
+                runSockArrayLoop = 0;
+            } else {
+                reInit = RSTRUE;
+                lasterrno = sendErrno;
+                lasterr_sock = pTarget->pSockArray[i + 1];
+                LogError(lasterrno, RS_RET_ERR_UDPSEND, "omfwd/udp: socket %d: sendto() error", lasterr_sock);
             }
         }
         if (lsent == (ssize_t)len && !pWrkrData->pData->bSendToAll) break;
@@ -1202,6 +1293,123 @@ finalize_it:
 }
 
 
+#ifdef HAVE_SENDMMSG
+    #define UDP_SENDMMSG_BATCH 64 /* max datagrams handed to one sendmmsg() call */
+
+/* Send a chunk of already rendered messages with sendmmsg(). Semantics
+ * follow UDPSend(): a message counts as sent once any socket accepted it
+ * for a resolved address, and only udp.sendtoall sends it to every
+ * address. Datagrams the system rejects as too large are passed on to
+ * UDPSendDatagram(), which owns the truncate-and-retry logic. If any
+ * message could not be sent at all, RS_RET_SUSPENDED is returned just as
+ * the per-message path does. RS_RET_NOT_IMPLEMENTED means the kernel does
+ * not offer sendmmsg() and nothing was sent.
+ */
+static rsRetVal UDPSendBatch(wrkrInstanceData_t *__restrict__ const pWrkrData,
+                             struct iovec *__restrict__ const iov,
+                             const unsigned nMsgs) {
+    struct mmsghdr mmh[UDP_SENDMMSG_BATCH];
+    unsigned idx[UDP_SENDMMSG_BATCH]; /* message index of each mmh entry */
+    sbool bSent[UDP_SENDMMSG_BATCH];
+    struct addrinfo *r;
+    sbool reInit = RSFALSE;
+    int lasterrno = ENOENT;
+    int lasterr_sock = -1;
+    unsigned nSentMsgs = 0;
+    targetData_t *const pTarget = &(pWrkrData->target[0]);
+    targetStats_t *const pTargetStats = &(pWrkrData->pData->target_stats[0]);
+    DEFiRet;
+
+    assert(nMsgs <= UDP_SENDMMSG_BATCH);
+    /* the caller cuts chunks at rebind boundaries, so checking the first message is sufficient */
+    if (pWrkrData->pData->iRebindInterval && (pTarget->nXmit % pWrkrData->pData->iRebindInterval == 0)) {
+        dbgprintf("omfwd dropping UDP 'connection' (as configured)\n");
+        pTarget->nXmit = 0;
+        DestructTargetData(pTarget, 1);
+    }
+
+    if (pTarget->pSockArray == NULL) {
+        CHKiRet(doTryResume(pTarget));
+    }
+    if (pTarget->pSockArray == NULL) {
+        FINALIZE;
+    }
+
+    memset(bSent, 0, sizeof(bSent));
+    for (r = pTarget->f_addr; r; r = r->ai_next) {
+        unsigned nPending = 0;
+        for (unsigned k = 0; k < nMsgs; ++k) {
+            if (!bSent[k] || pWrkrData->pData->bSendToAll) {
+                memset(&mmh[nPending], 0, sizeof(mmh[nPending]));
+                mmh[nPending].msg_hdr.msg_name = r->ai_addr;
+                mmh[nPending].msg_hdr.msg_namelen = r->ai_addrlen;
+                mmh[nPending].msg_hdr.msg_iov = &iov[k];
+                mmh[nPending].msg_hdr.msg_iovlen = 1;
+                idx[nPending++] = k;
+            }
+        }
+        if (nPending == 0) break;
+
+        unsigned done = 0;
+        for (int i = 0; done < nPending && i < *pTarget->pSockArray; i++) {
+            const int sock = pTarget->pSockArray[i + 1];
+            while (done < nPending) {
+                const int nSent = sendmmsg(sock, mmh + done, nPending - done, 0);
+                if (nSent > 0) {
+                    for (unsigned j = done; j < done + nSent; ++j) {
+                        bSent[idx[j]] = RSTRUE;
+                        ATOMIC_ADD_uint64(&pTargetStats->sentBytes, &pTargetStats->mut_sentBytes, mmh[j].msg_len);
+                    }
+                    done += nSent;
+                    continue;
+                }
+                int sendErrno = errno;
+                if (sendErrno == ENOSYS) {
+                    /* can only happen on the very first call (e.g. under valgrind) */
+                    DBGPRINTF("omfwd: error ENOSYS on call to sendmmsg() - fall back to sendto\n");
+                    ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+                } else if (sendErrno == EMSGSIZE) {
+                    const struct iovec *const pIov = &iov[idx[done]];
+                    if (UDPSendDatagram(pTargetStats, sock, pIov->iov_base, pIov->iov_len, r, &sendErrno) >= 0) {
+                        bSent[idx[done]] = RSTRUE;
+                        ++done;
+                        continue;
+                    }
+                }
+                reInit = RSTRUE;
+                lasterrno = sendErrno;
+                lasterr_sock = sock;
+                LogError(lasterrno, RS_RET_ERR_UDPSEND, "omfwd/udp: socket %d: sendmmsg() error", lasterr_sock);
+                break; /* try the remaining datagrams on the next socket */
+            }
+        }
+    }
+
+    for (unsigned k = 0; k < nMsgs; ++k) {
+        if (bSent[k]) ++nSentMsgs;
+    }
+    ATOMIC_ADD_uint64(&pTarget->pTargetStats->sentMsgs, &pTarget->pTargetStats->mut_sentMsgs, nSentMsgs);
+
+    /* one or more send failures; close sockets and re-init */
+    if (reInit == RSTRUE) {
+        DestructTargetData(pTarget, 0);
+    }
+
+    if (nSentMsgs != nMsgs) {
+        LogError(lasterrno, RS_RET_ERR_UDPSEND, "omfwd: socket %d: error %d sending %u of %u messages via udp",
+                 lasterr_sock, lasterrno, nMsgs - nSentMsgs, nMsgs);
+        iRet = RS_RET_SUSPENDED;
+    }
+
+finalize_it:
+    if (iRet != RS_RET_NOT_IMPLEMENTED) {
+        pTarget->nXmit += nMsgs;
+    }
+    RETiRet;
+}
+#endif /* #ifdef HAVE_SENDMMSG */
+
+
 /* set the permitted peers -- rgerhards, 2008-05-19
  */
 static rsRetVal setPermittedPeer(void __attribute__((unused)) * pVal, uchar *pszID) {
@@ -1436,6 +1644,132 @@ static rsRetVal TCPSendBuf(targetData_t *pTarget, uchar *buf, unsigned len, sboo
     RETiRet;
 }
 
+/* append a region to the pending gather list. Regions that directly follow
+ * the previous one in memory (usually the trailer of one frame and the
+ * header of the next inside vecMeta) are merged into a single iovec.
+ */
+static void TCPVecAdd(targetData_t *const pTarget, const void *const base, const size_t len) {
+    if (len == 0) return;
+    pTarget->lenVecPending += len;
+    if (pTarget->nVecIov > 0) {
+        struct iovec *const last = &pTarget->vecIov[pTarget->nVecIov - 1];
+        if ((const uchar *)last->iov_base + last->iov_len == (const uchar *)base) {
+            last->iov_len += len;
+            return;
+        }
+    }
+    pTarget->vecIov[pTarget->nVecIov].iov_base = (void *)base;
+    pTarget->vecIov[pTarget->nVecIov].iov_len = len;
+    ++pTarget->nVecIov;
+}
+
+/* framing octets are tiny and may live on the caller's stack, so copy them */
+static void TCPVecAddMeta(targetData_t *const pTarget, const char *const data, const size_t len) {
+    if (len == 0) return;
+    memcpy(pTarget->vecMeta + pTarget->lenVecMeta, data, len);
+    TCPVecAdd(pTarget, pTarget->vecMeta + pTarget->lenVecMeta, len);
+    pTarget->lenVecMeta += len;
+}
+
+static void TCPVecReset(targetData_t *const pTarget) {
+    pTarget->nVecIov = 0;
+    pTarget->lenVecMeta = 0;
+    pTarget->lenVecPending = 0;
+}
+
+/* copy the not yet written part of the gather list into sndBuf so that it
+ * outlives the current transaction. The list never describes more than
+ * sndBuf can hold (see TCPSendFrameParts()). Only the first entry may point
+ * into sndBuf itself, and only at or after the destination offset, so the
+ * copy never clobbers data still to be moved.
+ */
+static void TCPVecMaterialize(targetData_t *const pTarget) {
+    size_t offs = 0;
+
+    if (pTarget->nVecIov == 0) return;
+    assert(pTarget->lenVecPending <= sizeof(pTarget->sndBuf));
+    for (int i = 0; i < pTarget->nVecIov; ++i) {
+        memmove(pTarget->sndBuf + offs, pTarget->vecIov[i].iov_base, pTarget->vecIov[i].iov_len);
+        offs += pTarget->vecIov[i].iov_len;
+    }
+    pTarget->offsSndBuf = (int)offs;
+    TCPVecReset(pTarget);
+}
+
+/* write the pending gather list with as few writev() calls as the kernel
+ * permits. If bRetain is set, unsent data is kept (in sndBuf) for a later
+ * retry, else it is dropped - the latter is used for frames too large for
+ * sndBuf, mirroring what TCPSendBufUncompressed() callers do.
+ */
+static rsRetVal TCPSendVec(targetData_t *const pTarget, const sbool bRetain) {
+    struct iovec *iov = pTarget->vecIov;
+    int iovcnt = pTarget->nVecIov;
+    const size_t len = pTarget->lenVecPending;
+    ssize_t lenSend;
+    DEFiRet;
+
+    if (pTarget->pData->bExtendedConnCheck) {
+        CHKiRet(netstrm.CheckConnection(pTarget->pNetstrm));
+    }
+
+    while (iovcnt > 0) {
+        iRet = netstrm.SendV(pTarget->pNetstrm, iov, iovcnt, &lenSend);
+        if (iRet == RS_RET_RETRY) ABORT_FINALIZE(iRet);
+        CHKiRet(iRet);
+        DBGPRINTF("omfwd: TCP sent %zd bytes from %d iovecs, pending %zu\n", lenSend, iovcnt,
+                  pTarget->lenVecPending);
+        pTarget->lenVecPending -= lenSend;
+        /* skip what was fully written and trim a partially written entry */
+        while (iovcnt > 0 && (size_t)lenSend >= iov->iov_len) {
+            lenSend -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (lenSend > 0) {
+            iov->iov_base = (uchar *)iov->iov_base + lenSend;
+            iov->iov_len -= lenSend;
+        }
+    }
+
+    ATOMIC_ADD_uint64(&pTarget->pTargetStats->sentBytes, &pTarget->pTargetStats->mut_sentBytes, len);
+
+finalize_it:
+    if (iRet == RS_RET_OK || !bRetain) {
+        TCPVecReset(pTarget);
+    } else {
+        memmove(pTarget->vecIov, iov, iovcnt * sizeof(struct iovec));
+        pTarget->nVecIov = iovcnt;
+        TCPVecMaterialize(pTarget);
+    }
+    if (iRet != RS_RET_OK) {
+        if (iRet == RS_RET_RETRY) {
+            DBGPRINTF("omfwd: TCP send deferred for retry\n");
+        } else {
+            emitConnectionErrorMsg(pTarget, iRet);
+            if (!pTarget->bInDestruct) {
+                DestructTargetData(pTarget, 0);
+            }
+            iRet = RS_RET_SUSPENDED;
+        }
+    }
+    RETiRet;
+}
+
+/* send everything buffered for this target, be it a gather list or sndBuf */
+static rsRetVal TCPFlushPending(targetData_t *const pTarget, const sbool bIsFlush) {
+    DEFiRet;
+
+    if (pTarget->nVecIov != 0) {
+        CHKiRet(TCPSendVec(pTarget, 1));
+    } else if (pTarget->offsSndBuf != 0) {
+        CHKiRet(TCPSendBuf(pTarget, pTarget->sndBuf, pTarget->offsSndBuf, bIsFlush));
+        pTarget->offsSndBuf = 0;
+    }
+
+finalize_it:
+    RETiRet;
+}
+
 /* finish zlib buffer, to be called before closing the ZIP file (if running in stream mode). */
 static rsRetVal doZlibFinish(targetData_t *pTarget) {
     int zRet; /* zlib return state */
@@ -1518,14 +1852,55 @@ static rsRetVal doCompressionFinish(targetData_t *pTarget) {
 
 
 /* Add frame to send buffer (or send, if requried)
+ * The frame is handed over as octet-count header, message and trailing
+ * delimiter so that no intermediate copy of the full frame is needed.
+ * If the connection supports gather writes and msg stays valid until the
+ * end of the transaction (bMsgStable), the message is only referenced and
+ * the whole batch goes out with a single writev() at commit time (or when
+ * the buffer limit is reached). Otherwise the parts are copied straight
+ * into sndBuf.
  */
-static rsRetVal TCPSendFrame(void *pvData, char *msg, const size_t len) {
+static rsRetVal TCPAddFrame(targetData_t *const pTarget,
+                            const char *hdr,
+                            const size_t lenHdr,
+                            char *msg,
+                            const size_t len,
+                            const char *trl,
+                            const size_t lenTrl,
+                            const sbool bMsgStable) {
     DEFiRet;
-    targetData_t *pTarget = (targetData_t *)pvData;
+    const size_t lenFrame = lenHdr + len + lenTrl;
+
+    DBGPRINTF("omfwd: add %zu bytes to send buffer (curr offs %u, vec %zu, max len %d) msg: %*s\n", lenFrame,
+              pTarget->offsSndBuf, pTarget->lenVecPending, pTarget->maxLenSndBuf, (int)len, msg);
+    if (pTarget->bVecSend && bMsgStable) {
+        /* data retained from an earlier transaction goes out first */
+        if (pTarget->nVecIov == 0 && pTarget->offsSndBuf != 0) {
+            TCPVecAdd(pTarget, pTarget->sndBuf, pTarget->offsSndBuf);
+            pTarget->offsSndBuf = 0;
+        }
+        if (pTarget->lenVecPending != 0 &&
+            ((pTarget->lenVecPending + lenFrame) >= (size_t)pTarget->maxLenSndBuf ||
+             pTarget->nVecIov + 3 > OMFWD_VEC_MAX_IOV || pTarget->lenVecMeta + lenHdr + lenTrl > OMFWD_VEC_META_SIZE)) {
+            DBGPRINTF(
+                "omfwd: we need to do a tcp send due to buffer "
+                "out of space. If the transaction fails, this will "
+                "lead to duplication of messages");
+            CHKiRet(TCPSendVec(pTarget, 1));
+        }
+        TCPVecAddMeta(pTarget, hdr, lenHdr);
+        TCPVecAdd(pTarget, msg, len);
+        TCPVecAddMeta(pTarget, trl, lenTrl);
+        if (lenFrame > sizeof(pTarget->sndBuf)) {
+            /* can never be retained, send right away like the copy path does */
+            CHKiRet(TCPSendVec(pTarget, 0));
+            ABORT_FINALIZE(RS_RET_OK); /* committed everything so far */
+        }
+        ABORT_FINALIZE(RS_RET_DEFER_COMMIT);
+    }
 
-    DBGPRINTF("omfwd: add %zu bytes to send buffer (curr offs %u, max len %d) msg: %*s\n", len, pTarget->offsSndBuf,
-              pTarget->maxLenSndBuf, (int)len, msg);
-    if (pTarget->offsSndBuf != 0 && (pTarget->offsSndBuf + len) >= (size_t)pTarget->maxLenSndBuf) {
+    TCPVecMaterialize(pTarget); /* keep frame order if we switch from gathering to copying */
+    if (pTarget->offsSndBuf != 0 && (pTarget->offsSndBuf + lenFrame) >= (size_t)pTarget->maxLenSndBuf) {
         /* no buffer space left, need to commit previous records. With the
          * current API, there unfortunately is no way to signal this
          * state transition to the upper layer.
@@ -1539,14 +1914,18 @@ static rsRetVal TCPSendFrame(void *pvData, char *msg, const size_t len) {
     }
 
     /* check if the message is too large to fit into buffer */
-    if (len > sizeof(pTarget->sndBuf)) {
+    if (lenFrame > sizeof(pTarget->sndBuf)) {
+        if (lenHdr != 0) CHKiRet(TCPSendBuf(pTarget, (uchar *)hdr, lenHdr, NO_FLUSH));
         CHKiRet(TCPSendBuf(pTarget, (uchar *)msg, len, NO_FLUSH));
+        if (lenTrl != 0) CHKiRet(TCPSendBuf(pTarget, (uchar *)trl, lenTrl, NO_FLUSH));
         ABORT_FINALIZE(RS_RET_OK); /* committed everything so far */
     }
 
     /* we now know the buffer has enough free space */
-    memcpy(pTarget->sndBuf + pTarget->offsSndBuf, msg, len);
-    pTarget->offsSndBuf += len;
+    if (lenHdr != 0) memcpy(pTarget->sndBuf + pTarget->offsSndBuf, hdr, lenHdr);
+    memcpy(pTarget->sndBuf + pTarget->offsSndBuf + lenHdr, msg, len);
+    if (lenTrl != 0) memcpy(pTarget->sndBuf + pTarget->offsSndBuf + lenHdr + len, trl, lenTrl);
+    pTarget->offsSndBuf += lenFrame;
     iRet = RS_RET_DEFER_COMMIT;
 
 finalize_it:
@@ -1554,6 +1933,27 @@ finalize_it:
 }
 
 
+/* tcpclt callback for regular frames; msg is a template string of the current batch */
+static rsRetVal TCPSendFrameParts(void *pvData,
+                                  const char *hdr,
+                                  const size_t lenHdr,
+                                  char *msg,
+                                  const size_t len,
+                                  const char *trl,
+                                  const size_t lenTrl) {
+    return TCPAddFrame((targetData_t *)pvData, hdr, lenHdr, msg, len, trl, lenTrl, 1);
+}
+
+
+/* tcpclt callback for complete frames. It is only used to resend the previous
+ * frame after a reconnect; that buffer is replaced by the next send and thus
+ * must always be copied.
+ */
+static rsRetVal TCPSendFrame(void *pvData, char *msg, const size_t len) {
+    return TCPAddFrame((targetData_t *)pvData, NULL, 0, msg, len, NULL, 0, 0);
+}
+
+
 /* initializes a TCP session to a single Target
  */
 static rsRetVal TCPSendInitTarget(targetData_t *const pTarget) {
@@ -1617,6 +2017,13 @@ static rsRetVal TCPSendInitTarget(targetData_t *const pTarget) {
             CHKiRet(netstrm.EnableKeepAlive(pTarget->pNetstrm));
         }
 
+        /* gather writes reference the template strings directly, which is only
+         * possible if the frame is sent as rendered (no compression).
+         */
+        ssize_t lenProbe;
+        pTarget->bVecSend = pData->compressionMode == COMPRESS_NEVER &&
+                            netstrm.SendV(pTarget->pNetstrm, NULL, 0, &lenProbe) == RS_RET_OK;
+
         LogMsg(0, RS_RET_DEBUG, LOG_DEBUG, "omfwd: [wrkr %u] TCPSendInitTarget established connection to %s:%s",
                pTarget->pWrkrData->wrkrID, pTarget->target_name, pTarget->port);
     }
@@ -1960,6 +2367,94 @@ finalize_it:
     RETiRet;
 }
 
+/* check the action's rate limiter for one message. Returns RS_RET_DISCARDMSG if
+ * the message must be dropped; other limiter errors are reported and ignored.
+ */
+static rsRetVal checkRatelimit(wrkrInstanceData_t *const pWrkrData, const char *const namebuf) {
+    rsRetVal localRet;
+
+    if (pWrkrData->pData->ratelimiter == NULL) return RS_RET_OK;
+    localRet = ratelimitMsgCount(pWrkrData->pData->ratelimiter, 0, namebuf);
+    if (localRet == RS_RET_DISCARDMSG) return localRet;
+    if (localRet != RS_RET_OK) {
+        LogError(0, RS_RET_ERR, "omfwd: action '%s' error during rate limit: %d.\n",
+                 actionGetName(pWrkrData->pData->pAction), localRet);
+    }
+    return RS_RET_OK;
+}
+
+
+#ifdef HAVE_SENDMMSG
+/* hand one chunk to UDPSendBatch(), falling back to UDPSend() for good if
+ * the kernel turns out not to support sendmmsg().
+ */
+static rsRetVal UDPSendChunk(wrkrInstanceData_t *const pWrkrData, struct iovec *const iov, const unsigned n) {
+    targetData_t *const pTarget = &(pWrkrData->target[0]);
+    DEFiRet;
+
+    iRet = UDPSendBatch(pWrkrData, iov, n);
+    if (iRet == RS_RET_NOT_IMPLEMENTED) {
+        pWrkrData->bNoSendmmsg = RSTRUE;
+        iRet = RS_RET_OK;
+        for (unsigned k = 0; k < n; ++k) {
+            CHKiRet(UDPSend(pWrkrData, iov[k].iov_base, iov[k].iov_len));
+            ATOMIC_INC_uint64(&pTarget->pTargetStats->sentMsgs, &pTarget->pTargetStats->mut_sentMsgs);
+        }
+    }
+
+finalize_it:
+    RETiRet;
+}
+
+/* UDP flavor of the commitTransaction() main loop: messages are collected
+ * in chunks and handed to the kernel with sendmmsg(). Chunks never span a
+ * rebind boundary, so udp.rebindinterval keeps its per-message meaning.
+ */
+static rsRetVal UDPCommitBatch(wrkrInstanceData_t *const pWrkrData,
+                               actWrkrIParams_t *const pParams,
+                               const unsigned nParams,
+                               const char *const namebuf) {
+    struct iovec iov[UDP_SENDMMSG_BATCH];
+    unsigned n = 0;
+    targetData_t *const pTarget = &(pWrkrData->target[0]);
+    const int iRebindInterval = pWrkrData->pData->iRebindInterval;
+    const size_t maxLine = (size_t)glbl.GetMaxLine(runModConf->pConf);
+    DEFiRet;
+
+    for (unsigned i = 0; i < nParams; ++i) {
+        if (checkRatelimit(pWrkrData, namebuf) == RS_RET_DISCARDMSG) continue;
+
+        actWrkrIParams_t *const iparam = &actParam(pParams, 1, i, 0);
+        size_t len = iparam->lenStr;
+        if (len > maxLine) len = maxLine;
+        if (len > UDP_MAX_MSGSIZE) {
+            LogError(0, RS_RET_UDP_MSGSIZE_TOO_LARGE,
+                     "omfwd/udp: message is %u "
+                     "bytes long, but UDP can send at most %d bytes (by RFC limit) "
+                     "- truncating message",
+                     (unsigned)len, UDP_MAX_MSGSIZE);
+            len = UDP_MAX_MSGSIZE;
+        }
+        iov[n].iov_base = iparam->param;
+        iov[n].iov_len = len;
+        ++n;
+        pWrkrData->nXmit++;
+
+        if (n == UDP_SENDMMSG_BATCH || (iRebindInterval && (pTarget->nXmit + n) % iRebindInterval == 0)) {
+            CHKiRet(UDPSendChunk(pWrkrData, iov, n));
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        CHKiRet(UDPSendChunk(pWrkrData, iov, n));
+    }
+
+finalize_it:
+    RETiRet;
+}
+#endif /* #ifdef HAVE_SENDMMSG */
+
+
 BEGINcommitTransaction
     unsigned i;
     char namebuf[264]; /* 256 for FQDN, 5 for port and 3 for transport => 264 */
@@ -1994,21 +2489,40 @@ BEGINcommitTransaction
                  pWrkrData->pData->target_name[0], pWrkrData->pData->ports[0]);
     }
 
+#ifdef HAVE_SENDMMSG
+    /* single-message compression and a configured send delay need the per-message path */
+    if (pWrkrData->pData->protocol == FORW_UDP && !pWrkrData->bNoSendmmsg &&
+        pWrkrData->pData->compressionMode == COMPRESS_NEVER && pWrkrData->pData->iUDPSendDelay == 0) {
+        CHKiRet(UDPCommitBatch(pWrkrData, pParams, nParams, namebuf));
+        FINALIZE;
+    }
+#endif
+
     for (i = 0; i < nParams; ++i) {
         /* If rate limiting is enabled, check whether this message has to be discarded */
-        if (pWrkrData->pData->ratelimiter) {
-            iRet = ratelimitMsgCount(pWrkrData->pData->ratelimiter, 0, namebuf);
-            if (iRet == RS_RET_DISCARDMSG) {
-                iRet = RS_RET_OK;
-                continue;
-            } else if (iRet != RS_RET_OK) {
-                LogError(0, RS_RET_ERR, "omfwd: action '%s' error during rate limit: %d.\n",
-                         actionGetName(pWrkrData->pData->pAction), iRet);
-            }
+        if (checkRatelimit(pWrkrData, namebuf) == RS_RET_DISCARDMSG) {
+            continue;
         }
 
         int trynbr = 0;
         int dotry = 1;
+        if (pWrkrData->pData->poolDistribution == POOL_DISTRIB_HASH) {
+            /* sticky routing: the key decides the target, falling back in rendezvous order */
+            const actWrkrIParams_t *const keyParam = &actParam(pParams, 2, i, 1);
+            const uint64_t keyHash = poolHashBuf(POOL_HASH_INIT, keyParam->param, keyParam->lenStr);
+            targetData_t *pTarget;
+            for (int j = 0; j < pWrkrData->pData->nTargets; ++j) {
+                pWrkrData->target[j].bHashTried = RSFALSE;
+            }
+            while (dotry && (pTarget = poolSelectHashTarget(pWrkrData, keyHash)) != NULL) {
+                pTarget->bHashTried = RSTRUE;
+                iRet = processMsg(pTarget, &actParam(pParams, 2, i, 0));
+                if (iRet == RS_RET_OK || iRet == RS_RET_DEFER_COMMIT || iRet == RS_RET_PREVIOUS_COMMITTED) {
+                    dotry = 0;
+                }
+            }
+            trynbr = pWrkrData->pData->nTargets; /* skip round-robin selection below */
+        }
         while (dotry && trynbr < pWrkrData->pData->nTargets) {
             /* In the future we may consider if we would like to have targets on
                a per-worker or global basis. We now use worker because otherwise we
@@ -2040,11 +2554,11 @@ BEGINcommitTransaction
     }
 
     for (int j = 0; j < pWrkrData->pData->nTargets; ++j) {
-        if (pWrkrData->target[j].bIsConnected && pWrkrData->target[j].offsSndBuf != 0) {
-            iRet = TCPSendBuf(&(pWrkrData->target[j]), pWrkrData->target[j].sndBuf, pWrkrData->target[j].offsSndBuf,
-                              IS_FLUSH);
+        if (pWrkrData->target[j].bIsConnected &&
+            (pWrkrData->target[j].offsSndBuf != 0 || pWrkrData->target[j].nVecIov != 0)) {
+            iRet = TCPFlushPending(&(pWrkrData->target[j]), IS_FLUSH);
             if (iRet == RS_RET_OK || iRet == RS_RET_DEFER_COMMIT || iRet == RS_RET_PREVIOUS_COMMITTED) {
-                pWrkrData->target[j].offsSndBuf = 0;
+                iRet = RS_RET_OK;
             } else if (iRet == RS_RET_RETRY) {
                 DBGPRINTF("omfwd: TCP buffer flush deferred for retry to %s:%s\n", pWrkrData->target[j].target_name,
                           pWrkrData->target[j].port);
@@ -2084,6 +2598,13 @@ finalize_it:
      *   send buffer and will be flushed once doTryResume() re-establishes the
      *   connection on a subsequent transaction.
      */
+    /* gather lists point into this batch's template strings - keep a private copy of
+     * anything that did not go out (only happens if the loop above was left early)
+     */
+    for (int j = 0; j < pWrkrData->pData->nTargets; ++j) {
+        TCPVecMaterialize(&(pWrkrData->target[j]));
+    }
+
     /* do pool stats */
 
     countActiveTargets(pWrkrData);
@@ -2140,6 +2661,7 @@ static rsRetVal initTCP(wrkrInstanceData_t *pWrkrData) {
             /* and set callbacks */
             CHKiRet(tcpclt.SetSendInit(pWrkrData->target[i].pTCPClt, TCPSendInit));
             CHKiRet(tcpclt.SetSendFrame(pWrkrData->target[i].pTCPClt, TCPSendFrame));
+            CHKiRet(tcpclt.SetSendFrameParts(pWrkrData->target[i].pTCPClt, TCPSendFrameParts));
             CHKiRet(tcpclt.SetSendPrepRetry(pWrkrData->target[i].pTCPClt, TCPSendPrepRetry));
         }
     }
@@ -2150,6 +2672,9 @@ finalize_it:
 
 static void setInstParamDefaults(instanceData *pData) {
     pData->tplName = NULL;
+    pData->poolDistribution = POOL_DISTRIB_ROUNDROBIN;
+    pData->pszHashTplName = NULL;
+    pData->iNumTpls = 1;
     pData->pAction = NULL;
     pData->targetSrv = NULL;
     pData->protocol = FORW_UDP;
@@ -2574,6 +3099,23 @@ BEGINnewActInst
             pData->ipfreebind = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "pool.resumeinterval")) {
             pData->poolResumeInterval = (unsigned int)pvals[i].val.d.n;
+        } else if (!strcmp(actpblk.descr[i].name, "pool.distribution")) {
+            cstr = es_str2cstr(pvals[i].val.d.estr, NULL);
+            if (!strcasecmp(cstr, "roundrobin")) {
+                pData->poolDistribution = POOL_DISTRIB_ROUNDROBIN;
+            } else if (!strcasecmp(cstr, "hash")) {
+                pData->poolDistribution = POOL_DISTRIB_HASH;
+            } else {
+                LogError(0, RS_RET_PARAM_ERROR,
+                         "omfwd: invalid value for 'pool.distribution' "
+                         "parameter: '%s' - must be 'roundrobin' or 'hash'",
+                         cstr);
+                free(cstr);
+                ABORT_FINALIZE(RS_RET_PARAM_ERROR);
+            }
+            free(cstr);
+        } else if (!strcmp(actpblk.descr[i].name, "pool.hashtemplate")) {
+            CHKmalloc(pData->pszHashTplName = (uchar *)es_str2cstr(pvals[i].val.d.estr, NULL));
         } else if (!strcmp(actpblk.descr[i].name, "ratelimit.burst")) {
             pData->ratelimitBurst = (int)pvals[i].val.d.n;
         } else if (!strcmp(actpblk.descr[i].name, "ratelimit.interval")) {
@@ -2621,6 +3163,25 @@ BEGINnewActInst
         CHKiRet(resolveSrvTargets(pData));
     }
 
+    if (pData->poolDistribution == POOL_DISTRIB_HASH) {
+        if (pData->pszHashTplName == NULL) {
+            LogError(0, RS_RET_PARAM_ERROR,
+                     "omfwd: pool.distribution=\"hash\" requires pool.hashtemplate "
+                     "to name the template that renders the distribution key");
+            ABORT_FINALIZE(RS_RET_PARAM_ERROR);
+        }
+        if (pData->protocol == FORW_UDP) {
+            parser_warnmsg(
+                "omfwd: pool.distribution=\"hash\" is only supported in TCP mode, "
+                "UDP always uses a single target - ignored");
+            pData->poolDistribution = POOL_DISTRIB_ROUNDROBIN;
+        } else {
+            pData->iNumTpls = 2;
+        }
+    } else if (pData->pszHashTplName != NULL) {
+        parser_warnmsg("omfwd: pool.hashtemplate is only used with pool.distribution=\"hash\" - ignored");
+    }
+
     if (pData->protocol == FORW_UDP && pData->nTargets > 1) {
         parser_warnmsg(
             "you have defined %d targets. Multiple targets are ONLY "
@@ -2674,10 +3235,13 @@ BEGINnewActInst
         ABORT_FINALIZE(RS_RET_PARAM_ERROR);
     }
 
-    CODE_STD_STRING_REQUESTnewActInst(1);
+    CODE_STD_STRING_REQUESTnewActInst(pData->iNumTpls);
 
     tplToUse = ustrdup((pData->tplName == NULL) ? getDfltTpl() : pData->tplName);
     CHKiRet(OMSRsetEntry(*ppOMSR, 0, tplToUse, OMSR_NO_RQD_TPL_OPTS));
+    if (pData->iNumTpls == 2) {
+        CHKiRet(OMSRsetEntry(*ppOMSR, 1, ustrdup(pData->pszHashTplName), OMSR_NO_RQD_TPL_OPTS));
+    }
 
     if (pData->bSendToAll == -1) {
         pData->bSendToAll = send_to_all;
@@ -287,6 +287,36 @@ finalize_it:
     RETiRet;
 }
 
+/* use the header fast path in parse2()? Only the fuzz harness turns it off,
+ * to compare the fast path against the byte-by-byte parser.
+ */
+static int bFastPath = 1;
+
+/* Fast path for the HOSTNAME heuristics of parse2(). It handles the common
+ * case where the hostname candidate is terminated by a SP inside the scan
+ * window and no square brackets are permitted. The decision is exactly the
+ * one the byte-by-byte loop takes: every character up to the SP must be a
+ * valid hostname character and the last one must be alphanumeric.
+ * Returns the hostname length (the SP is not included), 0 if there is no
+ * hostname or -1 if the caller must use the byte-by-byte loop.
+ */
+static int ATTR_NONNULL() parseHostnameFast(const instanceConf_t* const pInst,
+                                            const uchar* const p2parse,
+                                            const parserHdrMasks_t* const pMasks) {
+    int lenHost;
+    int i;
+
+    if (pInst->bPermitSquareBracketsInHostname || pMasks->sp == 0) return -1;
+    lenHost = __builtin_ctzll(pMasks->sp);
+    for (i = 0; i < lenHost; ++i) {
+        if (!(isalnum(p2parse[i]) || p2parse[i] == '.' || p2parse[i] == '_' || p2parse[i] == '-' ||
+              (p2parse[i] == '@' && pInst->bPermitAtSignsInHostname) ||
+              (p2parse[i] == '/' && pInst->bPermitSlashesInHostname)))
+            return 0;
+    }
+    return (lenHost > 0 && isalnum(p2parse[lenHost - 1])) ? lenHost : 0;
+}
+
 /* parse a legacy-formatted syslog message.
  * We apply heuristics during header detection. These are not 100% failure
  * prove, but the best compromise we came up within 20+ years of adapting
@@ -298,6 +328,9 @@ BEGINparse2
     int i; /* general index for parsing */
     uchar bufParseTAG[CONF_TAG_MAXSIZE];
     uchar bufParseHOSTNAME[CONF_HOSTNAME_MAXSIZE];
+    parserHdrMasks_t masks;
+    uchar* pMasksBase = NULL; /* where masks were scanned, NULL if fast path is not used */
+    int lenFast;
     CODESTARTparse;
     assert(pMsg != NULL);
     assert(pMsg->pszRawMsg != NULL);
@@ -381,6 +414,11 @@ BEGINparse2
      * is meant to be an interim solution, but for now it is in the code.
      */
     if (pInst->bParseHOSTNAMEandTAG && !(pMsg->msgFlags & INTERNAL_MSG)) {
+        if (bFastPath) {
+            /* classify HOSTNAME and TAG delimiters once, both steps below use it */
+            parserScanHdr(p2parse, lenMsg, &masks);
+            pMasksBase = p2parse;
+        }
         /* parse HOSTNAME - but only if this is network-received!
          * rger, 2005-11-14: we still have a problem with BSD messages. These messages
          * do NOT include a host name. In most cases, this leads to the TAG to be treated
@@ -398,7 +436,17 @@ BEGINparse2
          * an option as it may interfere with non-hostnames in some message formats.
          * rgerhards, 2015-04-20
          */
-        if (lenMsg > 0 && pMsg->msgFlags & PARSE_HOSTNAME) {
+        if (lenMsg > 0 && pMsg->msgFlags & PARSE_HOSTNAME && pMasksBase != NULL &&
+            (lenFast = parseHostnameFast(pInst, p2parse, &masks)) >= 0) {
+            if (lenFast > 0) {
+                /* we got a hostname! */
+                memcpy(bufParseHOSTNAME, p2parse, lenFast);
+                bufParseHOSTNAME[lenFast] = '\0';
+                MsgSetHOSTNAME(pMsg, bufParseHOSTNAME, lenFast);
+                p2parse += lenFast + 1; /* "eat" it (including SP delimiter) */
+                lenMsg -= lenFast + 1;
+            }
+        } else if (lenMsg > 0 && pMsg->msgFlags & PARSE_HOSTNAME) {
             i = 0;
             int bHadSBracket = 0;
             if (pInst->bPermitSquareBracketsInHostname) {
@@ -469,9 +517,25 @@ BEGINparse2
          */
         uchar* const pTagStart = p2parse;
         i = 0;
-        while (lenMsg > 0 && *p2parse != ':' && *p2parse != ' ' && i < CONF_TAG_MAXSIZE - 2) {
-            bufParseTAG[i++] = *p2parse++;
-            --lenMsg;
+        lenFast = -1;
+        if (pMasksBase != NULL) {
+            /* the TAG ends at the first ':' or SP; if there is none, the window must cover the message */
+            parserHdrMasksSkip(&masks, p2parse - pMasksBase);
+            if ((masks.sp | masks.colon) != 0)
+                lenFast = __builtin_ctzll(masks.sp | masks.colon);
+            else if (masks.len == lenMsg)
+                lenFast = lenMsg;
+        }
+        if (lenFast >= 0) {
+            memcpy(bufParseTAG, p2parse, lenFast);
+            i = lenFast;
+            p2parse += lenFast;
+            lenMsg -= lenFast;
+        } else {
+            while (lenMsg > 0 && *p2parse != ':' && *p2parse != ' ' && i < CONF_TAG_MAXSIZE - 2) {
+                bufParseTAG[i++] = *p2parse++;
+                --lenMsg;
+            }
         }
         if (lenMsg > 0 && *p2parse == ':') {
             ++p2parse;
@@ -520,6 +584,7 @@ static instanceConf_t* fuzzParserInstance;
 rsRetVal pmrfc3164FuzzInit(void);
 void pmrfc3164FuzzExit(void);
 rsRetVal pmrfc3164FuzzParse(smsg_t* pMsg);
+void pmrfc3164FuzzSetFastPath(const int bEnable);
 
 rsRetVal pmrfc3164FuzzInit(void) {
     DEFiRet;
@@ -550,6 +615,10 @@ rsRetVal pmrfc3164FuzzParse(smsg_t* pMsg) {
     if (fuzzParserInstance == NULL) return RS_RET_ERR;
     return parse2(fuzzParserInstance, pMsg);
 }
+
+void pmrfc3164FuzzSetFastPath(const int bEnable) {
+    bFastPath = bEnable;
+}
 #endif
 
 
@@ -34,6 +34,7 @@ rsRetVal modInitpmrfc3164(int iIFVersRequested __attribute__((unused)),
 rsRetVal pmrfc3164FuzzInit(void);
 void pmrfc3164FuzzExit(void);
 rsRetVal pmrfc3164FuzzParse(smsg_t *pMsg);
+void pmrfc3164FuzzSetFastPath(const int bEnable);
     #endif
 
 #endif /* #ifndef PMRFC3164_H_INCLUDED */
@@ -58,6 +58,7 @@ DEFobjCurrIf(glbl) DEFobjCurrIf(parser) DEFobjCurrIf(datetime)
     BEGINisCompatibleWithFeature CODESTARTisCompatibleWithFeature;
 if (eFeat == sFEATUREAutomaticSanitazion) iRet = RS_RET_OK;
 if (eFeat == sFEATUREAutomaticPRIParsing) iRet = RS_RET_OK;
+if (eFeat == sFEATUREPrefixRejection) iRet = RS_RET_OK;
 ENDisCompatibleWithFeature
 
 
@@ -102,6 +103,55 @@ static int parseRFCField(uchar **pp2parse, uchar *pResult, int *pLenStr) {
 }
 
 
+/* use parseRFCHdrFieldsFast()? Only the fuzz harness turns it off, to
+ * compare the fast path against the byte-by-byte parser.
+ */
+static int bFastPath = 1;
+
+/* Fast path for the HOSTNAME, APP-NAME, PROCID and MSGID fields. The
+ * header is classified by parserScanHdr() and the four fields are taken by
+ * offset between the first four SPs. This produces exactly what four calls
+ * to parseRFCField() would, but only for the common case where all four
+ * terminating SPs are inside the scan window and no field contains a NUL
+ * byte (parseRFCField() results are used as C strings, so a NUL would
+ * truncate the field). Returns 0 if the fields were set, 1 if the caller
+ * must use parseRFCField() instead. Nothing is modified in that case.
+ */
+static int parseRFCHdrFieldsFast(smsg_t *const pMsg, uchar **pp2parse, int *pLenStr) {
+    uchar *const p2parse = *pp2parse;
+    parserHdrMasks_t masks;
+    uint64_t sp;
+    int offs[5]; /* start of each field, offs[4] is after the MSGID SP */
+    uchar buf[PARSER_HDR_WINDOW + 1];
+    int i;
+
+    parserScanHdr(p2parse, *pLenStr, &masks);
+    sp = masks.sp;
+    offs[0] = 0;
+    for (i = 1; i < 5; ++i) {
+        if (sp == 0) return 1;
+        offs[i] = __builtin_ctzll(sp) + 1;
+        sp &= sp - 1;
+    }
+    if ((masks.nul & (((uint64_t)1 << (offs[4] - 1)) - 1)) != 0) return 1;
+
+    MsgSetHOSTNAME(pMsg, p2parse, offs[1] - 1);
+    memcpy(buf, p2parse + offs[1], offs[2] - offs[1] - 1);
+    buf[offs[2] - offs[1] - 1] = '\0';
+    MsgSetAPPNAME(pMsg, (char *)buf);
+    memcpy(buf, p2parse + offs[2], offs[3] - offs[2] - 1);
+    buf[offs[3] - offs[2] - 1] = '\0';
+    MsgSetPROCID(pMsg, (char *)buf);
+    memcpy(buf, p2parse + offs[3], offs[4] - offs[3] - 1);
+    buf[offs[4] - offs[3] - 1] = '\0';
+    MsgSetMSGID(pMsg, (char *)buf);
+
+    *pp2parse = p2parse + offs[4];
+    *pLenStr -= offs[4];
+    return 0;
+}
+
+
 /* Helper to parseRFCSyslogMsg. This function parses the structured
  * data field of a message. It does NOT parse inside structured data,
  * just gets the field as whole. Parsing the single entities is left
@@ -204,8 +254,10 @@ static int parseRFCStructuredData(uchar **pp2parse, uchar *pResult, int *pLenStr
 BEGINparse
     uchar *p2parse;
     uchar *pBuf = NULL;
+    uchar bufStack[1024];
     int lenMsg;
     int bContParse = 1;
+    int bHdrFieldsDone = 0;
     CODESTARTparse;
     assert(pMsg != NULL);
     assert(pMsg->pszRawMsg != NULL);
@@ -224,9 +276,14 @@ BEGINparse
     /* Now get us some memory we can use as a work buffer while parsing.
      * We simply allocated a buffer sufficiently large to hold all of the
      * message, so we can not run into any troubles. I think this is
-     * wiser than to use individual buffers.
+     * wiser than to use individual buffers. Most messages fit into a stack
+     * buffer, so we only go to the heap for large ones.
      */
-    CHKmalloc(pBuf = malloc(lenMsg + 1));
+    if (lenMsg < (int)sizeof(bufStack)) {
+        pBuf = bufStack;
+    } else {
+        CHKmalloc(pBuf = malloc(lenMsg + 1));
+    }
 
     /* IMPORTANT NOTE:
      * Validation is not actually done below nor are any errors handled. I have
@@ -250,26 +307,31 @@ BEGINparse
         bContParse = 0;
     }
 
+    /* HOSTNAME, APP-NAME, PROCID, MSGID - try the fast path first */
+    if (bContParse && bFastPath && parseRFCHdrFieldsFast(pMsg, &p2parse, &lenMsg) == 0) {
+        bHdrFieldsDone = 1;
+    }
+
     /* HOSTNAME */
-    if (bContParse) {
+    if (bContParse && !bHdrFieldsDone) {
         parseRFCField(&p2parse, pBuf, &lenMsg);
         MsgSetHOSTNAME(pMsg, pBuf, ustrlen(pBuf));
     }
 
     /* APP-NAME */
-    if (bContParse) {
+    if (bContParse && !bHdrFieldsDone) {
         parseRFCField(&p2parse, pBuf, &lenMsg);
         MsgSetAPPNAME(pMsg, (char *)pBuf);
     }
 
     /* PROCID */
-    if (bContParse) {
+    if (bContParse && !bHdrFieldsDone) {
         parseRFCField(&p2parse, pBuf, &lenMsg);
         MsgSetPROCID(pMsg, (char *)pBuf);
     }
 
     /* MSGID */
-    if (bContParse) {
+    if (bContParse && !bHdrFieldsDone) {
         parseRFCField(&p2parse, pBuf, &lenMsg);
         MsgSetMSGID(pMsg, (char *)pBuf);
     }
@@ -284,13 +346,14 @@ BEGINparse
     MsgSetMSGoffs(pMsg, p2parse - pMsg->pszRawMsg);
 
 finalize_it:
-    if (pBuf != NULL) free(pBuf);
+    if (pBuf != bufStack) free(pBuf);
 ENDparse
 
 #ifdef ENABLE_FUZZING
 rsRetVal pmrfc5424FuzzInit(void);
 void pmrfc5424FuzzExit(void);
 rsRetVal pmrfc5424FuzzParse(smsg_t *pMsg);
+void pmrfc5424FuzzSetFastPath(const int bEnable);
 
 rsRetVal pmrfc5424FuzzInit(void) {
     DEFiRet;
@@ -313,6 +376,10 @@ void pmrfc5424FuzzExit(void) {
 rsRetVal pmrfc5424FuzzParse(smsg_t *pMsg) {
     return parse(pMsg);
 }
+
+void pmrfc5424FuzzSetFastPath(const int bEnable) {
+    bFastPath = bEnable;
+}
 #endif
 
 
@@ -34,6 +34,7 @@ rsRetVal modInitpmrfc5424(int iIFVersRequested __attribute__((unused)),
 rsRetVal pmrfc5424FuzzInit(void);
 void pmrfc5424FuzzExit(void);
 rsRetVal pmrfc5424FuzzParse(smsg_t *pMsg);
+void pmrfc5424FuzzSetFastPath(const int bEnable);
     #endif
 
 #endif /* #ifndef PMRFC54254_H_INCLUDED */